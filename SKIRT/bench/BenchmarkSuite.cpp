@@ -0,0 +1,162 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "BenchmarkSuite.hpp"
+#include "BuildInfo.hpp"
+#include "Console.hpp"
+#include "FatalError.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////
+
+BenchmarkSuite::BenchmarkSuite(string workPath, int numThreads, int numRepetitions, double scale, string filter,
+                               bool listOnly)
+    : _workPath(workPath), _numThreads(max(1, numThreads)), _numRepetitions(max(1, numRepetitions)),
+      _scale(scale > 0. ? scale : 1.), _filter(filter.empty() ? "*" : filter), _listOnly(listOnly)
+{}
+
+////////////////////////////////////////////////////////////////////
+
+size_t BenchmarkSuite::scaled(size_t numOperations) const
+{
+    return max(static_cast<size_t>(1), static_cast<size_t>(_scale * numOperations));
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool BenchmarkSuite::isAnySelected(const vector<string>& names) const
+{
+    bool selected = false;
+    for (const string& name : names)
+    {
+        if (StringUtils::matches(name, _filter))
+        {
+            if (_listOnly) Console::info(name);
+            selected = true;
+        }
+    }
+    return selected && !_listOnly;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BenchmarkSuite::measure(string name, size_t numOperations, std::function<void()> body, int numThreads)
+{
+    if (_listOnly || !StringUtils::matches(name, _filter)) return;
+
+    // warm up
+    body();
+
+    // time the repetitions
+    vector<double> timev;
+    for (int r = 0; r != _numRepetitions; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        timev.push_back(std::chrono::duration<double>(stop - start).count() / numOperations);
+    }
+
+    // calculate statistics
+    std::sort(timev.begin(), timev.end());
+    size_t n = timev.size();
+    double median = n % 2 ? timev[n / 2] : 0.5 * (timev[n / 2 - 1] + timev[n / 2]);
+    double mean = 0.;
+    for (double t : timev) mean += t;
+    mean /= n;
+    _results.push_back({name, numOperations, numThreads, timev[0], median, mean});
+
+    // report
+    Console::info(StringUtils::padRight(name, 48) + StringUtils::toString(timev[0] * 1e9, 'f', 2, 12)
+                  + " ns/op (median " + StringUtils::toString(median * 1e9, 'f', 2) + ")");
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BenchmarkSuite::verify(string name, double deviation, double tolerance)
+{
+    if (_listOnly || !StringUtils::matches(name, _filter)) return;
+
+    _checks.push_back({name, deviation, tolerance});
+
+    // report
+    string message = StringUtils::padRight(name, 48) + StringUtils::toString(deviation, 'e', 3, 12) + " (tolerance "
+                     + StringUtils::toString(tolerance, 'e', 1) + ")";
+    if (deviation <= tolerance)
+        Console::info(message);
+    else
+        Console::error(message + " FAILED");
+}
+
+////////////////////////////////////////////////////////////////////
+
+int BenchmarkSuite::numFailedChecks() const
+{
+    int numFailed = 0;
+    for (const Check& check : _checks)
+        if (!(check.deviation <= check.tolerance)) numFailed++;
+    return numFailed;
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns the specified text as a quoted JSON string
+    string quoted(string text)
+    {
+        text = StringUtils::replace(text, "\\", "\\\\");
+        text = StringUtils::replace(text, "\"", "\\\"");
+        return "\"" + text + "\"";
+    }
+
+    // returns the specified time in seconds as a JSON number in nanoseconds
+    string nanoseconds(double time) { return StringUtils::toString(time * 1e9, 'g', 6); }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BenchmarkSuite::writeJson(string filepath) const
+{
+    std::ofstream out = System::ofstream(filepath);
+    if (!out) throw FATALERROR("Could not open benchmark output file " + filepath);
+
+    out << "{\n";
+    out << "  \"program\": \"skirtbench\",\n";
+    out << "  \"version\": " << quoted(BuildInfo::projectVersion()) << ",\n";
+    out << "  \"codeVersion\": " << quoted(BuildInfo::codeVersion()) << ",\n";
+    out << "  \"buildTimestamp\": " << quoted(BuildInfo::timestamp()) << ",\n";
+    out << "  \"host\": " << quoted(System::hostname()) << ",\n";
+    out << "  \"timestamp\": " << quoted(System::timestamp(true)) << ",\n";
+    out << "  \"threads\": " << _numThreads << ",\n";
+    out << "  \"repetitions\": " << _numRepetitions << ",\n";
+    out << "  \"scale\": " << StringUtils::toString(_scale) << ",\n";
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i != _results.size(); ++i)
+    {
+        const Result& result = _results[i];
+        out << (i ? ",\n" : "\n");
+        out << "    {\"name\": " << quoted(result.name) << ", \"operations\": " << result.numOperations
+            << ", \"threads\": " << result.numThreads << ", \"minNsPerOp\": " << nanoseconds(result.minTime)
+            << ", \"medianNsPerOp\": " << nanoseconds(result.medianTime)
+            << ", \"meanNsPerOp\": " << nanoseconds(result.meanTime) << "}";
+    }
+    out << "\n  ],\n";
+    out << "  \"checks\": [";
+    for (size_t i = 0; i != _checks.size(); ++i)
+    {
+        const Check& check = _checks[i];
+        out << (i ? ",\n" : "\n");
+        out << "    {\"name\": " << quoted(check.name)
+            << ", \"deviation\": " << StringUtils::toString(check.deviation, 'g', 6)
+            << ", \"tolerance\": " << StringUtils::toString(check.tolerance, 'g', 6)
+            << ", \"passed\": " << (check.deviation <= check.tolerance ? "true" : "false") << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,132 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef BENCHMARKSUITE_HPP
+#define BENCHMARKSUITE_HPP
+
+#include "Basics.hpp"
+#include <functional>
+
+////////////////////////////////////////////////////////////////////
+
+/** A BenchmarkSuite instance times a sequence of micro-benchmarks and collects the results so that
+    they can be written to a JSON file. Each benchmark is identified by a hierarchical name of the
+    form "group/subject/operation" and consists of a body function that performs a known number of
+    operations. The measure() function runs the body once to warm up caches and lazily initialized
+    data structures, and then the configured number of times while measuring the elapsed wall-clock
+    time. The results are expressed as the minimum, median and mean time per operation over these
+    repetitions; the minimum is usually the most reproducible figure for comparing builds.
+
+    The suite also holds the configuration options shared by all benchmarks: the work directory for
+    temporary files, the number of parallel threads used for benchmarks that measure contention,
+    a scale factor for the amount of work performed by each benchmark, and a filter pattern
+    selecting the benchmarks to be run. Benchmark clients announce the names of the benchmarks in
+    each group through the isAnySelected() function before constructing the fixtures for the group.
+    In list mode, this function outputs the names of the selected benchmarks and reports that none
+    of them should be run.
+
+    In addition to timing, benchmark clients can report accuracy checks through the verify()
+    function. An accuracy check compares the result of an optimized calculation with that of a
+    reference calculation, so that optimizations trading accuracy for speed cannot silently
+    degrade the results. Accuracy checks are named and selected in the same way as benchmarks. */
+class BenchmarkSuite final
+{
+    // ================== Construction ==================
+
+public:
+    /** The constructor stores the specified configuration options. The \em filter argument is a
+        pattern that may include * and ? wildcards; an empty filter selects all benchmarks. */
+    BenchmarkSuite(string workPath, int numThreads, int numRepetitions, double scale, string filter,
+                   bool listOnly);
+
+    // ================== Configuration ==================
+
+public:
+    /** This function returns the directory in which benchmarks can place temporary files. */
+    string workPath() const { return _workPath; }
+
+    /** This function returns the number of threads to be used by benchmarks that measure
+        contention between parallel threads. */
+    int numThreads() const { return _numThreads; }
+
+    /** This function returns the given nominal number of operations multiplied by the configured
+        scale factor, with a minimum of one. */
+    size_t scaled(size_t numOperations) const;
+
+    /** This function returns true if at least one of the specified benchmark names is selected by
+        the filter pattern, and false otherwise. It allows skipping the construction of expensive
+        fixtures that are not needed by any of the selected benchmarks. In list mode, the function
+        always returns false after outputting the selected names, so that no fixtures are
+        constructed at all. */
+    bool isAnySelected(const vector<string>& names) const;
+
+    // ================== Measuring ==================
+
+public:
+    /** If the benchmark with the specified name is selected by the filter pattern, this function
+        runs the specified body function as described in the class header and records the results.
+        The body function must perform the specified number of operations each time it is invoked.
+        The \em numThreads argument indicates the number of parallel threads used by the body
+        function; it is reported with the results. */
+    void measure(string name, size_t numOperations, std::function<void()> body, int numThreads = 1);
+
+    // ================== Verifying ==================
+
+public:
+    /** If the accuracy check with the specified name is selected by the filter pattern, this
+        function records the specified deviation of an optimized calculation from the corresponding
+        reference calculation, and reports whether the deviation lies within the specified
+        tolerance. The interpretation of the deviation (e.g., relative or absolute) is determined
+        by the client. */
+    void verify(string name, double deviation, double tolerance);
+
+    /** This function returns the number of accuracy checks recorded so far for which the
+        deviation exceeded the tolerance. */
+    int numFailedChecks() const;
+
+    // ================== Output ==================
+
+public:
+    /** This function writes the results of all benchmarks measured and all accuracy checks
+        recorded so far to the specified file in JSON format, together with information on the
+        build, the host and the configuration. */
+    void writeJson(string filepath) const;
+
+    // ================== Data members ==================
+
+private:
+    // configuration
+    string _workPath;
+    int _numThreads{1};
+    int _numRepetitions{1};
+    double _scale{1.};
+    string _filter;
+    bool _listOnly{false};
+
+    // results
+    struct Result
+    {
+        string name;
+        size_t numOperations;
+        int numThreads;
+        double minTime;  // seconds per operation
+        double medianTime;
+        double meanTime;
+    };
+    vector<Result> _results;
+
+    // accuracy checks
+    struct Check
+    {
+        string name;
+        double deviation;
+        double tolerance;
+    };
+    vector<Check> _checks;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
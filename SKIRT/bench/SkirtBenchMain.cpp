@@ -0,0 +1,121 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "BenchmarkSuite.hpp"
+#include "BuildInfo.hpp"
+#include "CommandLineArguments.hpp"
+#include "Console.hpp"
+#include "FatalError.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
+#include "SignalHandler.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "SkirtBenchmarks.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the allowed options list, in the format consumed by the CommandLineArguments constructor
+    const char* allowedOptions = "-t* -r* -s* -f* -o* -w* -l";
+
+    // prints a help message listing the command line options
+    void printHelp()
+    {
+        Console::warning("");
+        Console::warning("To run the micro-benchmarks use the command line:");
+        Console::warning("");
+        Console::warning(" skirtbench [-t <threads>] [-r <repetitions>] [-s <scale>] [-f <filter>]");
+        Console::warning("            [-o <jsonfile>] [-w <workdir>] [-l]");
+        Console::warning("");
+        Console::warning(" -t <threads> : the number of threads for the contention benchmarks (default: all cores)");
+        Console::warning(" -r <repetitions> : the number of timed repetitions per benchmark (default: 5)");
+        Console::warning(" -s <scale> : the scale factor for the amount of work per benchmark (default: 1)");
+        Console::warning(" -f <filter> : run only benchmarks with a name matching the pattern, e.g. 'grid/*'");
+        Console::warning(" -o <jsonfile> : the path of the JSON output file (default: skirtbench.json)");
+        Console::warning(" -w <workdir> : the directory for temporary files (default: current directory)");
+        Console::warning(" -l : list the names of the selected benchmarks without running them");
+        Console::warning("");
+    }
+
+    // runs the benchmarks according to the command line arguments
+    int runBenchmarks()
+    {
+        CommandLineArguments args(System::arguments(), allowedOptions);
+        if (!args.isValid() || args.hasFilepaths())
+        {
+            Console::error("Invalid command line arguments");
+            printHelp();
+            return EXIT_FAILURE;
+        }
+        if (ProcessManager::isMultiProc()) throw FATALERROR("Benchmarks cannot be run with multiple processes");
+
+        // get the options
+        int numThreads = args.isPresent("-t") ? args.intValue("-t") : ParallelFactory::defaultThreadCount();
+        int numRepetitions = args.isPresent("-r") ? args.intValue("-r") : 5;
+        double scale = args.isPresent("-s") ? args.doubleValue("-s") : 1.;
+        string workPath = args.isPresent("-w") ? args.value("-w") : ".";
+        string jsonPath = args.isPresent("-o") ? args.value("-o") : "skirtbench.json";
+        if (numThreads < 1 || numRepetitions < 1 || scale <= 0.)
+            throw FATALERROR("Invalid value for number of threads, number of repetitions or scale factor");
+        if (!System::isDir(workPath)) throw FATALERROR("Work directory does not exist: " + workPath);
+        workPath = System::canonicalPath(workPath);
+
+        // run the benchmarks
+        BenchmarkSuite suite(workPath, numThreads, numRepetitions, scale, args.value("-f"), args.isPresent("-l"));
+        SkirtBenchmarks::all(suite);
+
+        // write the results
+        if (!args.isPresent("-l"))
+        {
+            suite.writeJson(jsonPath);
+            Console::success("Benchmark results written to " + jsonPath);
+        }
+        int numFailed = suite.numFailedChecks();
+        if (numFailed)
+        {
+            Console::error(std::to_string(numFailed) + " accuracy check(s) failed");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+    // Initialize inter-process communication capability, if present
+    ProcessManager pm(&argc, &argv);
+
+    // Initialize the system and install signal handlers
+    System system(argc, argv);
+    SignalHandler::InstallSignalHandlers();
+
+    // Add all simulation items to the item registry
+    string version = BuildInfo::projectVersion();
+    SimulationItemRegistry registry(version, "9");
+
+    // Run the benchmarks and properly report any exceptions
+    Console::info("Welcome to skirtbench " + version + " (" + BuildInfo::codeVersion() + " " + BuildInfo::timestamp()
+                  + ")");
+    try
+    {
+        return runBenchmarks();
+    }
+    catch (FatalError& error)
+    {
+        for (string line : error.message()) Console::error(line);
+    }
+    catch (const std::exception& except)
+    {
+        Console::error("Standard Library Exception: " + string(except.what()));
+    }
+    return EXIT_FAILURE;
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,1006 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SkirtBenchmarks.hpp"
+#include "BenchmarkSuite.hpp"
+#include "CdfSampler.hpp"
+#include "Constants.hpp"
+#include "FluxRecorder.hpp"
+#include "InstrumentSystem.hpp"
+#include "LockFree.hpp"
+#include "MediumSystem.hpp"
+#include "MonteCarloSimulation.hpp"
+#include "NR.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "PathSegmentGenerator.hpp"
+#include "PhotonPacket.hpp"
+#include "Random.hpp"
+#include "Range.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "SpatialGrid.hpp"
+#include "Sphere2DSpatialGrid.hpp"
+#include "StoredTable.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include "XmlHierarchyCreator.hpp"
+#include <cfloat>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // a volatile variable that receives benchmark results so that the compiler cannot optimize away their calculation
+    thread_local volatile double _sink;
+
+    // stores the specified value in the volatile sink
+    void keep(double value) { _sink = value; }
+
+    // ---- simulation fixtures ----
+
+    // returns a ski file serialization for a simulation with the specified simulation mode, source wavelength range,
+    // source SED, and (optional) medium system, without instruments and without any photon packets
+    string skiContents(string mode, string wavelengthRange, string sed, string mediumSystem)
+    {
+        return R"(<?xml version="1.0" encoding="UTF-8"?>
+<skirt-simulation-hierarchy type="MonteCarloSimulation" format="9" producer="skirtbench" time="">
+<MonteCarloSimulation userLevel="Expert" simulationMode=")"
+               + mode + R"(" numPackets="0">
+<random type="Random"><Random seed="4357"/></random>
+<units type="Units"><SIUnits/></units>
+<cosmology type="Cosmology"><LocalUniverseCosmology/></cosmology>
+<sourceSystem type="SourceSystem"><SourceSystem )"
+               + wavelengthRange + R"( sourceBias="0.5"><sources type="Source">
+<PointSource positionX="0 pc" positionY="0 pc" positionZ="0 pc" sourceWeight="1" wavelengthBias="0">
+<angularDistribution type="AngularDistribution"><IsotropicAngularDistribution/></angularDistribution>
+<polarizationProfile type="PolarizationProfile"><NoPolarizationProfile/></polarizationProfile>
+<sed type="SED">)" + sed
+               + R"(</sed>
+<normalization type="LuminosityNormalization">
+<IntegratedLuminosityNormalization wavelengthRange="Source" integratedLuminosity="1 Lsun"/></normalization>
+</PointSource></sources></SourceSystem></sourceSystem>
+)" + mediumSystem
+               + R"(
+<instrumentSystem type="InstrumentSystem"><InstrumentSystem>
+<defaultWavelengthGrid type="WavelengthGrid">
+<LogWavelengthGrid minWavelength="0.1 micron" maxWavelength="10 micron" numWavelengths="100"/>
+</defaultWavelengthGrid><instruments type="Instrument"/></InstrumentSystem></instrumentSystem>
+<probeSystem type="ProbeSystem"><ProbeSystem/></probeSystem>
+</MonteCarloSimulation>
+</skirt-simulation-hierarchy>
+)";
+    }
+
+    // returns a ski file serialization for a continuum simulation with dust and electrons on the specified grid
+    string continuumSkiContents(string grid)
+    {
+        return skiContents("ExtinctionOnly", R"(minWavelength="0.1 micron" maxWavelength="10 micron")",
+                           R"(<BlackBodySED temperature="5000 K"/>)", R"(<mediumSystem type="MediumSystem">
+<MediumSystem numDensitySamples="20">
+<photonPacketOptions type="PhotonPacketOptions"><PhotonPacketOptions/></photonPacketOptions>
+<extinctionOnlyOptions type="ExtinctionOnlyOptions">
+<ExtinctionOnlyOptions storeRadiationField="false"/></extinctionOnlyOptions>
+<media type="Medium">
+<GeometricMedium><geometry type="Geometry"><PlummerGeometry scaleLength="1 pc"/></geometry>
+<materialMix type="MaterialMix"><MeanListDustMix wavelengths="0.1 micron, 1 micron, 10 micron"
+ extinctionCoefficients="5e4 m2/kg, 1e4 m2/kg, 1e3 m2/kg" albedos="0.4, 0.5, 0.2"
+ asymmetryParameters="0.6, 0.5, 0.1"/></materialMix>
+<normalization type="MaterialNormalization">
+<OpticalDepthMaterialNormalization axis="Z" wavelength="1 micron" opticalDepth="1"/></normalization>
+</GeometricMedium>
+<GeometricMedium><geometry type="Geometry"><PlummerGeometry scaleLength="2 pc"/></geometry>
+<materialMix type="MaterialMix"><ElectronMix/></materialMix>
+<normalization type="MaterialNormalization">
+<OpticalDepthMaterialNormalization axis="Z" wavelength="1 micron" opticalDepth="0.1"/></normalization>
+</GeometricMedium>
+</media>
+<grid type="SpatialGrid">)" + grid + R"(</grid>
+</MediumSystem></mediumSystem>)");
+    }
+
+    // returns a ski file serialization for a Lyman-alpha simulation with neutral hydrogen on a Cartesian grid
+    string lyaSkiContents()
+    {
+        return skiContents("LyaWithDustExtinction", R"(minWavelength="0.12 micron" maxWavelength="0.1232 micron")",
+                           R"(<LyaGaussianSED dispersion="10 km/s"/>)", R"(<mediumSystem type="MediumSystem">
+<MediumSystem numDensitySamples="20">
+<photonPacketOptions type="PhotonPacketOptions"><PhotonPacketOptions/></photonPacketOptions>
+<lyaOptions type="LyaOptions"><LyaOptions lyaAccelerationScheme="Constant" lyaAccelerationStrength="1"/></lyaOptions>
+<media type="Medium">
+<GeometricMedium><geometry type="Geometry"><PlummerGeometry scaleLength="1 pc"/></geometry>
+<materialMix type="MaterialMix"><LyaNeutralHydrogenGasMix defaultTemperature="1e4 K"/></materialMix>
+<normalization type="MaterialNormalization"><MassMaterialNormalization mass="1e-2 Msun"/></normalization>
+</GeometricMedium>
+</media>
+<grid type="SpatialGrid"><CartesianSpatialGrid minX="-5 pc" maxX="5 pc" minY="-5 pc" maxY="5 pc" minZ="-5 pc"
+ maxZ="5 pc"><meshX type="MoveableMesh"><LinMesh numBins="16"/></meshX><meshY type="MoveableMesh">
+<LinMesh numBins="16"/></meshY><meshZ type="MoveableMesh"><LinMesh numBins="16"/></meshZ></CartesianSpatialGrid>
+</grid>
+</MediumSystem></mediumSystem>)");
+    }
+
+    // returns a ski file serialization for a simulation without media
+    string utilitySkiContents()
+    {
+        return skiContents("NoMedium", R"(minWavelength="0.1 micron" maxWavelength="10 micron")",
+                           R"(<BlackBodySED temperature="5000 K"/>)", "");
+    }
+
+    // ---- reference path segment generator for the 2D spherical grid ----
+
+    // the path segment generator for Sphere2DSpatialGrid before the introduction of incremental boundary crossings,
+    // which propagates the position after each segment and locates the cell indices whenever no exit point is found;
+    // it is retained here as a reference for verifying the current generator
+    class LegacySphere2DSegmentGenerator : public PathSegmentGenerator
+    {
+    public:
+        // rebuilds the cell boundaries from the properties of the specified grid, as the grid does during setup
+        explicit LegacySphere2DSegmentGenerator(const Sphere2DSpatialGrid* grid)
+        {
+            _rmax = grid->maxRadius();
+            _rv = grid->meshRadial()->mesh() * _rmax;
+            _Nr = _rv.size() - 1;
+
+            // make sure there is a polar boundary corresponding to the xy-plane with an exact zero cosine
+            vector<double> thetav;
+            for (double t : grid->meshPolar()->mesh()) thetav.push_back(t * M_PI);
+            bool hasZero = false;
+            for (double theta : thetav)
+                if (abs(cos(theta)) < 1e-9) hasZero = true;
+            if (!hasZero) thetav.insert(std::upper_bound(thetav.begin(), thetav.end(), M_PI_2), M_PI_2);
+            _Ntheta = thetav.size() - 1;
+            _thetav.resize(_Ntheta + 1);
+            _cv.resize(_Ntheta + 1);
+            for (int k = 0; k <= _Ntheta; ++k)
+            {
+                _thetav[k] = thetav[k];
+                _cv[k] = abs(cos(thetav[k])) < 1e-9 ? 0. : cos(thetav[k]);
+            }
+            _cv[0] = 1.;
+            _cv[_Ntheta] = -1.;
+
+            // determine the grid's cell index for each combination of radial and polar indices
+            _mv.resize(_Nr * _Ntheta);
+            for (int i = 0; i != _Nr; ++i)
+                for (int k = 0; k != _Ntheta; ++k)
+                    _mv[i * _Ntheta + k] =
+                        grid->cellIndex(Position(0.5 * (_rv[i] + _rv[i + 1]), 0.5 * (_thetav[k] + _thetav[k + 1]), 0.,
+                                                 Position::CoordinateSystem::SPHERICAL));
+        }
+
+        bool next() override
+        {
+            switch (state())
+            {
+                case State::Unknown:
+                {
+                    // small value relative to domain size
+                    _eps = 1e-11 * _rmax;
+
+                    // if necessary, try moving the photon packet inside the grid
+                    double r2 = r().norm2();
+                    if (r2 > _rmax * _rmax)
+                    {
+                        double ds = firstIntersectionSphere(r(), k(), _rmax);
+                        if (ds > 0.)
+                        {
+                            propagater(ds + _eps);
+                            setCellIndices();
+                            if (_i >= 0)
+                            {
+                                setEmptySegment(ds);
+                                setState(State::Inside);
+                                return true;
+                            }
+                        }
+                        setState(State::Outside);
+                        return false;
+                    }
+
+                    // if necessary, move the position away from the origin so that it has meaningful cell indices
+                    if (r2 == 0.) propagater(_eps);
+                    setCellIndices();
+                    setState(State::Inside);
+                }
+
+                // intentionally falls through
+                case State::Inside:
+                {
+                    while (true)  // the loop is executed more than once only if no exit point is found
+                    {
+                        // consider the potential exit points for each of the four cell boundaries
+                        int icur = _i;
+                        int kcur = _k;
+                        double ds = DBL_MAX;
+                        if (icur > 0) consider(firstIntersectionSphere(r(), k(), _rv[icur]), ds, icur - 1, kcur);
+                        consider(firstIntersectionSphere(r(), k(), _rv[icur + 1]), ds, icur + 1, kcur);
+                        if (kcur > 0) consider(firstIntersectionCone(r(), k(), _cv[kcur]), ds, icur, kcur - 1);
+                        if (kcur < _Ntheta - 1)
+                            consider(firstIntersectionCone(r(), k(), _cv[kcur + 1]), ds, icur, kcur + 1);
+
+                        // if an exit point was found, add a segment to the path
+                        if (_i != icur || _k != kcur)
+                        {
+                            setSegment(_mv[icur * _Ntheta + kcur], ds);
+                            propagater(ds + _eps);
+                            if (_i >= _Nr) setState(State::Outside);
+                            return true;
+                        }
+
+                        // otherwise, move a tiny bit along the path and reset the current cell indices
+                        propagater(_eps);
+                        setCellIndices();
+                        if (_i < 0)
+                        {
+                            setState(State::Outside);
+                            return false;
+                        }
+                    }
+                }
+
+                case State::Outside:
+                {
+                }
+            }
+            return false;
+        }
+
+    private:
+        // determines the indices of the cell containing the current position; _i is -1 if it is outside the grid
+        void setCellIndices()
+        {
+            double radius, theta, phi;
+            r().spherical(radius, theta, phi);
+            _i = NR::locateFail(_rv, radius);
+            _k = NR::locateClip(_thetav, theta);
+        }
+
+        // updates the exit distance and the next cell indices if the specified distance is positive and smaller
+        void consider(double s, double& ds, int i, int k)
+        {
+            if (s > 0 && s < ds)
+            {
+                ds = s;
+                _i = i;
+                _k = k;
+            }
+        }
+
+        // returns the smallest positive solution of x^2 + 2*b*x + c = 0, or 0 if there is no positive solution
+        static double smallestPositiveSolution(double b, double c)
+        {
+            if (b * b > c)
+            {
+                if (b > 0)
+                {
+                    if (c < 0) return c / (-b - sqrt(b * b - c));
+                }
+                else
+                {
+                    double x2 = -b + sqrt(b * b - c);
+                    if (c > 0)
+                    {
+                        double x1 = c / x2;
+                        if (x1 < x2) return x1;
+                    }
+                    return x2;
+                }
+            }
+            return 0;
+        }
+
+        // returns the smallest positive solution of a*x^2 + 2*b*x + c = 0, or 0 if there is no positive solution
+        static double smallestPositiveSolution(double a, double b, double c)
+        {
+            if (abs(a) > 1e-9) return smallestPositiveSolution(b / a, c / a);
+            double x = -0.5 * c / b;
+            return x > 0 ? x : 0;
+        }
+
+        // returns the distance to the first intersection between the ray and the sphere with the given radius
+        static double firstIntersectionSphere(Vec bfr, Vec bfk, double r)
+        {
+            return smallestPositiveSolution(Vec::dot(bfr, bfk), bfr.norm2() - r * r);
+        }
+
+        // returns the distance to the first intersection between the ray and the cone with the given cos(theta)
+        static double firstIntersectionCone(Vec bfr, Vec bfk, double c)
+        {
+            return c ? smallestPositiveSolution(c * c - bfk.z() * bfk.z(),
+                                                c * c * Vec::dot(bfr, bfk) - bfr.z() * bfk.z(),
+                                                c * c * bfr.norm2() - bfr.z() * bfr.z())
+                     : -bfr.z() / bfk.z();
+        }
+
+        double _rmax{0.};
+        int _Nr{0};
+        int _Ntheta{0};
+        Array _rv;
+        Array _thetav;
+        Array _cv;
+        vector<int> _mv;
+        double _eps{0.};
+        int _i{-1};
+        int _k{-1};
+    };
+
+    // the spatial grids used for the grid benchmarks: name and ski file serialization
+    const vector<std::pair<string, string>> gridSpecs = {
+        {"Sphere1D", R"(<Sphere1DSpatialGrid maxRadius="5 pc">
+<meshRadial type="Mesh"><LinMesh numBins="100"/></meshRadial></Sphere1DSpatialGrid>)"},
+        {"Sphere2D", R"(<Sphere2DSpatialGrid maxRadius="5 pc">
+<meshRadial type="Mesh"><LinMesh numBins="50"/></meshRadial>
+<meshPolar type="Mesh"><LinMesh numBins="50"/></meshPolar></Sphere2DSpatialGrid>)"},
+        {"Cylinder2D", R"(<Cylinder2DSpatialGrid maxRadius="5 pc" minZ="-5 pc" maxZ="5 pc">
+<meshRadial type="Mesh"><LinMesh numBins="50"/></meshRadial>
+<meshZ type="MoveableMesh"><LinMesh numBins="50"/></meshZ></Cylinder2DSpatialGrid>)"},
+        {"Cartesian", R"(<CartesianSpatialGrid minX="-5 pc" maxX="5 pc" minY="-5 pc" maxY="5 pc" minZ="-5 pc"
+ maxZ="5 pc">
+<meshX type="MoveableMesh"><LinMesh numBins="32"/></meshX><meshY type="MoveableMesh"><LinMesh numBins="32"/></meshY>
+<meshZ type="MoveableMesh"><LinMesh numBins="32"/></meshZ></CartesianSpatialGrid>)"},
+        {"OctTree", R"(<PolicyTreeSpatialGrid minX="-5 pc" maxX="5 pc" minY="-5 pc" maxY="5 pc" minZ="-5 pc" maxZ="5 pc"
+ treeType="OctTree"><policy type="TreePolicy"><DensityTreePolicy minLevel="3" maxLevel="6" maxDustFraction="1e-5"
+ maxElectronFraction="1e-5"/></policy></PolicyTreeSpatialGrid>)"},
+        {"Voronoi", R"(<VoronoiMeshSpatialGrid minX="-5 pc" maxX="5 pc" minY="-5 pc" maxY="5 pc" minZ="-5 pc"
+ maxZ="5 pc" policy="DustDensity" numSites="10000"/>)"},
+    };
+
+    // a simulation hierarchy constructed from a ski file serialization and set up for use by benchmarks
+    class Fixture
+    {
+    public:
+        // constructs the simulation hierarchy and performs setup; the log output is limited to errors
+        Fixture(const BenchmarkSuite& suite, string name, string contents)
+        {
+            _topItem = XmlHierarchyCreator::readString(SimulationItemRegistry::getSchemaDef(), contents,
+                                                       "skirtbench fixture " + name);
+            _simulation = dynamic_cast<MonteCarloSimulation*>(_topItem.get());
+            _simulation->filePaths()->setOutputPrefix("skirtbench_" + name);
+            _simulation->filePaths()->setInputPath(suite.workPath());
+            _simulation->filePaths()->setOutputPath(suite.workPath());
+            _simulation->parallelFactory()->setMaxThreadCount(suite.numThreads());
+            _simulation->log()->setLowestLevel(Log::Level::Error);
+            _simulation->setupAndRun();
+        }
+
+        MonteCarloSimulation* simulation() const { return _simulation; }
+        MediumSystem* mediumSystem() const { return _simulation->mediumSystem(); }
+        Random* random() const { return _simulation->random(); }
+
+    private:
+        std::unique_ptr<Item> _topItem;
+        MonteCarloSimulation* _simulation{nullptr};
+    };
+
+    // returns a random wavelength from a logarithmic distribution between the specified limits
+    double randomWavelength(Random* random, double minWavelength, double maxWavelength)
+    {
+        return minWavelength * pow(maxWavelength / minWavelength, random->uniform());
+    }
+
+    // ---- stored table files ----
+
+    // writes a stored table file with the specified axes and a single quantity to the specified path;
+    // the axes are specified as name, unit and grid points, and the quantity values are obtained from the
+    // specified function, which is called with the grid point indices for each axis
+    void writeStoredTable(string path, const vector<string>& axisNames, const vector<string>& axisUnits,
+                          const vector<Array>& axisGrids, std::function<double(const vector<size_t>&)> value)
+    {
+        std::ofstream out = System::ofstream(path);
+        auto writeString = [&out](string s) { out.write(StringUtils::padRight(s, 8).c_str(), 8); };
+        auto writeSize = [&out](size_t v) { out.write(reinterpret_cast<const char*>(&v), 8); };
+        auto writeDouble = [&out](double v) { out.write(reinterpret_cast<const char*>(&v), 8); };
+
+        size_t numAxes = axisNames.size();
+        out.write("SKIRT X\n", 8);
+        writeSize(0x010203040A0BFEFF);
+        writeSize(numAxes);
+        for (const string& name : axisNames) writeString(name);
+        for (const string& unit : axisUnits) writeString(unit);
+        for (size_t k = 0; k != numAxes; ++k) writeString("log");
+        for (const Array& grid : axisGrids)
+        {
+            writeSize(grid.size());
+            for (double x : grid) writeDouble(x);
+        }
+        writeSize(1);
+        writeString("Q");
+        writeString("1");
+        writeString("log");
+
+        // write the values with the first axis index varying fastest
+        size_t numValues = 1;
+        for (const Array& grid : axisGrids) numValues *= grid.size();
+        vector<size_t> indices(numAxes);
+        for (size_t i = 0; i != numValues; ++i)
+        {
+            size_t rest = i;
+            for (size_t k = 0; k != numAxes; ++k)
+            {
+                indices[k] = rest % axisGrids[k].size();
+                rest /= axisGrids[k].size();
+            }
+            writeDouble(value(indices));
+        }
+        out.write("STABEND\n", 8);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::spatialGrids(BenchmarkSuite& suite)
+{
+    for (const auto& spec : gridSpecs)
+    {
+        string pathName = "grid/" + spec.first + "/pathSegments";
+        string setName = "medium/" + spec.first + "/setOpticalDepths";
+        string getName = "medium/" + spec.first + "/getOpticalDepth";
+        string cellName = "grid/" + spec.first + "/randomPositionInCell";
+        string escapeName = "medium/" + spec.first + "/getEscapeOpticalDepth";
+        string checkName = "check/" + spec.first + "/escapeOpticalDepth";
+        string cellsName = "check/" + spec.first + "/pathCells";
+        if (!suite.isAnySelected({pathName, setName, getName, cellName, escapeName, checkName, cellsName})) continue;
+
+        Fixture fixture(suite, spec.first, continuumSkiContents(spec.second));
+        MediumSystem* ms = fixture.mediumSystem();
+        const SpatialGrid* grid = ms->grid();
+        Random* random = fixture.random();
+
+        // generate the random rays and wavelengths
+        size_t numRays = suite.scaled(20000);
+        Box box = grid->boundingBox();
+        vector<Position> rv(numRays);
+        vector<Direction> kv(numRays);
+        Array lambdav(numRays);
+        for (size_t i = 0; i != numRays; ++i)
+        {
+            rv[i] = random->position(box);
+            kv[i] = random->direction();
+            lambdav[i] = randomWavelength(random, 0.1e-6, 10e-6);
+        }
+
+        // path segment generation
+        auto generator = grid->createPathSegmentGenerator();
+        SpatialGridPath path;
+        suite.measure(pathName, numRays, [&]() {
+            double s = 0.;
+            for (size_t i = 0; i != numRays; ++i)
+            {
+                path.setPosition(rv[i]);
+                path.setDirection(kv[i]);
+                generator->start(&path);
+                while (generator->next()) s += generator->ds();
+            }
+            keep(s);
+        });
+
+        // path segments verified against the cell containing the midpoint of each segment, in terms of the
+        // fraction of the path length assigned to the wrong cell; segments that are so short that roundoff
+        // errors may place their midpoint in a neighboring cell are ignored
+        if (suite.isAnySelected({cellsName}))
+        {
+            double tiny = 1e-7 * box.diagonal();
+            double total = 0.;
+            double wrong = 0.;
+            for (size_t i = 0; i != numRays; ++i)
+            {
+                path.setPosition(rv[i]);
+                path.setDirection(kv[i]);
+                generator->start(&path);
+                double s = 0.;
+                while (generator->next())
+                {
+                    if (generator->m() >= 0)
+                    {
+                        total += generator->ds();
+                        Position mid(rv[i] + kv[i] * (s + 0.5 * generator->ds()));
+                        if (generator->ds() > tiny && grid->cellIndex(mid) != generator->m()) wrong += generator->ds();
+                    }
+                    s += generator->ds();
+                }
+            }
+            suite.verify(cellsName, wrong / total, 1e-6);
+        }
+
+        // optical depth calculations
+        PhotonPacket pp;
+        suite.measure(setName, numRays, [&]() {
+            for (size_t i = 0; i != numRays; ++i)
+            {
+                pp.launch(i, lambdav[i], 1., rv[i], kv[i]);
+                ms->setOpticalDepths(&pp);
+            }
+            keep(pp.totalOpticalDepth());
+        });
+        suite.measure(getName, numRays, [&]() {
+            double tau = 0.;
+            for (size_t i = 0; i != numRays; ++i)
+            {
+                pp.launch(i, lambdav[i], 1., rv[i], kv[i]);
+                tau += ms->getOpticalDepth(&pp, std::numeric_limits<double>::infinity());
+            }
+            keep(tau);
+        });
+
+        // random position generation in random cells
+        int numCells = grid->numCells();
+        vector<int> mv(numRays);
+        for (size_t i = 0; i != numRays; ++i) mv[i] = min(numCells - 1, static_cast<int>(random->uniform() * numCells));
+        suite.measure(cellName, numRays, [&]() {
+            double x = 0.;
+            for (size_t i = 0; i != numRays; ++i) x += grid->randomPositionInCell(mv[i]).x();
+            keep(x);
+        });
+
+        // optical depth towards a distant observer through the escape optical depth cache,
+        // verified against the full path calculation in terms of the total transmitted luminosity;
+        // the cache is supported only for three-dimensional grids
+        if (grid->dimension() == 3 && suite.isAnySelected({escapeName, checkName}))
+        {
+            Direction bfk(M_PI / 6., M_PI / 9.);
+            int cacheIndex = ms->cacheEscapeOpticalDepths(bfk);
+            suite.measure(escapeName, numRays, [&]() {
+                double tau = 0.;
+                for (size_t i = 0; i != numRays; ++i)
+                {
+                    pp.launch(i, lambdav[i], 1., rv[i], bfk);
+                    tau += ms->getEscapeOpticalDepth(cacheIndex, &pp, std::numeric_limits<double>::infinity());
+                }
+                keep(tau);
+            });
+
+            double cached = 0.;
+            double traced = 0.;
+            for (size_t i = 0; i != numRays; ++i)
+            {
+                pp.launch(i, lambdav[i], 1., rv[i], bfk);
+                cached += exp(-ms->getEscapeOpticalDepth(cacheIndex, &pp, std::numeric_limits<double>::infinity()));
+                traced += exp(-ms->getOpticalDepth(&pp, std::numeric_limits<double>::infinity()));
+            }
+            suite.verify(checkName, abs(cached / traced - 1.), 1e-3);
+        }
+    }
+
+    // path segments through the 2D spherical grid, verified against those produced by the reference generator,
+    // in terms of the fraction of rays with a different sequence of cells and the deviation of the path lengths
+    // for the other rays; segments shorter than a small fraction of the domain size are ignored, because the
+    // reference generator nudges the position after each segment
+    string legacyCellsName = "check/Sphere2D/legacyCells";
+    string legacyLengthName = "check/Sphere2D/legacyLength";
+    if (suite.isAnySelected({legacyCellsName, legacyLengthName}))
+    {
+        Fixture fixture(suite, gridSpecs[1].first, continuumSkiContents(gridSpecs[1].second));
+        auto grid = dynamic_cast<const Sphere2DSpatialGrid*>(fixture.mediumSystem()->grid());
+        Random* random = fixture.random();
+        auto generator = grid->createPathSegmentGenerator();
+        LegacySphere2DSegmentGenerator legacy(grid);
+
+        // returns the list of cells and corresponding path lengths for the specified ray and generator
+        Box box = grid->boundingBox();
+        double tiny = 1e-7 * box.diagonal();
+        SpatialGridPath path;
+        auto segments = [&path, tiny](PathSegmentGenerator* generator, Position bfr, Direction bfk) {
+            vector<std::pair<int, double>> segmentv;
+            path.setPosition(bfr);
+            path.setDirection(bfk);
+            generator->start(&path);
+            while (generator->next())
+            {
+                if (generator->m() >= 0 && generator->ds() > tiny)
+                {
+                    if (!segmentv.empty() && segmentv.back().first == generator->m())
+                        segmentv.back().second += generator->ds();
+                    else
+                        segmentv.emplace_back(generator->m(), generator->ds());
+                }
+            }
+            return segmentv;
+        };
+
+        size_t numRays = suite.scaled(20000);
+        size_t numDifferent = 0;
+        double total = 0.;
+        double deviation = 0.;
+        for (size_t i = 0; i != numRays; ++i)
+        {
+            Position bfr = random->position(box);
+            Direction bfk = random->direction();
+            auto segmentv = segments(generator.get(), bfr, bfk);
+            auto legacyv = segments(&legacy, bfr, bfk);
+            bool same = segmentv.size() == legacyv.size();
+            for (size_t j = 0; same && j != segmentv.size(); ++j)
+                if (segmentv[j].first != legacyv[j].first) same = false;
+            if (!same)
+            {
+                numDifferent++;
+                continue;
+            }
+            for (size_t j = 0; j != segmentv.size(); ++j)
+            {
+                total += legacyv[j].second;
+                deviation += abs(segmentv[j].second - legacyv[j].second);
+            }
+        }
+        suite.verify(legacyCellsName, static_cast<double>(numDifferent) / numRays, 1e-3);
+        suite.verify(legacyLengthName, total > 0. ? deviation / total : 1., 1e-8);
+    }
+
+    // path lengths through the radial shells of the 2D spherical grid, verified against those through the
+    // 1D spherical grid, which has a radial mesh with twice as many bins covering the same shell boundaries
+    string lengthName = "check/Sphere2D/pathLength";
+    if (suite.isAnySelected({lengthName}))
+    {
+        Fixture fixture1(suite, gridSpecs[0].first, continuumSkiContents(gridSpecs[0].second));
+        Fixture fixture2(suite, gridSpecs[1].first, continuumSkiContents(gridSpecs[1].second));
+        const SpatialGrid* grid1 = fixture1.mediumSystem()->grid();
+        const SpatialGrid* grid2 = fixture2.mediumSystem()->grid();
+        Random* random = fixture2.random();
+        auto generator1 = grid1->createPathSegmentGenerator();
+        auto generator2 = grid2->createPathSegmentGenerator();
+
+        // accumulates the path length per radial shell of the 2D grid for the specified ray and generator
+        const int numShells = 50;
+        double shellWidth = grid2->boundingBox().xmax() / numShells;
+        SpatialGridPath path;
+        auto shellLengths = [&](const SpatialGrid* grid, PathSegmentGenerator* generator, Position bfr,
+                                Direction bfk) {
+            Array lengthv(numShells);
+            path.setPosition(bfr);
+            path.setDirection(bfk);
+            generator->start(&path);
+            while (generator->next())
+            {
+                if (generator->m() >= 0)
+                {
+                    int shell = static_cast<int>(grid->centralPositionInCell(generator->m()).norm() / shellWidth);
+                    lengthv[min(shell, numShells - 1)] += generator->ds();
+                }
+            }
+            return lengthv;
+        };
+
+        // include rays through or very close to the origin and along the polar axis to exercise the degenerate cases
+        size_t numRays = suite.scaled(20000);
+        Box box = grid2->boundingBox();
+        double total = 0.;
+        double deviation = 0.;
+        for (size_t i = 0; i != numRays; ++i)
+        {
+            Position bfr = random->position(box);
+            Direction bfk = random->direction();
+            if (i % 10 == 1) bfk = Direction(bfr / -bfr.norm());
+            if (i % 10 == 2) bfk = Direction(0., 0., bfr.z() > 0. ? -1. : 1.);
+            if (i % 10 == 3) bfr = Position(bfr.x() * 1e-9, bfr.y() * 1e-9, bfr.z());
+            Array lengthv1 = shellLengths(grid1, generator1.get(), bfr, bfk);
+            Array lengthv2 = shellLengths(grid2, generator2.get(), bfr, bfk);
+            total += lengthv1.sum();
+            deviation += abs(lengthv2 - lengthv1).sum();
+        }
+        suite.verify(lengthName, deviation / total, 1e-8);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // measures extinction opacity lookups for the specified material type in the specified fixture,
+    // for random cells and for random wavelengths between the specified limits
+    void measureOpacity(BenchmarkSuite& suite, string name, const Fixture& fixture, MaterialMix::MaterialType type,
+                        double minWavelength, double maxWavelength)
+    {
+        MediumSystem* ms = fixture.mediumSystem();
+        Random* random = fixture.random();
+
+        size_t n = suite.scaled(1000000);
+        vector<int> mv(n);
+        Array lambdav(n);
+        for (size_t i = 0; i != n; ++i)
+        {
+            mv[i] = min(static_cast<int>(random->uniform() * ms->numCells()), ms->numCells() - 1);
+            lambdav[i] = randomWavelength(random, minWavelength, maxWavelength);
+        }
+
+        suite.measure(name, n, [&]() {
+            double k = 0.;
+            for (size_t i = 0; i != n; ++i) k += ms->opacityExt(lambdav[i], mv[i], type);
+            keep(k);
+        });
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::materialMixes(BenchmarkSuite& suite)
+{
+    if (suite.isAnySelected({"mix/dust/opacityExt", "mix/electrons/opacityExt"}))
+    {
+        Fixture fixture(suite, "mixes", continuumSkiContents(gridSpecs[3].second));
+        measureOpacity(suite, "mix/dust/opacityExt", fixture, MaterialMix::MaterialType::Dust, 0.1e-6, 10e-6);
+        measureOpacity(suite, "mix/electrons/opacityExt", fixture, MaterialMix::MaterialType::Electrons, 0.1e-6,
+                       10e-6);
+    }
+    if (suite.isAnySelected({"mix/lya/opacityExt"}))
+    {
+        // use wavelengths covering the line core and the inner wings
+        Fixture fixture(suite, "lya", lyaSkiContents());
+        double lambda = Constants::lambdaLya();
+        measureOpacity(suite, "mix/lya/opacityExt", fixture, MaterialMix::MaterialType::Gas, 0.998 * lambda,
+                       1.002 * lambda);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::randomDeviates(BenchmarkSuite& suite)
+{
+    if (!suite.isAnySelected({"random/uniform", "random/gauss", "random/expon", "random/direction"})) return;
+
+    Fixture fixture(suite, "random", utilitySkiContents());
+    Random* random = fixture.random();
+    size_t n = suite.scaled(10000000);
+
+    suite.measure("random/uniform", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->uniform();
+        keep(s);
+    });
+    suite.measure("random/gauss", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->gauss();
+        keep(s);
+    });
+    suite.measure("random/expon", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->expon();
+        keep(s);
+    });
+    suite.measure("random/direction", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->direction().x();
+        keep(s);
+    });
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::cdfSampling(BenchmarkSuite& suite)
+{
+    if (!suite.isAnySelected({"cdf/construct", "cdf/linlin/binarySearch", "cdf/linlin/guideTable",
+                              "cdf/loglog/binarySearch", "cdf/loglog/guideTable"}))
+        return;
+
+    Fixture fixture(suite, "cdf", utilitySkiContents());
+    Random* random = fixture.random();
+
+    // tabulate a black-body-like distribution on a logarithmic grid with 1000 points
+    const int numPoints = 1000;
+    Array inxv, inpv;
+    NR::buildLogGrid(inxv, 0.01, 100., numPoints - 1);
+    inpv.resize(numPoints);
+    for (int i = 0; i != numPoints; ++i) inpv[i] = pow(inxv[i], 3) / (exp(inxv[i]) - 1.);
+    Range range(0.02, 50.);
+
+    // construction of the cumulative distribution
+    Array xv, pv, Pv;
+    size_t numConstruct = suite.scaled(20000);
+    suite.measure("cdf/construct", numConstruct, [&]() {
+        for (size_t i = 0; i != numConstruct; ++i) NR::cdf<NR::interpolateLogLog>(xv, pv, Pv, inxv, inpv, range);
+        keep(Pv[Pv.size() / 2]);
+    });
+
+    // sampling
+    Array linxv, linpv, linPv, logxv, logpv, logPv;
+    NR::cdf<NR::interpolateLinLin>(linxv, linpv, linPv, inxv, inpv, range);
+    NR::cdf<NR::interpolateLogLog>(logxv, logpv, logPv, inxv, inpv, range);
+    CdfSampler linSampler, logSampler;
+    linSampler.initLinLin(linxv, linPv);
+    logSampler.initLogLog(logxv, logpv, logPv);
+    size_t n = suite.scaled(2000000);
+
+    suite.measure("cdf/linlin/binarySearch", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->cdfLinLin(linxv, linPv);
+        keep(s);
+    });
+    suite.measure("cdf/linlin/guideTable", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->cdf(linSampler);
+        keep(s);
+    });
+    suite.measure("cdf/loglog/binarySearch", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->cdfLogLog(logxv, logpv, logPv);
+        keep(s);
+    });
+    suite.measure("cdf/loglog/guideTable", n, [&]() {
+        double s = 0.;
+        for (size_t i = 0; i != n; ++i) s += random->cdf(logSampler);
+        keep(s);
+    });
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::storedTables(BenchmarkSuite& suite)
+{
+    if (!suite.isAnySelected({"table/1D/interpolate", "table/2D/interpolate", "table/4D/interpolate", "table/2D/cdf",
+                              "table/4D/cdf"}))
+        return;
+
+    Fixture fixture(suite, "table", utilitySkiContents());
+    Random* random = fixture.random();
+
+    // generate the stored table files: an optical property as a function of wavelength and temperature,
+    // and a stellar atmosphere spectrum as a function of wavelength, metallicity, temperature and gravity
+    Array lambdav, Tv, Zv, Ttv, gv;
+    NR::buildLogGrid(lambdav, 1e-8, 1e-3, 1199);
+    NR::buildLogGrid(Tv, 3., 3e4, 199);
+    NR::buildLogGrid(Zv, 1e-4, 0.05, 5);
+    NR::buildLogGrid(Ttv, 3500., 5e4, 59);
+    NR::buildLogGrid(gv, 1., 1e5, 10);
+    auto value = [&lambdav, &Tv](double lambda, double T) {
+        double x = Constants::h() * Constants::c() / (lambda * Constants::k() * T);
+        return 1. / (pow(lambda, 5) * (exp(min(x, 700.)) - 1.)) + 1e-300;
+    };
+    string path1 = StringUtils::joinPaths(suite.workPath(), "skirtbench_table1.stab");
+    string path2 = StringUtils::joinPaths(suite.workPath(), "skirtbench_table2.stab");
+    string path4 = StringUtils::joinPaths(suite.workPath(), "skirtbench_table4.stab");
+    writeStoredTable(path1, {"lambda"}, {"m"}, {lambdav},
+                     [&](const vector<size_t>& i) { return value(lambdav[i[0]], 5000.); });
+    writeStoredTable(path2, {"lambda", "T"}, {"m", "K"}, {lambdav, Tv},
+                     [&](const vector<size_t>& i) { return value(lambdav[i[0]], Tv[i[1]]); });
+    writeStoredTable(path4, {"lambda", "Z", "T", "g"}, {"m", "1", "K", "m/s2"}, {lambdav, Zv, Ttv, gv},
+                     [&](const vector<size_t>& i) {
+                         return value(lambdav[i[0]], Ttv[i[2]]) * (1. + Zv[i[1]]) * (1. + 1e-3 * log(gv[i[3]]));
+                     });
+
+    // generate the random interpolation points
+    size_t n = suite.scaled(2000000);
+    Array xv(n), yv(n), Zrv(n), Trv(n), grv(n);
+    for (size_t i = 0; i != n; ++i)
+    {
+        xv[i] = randomWavelength(random, 1e-8, 1e-3);
+        yv[i] = randomWavelength(random, 3., 3e4);
+        Zrv[i] = randomWavelength(random, 1e-4, 0.05);
+        Trv[i] = randomWavelength(random, 3500., 5e4);
+        grv[i] = randomWavelength(random, 1., 1e5);
+    }
+
+    // interpolation
+    {
+        StoredTable<1> table1(fixture.simulation(), "skirtbench_table1", "lambda(m)", "Q(1)", true, false);
+        StoredTable<2> table2(fixture.simulation(), "skirtbench_table2", "lambda(m),T(K)", "Q(1)", true, false);
+        StoredTable<4> table4(fixture.simulation(), "skirtbench_table4", "lambda(m),Z(1),T(K),g(m/s2)", "Q(1)", true,
+                              false);
+        suite.measure("table/1D/interpolate", n, [&]() {
+            double s = 0.;
+            for (size_t i = 0; i != n; ++i) s += table1(xv[i]);
+            keep(s);
+        });
+        suite.measure("table/2D/interpolate", n, [&]() {
+            double s = 0.;
+            for (size_t i = 0; i != n; ++i) s += table2(xv[i], yv[i]);
+            keep(s);
+        });
+        suite.measure("table/4D/interpolate", n, [&]() {
+            double s = 0.;
+            for (size_t i = 0; i != n; ++i) s += table4(xv[i], Zrv[i], Trv[i], grv[i]);
+            keep(s);
+        });
+
+        // construction of the normalized spectrum across (most of) the wavelength range for random parameter values
+        size_t m = suite.scaled(2000);
+        Range range(1e-7, 1e-4);
+        Array lv, pv, Pv;
+        suite.measure("table/2D/cdf", m, [&]() {
+            double s = 0.;
+            for (size_t i = 0; i != m; ++i) s += table2.cdf(lv, pv, Pv, range, yv[i]);
+            keep(s);
+        });
+        suite.measure("table/4D/cdf", m, [&]() {
+            double s = 0.;
+            for (size_t i = 0; i != m; ++i) s += table4.cdf(lv, pv, Pv, range, Zrv[i], Trv[i], grv[i]);
+            keep(s);
+        });
+    }
+
+    // remove the stored table files after the tables have released them
+    System::removeFile(path1);
+    System::removeFile(path2);
+    System::removeFile(path4);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::fluxRecorder(BenchmarkSuite& suite)
+{
+    if (!suite.isAnySelected({"recorder/sed/detect", "recorder/sed/detectContended"})) return;
+
+    Fixture fixture(suite, "recorder", utilitySkiContents());
+    MonteCarloSimulation* simulation = fixture.simulation();
+    Random* random = fixture.random();
+
+    // configure a recorder for a spatially integrated SED on the default instrument wavelength grid
+    FluxRecorder recorder(simulation);
+    recorder.setSimulationInfo("skirtbench", simulation->instrumentSystem()->defaultWavelengthGrid(), false, false);
+    recorder.setUserFlags(false, 0, false, false);
+    recorder.setRestFrameDistance(10e6 * Constants::pc());
+    recorder.includeFluxDensity();
+    recorder.finalizeConfiguration();
+
+    // launch a set of photon packets with random wavelengths that are detected in turn
+    const size_t numPackets = 1024;
+    vector<PhotonPacket> ppv(numPackets);
+    for (size_t i = 0; i != numPackets; ++i)
+        ppv[i].launch(i, randomWavelength(random, 0.1e-6, 10e-6), 1., Position(), random->direction());
+
+    size_t n = suite.scaled(4000000);
+    suite.measure("recorder/sed/detect", n, [&]() {
+        for (size_t i = 0; i != n; ++i) recorder.detect(&ppv[i % numPackets], -1);
+    });
+
+    Parallel* parallel = simulation->parallelFactory()->parallelDistributed();
+    suite.measure(
+        "recorder/sed/detectContended", n,
+        [&]() {
+            parallel->call(n, [&](size_t firstIndex, size_t numIndices) {
+                for (size_t i = firstIndex; i != firstIndex + numIndices; ++i)
+                    recorder.detect(&ppv[i % numPackets], -1);
+            });
+        },
+        suite.numThreads());
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::lockFree(BenchmarkSuite& suite)
+{
+    if (!suite.isAnySelected({"lockfree/add/uncontended", "lockfree/add/shared", "lockfree/add/spread"})) return;
+
+    Fixture fixture(suite, "lockfree", utilitySkiContents());
+    Parallel* parallel = fixture.simulation()->parallelFactory()->parallelDistributed();
+
+    size_t n = suite.scaled(4000000);
+    const size_t numTargets = 4096;
+    Array targetv(numTargets);
+
+    suite.measure("lockfree/add/uncontended", n, [&]() {
+        for (size_t i = 0; i != n; ++i) LockFree::add(targetv[0], 1.);
+    });
+    suite.measure(
+        "lockfree/add/shared", n,
+        [&]() {
+            parallel->call(n, [&](size_t firstIndex, size_t numIndices) {
+                for (size_t i = firstIndex; i != firstIndex + numIndices; ++i) LockFree::add(targetv[0], 1.);
+            });
+        },
+        suite.numThreads());
+    suite.measure(
+        "lockfree/add/spread", n,
+        [&]() {
+            parallel->call(n, [&](size_t firstIndex, size_t numIndices) {
+                // scatter consecutive indices over the targets with a multiplicative hash
+                for (size_t i = firstIndex; i != firstIndex + numIndices; ++i)
+                    LockFree::add(targetv[(i * 2654435761u) % numTargets], 1.);
+            });
+        },
+        suite.numThreads());
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtBenchmarks::all(BenchmarkSuite& suite)
+{
+    spatialGrids(suite);
+    materialMixes(suite);
+    randomDeviates(suite);
+    cdfSampling(suite);
+    storedTables(suite);
+    fluxRecorder(suite);
+    lockFree(suite);
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,98 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef SKIRTBENCHMARKS_HPP
+#define SKIRTBENCHMARKS_HPP
+
+#include "Basics.hpp"
+class BenchmarkSuite;
+
+////////////////////////////////////////////////////////////////////
+
+/** This namespace contains the micro-benchmarks for the hot paths in the SKIRT photon transport
+    cycle. Each function in the namespace measures a group of related benchmarks through the
+    specified BenchmarkSuite instance, which also determines the benchmark selection and the amount
+    of work performed.
+
+    Benchmarks that require a simulation hierarchy construct a small simulation from an embedded ski
+    file serialization, perform setup for it, and then exercise the relevant functions of the
+    hierarchy directly. These simulations do not depend on any external resource files, and all
+    random positions, directions and wavelengths are generated from the simulation's random number
+    generator with a fixed seed before timing starts, so that consecutive invocations perform
+    identical work. */
+namespace SkirtBenchmarks
+{
+    /** This function measures path segment generation for each of the spatial grid types that can
+        be configured without input files (grid/<type>/pathSegments), and the optical depth
+        calculations performed by the MediumSystem::setOpticalDepths() and
+        MediumSystem::getOpticalDepth() functions for each of these grids
+        (medium/<type>/setOpticalDepths and medium/<type>/getOpticalDepth). Each operation
+        corresponds to a single ray with a random starting position inside the bounding box of the
+        grid and a random direction. In addition, the function measures the generation of a random
+        position inside a random cell of each grid (grid/<type>/randomPositionInCell). The accuracy
+        check check/<type>/pathCells verifies that the midpoint of each path segment lies in the
+        cell reported by the path segment generator, as determined by SpatialGrid::cellIndex().
+
+        For the three-dimensional grids, the function also measures the optical depth calculation
+        through the escape optical depth cache offered by the MediumSystem::getEscapeOpticalDepth()
+        function for the same starting positions and a fixed direction
+        (medium/<type>/getEscapeOpticalDepth). The accuracy check check/<type>/escapeOpticalDepth
+        verifies that the total luminosity transmitted along these paths agrees with the value
+        obtained through full path calculation within a relative tolerance of 0.1 per cent.
+
+        The accuracy checks check/Sphere2D/legacyCells and check/Sphere2D/legacyLength compare the
+        path segments through the 2D spherical grid for random rays with those produced by the
+        path segment generator used before the introduction of incremental boundary crossings,
+        which is retained in the benchmark code as a reference. The first check reports the
+        fraction of rays with a different sequence of cells, and the second one the relative
+        deviation of the path lengths in each cell for the other rays.
+
+        Finally, the accuracy check check/Sphere2D/pathLength verifies that the path lengths
+        through the radial shells of the 2D spherical grid, including those for rays passing
+        through or near the origin and along the polar axis, agree with those through the 1D
+        spherical grid with the same shell boundaries. */
+    void spatialGrids(BenchmarkSuite& suite);
+
+    /** This function measures the extinction opacity lookups for the dust, electron and
+        Lyman-alpha gas material mixes, through the corresponding MediumSystem::opacityExt()
+        functions (mix/<type>/opacityExt). Each operation corresponds to a lookup for a random cell
+        and a random wavelength. */
+    void materialMixes(BenchmarkSuite& suite);
+
+    /** This function measures the generation of uniform, Gaussian, and exponential random
+        deviates and of random isotropic directions by the Random class (random/<deviate>). */
+    void randomDeviates(BenchmarkSuite& suite);
+
+    /** This function measures the construction of a cumulative distribution function by the
+        NR::cdf() function (cdf/construct), and the sampling of random numbers from such
+        distributions through binary search (cdf/<scheme>/binarySearch) and through the guide
+        table offered by the CdfSampler class (cdf/<scheme>/guideTable), for both linear and
+        logarithmic interpolation schemes. */
+    void cdfSampling(BenchmarkSuite& suite);
+
+    /** This function measures interpolation in one-, two- and four-dimensional stored tables
+        (table/<N>D/interpolate), and the construction of a normalized distribution along the
+        first axis for a given set of values for the other axes (table/<N>D/cdf). The stored table
+        files are generated in the work directory and removed after use. */
+    void storedTables(BenchmarkSuite& suite);
+
+    /** This function measures the FluxRecorder::detect() function for a recorder configured to
+        record a spatially integrated SED, invoked from a single thread (recorder/sed/detect) and
+        concurrently from all threads (recorder/sed/detectContended). */
+    void fluxRecorder(BenchmarkSuite& suite);
+
+    /** This function measures the LockFree::add() function when invoked from a single thread
+        (lockfree/add/uncontended), concurrently from all threads on a single target
+        (lockfree/add/shared), and concurrently from all threads on a large number of targets
+        (lockfree/add/spread). */
+    void lockFree(BenchmarkSuite& suite);
+
+    /** This function invokes all of the benchmark functions in this namespace in order. */
+    void all(BenchmarkSuite& suite);
+}
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -15,6 +15,9 @@ void BlackBodySED::setupSelfBefore()
 
     _planck = new PlanckFunction(temperature());
     _Ltot = _planck->cdf(_lambdav, _pv, _Pv, normalizationWavelengthRange());
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLogLog(_lambdav, _pv, _Pv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -59,7 +62,7 @@ double BlackBodySED::integratedLuminosity(const Range& wavelengthRange) const
 
 double BlackBodySED::generateWavelength() const
 {
-    return random()->cdfLogLog(_lambdav, _pv, _Pv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
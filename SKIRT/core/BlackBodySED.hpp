@@ -7,6 +7,7 @@
 #define BLACKBODYSED_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SED.hpp"
 class PlanckFunction;
 
@@ -73,6 +74,7 @@ private:
     Array _lambdav;
     Array _pv;
     Array _Pv;
+    CdfSampler _sampler;
     double _Ltot{0};
 };
 
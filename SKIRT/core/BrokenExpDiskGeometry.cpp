@@ -41,6 +41,9 @@ void BrokenExpDiskGeometry::setupSelfBefore()
     double IR = _Xv[N - 1];
     _Xv /= IR;
 
+    // prepare for sampling the distribution in constant time
+    _sampler.initLinLin(_Rv, _Xv);
+
     // calculate _rho0;
 
     _rho0 = 1.0 / 4.0 / M_PI / _hz / IR;
@@ -79,7 +82,7 @@ double BrokenExpDiskGeometry::density(double R, double z) const
 
 double BrokenExpDiskGeometry::randomCylRadius() const
 {
-    return random()->cdfLinLin(_Rv, _Xv);
+    return random()->cdf(_sampler);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define BROKENEXPDISKGEOMETRY_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SepAxGeometry.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -133,6 +134,7 @@ private:
     double _SigmaR{0.};
     Array _Rv;
     Array _Xv;
+    CdfSampler _sampler;
 };
 
 ////////////////////////////////////////////////////////////////////
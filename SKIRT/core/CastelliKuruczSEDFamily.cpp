@@ -68,31 +68,62 @@ namespace
 
 double CastelliKuruczSEDFamily::specificLuminosity(double wavelength, const Array& parameters) const
 {
-    double R = parameters[0];
-    double Z = parameters[1];
-    double T = parameters[2];
-    double g = parameters[3];
-
-    // if needed, force the parameter values inside the valid portion of the grid
-    clampParameterValues(T, g);
+    double Z, T, g;
+    double area = decodeParameters(parameters, Z, T, g);
 
-    return 4. * M_PI * R * R * _table(wavelength, Z, T, g);
+    return area * _table(wavelength, Z, T, g);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double CastelliKuruczSEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                                     const Array& parameters) const
+{
+    double Z, T, g;
+    double area = decodeParameters(parameters, Z, T, g);
+
+    return area * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, T, g);
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t CastelliKuruczSEDFamily::numNodes() const
+{
+    return _table.numNodes();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void CastelliKuruczSEDFamily::nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const
+{
+    double Z, T, g;
+    double area = decodeParameters(parameters, Z, T, g);
+
+    _table.nodeWeights(nodes, Z, T, g);
+    for (auto& node : nodes) node.second *= area;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double CastelliKuruczSEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
+                                        size_t node) const
+{
+    return _table.nodeCdf(lambdav, pv, Pv, wavelengthRange, node);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double CastelliKuruczSEDFamily::decodeParameters(const Array& parameters, double& Z, double& T, double& g) const
 {
     double R = parameters[0];
-    double Z = parameters[1];
-    double T = parameters[2];
-    double g = parameters[3];
+    Z = parameters[1];
+    T = parameters[2];
+    g = parameters[3];
 
     // if needed, force the parameter values inside the valid portion of the grid
     clampParameterValues(T, g);
 
-    return 4. * M_PI * R * R * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, T, g);
+    return 4. * M_PI * R * R;
 }
 
 ////////////////////////////////////////////////////////////////////
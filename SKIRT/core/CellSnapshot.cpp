@@ -5,6 +5,7 @@
 
 #include "CellSnapshot.hpp"
 #include "Log.hpp"
+#include "MemoryRegistry.hpp"
 #include "NR.hpp"
 #include "Random.hpp"
 #include "StringUtils.hpp"
@@ -187,6 +188,11 @@ void CellSnapshot::readAndClose()
     // inform the user
     log()->info("  Number of cells: " + std::to_string(_propv.size()));
 
+    // report the memory allocated for the imported properties
+    if (!_propv.empty())
+        MemoryRegistry::add(log(), MemoryRegistry::Category::Snapshots,
+                            _propv.size() * (sizeof(Array) + _propv[0].size() * sizeof(double)));
+
     // if a mass density policy has been set, calculate masses and densities for all cells
     if (hasMassDensityPolicy())
     {
@@ -0,0 +1,154 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "Checkpoint.hpp"
+#include "Configuration.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
+#include "PersistentCache.hpp"
+#include "ProcessManager.hpp"
+#include "System.hpp"
+#include <cstdio>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the tags at the start and end of a checkpoint file
+    const char* headTag = "SKIRT K\n";
+    const char* tailTag = "CHECKEND";
+}
+
+////////////////////////////////////////////////////////////////////
+
+Checkpoint::Checkpoint(const SimulationItem* item) : _item(item)
+{
+    _path = item->find<FilePaths>()->output("checkpoint_" + std::to_string(ProcessManager::rank()) + ".dat");
+    _keyHash = PersistentCache::hashString(item->find<Configuration>()->checkpointKey());
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Checkpoint::beginWrite()
+{
+    _tmpPath = _path + ".tmp";
+    _out = System::ofstream(_tmpPath);
+    if (!_out) throw FATALERROR("Cannot create checkpoint file " + _tmpPath);
+    PersistentCache::writeTag(_out, headTag);
+    PersistentCache::writeSize(_out, ProcessManager::rank());
+    PersistentCache::writeSize(_out, ProcessManager::size());
+    PersistentCache::writeSize(_out, _keyHash);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Checkpoint::write(const Array& values)
+{
+    PersistentCache::writeArray(_out, values);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Checkpoint::write(double value)
+{
+    write(Array({value}));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Checkpoint::endWrite()
+{
+    PersistentCache::writeTag(_out, tailTag);
+    if (!_out) throw FATALERROR("Error while writing checkpoint file " + _tmpPath);
+    _out.close();
+
+    // move the file into place, replacing the previous checkpoint file
+    if (std::rename(_tmpPath.c_str(), _path.c_str()))
+        throw FATALERROR("Cannot move checkpoint file into place: " + _path);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool Checkpoint::beginRead()
+{
+    // open the file and verify the header
+    bool valid = false;
+    if (System::isFile(_path))
+    {
+        _in = System::ifstream(_path);
+        size_t tag, rank, size, keyHash;
+        valid = PersistentCache::readSize(_in, tag) && PersistentCache::readSize(_in, rank)
+                && PersistentCache::readSize(_in, size) && PersistentCache::readSize(_in, keyHash)
+                && PersistentCache::isTag(tag, headTag) && rank == static_cast<size_t>(ProcessManager::rank())
+                && size == static_cast<size_t>(ProcessManager::size()) && keyHash == _keyHash;
+    }
+
+    // make sure that all processes take the same decision
+    if (ProcessManager::isMultiProc())
+    {
+        Array numValid({valid ? 1. : 0.});
+        ProcessManager::sumToAll(numValid);
+        valid = numValid[0] == ProcessManager::size();
+    }
+    if (!valid && _in.is_open()) _in.close();
+    return valid;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Checkpoint::read(Array& values)
+{
+    size_t length;
+    if (!PersistentCache::readSize(_in, length) || PersistentCache::isTag(length, tailTag))
+        throw FATALERROR("Checkpoint file " + _path + " does not contain the expected data");
+    if (values.size() && values.size() != length)
+        throw FATALERROR("Checkpoint file " + _path + " does not match the simulation configuration");
+    if (values.size() != length) values.resize(length);
+    if (!PersistentCache::readValues(_in, values)) throw FATALERROR("Checkpoint file " + _path + " is truncated");
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool Checkpoint::readConsistent(Array& values)
+{
+    read(values);
+    if (!ProcessManager::isMultiProc()) return true;
+
+    // obtain the values read by the root process; adding zeros from the other processes is exact
+    Array rootValues(values.size());
+    if (ProcessManager::isRoot()) rootValues = values;
+    ProcessManager::sumToAll(rootValues);
+
+    // make sure that all processes take the same decision
+    bool same = true;
+    for (size_t i = 0; i != values.size(); ++i)
+        if (values[i] != rootValues[i]) same = false;
+    Array numSame({same ? 1. : 0.});
+    ProcessManager::sumToAll(numSame);
+    if (numSame[0] == ProcessManager::size()) return true;
+    _in.close();
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Checkpoint::read()
+{
+    Array values(1);
+    read(values);
+    return values[0];
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Checkpoint::endRead()
+{
+    size_t tag;
+    if (!PersistentCache::readSize(_in, tag) || !PersistentCache::isTag(tag, tailTag))
+        throw FATALERROR("Checkpoint file " + _path + " contains unexpected data");
+    _in.close();
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,99 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "Array.hpp"
+#include <fstream>
+class SimulationItem;
+
+////////////////////////////////////////////////////////////////////
+
+/** A Checkpoint instance manages the checkpoint file for the calling process in a simulation
+    that is being checkpointed so that it can be resumed after an interruption (see
+    MonteCarloSimulation). Each process writes and reads its own checkpoint file, so that the
+    processes can save the portions of the simulation state that are not synchronized between
+    processes (such as the partial radiation field accumulated during a segment) and so that the
+    checkpoint files can be written in parallel. The checkpoint file for a process is placed in
+    the output directory and named <tt>prefix_checkpoint_N.dat</tt>, where N is the rank of the
+    process.
+
+    A checkpoint file consists of a sequence of 8-byte items, written and read with the binary item
+    functions offered by the PersistentCache class: a tag, the rank of the process that wrote the
+    file, the number of processes, a hash of the key identifying the simulation configuration (see
+    Configuration::setCheckpointOptions()), and a sequence of arrays each consisting of its length followed
+    by its values, terminated by an end-of-file tag. The contents of the arrays is determined by the
+    client, which must read the arrays in the same order as they were written. To avoid leaving a corrupt
+    checkpoint file when the simulation is interrupted while writing, a new checkpoint file is
+    written under a temporary name and then renamed, replacing the previous checkpoint file. */
+class Checkpoint
+{
+public:
+    /** The constructor initializes a checkpoint for the calling process in the simulation
+        hierarchy containing the specified simulation item. */
+    explicit Checkpoint(const SimulationItem* item);
+
+    //================= Writing =================
+
+    /** This function starts writing a new checkpoint file under a temporary name. */
+    void beginWrite();
+
+    /** This function appends the specified array to the checkpoint file being written. */
+    void write(const Array& values);
+
+    /** This function appends the specified value to the checkpoint file being written, as an array
+        with a single element. */
+    void write(double value);
+
+    /** This function completes the checkpoint file being written and moves it into place,
+        replacing the previous checkpoint file, if any. */
+    void endWrite();
+
+    //================= Reading =================
+
+    /** This function opens the checkpoint file for reading and verifies its header. It must be
+        called by all processes at the same point in the execution flow. The function returns true
+        if a valid checkpoint file written with the same number of processes and the same
+        simulation configuration is available to all processes, and false otherwise. */
+    bool beginRead();
+
+    /** This function reads the next array from the checkpoint file into the specified array, as
+        the read() function, and verifies that the array read by each process holds the same
+        values. It must be called by all processes at the same point in the execution flow. The
+        function returns true if the arrays are identical. Otherwise, it closes the checkpoint file
+        and returns false in all processes. This allows detecting checkpoint files written by the
+        processes at different positions in the simulation, for example because the simulation was
+        interrupted after some but not all processes had moved their new checkpoint file into
+        place. */
+    bool readConsistent(Array& values);
+
+    /** This function reads the next array from the checkpoint file into the specified array. If
+        the array already has a nonzero size that differs from the size of the stored array, or if
+        there are no remaining arrays, the function throws a fatal error. */
+    void read(Array& values);
+
+    /** This function returns the next value in the checkpoint file, assuming that it has been
+        stored as an array with a single element through the write(double) function. */
+    double read();
+
+    /** This function verifies that all arrays in the checkpoint file have been read and closes
+        the file. */
+    void endRead();
+
+    //================= Data members =================
+
+private:
+    const SimulationItem* _item{nullptr};
+    string _path;     // the path of the checkpoint file for this process
+    string _tmpPath;  // the path of the temporary file being written
+    size_t _keyHash;  // the hash of the key identifying the simulation configuration
+    std::ofstream _out;
+    std::ifstream _in;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
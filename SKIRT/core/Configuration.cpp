@@ -83,6 +83,9 @@ void Configuration::setupSelfBefore()
         _minWeightReduction = ms->photonPacketOptions()->minWeightReduction();
         _minScattEvents = ms->photonPacketOptions()->minScattEvents();
         _pathLengthBias = ms->photonPacketOptions()->pathLengthBias();
+        _peelOffRouletteThreshold = ms->photonPacketOptions()->peelOffRouletteThreshold();
+        _tuneParameters = ms->photonPacketOptions()->tuneParameters();
+        _pilotFraction = ms->photonPacketOptions()->pilotFraction();
     }
 
     // retrieve extinction-only options
@@ -302,7 +305,7 @@ void Configuration::setupSelfAfter()
     if (_hasMovingMedia) log->info("  Including support for kinematics");
 
     // disable path length stretching if the wavelength of a photon packet can change during its lifetime
-    if ((_hasMovingMedia || _hubbleExpansionRate || _hasLymanAlpha) && _pathLengthBias > 0.)
+    if (!supportsPathLengthStretching() && _pathLengthBias > 0.)
     {
         log->warning("  Disabling path length stretching to allow Doppler shifts to be properly sampled");
         _pathLengthBias = 0.;
@@ -346,17 +349,64 @@ void Configuration::setupSelfAfter()
 
 ////////////////////////////////////////////////////////////////////
 
-void Configuration::setEmulationMode()
+void Configuration::setEmulationMode(double numPilotPackets)
 {
+    // remember the pilot packet count when called again from setupSelfBefore() with the default argument
+    if (numPilotPackets > 0.) _numPilotPackets = numPilotPackets;
+
+    // retain the configured launch and iteration settings
+    _configuredRunSize.numPrimaryPackets = _numPrimaryPackets;
+    _configuredRunSize.numDynamicStatePackets = _numDynamicStatePackets;
+    _configuredRunSize.numIterationPackets = _numIterationPackets;
+    _configuredRunSize.numSecondaryPackets = _numSecondaryPackets;
+    _configuredRunSize.hasDynamicState = _hasDynamicState;
+    _configuredRunSize.minDynamicStateIterations = _minDynamicStateIterations;
+    _configuredRunSize.maxDynamicStateIterations = _maxDynamicStateIterations;
+    _configuredRunSize.minIterations = _minIterations;
+    _configuredRunSize.maxIterations = _maxIterations;
+
+    // override them
     _emulationMode = true;
-    _numPrimaryPackets = 0.;
-    _numIterationPackets = 0.;
-    _numSecondaryPackets = 0.;
+    _numPrimaryPackets = min(_numPrimaryPackets, _numPilotPackets);
+    _numIterationPackets = min(_numIterationPackets, _numPilotPackets);
+    _numSecondaryPackets = min(_numSecondaryPackets, _numPilotPackets);
     _hasDynamicState = false;
     _minIterations = 1;
     _maxIterations = 1;
 }
 
+////////////////////////////////////////////////////////////////////
+
+void Configuration::setPredictionLayout(int numThreads, int numProcesses)
+{
+    _predictionThreadCount = max(numThreads, 0);
+    _predictionProcessCount = max(numProcesses, 0);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Configuration::setMediumSetupKey(string key)
+{
+    _mediumSetupKey = key;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Configuration::setCheckpointOptions(double interval, bool resume, string key)
+{
+    _checkpointInterval = interval;
+    _resumeFromCheckpoint = resume;
+    _checkpointKey = key;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Configuration::setMaxRepackedTableValues(size_t maxValues)
+{
+    _maxRepackedTableValues = maxValues;
+}
+
+
 ////////////////////////////////////////////////////////////////////
 
 namespace
@@ -59,8 +59,44 @@ public:
     /** This function puts the simulation in emulation mode. Specifically, it sets a flag that can
         be queried by other simulation items, it sets the number of photon packets to zero, and if
         iteration over the simulation state is enabled, it forces the number of iterations to one.
-        */
-    void setEmulationMode();
+
+        If the specified number of pilot photon packets is positive, the number of photon packets
+        launched in each simulation segment is limited to that number rather than set to zero, so
+        that the emulated run can serve as a pilot for predicting the run time of the actual
+        simulation (see RuntimePredictor). In both cases, the launch and iteration settings
+        configured by the user are retained and can be retrieved through the configuredRunSize()
+        function. */
+    void setEmulationMode(double numPilotPackets = 0.);
+
+    /** This function sets the parallelization layout for which the run time of the actual
+        simulation is predicted from an emulated pilot run (see RuntimePredictor), i.e. the number
+        of threads per process and the number of processes. A value of zero indicates that the
+        corresponding number should be taken from the pilot run itself, which is the default. */
+    void setPredictionLayout(int numThreads, int numProcesses);
+
+    /** This function sets a key identifying the configuration of the medium system. Simulations
+        with the same nonempty key (e.g. variants in a parameter sweep that differ only in their
+        sources or instruments) are assumed to produce the same initial medium state, so that the
+        medium system can share this state between them through the in-memory PersistentCache
+        store. The key is empty by default, in which case the medium state is never shared. */
+    void setMediumSetupKey(string key);
+
+    /** This function configures checkpointing for the simulation (see MonteCarloSimulation). If
+        the specified interval (in seconds of wall-clock time) is positive, a checkpoint is written
+        whenever this interval has elapsed since the start of the run or since the previous
+        checkpoint. If the \em resume flag is true, the simulation resumes from the checkpoint
+        written by a previous run with the same configuration, if available. The \em key
+        identifies the configuration of the simulation (e.g., a serialization of the simulation
+        hierarchy loaded from the ski file); a checkpoint written with a different key is not
+        used for resuming. By default, checkpointing is disabled. */
+    void setCheckpointOptions(double interval, bool resume, string key);
+
+    /** This function sets the maximum number of values in a stored table for which the values of
+        a quantity are repacked in memory to speed up interpolation (see StoredTable). A value of
+        zero disables repacking. The default limit is \f$2^{23}\f$ values, i.e. 64 MB. Because the
+        repacked values are shared by all simulations in a process, the limit in effect for the
+        first simulation that opens a given table determines whether it is repacked. */
+    void setMaxRepackedTableValues(size_t maxValues);
 
     //=========== Getters for configuration properties ============
 
@@ -68,6 +104,57 @@ public:
     /** Returns true if the simulation has been put in emulation mode. */
     bool emulationMode() const { return _emulationMode; }
 
+    /** Returns the maximum number of photon packets launched per simulation segment in emulation
+        mode, or zero if the emulated run does not launch any photon packets. */
+    double numPilotPackets() const { return _numPilotPackets; }
+
+    /** Returns the number of threads per process for which the run time is predicted from an
+        emulated pilot run, or zero if this number should be taken from the pilot run. */
+    int predictionThreadCount() const { return _predictionThreadCount; }
+
+    /** Returns the number of processes for which the run time is predicted from an emulated pilot
+        run, or zero if this number should be taken from the pilot run. */
+    int predictionProcessCount() const { return _predictionProcessCount; }
+
+    /** This structure holds the launch and iteration settings of a simulation, as returned by the
+        configuredRunSize() function. */
+    struct RunSize
+    {
+        double numPrimaryPackets{0.};
+        double numDynamicStatePackets{0.};
+        double numIterationPackets{0.};
+        double numSecondaryPackets{0.};
+        bool hasDynamicState{false};
+        int minDynamicStateIterations{1};
+        int maxDynamicStateIterations{1};
+        int minIterations{1};
+        int maxIterations{1};
+    };
+
+    /** In emulation mode, returns the launch and iteration settings configured by the user before
+        they were overridden by the setEmulationMode() function. Outside of emulation mode, the
+        returned values are meaningless. */
+    const RunSize& configuredRunSize() const { return _configuredRunSize; }
+
+    /** Returns the key identifying the configuration of the medium system for sharing the initial
+        medium state between simulations, or the empty string if the state should not be shared. */
+    string mediumSetupKey() const { return _mediumSetupKey; }
+
+    /** Returns the wall-clock time interval (in seconds) between checkpoints, or zero if no
+        checkpoints should be written. */
+    double checkpointInterval() const { return _checkpointInterval; }
+
+    /** Returns true if the simulation should resume from a previously written checkpoint. */
+    bool resumeFromCheckpoint() const { return _resumeFromCheckpoint; }
+
+    /** Returns the key identifying the configuration of the simulation for checkpointing
+        purposes. */
+    string checkpointKey() const { return _checkpointKey; }
+
+    /** Returns the maximum number of values in a stored table for which the values of a quantity
+        are repacked in memory. */
+    size_t maxRepackedTableValues() const { return _maxRepackedTableValues; }
+
     /** Returns the redshift at which the model resides, or zero if the model resides in the Local
         Universe. */
     double redshift() const { return _redshift; }
@@ -151,6 +238,21 @@ public:
         distribution. */
     double pathLengthBias() const { return _pathLengthBias; }
 
+    /** Returns true if path length stretching is supported by the simulation, i.e. if the
+        wavelength of a photon packet cannot change during its lifetime, and false otherwise. */
+    bool supportsPathLengthStretching() const { return !_hasMovingMedia && !_hubbleExpansionRate && !_hasLymanAlpha; }
+
+    /** Returns the fraction of a photon packet's launch luminosity below which a peel-off photon
+        packet is subject to Russian roulette, or zero if peel-off roulette is disabled. */
+    double peelOffRouletteThreshold() const { return _peelOffRouletteThreshold; }
+
+    /** Returns true if the photon life-cycle parameters should be tuned in a pilot run before the
+        primary emission segment, false if not. */
+    bool tuneParameters() const { return _tuneParameters; }
+
+    /** Returns the fraction of the number of primary photon packets launched in the pilot run. */
+    double pilotFraction() const { return _pilotFraction; }
+
     /** Returns the number of random density samples for determining spatial cell mass. */
     int numDensitySamples() const { return _numDensitySamples; }
 
@@ -332,6 +434,15 @@ public:
 private:
     // general
     bool _emulationMode{false};
+    double _numPilotPackets{0.};
+    int _predictionThreadCount{0};
+    int _predictionProcessCount{0};
+    RunSize _configuredRunSize;
+    string _mediumSetupKey;
+    double _checkpointInterval{0.};
+    bool _resumeFromCheckpoint{false};
+    string _checkpointKey;
+    size_t _maxRepackedTableValues{8 * 1024 * 1024};
 
     // cosmology parameters
     double _redshift{0.};
@@ -356,6 +467,9 @@ private:
     double _minWeightReduction{1e4};
     int _minScattEvents{0};
     double _pathLengthBias{0.5};
+    double _peelOffRouletteThreshold{0.};
+    bool _tuneParameters{false};
+    double _pilotFraction{0.05};
     int _numDensitySamples{100};
 
     // radiation field
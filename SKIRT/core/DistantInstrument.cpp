@@ -7,6 +7,8 @@
 #include "Configuration.hpp"
 #include "FatalError.hpp"
 #include "FluxRecorder.hpp"
+#include "MediumSystem.hpp"
+#include "SpatialGrid.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -51,11 +53,53 @@ void DistantInstrument::setupSelfBefore()
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // minimum instrument distance, in units of the diagonal of the spatial domain, for caching escape optical depths
+    const double minEscapeCacheDistance = 100.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DistantInstrument::setupSelfAfter()
+{
+    Instrument::setupSelfAfter();
+
+    auto config = find<Configuration>();
+    if (cacheEscapeOpticalDepths() && config->hasMedium())
+    {
+        if (config->hasDynamicState()
+            || !(config->hasSingleConstantSectionMedium() || config->hasMultipleConstantSectionMedia()))
+            throw FATALERROR("Caching escape optical depths requires a static medium state with spatially constant "
+                             "cross sections");
+
+        // in grids with rotational symmetry, a cell extends around the symmetry axis, so that a single path
+        // near the cell center cannot represent the paths from other positions in the cell
+        auto ms = find<MediumSystem>();
+        if (ms->grid()->dimension() != 3)
+            throw FATALERROR("Caching escape optical depths requires a spatial grid without symmetries");
+
+        // the cached column densities represent parallel paths to the boundary of the spatial domain,
+        // so the instrument must be much farther away than the size of the domain
+        double size = ms->grid()->boundingBox().widths().norm();
+        if (distance() > 0. && distance() < minEscapeCacheDistance * size)
+            throw FATALERROR("Caching escape optical depths requires an instrument distance of at least "
+                             + std::to_string(static_cast<int>(minEscapeCacheDistance))
+                             + " times the diagonal of the spatial domain");
+
+        int cacheIndex = ms->cacheEscapeOpticalDepths(_bfkobs);
+        instrumentFluxRecorder()->setEscapeOpticalDepthCache(cacheIndex);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void DistantInstrument::determineSameObserverAsPreceding(const Instrument* precedingInstrument)
 {
     auto other = dynamic_cast<const DistantInstrument*>(precedingInstrument);
     if (other && distance() == other->distance() && inclination() == other->inclination()
-        && azimuth() == other->azimuth() && roll() == other->roll())
+        && azimuth() == other->azimuth() && roll() == other->roll()
+        && cacheEscapeOpticalDepths() == other->cacheEscapeOpticalDepths())
     {
         setSameObserverAsPreceding();
     }
@@ -83,6 +83,11 @@ class DistantInstrument : public Instrument
         ATTRIBUTE_DEFAULT_VALUE(roll, "0 deg")
         ATTRIBUTE_DISPLAYED_IF(roll, "Level2&(Dimension2|Dimension3)")
 
+        PROPERTY_BOOL(cacheEscapeOpticalDepths, "precalculate the optical depth towards the instrument for each cell")
+        ATTRIBUTE_DEFAULT_VALUE(cacheEscapeOpticalDepths, "false")
+        ATTRIBUTE_RELEVANT_IF(cacheEscapeOpticalDepths, "!NoMedium")
+        ATTRIBUTE_DISPLAYED_IF(cacheEscapeOpticalDepths, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
@@ -91,12 +96,26 @@ protected:
     /** This function pre-calculates the directions that need to be returned by the instrument. */
     void setupSelfBefore() override;
 
+    /** If the \em cacheEscapeOpticalDepths flag is enabled and the simulation includes media, this
+        function asks the medium system to calculate the column densities towards the instrument for
+        each spatial cell and each medium component, and configures the flux recorder to use this
+        cache. The function throws a fatal error if the medium state may change during the
+        simulation, if the cross sections of the media are not spatially constant, if the
+        spatial grid has a rotational symmetry (in which case a cell extends around the symmetry
+        axis), or if the instrument distance is nonzero but smaller than 100 times the diagonal of
+        the spatial domain (in which case the paths towards the instrument cannot be considered
+        to be parallel). */
+    void setupSelfAfter() override;
+
     //======================== Other Functions =======================
 
 public:
     /** This function determines whether the specified instrument has the same observer type,
         position and viewing direction as the receiving instrument, and if so, calls the
-        setSameObserverAsPreceding() function to remember the fact. */
+        setSameObserverAsPreceding() function to remember the fact. Instruments with a different
+        setting for the \em cacheEscapeOpticalDepths flag are never considered to be the same
+        observer, because the optical depth calculated for one of them must not be reused for the
+        other. */
     void determineSameObserverAsPreceding(const Instrument* precedingInstrument) override;
 
     /** Returns the direction towards the observer, expressed in model coordinates. The provided
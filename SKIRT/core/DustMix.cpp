@@ -7,6 +7,7 @@
 #include "Configuration.hpp"
 #include "Log.hpp"
 #include "MaterialState.hpp"
+#include "MemoryRegistry.hpp"
 #include "NR.hpp"
 #include "PhotonPacket.hpp"
 #include "Random.hpp"
@@ -125,6 +126,10 @@ void DustMix::setupSelfAfter()
             NR::cdf(_thetaXvv[ell], maxTheta, [this, ell](int t) { return _S11vv(ell, t + 1) * sin(_thetav[t + 1]); });
         }
 
+        // prepare for sampling these distributions in constant time
+        _thetaSamplerv.resize(numLambda);
+        for (int ell = 0; ell != numLambda; ++ell) _thetaSamplerv[ell].initLinLin(_thetav, _thetaXvv[ell]);
+
         // create a table with the phase function normalization factor for each wavelength
         _pfnormv.resize(numLambda);
         for (int ell = 0; ell != numLambda; ++ell)
@@ -187,6 +192,7 @@ void DustMix::setupSelfAfter()
 
     allocatedBytes += allocatedSize * sizeof(double) + _calc.allocatedBytes();
     find<Log>()->info(type() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
+    MemoryRegistry::add(this, MemoryRegistry::Category::Mixes, allocatedBytes);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -444,7 +450,7 @@ double DustMix::phaseFunctionValueForCosine(double lambda, double costheta) cons
 
 double DustMix::generateCosineFromPhaseFunction(double lambda) const
 {
-    return cos(random()->cdfLinLin(_thetav, _thetaXvv[indexForLambda(lambda)]));
+    return cos(random()->cdf(_thetaSamplerv[indexForLambda(lambda)]));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -465,7 +471,7 @@ std::pair<double, double> DustMix::generateAnglesFromPhaseFunction(double lambda
     int ell = indexForLambda(lambda);
 
     // sample from the normalized cumulative distribution of theta for this wavelength
-    double theta = random()->cdfLinLin(_thetav, _thetaXvv[ell]);
+    double theta = random()->cdf(_thetaSamplerv[ell]);
     int t = indexForTheta(theta);
 
     // construct and sample from the normalized cumulative distribution of phi for this wavelength and theta angle
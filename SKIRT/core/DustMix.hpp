@@ -7,6 +7,7 @@
 #define DUSTMIX_HPP
 
 #include "ArrayTable.hpp"
+#include "CdfSampler.hpp"
 #include "EquilibriumDustEmissionCalculator.hpp"
 #include "MaterialMix.hpp"
 #include "Table.hpp"
@@ -457,12 +458,13 @@ private:
     Table<2> _S34vv;  // indexed on ell,t
 
     // precalculated discretizations of (functions of) the scattering angles
-    ArrayTable<2> _thetaXvv;  // indexed on ell and t
-    Array _pfnormv;           // indexed on ell
-    Array _phiv;              // indexed on f
-    Array _phi1v;             // indexed on f
-    Array _phisv;             // indexed on f
-    Array _phicv;             // indexed on f
+    ArrayTable<2> _thetaXvv;             // indexed on ell and t
+    vector<CdfSampler> _thetaSamplerv;  // indexed on ell
+    Array _pfnormv;                      // indexed on ell
+    Array _phiv;                         // indexed on f
+    Array _phi1v;                        // indexed on f
+    Array _phisv;                        // indexed on f
+    Array _phicv;                        // indexed on f
 
     // precalculated discretizations for spheroidal grains as a function of the emission angle
     ArrayTable<2> _sigmaabsvv;     // indexed on ell and t
@@ -33,6 +33,9 @@ void EinastoGeometry::setupSelfBefore()
     }
     _Xv[0] = 0.0;
     _Xv[N - 1] = 1.0;
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLinLin(_rv, _Xv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -46,7 +49,7 @@ double EinastoGeometry::density(double r) const
 
 double EinastoGeometry::randomRadius() const
 {
-    return random()->cdfLinLin(_rv, _Xv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define EINASTOGEOMETRY_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SpheGeometry.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -77,6 +78,7 @@ private:
     double _rhos{0.};
     Array _rv;
     Array _Xv;
+    CdfSampler _sampler;
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -15,6 +15,9 @@ void FamilySED::setupSelfBefore()
 
     _family = getFamilyAndParameters(_parameters);
     _Ltot = _family->cdf(_lambdav, _pv, _Pv, normalizationWavelengthRange(), _parameters);
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLogLog(_lambdav, _pv, _Pv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -52,7 +55,7 @@ double FamilySED::integratedLuminosity(const Range& wavelengthRange) const
 
 double FamilySED::generateWavelength() const
 {
-    return random()->cdfLogLog(_lambdav, _pv, _Pv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define FAMILYSED_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SED.hpp"
 class SEDFamily;
 
@@ -68,6 +69,7 @@ private:
     Array _lambdav;
     Array _pv;
     Array _Pv;
+    CdfSampler _sampler;
     double _Ltot{0};
 };
 
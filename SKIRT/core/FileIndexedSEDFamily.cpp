@@ -34,9 +34,8 @@ Range FileIndexedSEDFamily::intrinsicWavelengthRange() const
 
 double FileIndexedSEDFamily::specificLuminosity(double wavelength, const Array& parameters) const
 {
-    double index = parameters[0];
-    // ignore negative indices as per the API
-    if (index < 0)
+    double index;
+    if (!decodeParameters(parameters, index))
     {
         return 0.;
     }
@@ -51,9 +50,8 @@ double FileIndexedSEDFamily::specificLuminosity(double wavelength, const Array&
 double FileIndexedSEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                                  const Array& parameters) const
 {
-    double index = parameters[0];
-    // ignore negative indices as per the API
-    if (index < 0)
+    double index;
+    if (!decodeParameters(parameters, index))
     {
         return 0.;
     }
@@ -66,3 +64,39 @@ double FileIndexedSEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Ran
 }
 
 ////////////////////////////////////////////////////////////////////
+
+size_t FileIndexedSEDFamily::numNodes() const
+{
+    return _table.numNodes();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FileIndexedSEDFamily::nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const
+{
+    double index;
+    if (!decodeParameters(parameters, index))
+        nodes.clear();
+    else
+        _table.nodeWeights(nodes, index);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double FileIndexedSEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
+                                     size_t node) const
+{
+    return _table.nodeCdf(lambdav, pv, Pv, wavelengthRange, node);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool FileIndexedSEDFamily::decodeParameters(const Array& parameters, double& index) const
+{
+    index = parameters[0];
+
+    // ignore negative indices as per the API
+    return index >= 0;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -232,6 +232,27 @@ string FilePaths::outputPrefix() const
 
 ////////////////////////////////////////////////////////////////////
 
+void FilePaths::setCachePath(string value)
+{
+    if (value.empty())
+    {
+        _cachePath.clear();
+        return;
+    }
+    if (!System::isDir(value) && !System::makeDir(value))
+        throw FATALERROR("Cache path does not exist and cannot be created: " + value);
+    _cachePath = System::canonicalPath(value) + "/";
+}
+
+////////////////////////////////////////////////////////////////////
+
+string FilePaths::cachePath() const
+{
+    return _cachePath;
+}
+
+////////////////////////////////////////////////////////////////////
+
 string FilePaths::output(string name) const
 {
     return _outputPath + _outputPrefix + "_" + name;
@@ -115,6 +115,15 @@ public:
         filename are separated by an underscore. */
     string output(string name) const;
 
+    /** Sets the (absolute or relative) path for the directory holding the persistent cache of
+        derived data that can be reused by subsequent simulations (see PersistentCache). An empty
+        string (the default value) means that the cache is disabled. */
+    void setCachePath(string value);
+
+    /** Returns the (absolute or relative) path for the persistent cache directory, or the empty
+        string if the cache is disabled. */
+    string cachePath() const;
+
     //======================== Resource files =======================
 
 public:
@@ -158,6 +167,7 @@ private:
     string _inputPath;
     string _outputPath;
     string _outputPrefix;
+    string _cachePath;
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -37,9 +37,8 @@ Range FileSSPSEDFamily::intrinsicWavelengthRange() const
 
 double FileSSPSEDFamily::specificLuminosity(double wavelength, const Array& parameters) const
 {
-    double M = parameters[0] / Constants::Msun();
-    double Z = parameters[1];
-    double t = parameters[2] / Constants::year();
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
 
     return M * _table(wavelength, Z, t);
 }
@@ -49,11 +48,44 @@ double FileSSPSEDFamily::specificLuminosity(double wavelength, const Array& para
 double FileSSPSEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                              const Array& parameters) const
 {
-    double M = parameters[0] / Constants::Msun();
-    double Z = parameters[1];
-    double t = parameters[2] / Constants::year();
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
 
     return M * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, t);
 }
 
 ////////////////////////////////////////////////////////////////////
+
+size_t FileSSPSEDFamily::numNodes() const
+{
+    return _table.numNodes();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FileSSPSEDFamily::nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const
+{
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
+
+    _table.nodeWeights(nodes, Z, t);
+    for (auto& node : nodes) node.second *= M;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double FileSSPSEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange, size_t node) const
+{
+    return _table.nodeCdf(lambdav, pv, Pv, wavelengthRange, node);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double FileSSPSEDFamily::decodeParameters(const Array& parameters, double& Z, double& t) const
+{
+    Z = parameters[1];
+    t = parameters[2] / Constants::year();
+    return parameters[0] / Constants::Msun();
+}
+
+////////////////////////////////////////////////////////////////////
@@ -4,10 +4,13 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "FluxRecorder.hpp"
+#include "Checkpoint.hpp"
 #include "FITSInOut.hpp"
 #include "LockFree.hpp"
 #include "Log.hpp"
 #include "MediumSystem.hpp"
+#include "MemoryRegistry.hpp"
+#include "ParallelFactory.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
 #include "StringUtils.hpp"
@@ -109,6 +112,13 @@ void FluxRecorder::includeSurfaceBrightness(int numPixelsX, int numPixelsY, doub
 
 ////////////////////////////////////////////////////////////////////
 
+void FluxRecorder::setEscapeOpticalDepthCache(int cacheIndex)
+{
+    _escapeCacheIndex = cacheIndex;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void FluxRecorder::finalizeConfiguration()
 {
     // get a pointer to the medium system, if present
@@ -173,6 +183,14 @@ void FluxRecorder::finalizeConfiguration()
         for (auto& array : _wifu) array.resize(lenIFU);
     }
 
+    // distribute the pages of the large IFU arrays over the NUMA nodes, one wavelength plane at a time
+    if (_includeSurfaceBrightness)
+    {
+        auto parfac = _parentItem->find<ParallelFactory>();
+        for (auto& array : _ifu) parfac->firstTouch(array, _lambdagrid->numBins());
+        for (auto& array : _wifu) parfac->firstTouch(array, _lambdagrid->numBins());
+    }
+
     // calculate and log allocated memory size
     size_t allocatedSize = 0;
     for (const auto& array : _sed) allocatedSize += array.size();
@@ -181,6 +199,7 @@ void FluxRecorder::finalizeConfiguration()
     for (const auto& array : _wifu) allocatedSize += array.size();
     _parentItem->find<Log>()->info(_parentItem->typeAndName() + " allocated "
                                    + StringUtils::toMemSizeString(allocatedSize * sizeof(double)) + " of memory");
+    MemoryRegistry::add(_parentItem, MemoryRegistry::Category::Detectors, allocatedSize * sizeof(double));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -222,12 +241,26 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
             }
             else
             {
-                tau = _ms->getOpticalDepth(pp, distance);
+                tau = _escapeCacheIndex >= 0 ? _ms->getEscapeOpticalDepth(_escapeCacheIndex, pp, distance)
+                                             : _ms->getOpticalDepth(pp, distance);
                 pp->setObservedOpticalDepth(tau);
             }
             Lext *= exp(-tau);
         }
 
+        // in pilot mode, accumulate the contribution for this history rather than recording it
+        if (_pilot)
+        {
+            PilotTally* tally = _pilotTallies.local();
+            if (tally->historyIndex != pp->historyIndex())
+            {
+                recordPilotTally(tally);
+                tally->historyIndex = pp->historyIndex();
+            }
+            tally->w += Lext;
+            continue;
+        }
+
         // get number of scatterings (because we use it a lot)
         int numScatt = pp->numScatt();
 
@@ -339,6 +372,156 @@ void FluxRecorder::flush()
 
 ////////////////////////////////////////////////////////////////////
 
+void FluxRecorder::beginPilot()
+{
+    _pilot = true;
+    _pilotSum = 0.;
+    _pilotSum2 = 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::pair<double, double> FluxRecorder::endPilot()
+{
+    // record the dangling tallies from all threads
+    for (PilotTally* tally : _pilotTallies.all())
+    {
+        recordPilotTally(tally);
+        tally->historyIndex = std::numeric_limits<size_t>::max();
+    }
+    _pilot = false;
+    return std::make_pair(_pilotSum, _pilotSum2);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::recordPilotTally(PilotTally* tally)
+{
+    if (tally->w)
+    {
+        LockFree::add(_pilotSum, tally->w);
+        LockFree::add(_pilotSum2, tally->w * tally->w);
+        tally->w = 0.;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns true if any of the values in any of the specified arrays is nonzero
+    bool hasNonZeroValue(const vector<Array>& arrays)
+    {
+        for (const Array& array : arrays)
+            for (double value : array)
+                if (value) return true;
+        return false;
+    }
+
+    // multiplies the portion of each array that was added since the corresponding snapshot by the specified factor,
+    // or multiplies the complete array if there is no snapshot; the factor is raised to the power of the array index
+    // if requested (for statistics arrays) and to the power of 1 otherwise
+    void scaleSinceSnapshot(vector<Array>& arrays, const vector<Array>& snapshots, double factor, bool statistics)
+    {
+        double fn = statistics ? 1. : factor;
+        for (size_t k = 0; k != arrays.size(); ++k)
+        {
+            if (snapshots.empty())
+                arrays[k] *= fn;
+            else
+                arrays[k] = snapshots[k] + (arrays[k] - snapshots[k]) * fn;
+            if (statistics) fn *= factor;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::beginSegment()
+{
+    if (hasNonZeroValue(_sed) || hasNonZeroValue(_ifu) || hasNonZeroValue(_wsed) || hasNonZeroValue(_wifu))
+    {
+        _sedSnapshot = _sed;
+        _ifuSnapshot = _ifu;
+        _wsedSnapshot = _wsed;
+        _wifuSnapshot = _wifu;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+Array FluxRecorder::segmentStatistics() const
+{
+    if (!_recordStatistics || !_includeFluxDensity) return Array();
+
+    int numWavelengths = _lambdagrid->numBins();
+    Array sums(numWavelengths * (maxContributionPower + 1));
+    for (int ell = 0; ell != numWavelengths; ++ell)
+        for (int k = 0; k <= maxContributionPower; ++k)
+            sums[ell * (maxContributionPower + 1) + k] =
+                _wsed[k][ell] - (_wsedSnapshot.empty() ? 0. : _wsedSnapshot[k][ell]);
+    return sums;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::scaleSegment(double weightFactor)
+{
+    scaleSinceSnapshot(_sed, _sedSnapshot, weightFactor, false);
+    scaleSinceSnapshot(_ifu, _ifuSnapshot, weightFactor, false);
+    scaleSinceSnapshot(_wsed, _wsedSnapshot, weightFactor, true);
+    scaleSinceSnapshot(_wifu, _wifuSnapshot, weightFactor, true);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::endSegment(double weightFactor)
+{
+    if (weightFactor != 1.) scaleSegment(weightFactor);
+    _sedSnapshot.clear();
+    _ifuSnapshot.clear();
+    _wsedSnapshot.clear();
+    _wifuSnapshot.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::calibrateAndWriteIntermediate(double weightFactor)
+{
+    // remember the current detector arrays, which are modified by scaling and calibration
+    vector<Array> sed = _sed;
+    vector<Array> ifu = _ifu;
+    vector<Array> wsed = _wsed;
+    vector<Array> wifu = _wifu;
+
+    scaleSegment(weightFactor);
+    calibrateAndWrite();
+
+    // restore the detector arrays
+    _sed = std::move(sed);
+    _ifu = std::move(ifu);
+    _wsed = std::move(wsed);
+    _wifu = std::move(wifu);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::writeCheckpoint(Checkpoint* checkpoint) const
+{
+    for (const auto& arrays : {&_sed, &_ifu, &_wsed, &_wifu})
+        for (const Array& array : *arrays) checkpoint->write(array);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::readCheckpoint(Checkpoint* checkpoint)
+{
+    for (auto& arrays : {&_sed, &_ifu, &_wsed, &_wifu})
+        for (Array& array : *arrays) checkpoint->read(array);
+}
+
+////////////////////////////////////////////////////////////////////
+
 void FluxRecorder::calibrateAndWrite()
 {
     // collect recorded data from all processes
@@ -9,6 +9,7 @@
 #include "Array.hpp"
 #include "ThreadLocalMember.hpp"
 #include <tuple>
+class Checkpoint;
 class MediumSystem;
 class PhotonPacket;
 class SimulationItem;
@@ -166,6 +167,14 @@ public:
     void includeSurfaceBrightness(int numPixelsX, int numPixelsY, double pixelSizeX, double pixelSizeY, double centerX,
                                   double centerY, bool convertToAngularSize);
 
+    /** This function configures the recorder to obtain the optical depth towards the observer from
+        the escape optical depth cache with the specified index offered by the medium system (see
+        MediumSystem::cacheEscapeOpticalDepths()), rather than tracing the full path for each
+        detected photon packet. The caller is responsible for ensuring that the cache has been
+        calculated for the direction towards the observer. This function may be called at any time
+        before the first invocation of the detect() function. */
+    void setEscapeOpticalDepthCache(int cacheIndex);
+
     /** This function completes the configuration of the recorder. It must be called after any of
         the configuration functions, and before the first invocation of the detect() function. */
     void finalizeConfiguration();
@@ -198,6 +207,21 @@ public:
         actually destructed, the flush() function should be called from a single thread. */
     void flush();
 
+    /** This function puts the recorder in pilot mode, which is used to measure the statistical
+        properties of the recorded flux for tuning purposes (see MonteCarloSimulation::runPilot()).
+        In pilot mode, the detect() function performs all calculations as usual, including the
+        extinction along the path to the instrument, but rather than recording the contributions in
+        the detector arrays, it accumulates the sum \f$w_i\f$ of all contributions for each photon
+        packet history \f$i\f$ (regardless of wavelength or pixel). This function is not
+        thread-safe. */
+    void beginPilot();
+
+    /** This function ends pilot mode (see beginPilot()) and returns the sums \f$\sum_i w_i\f$ and
+        \f$\sum_i w_i^2\f$ over all photon packet histories detected in the calling process since
+        pilot mode was entered. Like the flush() function, it must be called from a single thread
+        after the parallel threads have completed their work. */
+    std::pair<double, double> endPilot();
+
     /** This function calibrates and outputs the instrument data. The calibration includes dividing
         the luminosities (W) recorded for each bin by the wavelength bin width to obtain specific
         luminosities (W/m) and further conversion to flux density (incorporating distance) and/or
@@ -210,6 +234,48 @@ public:
         documentation in the header of this class. */
     void calibrateAndWrite();
 
+    /** This function marks the start of a photon packet segment for which the recorded
+        contributions may need to be rescaled afterwards, for example because the segment is
+        terminated before all photon packets have been launched (see
+        InstrumentSystem::stopAtConvergence). If any information has been recorded before, the
+        function takes a snapshot of the detector arrays so that the contributions recorded during
+        the segment can be distinguished from the earlier ones. This temporarily doubles the memory
+        requirements of the recorder. This function is not thread-safe. */
+    void beginSegment();
+
+    /** This function returns the sums \f$\sum_i w_i^k\f$, with \f$k=0,\dots,4\f$, of the
+        contributions to each %SED wavelength bin recorded in the calling process since the start of
+        the current segment (see beginSegment()). The sums for wavelength bin \f$\ell\f$ are stored
+        at indices \f$5\ell+k\f$. If the recorder does not record %SED statistics, the function
+        returns an empty array. The flush() function should be called before invoking this
+        function. */
+    Array segmentStatistics() const;
+
+    /** This function ends the current segment (see beginSegment()) and multiplies the weight of all
+        contributions recorded since the start of the segment by the specified factor. For the
+        detector arrays that need to be calibrated, this amounts to multiplying the segment
+        contributions by the factor. For the statistics arrays with the sums \f$\sum_i w_i^k\f$,
+        the segment contributions are multiplied by the factor to the power \f$k\f$. The
+        snapshot, if any, is released. This function is not thread-safe. */
+    void endSegment(double weightFactor);
+
+    /** This function calibrates and outputs the instrument data as if the current segment were
+        ended with the specified weight factor, while leaving the detector arrays and the segment
+        state unchanged, so that the recording can continue. This allows writing intermediate
+        results for monitoring purposes. Because it uses a temporary copy of the detector arrays,
+        the function temporarily requires additional memory. The output files have the same names
+        as the final output and are overwritten at the end of the simulation. */
+    void calibrateAndWriteIntermediate(double weightFactor);
+
+    /** This function appends the uncalibrated detector arrays recorded by the calling process to
+        the specified checkpoint. The flush() function should be called before invoking this
+        function. */
+    void writeCheckpoint(Checkpoint* checkpoint) const;
+
+    /** This function restores the detector arrays written by the writeCheckpoint() function from
+        the specified checkpoint. */
+    void readCheckpoint(Checkpoint* checkpoint);
+
     //================= Private Types and Functions ===============
 
 private:
@@ -252,6 +318,22 @@ private:
         specified list into the statistics arrays. */
     void recordContributions(ContributionList* contributionList);
 
+    /** Private data structure to accumulate the total contribution of the current photon packet
+        history in pilot mode. */
+    struct PilotTally
+    {
+        size_t historyIndex{std::numeric_limits<size_t>::max()};
+        double w{0.};
+    };
+
+    /** This private helper function adds the total contribution of the history in the specified
+        tally to the pilot sums and resets the tally. */
+    void recordPilotTally(PilotTally* tally);
+
+    /** This private helper function multiplies the weight of the contributions recorded since the
+        start of the current segment by the specified factor, without releasing the snapshot. */
+    void scaleSegment(double weightFactor);
+
     //======================== Data Members ========================
 
 private:
@@ -270,6 +352,8 @@ private:
     bool _includeFluxDensity{false};
     bool _includeSurfaceBrightness{false};
 
+    int _escapeCacheIndex{-1};  // index of the escape optical depth cache in the medium system, or -1 if none
+
     // recorder configuration on distance and redshift, received from client during configuration
     double _redshift{0};
     double _angularDiameterDistance{0};
@@ -300,6 +384,18 @@ private:
 
     // thread-local contribution list
     ThreadLocalMember<ContributionList> _contributionLists;
+
+    // pilot mode flag, sums of contributions and their squares, and thread-local tally
+    bool _pilot{false};
+    double _pilotSum{0.};
+    double _pilotSum2{0.};
+    ThreadLocalMember<PilotTally> _pilotTallies;
+
+    // snapshots of the detector arrays at the start of the current segment (empty if nothing was recorded before)
+    vector<Array> _sedSnapshot;
+    vector<Array> _ifuSnapshot;
+    vector<Array> _wsedSnapshot;
+    vector<Array> _wifuSnapshot;
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -31,6 +31,9 @@ void GaussianGeometry::setupSelfBefore()
         _Xv[i] = erf(t) - M_2_SQRTPI * t * exp(-t * t);
     }
     _Xv[N - 1] = 1.0;
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLinLin(_rv, _Xv);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -46,7 +49,7 @@ double GaussianGeometry::density(double r) const
 
 double GaussianGeometry::randomRadius() const
 {
-    return random()->cdfLinLin(_rv, _Xv);
+    return random()->cdf(_sampler);
 }
 
 ////////////////////////////////////////////////////////////////////
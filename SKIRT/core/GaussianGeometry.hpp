@@ -7,6 +7,7 @@
 #define GAUSSIANGEOMETRY_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SpheGeometry.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -67,6 +68,7 @@ private:
     double _rho0{0.};
     Array _rv;
     Array _Xv;
+    CdfSampler _sampler;
 };
 
 ////////////////////////////////////////////////////////////////////
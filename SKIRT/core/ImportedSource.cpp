@@ -8,6 +8,7 @@
 #include "Constants.hpp"
 #include "FatalError.hpp"
 #include "Log.hpp"
+#include "MemoryRegistry.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -18,6 +19,8 @@
 #include "Snapshot.hpp"
 #include "VelocityInterface.hpp"
 #include "WavelengthGrid.hpp"
+#include <iterator>
+#include <mutex>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -25,6 +28,24 @@ namespace
 {
     // maximum number of luminosity calculations between two invocations of infoIfElapsed()
     const size_t logProgressChunkSize = 10000;
+
+    // maximum number of bytes (per process) allocated for caching the spectra of SED family grid nodes
+    const size_t maxNodeCacheBytes = 256 * 1024 * 1024;
+
+    // merges the sorted node indices in the second list into the sorted first list, removing duplicates;
+    // if the merged list holds more than the specified number of nodes, clears it and sets the flag to false
+    void mergeNodes(vector<size_t>& nodev, const vector<size_t>& addedv, size_t maxNumNodes, bool& cacheNodes)
+    {
+        vector<size_t> mergedv;
+        mergedv.reserve(nodev.size() + addedv.size());
+        std::set_union(nodev.begin(), nodev.end(), addedv.begin(), addedv.end(), std::back_inserter(mergedv));
+        nodev.swap(mergedv);
+        if (nodev.size() > maxNumNodes)
+        {
+            nodev.clear();
+            cacheNodes = false;
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -74,14 +95,38 @@ void ImportedSource::setupSelfAfter()
     int M = _snapshot->numEntities();
     if (M)
     {
+        auto log = find<Log>();
+
+        // we accumulate the aggregate spectrum of all entities on the wavelength grid of the first entity;
+        // if an entity has a different wavelength grid, the aggregate spectrum is not available
+        {
+            Array params, pv, Pv;
+            _snapshot->parameters(0, params);
+            _sedFamily->cdf(_lambdav, pv, Pv, _wavelengthRange, params);
+        }
+        Array aggregatev(_lambdav.size());
+        Array mismatchv(1);  // the number of entities with a different wavelength grid
+
+        // if the SED family supports it, we also collect the sorted indices of the grid nodes used by the entities
+        // so that we can cache their spectra; we stop collecting as soon as the cache would exceed the memory budget
+        bool supportsNodes = _sedFamily->numNodes() > 0;
+        bool cacheNodes = supportsNodes;  // shared by all threads; modified only while holding the mutex
+        size_t maxNumNodes = maxNodeCacheBytes / ((2 * _lambdav.size() + 1) * sizeof(double) + sizeof(size_t));
+        vector<size_t> usedNodev;
+        std::mutex mutex;  // guards the accumulators shared by all threads
+
         // integrating over the SED for each entity can be time-consuming, so we do this in parallel
         _Lv.resize(M);
-        auto log = find<Log>();
         log->info("Calculating luminosities for " + std::to_string(M) + " imported entities...");
         log->infoSetElapsed(M);
-        find<ParallelFactory>()->parallelDistributed()->call(M, [this, log](size_t firstIndex, size_t numIndices) {
-            Array lambdav, pv, Pv;  // the contents of these arrays is not used, so this could be optimized if needed
+        find<ParallelFactory>()->parallelDistributed()->call(M, [&](size_t firstIndex, size_t numIndices) {
+            Array lambdav, pv, Pv;
             Array params;
+            Array sumv(_lambdav.size());
+            size_t numMismatches = 0;
+            vector<std::pair<size_t, double>> nodes;
+            vector<size_t> nodev;
+            bool collectNodes = supportsNodes;
 
             while (numIndices)
             {
@@ -89,23 +134,143 @@ void ImportedSource::setupSelfAfter()
                 for (size_t m = firstIndex; m != firstIndex + currentChunkSize; ++m)
                 {
                     _snapshot->parameters(m, params);
-                    _Lv[m] = _sedFamily->cdf(lambdav, pv, Pv, _wavelengthRange, params);
+                    double L = _sedFamily->cdf(lambdav, pv, Pv, _wavelengthRange, params);
+                    _Lv[m] = L;
+                    if (L > 0)
+                    {
+                        if (lambdav.size() == _lambdav.size()
+                            && std::equal(begin(lambdav), end(lambdav), begin(_lambdav)))
+                            sumv += L * pv;
+                        else
+                            numMismatches++;
+                        if (collectNodes)
+                        {
+                            _sedFamily->nodeWeights(params, nodes);
+                            for (const auto& node : nodes) nodev.push_back(node.first);
+                        }
+                    }
+                }
+                std::sort(nodev.begin(), nodev.end());
+                nodev.erase(std::unique(nodev.begin(), nodev.end()), nodev.end());
+                if (nodev.size() > maxNumNodes)
+                {
+                    nodev.clear();
+                    collectNodes = false;
                 }
                 log->infoIfElapsed("Calculated luminosities: ", currentChunkSize);
                 firstIndex += currentChunkSize;
                 numIndices -= currentChunkSize;
             }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            aggregatev += sumv;
+            mismatchv[0] += numMismatches;
+            if (!collectNodes) cacheNodes = false;
+            if (cacheNodes) mergeNodes(usedNodev, nodev, maxNumNodes, cacheNodes);
         });
         ProcessManager::sumToAll(_Lv);
+        ProcessManager::sumToAll(aggregatev);
+        ProcessManager::sumToAll(mismatchv);
+
+        // combine the used grid nodes across processes; the first item flags whether the budget was exceeded
+        if (ProcessManager::isMultiProc())
+        {
+            vector<size_t> localNodev = usedNodev;
+            bool localCacheNodes = cacheNodes;
+            auto producer = [&localNodev, localCacheNodes](vector<double>& data) {
+                data.push_back(localCacheNodes ? 1. : 0.);
+                for (size_t node : localNodev) data.push_back(node);
+            };
+            auto consumer = [&usedNodev, &cacheNodes, maxNumNodes](const vector<double>& data) {
+                if (data.empty() || !data[0]) cacheNodes = false;
+                if (cacheNodes)
+                    mergeNodes(usedNodev, vector<size_t>(data.begin() + 1, data.end()), maxNumNodes, cacheNodes);
+            };
+            ProcessManager::broadcastAllToAll(producer, consumer);
+        }
 
         // remember the total luminosity and normalize the vector
         _L = _Lv.sum();
         if (_L) _Lv /= _L;
+
+        // remember the aggregate spectrum if it is available
+        if (!mismatchv[0] && _lambdav.size() > 1)
+        {
+            _aggregatev = aggregatev;
+            MemoryRegistry::add(this, MemoryRegistry::Category::Snapshots, 2 * _lambdav.size() * sizeof(double));
+        }
+
+        // cache the spectra for the used grid nodes, if supported and within the memory budget
+        if (cacheNodes)
+            cacheNodeSpectra(usedNodev);
+        else if (supportsNodes)
+            log->info("Not caching spectra for SED family grid nodes because this would exceed the memory budget");
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+void ImportedSource::cacheNodeSpectra(const vector<size_t>& nodev)
+{
+    auto log = find<Log>();
+
+    // the caller guarantees that the cache fits within the memory budget
+    size_t K = nodev.size();
+    size_t n = _lambdav.size();
+    if (!K || n < 2) return;
+
+    // calculate the spectra in parallel, packing the pdf, cdf and normalization factor for each node into a single
+    // array so that the results can be combined across processes; a negative normalization factor flags a node for
+    // which the wavelength grid differs from the shared grid
+    log->info("Caching spectra for " + std::to_string(K) + " SED family grid nodes...");
+    size_t stride = 2 * n + 1;
+    Array packedv(stride * K);
+    find<ParallelFactory>()->parallelDistributed()->call(K, [this, &nodev, &packedv, n, stride](size_t firstIndex,
+                                                                                                size_t numIndices) {
+        Array lambdav, pv, Pv;
+        for (size_t k = firstIndex; k != firstIndex + numIndices; ++k)
+        {
+            double N = _sedFamily->nodeCdf(lambdav, pv, Pv, _wavelengthRange, nodev[k]);
+            double* target = begin(packedv) + k * stride;
+            if (lambdav.size() == n && std::equal(begin(lambdav), end(lambdav), begin(_lambdav)))
+            {
+                if (N > 0)
+                {
+                    std::copy(begin(pv), end(pv), target);
+                    std::copy(begin(Pv), end(Pv), target + n);
+                    target[2 * n] = N;
+                }
+            }
+            else
+                target[2 * n] = -1.;
+        }
+    });
+    ProcessManager::sumToAll(packedv);
+
+    // unpack the nodes with a nonzero spectrum, giving up if any of the nodes has a different wavelength grid
+    for (size_t k = 0; k != K; ++k)
+        if (packedv[k * stride + 2 * n] < 0)
+        {
+            log->info("Not caching spectra for SED family grid nodes because the wavelength grids differ");
+            return;
+        }
+    for (size_t k = 0; k != K; ++k)
+    {
+        double N = packedv[k * stride + 2 * n];
+        if (N > 0)
+        {
+            _nodev.push_back(nodev[k]);
+            _nodeNv.push_back(N);
+            _nodepvv.emplace_back(packedv[std::slice(k * stride, n, 1)]);
+            _nodePvv.emplace_back(packedv[std::slice(k * stride + n, n, 1)]);
+        }
+    }
+    MemoryRegistry::add(this, MemoryRegistry::Category::Snapshots,
+                        _nodev.size() * ((2 * n + 1) * sizeof(double) + sizeof(size_t)));
+}
+
+////////////////////////////////////////////////////////////////////
+
 ImportedSource::~ImportedSource()
 {
     delete _snapshot;
@@ -157,6 +322,14 @@ double ImportedSource::specificLuminosity(double wavelength) const
 {
     if (!_wavelengthRange.containsFuzzy(wavelength)) return 0.;
 
+    // use the aggregate spectrum if it is available; in between the grid wavelengths this approximates the sum
+    // of the entity spectra, which are interpolated individually by the SED family
+    if (_aggregatev.size())
+    {
+        wavelength = max(_lambdav[0], min(_lambdav[_lambdav.size() - 1], wavelength));
+        return NR::value<NR::interpolateLogLog>(wavelength, _lambdav, _aggregatev);
+    }
+
     Array params;
     double sum = 0.;
     int M = _snapshot->numEntities();
@@ -238,6 +411,100 @@ namespace
     thread_local EntitySED t_sed;
 }
 
+namespace
+{
+    // an instance of this class holds the mixture of cached grid node spectra for a single entity, i.e. the cache
+    // index and the normalized mixture weight for each of the grid nodes involved in the interpolation of its SED
+    class EntityMixture
+    {
+    private:
+        // these two variables unambiguously identify a particular entity, even with multiple imported sources
+        int _m{-1};                          // entity index
+        const Snapshot* _snapshot{nullptr};  // snapshot
+        Array _params;                       // entity parameters
+        vector<std::pair<size_t, double>> _nodes;
+        vector<int> _cv;     // cache index for each node in the mixture
+        vector<double> _wv;  // normalized mixture weight for each node in the mixture
+        Array _sv;           // normalized specific luminosity of the entity at each grid wavelength, or -1 if unknown
+
+    public:
+        EntityMixture() {}
+
+        // sets the mixture from the SED family and the cache if this is a different entity or snapshot;
+        // returns false if the mixture is empty
+        bool setIfNeeded(int m, const Snapshot* snapshot, const SEDFamily* family, const vector<size_t>& nodev,
+                         const vector<double>& nodeNv, size_t numWavelengths)
+        {
+            if (m != _m || snapshot != _snapshot)
+            {
+                snapshot->parameters(m, _params);
+                family->nodeWeights(_params, _nodes);
+                _cv.clear();
+                _wv.clear();
+                _sv.resize(numWavelengths, -1.);
+                double sum = 0.;
+                for (const auto& node : _nodes)
+                {
+                    auto it = std::lower_bound(nodev.begin(), nodev.end(), node.first);
+                    if (it != nodev.end() && *it == node.first)
+                    {
+                        int c = it - nodev.begin();
+                        double w = node.second * nodeNv[c];
+                        _cv.push_back(c);
+                        _wv.push_back(w);
+                        sum += w;
+                    }
+                }
+                if (sum > 0)
+                    for (double& w : _wv) w /= sum;
+                else
+                    _cv.clear();
+                _snapshot = snapshot;
+                _m = m;
+            }
+            return !_cv.empty();
+        }
+
+        // returns the specific luminosity of the entity's SED at the grid wavelength with the given index, divided
+        // by the given entity luminosity; the value is calculated on first use and cached for the current entity
+        double specificLuminosity(int i, const SEDFamily* family, const Array& lambdav, double L)
+        {
+            if (_sv[i] < 0.) _sv[i] = family->specificLuminosity(lambdav[i], _params) / L;
+            return _sv[i];
+        }
+
+        // returns the cache index of a random node selected according to the mixture weights
+        int generateNode(Random* random) const
+        {
+            double X = random->uniform();
+            size_t last = _cv.size() - 1;
+            for (size_t i = 0; i != last; ++i)
+            {
+                X -= _wv[i];
+                if (X < 0) return _cv[i];
+            }
+            return _cv[last];
+        }
+
+        // returns the normalized specific luminosity of the mixture for the given wavelength,
+        // which must be in the interval with the given index of the given wavelength grid
+        double specificLuminosity(double lambda, int i, const Array& lambdav, const vector<Array>& pvv) const
+        {
+            double sum = 0.;
+            for (size_t k = 0; k != _cv.size(); ++k)
+            {
+                const Array& pv = pvv[_cv[k]];
+                sum += _wv[k] * NR::interpolateLogLog(lambda, lambdav[i], lambdav[i + 1], pv[i], pv[i + 1]);
+            }
+            return sum;
+        }
+    };
+
+    // setup a mixture instance for each parallel execution thread; this works even if
+    // there are multiple sources of this type because each thread handles a single photon packet at a time
+    thread_local EntityMixture t_mixture;
+}
+
 namespace
 {
     // an instance of this class offers the velocity interface for an imported entity
@@ -279,39 +546,74 @@ void ImportedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) con
     // calculate the weight related to biased source selection
     double ws = _Lv[m] / _Wv[m];
 
-    // get the normalized regular and cumulative distributions for this entity, if not already available
-    t_sed.setIfNeeded(m, _snapshot, _sedFamily, _wavelengthRange);
-
     // generate a random wavelength from the SED and/or from the bias distribution
     double lambda, w;
-    if (!_xi)
+    if (!_nodev.empty() && t_mixture.setIfNeeded(m, _snapshot, _sedFamily, _nodev, _nodeNv, _lambdav.size()))
     {
-        // no biasing -- simply use the intrinsic spectral distribution
-        lambda = t_sed.generateWavelength(random());
-        w = 1.;
+        // sample a wavelength from the mixture of cached node spectra for this entity or from the bias distribution
+        if (!_xi || random()->uniform() > _xi)
+        {
+            int c = t_mixture.generateNode(random());
+            lambda = random()->cdfLogLog(_lambdav, _nodepvv[c], _nodePvv[c]);
+        }
+        else
+            lambda = _biasDistribution->generateWavelength();
+
+        // calculate the normalized specific luminosity of the entity's SED (interpolated between the wavelength grid
+        // points in the same way as for the spectrum calculated by the SED family) and that of the mixture
+        double s = 0.;
+        double q = 0.;
+        int i = NR::locateFail(_lambdav, lambda);
+        if (i >= 0)
+        {
+            double Lm = _Lv[m] * _L;
+            double s1 = t_mixture.specificLuminosity(i, _sedFamily, _lambdav, Lm);
+            double s2 = t_mixture.specificLuminosity(i + 1, _sedFamily, _lambdav, Lm);
+            s = NR::interpolateLogLog(lambda, _lambdav[i], _lambdav[i + 1], s1, s2);
+            q = t_mixture.specificLuminosity(lambda, i, _lambdav, _nodepvv);
+        }
+
+        // calculate the compensating weight factor for sampling from the mixture rather than from the entity's SED,
+        // combined with the composite bias weight; if the wavelength can't occur in the intrinsic distribution,
+        // the weight factor is zero regardless of the probability in the sampling distribution
+        double b = _xi ? _biasDistribution->probability(lambda) : 0.;
+        double d = (1 - _xi) * q + _xi * b;
+        w = s > 0 && d > 0 ? s / d : 0.;
     }
     else
     {
-        // biasing -- use one or the other distribution
-        if (random()->uniform() > _xi)
-            lambda = t_sed.generateWavelength(random());
-        else
-            lambda = _biasDistribution->generateWavelength();
+        // get the normalized regular and cumulative distributions for this entity, if not already available
+        t_sed.setIfNeeded(m, _snapshot, _sedFamily, _wavelengthRange);
 
-        // calculate the compensating weight factor
-        double s = t_sed.specificLuminosity(lambda);
-        if (!s)
+        if (!_xi)
         {
-            // if the wavelength can't occur in the intrinsic distribution,
-            // the weight factor is zero regardless of the probability in the bias distribution
-            // (handling this separately also avoids NaNs in the pathological case s=b=0)
-            w = 0.;
+            // no biasing -- simply use the intrinsic spectral distribution
+            lambda = t_sed.generateWavelength(random());
+            w = 1.;
         }
         else
         {
-            // regular composite bias weight
-            double b = _biasDistribution->probability(lambda);
-            w = s / ((1 - _xi) * s + _xi * b);
+            // biasing -- use one or the other distribution
+            if (random()->uniform() > _xi)
+                lambda = t_sed.generateWavelength(random());
+            else
+                lambda = _biasDistribution->generateWavelength();
+
+            // calculate the compensating weight factor
+            double s = t_sed.specificLuminosity(lambda);
+            if (!s)
+            {
+                // if the wavelength can't occur in the intrinsic distribution,
+                // the weight factor is zero regardless of the probability in the bias distribution
+                // (handling this separately also avoids NaNs in the pathological case s=b=0)
+                w = 0.;
+            }
+            else
+            {
+                // regular composite bias weight
+                double b = _biasDistribution->probability(lambda);
+                w = s / ((1 - _xi) * s + _xi * b);
+            }
         }
     }
 
@@ -78,9 +78,22 @@ protected:
 
         Finally, the function constructs a vector with the luminosities (integrated over the
         primary source wavelength range) for all imported entities. This information is used when
-        deciding how many photon packets should be launched from each entity. */
+        deciding how many photon packets should be launched from each entity. In the same pass, the
+        function accumulates the aggregate spectrum of all entities, which is used by the
+        specificLuminosity() function, and, if the %SED family supports it, determines the nodes of
+        the family's parameter grid involved in the interpolation of the entity spectra, which are
+        passed to the cacheNodeSpectra() function. */
     void setupSelfAfter() override;
 
+    /** This function calculates and caches the normalized spectra for the %SED family grid nodes
+        with the indices in the specified sorted list, for use by the launch() function. The
+        spectra are calculated in parallel and shared by all execution threads. The caller
+        collects the list sparsely and guarantees that the cache fits within a fixed memory budget;
+        if it does not, this function is not called. If the wavelength grids of the node spectra
+        differ, no spectra are cached. In both cases, photon packets are launched from the
+        individual entity spectra instead. */
+    void cacheNodeSpectra(const vector<size_t>& nodev);
+
     /** This function constructs a new Snapshot object of the type appropriate for the subclass,
         calls its open() function, and returns a pointer to the object. Ownership of the Snapshot
         object is transferred to the caller. */
@@ -115,7 +128,14 @@ public:
     /** This function returns the specific luminosity \f$L_\lambda\f$ (i.e. radiative power per
          unit of wavelength) of the source at the specified wavelength, or zero if the wavelength is
          outside the wavelength range of primary sources (configured for the source system as a
-         whole) or if the source simply does not emit at the wavelength. */
+         whole) or if the source simply does not emit at the wavelength.
+
+         If all entities share the same wavelength grid, the function log-log interpolates the
+         aggregate spectrum accumulated on that grid during setup, clamping the wavelength to the
+         grid's range. This is an approximation: the result is exact at the grid wavelengths, but in
+         between it may deviate slightly from the sum of the individually interpolated entity
+         spectra. Otherwise, the function sums the exact specific luminosities obtained from the
+         %SED family for all entities. */
     double specificLuminosity(double wavelength) const override;
 
     /** This function performs some preparations for launching photon packets. It is called in
@@ -141,19 +161,31 @@ public:
          given history index and luminosity contribution. It proceeds as follows.
 
          First, the function finds the entity index that corresponding to the history index using
-         the map constructed by the prepareForLaunch() function. It obtains the normalized spectral
-         distribition (and the corresponding cumulative distribution) for that entity from the SED
-         family configured for this source. In fact, the function sets up a thread-local object
-         that caches the spectral distribution for an entity between consecutive invocations of the
-         launch() function. This works even if there are multiple sources of this type because each
-         thread handles a single photon packet at a time.
-
-         Subsequently, the function samples a wavelength from the entity's SED, properly handling
-         the configured wavelength biasing, and asks the Snapshot object to generate a random
-         launch position for the entity. If the importVelocity flag is enabled, the function also
-         constructs an object that serves a RedshiftInterface appropriate for the velocity of the
-         entity. Again, this object is allocated in thread-local storage so that it stays around
-         after being handed to the photon packet.
+         the map constructed by the prepareForLaunch() function.
+
+         If spectra for the %SED family grid nodes have been cached during setup, the function
+         samples a wavelength from the mixture of the cached spectra for the grid nodes involved in
+         the interpolation of the entity's %SED, with mixture weights proportional to the
+         interpolation weight times the luminosity of each node, possibly combined with the
+         configured wavelength bias distribution. The photon packet weight is multiplied by the
+         ratio of the entity's normalized specific luminosity and the probability of the sampling
+         distribution at the sampled wavelength, so that the result is unbiased. For families that
+         interpolate linearly in the tabulated luminosities, the mixture closely matches the
+         entity's %SED, so that this ratio is close to unity.
+
+         Otherwise, the function obtains the normalized spectral distribition (and the
+         corresponding cumulative distribution) for that entity from the SED family configured for
+         this source. In fact, the function sets up a thread-local object that caches the spectral
+         distribution for an entity between consecutive invocations of the launch() function. This
+         works even if there are multiple sources of this type because each thread handles a single
+         photon packet at a time. The function then samples a wavelength from the entity's SED,
+         properly handling the configured wavelength biasing.
+
+         Subsequently, the function asks the Snapshot object to generate a random launch position
+         for the entity. If the importVelocity flag is enabled, the function also constructs an
+         object that serves a RedshiftInterface appropriate for the velocity of the entity. Again,
+         this object is allocated in thread-local storage so that it stays around after being
+         handed to the photon packet.
 
          Finally, the function causes the photon packet to be launched with the information
          described above and an isotropic launch direction. */
@@ -174,6 +206,14 @@ private:
     double _L{0};  // the total bolometric luminosity of all entities (absolute number)
     Array _Lv;     // the relative bolometric luminosity of each entity (normalized to unity)
 
+    // spectral information initialized during setup
+    Array _lambdav;           // the wavelength grid shared by the aggregate and cached spectra
+    Array _aggregatev;        // the aggregate specific luminosity of all entities (empty if not available)
+    vector<size_t> _nodev;   // the sorted indices of the cached SED family grid nodes (empty if there is no cache)
+    vector<double> _nodeNv;  // the normalization factor (luminosity) for each cached node spectrum
+    vector<Array> _nodepvv;  // the normalized pdf for each cached node spectrum
+    vector<Array> _nodePvv;  // the normalized cdf for each cached node spectrum
+
     // intialized by prepareForLaunch()
     Array _Wv;           // the relative launch weight for each entity (normalized to unity)
     vector<size_t> _Iv;  // first history index allocated to each entity (with extra entry at the end)
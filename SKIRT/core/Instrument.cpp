@@ -7,6 +7,9 @@
 #include "Configuration.hpp"
 #include "FatalError.hpp"
 #include "FluxRecorder.hpp"
+#include "Log.hpp"
+#include "ProcessManager.hpp"
+#include "StringUtils.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -61,9 +64,87 @@ void Instrument::flush()
 
 ////////////////////////////////////////////////////////////////////
 
+void Instrument::beginPilot()
+{
+    _recorder->beginPilot();
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::pair<double, double> Instrument::endPilot()
+{
+    _numRoulettePlayed = 0;
+    _numRouletteSurvived = 0;
+    return _recorder->endPilot();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Instrument::beginSegment()
+{
+    _recorder->beginSegment();
+}
+
+////////////////////////////////////////////////////////////////////
+
+Array Instrument::segmentStatistics() const
+{
+    return _recorder->segmentStatistics();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Instrument::endSegment(double weightFactor)
+{
+    _recorder->endSegment(weightFactor);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Instrument::writeIntermediate(double weightFactor)
+{
+    _recorder->calibrateAndWriteIntermediate(weightFactor);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Instrument::writeCheckpoint(Checkpoint* checkpoint) const
+{
+    _recorder->writeCheckpoint(checkpoint);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Instrument::readCheckpoint(Checkpoint* checkpoint)
+{
+    _recorder->readCheckpoint(checkpoint);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Instrument::recordPeelOffRoulette(bool survived)
+{
+    _numRoulettePlayed.fetch_add(1, std::memory_order_relaxed);
+    if (survived) _numRouletteSurvived.fetch_add(1, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////
+
 void Instrument::write()
 {
     _recorder->calibrateAndWrite();
+
+    // log the peel-off roulette statistics, aggregated over all processes
+    if (find<Configuration>()->peelOffRouletteThreshold() > 0.)
+    {
+        Array counts(2);
+        counts[0] = _numRoulettePlayed;
+        counts[1] = _numRouletteSurvived;
+        ProcessManager::sumToAll(counts);
+        find<Log>()->info(typeAndName() + " subjected " + StringUtils::toString(counts[0], 'd', 0)
+                          + " peel-offs to Russian roulette; " + StringUtils::toString(counts[1], 'd', 0)
+                          + " survived");
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -10,6 +10,8 @@
 #include "Position.hpp"
 #include "SimulationItem.hpp"
 #include "WavelengthGrid.hpp"
+#include <atomic>
+class Checkpoint;
 class FluxRecorder;
 class PhotonPacket;
 
@@ -100,12 +102,61 @@ public:
         with this instrument. */
     void write();
 
+    /** This function puts the instrument in pilot mode, in which detected photon packets are not
+        recorded but merely tallied to measure the statistical properties of the detected flux. It
+        simply calls the corresponding function of the FluxRecorder instance associated with this
+        instrument. */
+    void beginPilot();
+
+    /** This function ends pilot mode and returns the sums of the total contributions and of their
+        squares over all photon packet histories detected in the calling process. It simply calls
+        the corresponding function of the FluxRecorder instance associated with this instrument,
+        and resets the peel-off roulette statistics. */
+    std::pair<double, double> endPilot();
+
+    /** This function marks the start of a photon packet segment for which the recorded
+        contributions may need to be rescaled afterwards. It simply calls the corresponding
+        function of the FluxRecorder instance associated with this instrument. */
+    void beginSegment();
+
+    /** This function returns the %SED statistics sums recorded in the calling process since the
+        start of the current segment, or an empty array if the instrument does not record %SED
+        statistics. It simply calls the corresponding function of the FluxRecorder instance
+        associated with this instrument. */
+    Array segmentStatistics() const;
+
+    /** This function ends the current segment, multiplying the weight of all contributions recorded
+        during the segment by the specified factor. It simply calls the corresponding function of
+        the FluxRecorder instance associated with this instrument. */
+    void endSegment(double weightFactor);
+
+    /** This function outputs the recorded contents as if the current segment were ended with the
+        specified weight factor, without disturbing the recording process. It simply calls the
+        corresponding function of the FluxRecorder instance associated with this instrument. */
+    void writeIntermediate(double weightFactor);
+
+    /** This function appends the information recorded by the instrument in the calling process to
+        the specified checkpoint. It simply calls the corresponding function of the FluxRecorder
+        instance associated with this instrument. */
+    void writeCheckpoint(Checkpoint* checkpoint) const;
+
+    /** This function restores the information written by the writeCheckpoint() function from the
+        specified checkpoint. It simply calls the corresponding function of the FluxRecorder
+        instance associated with this instrument. */
+    void readCheckpoint(Checkpoint* checkpoint);
+
     /** This function returns true if the receiving instrument has the same observer type, position
-        and viewing direction as the preceding instrument in the instrument system. This
-        information is determined and cached by the determineSameObserverAsPreceding() function,
-        which is called by the InstrumentSystem during setup. */
+        and viewing direction as the preceding instrument in the list of instruments grouped by
+        observer (see InstrumentSystem::groupedInstruments()). This information is determined and
+        cached by the determineSameObserverAsPreceding() function, which is called by the
+        InstrumentSystem during setup. */
     bool isSameObserverAsPreceding() const { return _isSameObserverAsPreceding; }
 
+    /** This function records the outcome of the Russian roulette played with a peel-off photon
+        packet destined for this instrument (see MonteCarloSimulation::playPeelOffRoulette()). The
+        resulting statistics are logged by the write() function. This function is thread-safe. */
+    void recordPeelOffRoulette(bool survived);
+
 protected:
     /** This function sets the "isSameObserverAsPreceding" flag to true. By default (i.e. if this
         function is never invoked) the flag is set to false. This function is intended for use from
@@ -150,6 +201,10 @@ private:
     const WavelengthGrid* _instrumentWavelengthGrid{nullptr};
     FluxRecorder* _recorder{nullptr};
     bool _isSameObserverAsPreceding{false};
+
+    // peel-off roulette statistics, updated concurrently from the parallel threads
+    std::atomic<size_t> _numRoulettePlayed{0};
+    std::atomic<size_t> _numRouletteSurvived{0};
 };
 
 ////////////////////////////////////////////////////////////////////
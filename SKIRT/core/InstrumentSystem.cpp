@@ -4,6 +4,10 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "InstrumentSystem.hpp"
+#include "FatalError.hpp"
+#include "Log.hpp"
+#include "ProcessManager.hpp"
+#include "StringUtils.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -11,11 +15,38 @@ void InstrumentSystem::setupSelfAfter()
 {
     SimulationItem::setupSelfAfter();
 
-    Instrument* preceding = nullptr;
+    // group the instruments by observer, regardless of their order in the configuration; the flag set by
+    // determineSameObserverAsPreceding() remains valid because each group is stored contiguously
+    vector<vector<Instrument*>> groups;
     for (Instrument* instrument : _instruments)
     {
-        if (preceding) instrument->determineSameObserverAsPreceding(preceding);
-        preceding = instrument;
+        auto group = groups.begin();
+        for (; group != groups.end(); ++group)
+        {
+            instrument->determineSameObserverAsPreceding(group->front());
+            if (instrument->isSameObserverAsPreceding()) break;
+        }
+        if (group != groups.end())
+            group->push_back(instrument);
+        else
+            groups.push_back({instrument});
+    }
+    for (const auto& group : groups) _groupedInstruments.insert(_groupedInstruments.end(), group.begin(), group.end());
+
+    // log the number of distinct observers if this saves any peel-off calculations
+    if (groups.size() < _instruments.size())
+        find<Log>()->info("Peel-off for " + std::to_string(_instruments.size()) + " instruments is grouped by "
+                          + std::to_string(groups.size()) + " distinct observers");
+
+    if (stopAtConvergence())
+    {
+        bool hasStatistics = false;
+        for (Instrument* instrument : _instruments)
+            if (instrument->recordStatistics()) hasStatistics = true;
+        if (!hasStatistics)
+            throw FATALERROR("Stopping at convergence requires at least one instrument that records statistics");
+        if (!targetRelativeError() && !targetVov())
+            throw FATALERROR("Stopping at convergence requires a target relative error and/or VOV");
     }
 }
 
@@ -34,3 +65,89 @@ void InstrumentSystem::write()
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void InstrumentSystem::beginSegment()
+{
+    for (Instrument* instrument : _instruments) instrument->beginSegment();
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool InstrumentSystem::hasConverged(size_t numHistories)
+{
+    const int numPowers = 5;  // powers 0 to 4 as recorded by FluxRecorder
+    double N = numHistories;
+    bool hasFlux = false;
+    double maxR = 0.;
+    double maxVov = 0.;
+    for (Instrument* instrument : _instruments)
+    {
+        Array sums = instrument->segmentStatistics();
+        if (!sums.size()) continue;
+        ProcessManager::sumToAll(sums);
+
+        // calculate the relative error and the VOV for each wavelength bin in range with nonzero flux
+        const WavelengthGrid* wlg = instrument->instrumentWavelengthGrid();
+        int numWavelengths = wlg->numBins();
+        for (int ell = 0; ell != numWavelengths; ++ell)
+        {
+            double lambda = wlg->wavelength(ell);
+            if (lambda < convergenceMinWavelength() || lambda > convergenceMaxWavelength()) continue;
+            double sum1 = sums[ell * numPowers + 1];
+            double sum2 = sums[ell * numPowers + 2];
+            double sum3 = sums[ell * numPowers + 3];
+            double sum4 = sums[ell * numPowers + 4];
+            if (sum1 <= 0.) continue;
+            hasFlux = true;
+
+            double R = sqrt(max(0., sum2 / (sum1 * sum1) - 1. / N));
+            double denominator = sum2 - sum1 * sum1 / N;
+            double VOV = denominator > 0. ? (sum4 - 4. * sum1 * sum3 / N + 6. * sum1 * sum1 * sum2 / (N * N)
+                                             - 3. * pow(sum1, 4) / (N * N * N))
+                                                    / (denominator * denominator)
+                                                - 1. / N
+                                          : 0.;
+            maxR = max(maxR, R);
+            maxVov = max(maxVov, VOV);
+        }
+    }
+
+    if (!hasFlux)
+    {
+        find<Log>()->info("  No flux has been detected in the convergence wavelength range");
+        return false;
+    }
+    find<Log>()->info("  Maximum relative error R = " + StringUtils::toString(maxR, 'g', 3)
+                      + "; maximum VOV = " + StringUtils::toString(maxVov, 'g', 3));
+    return (!targetRelativeError() || maxR <= targetRelativeError()) && (!targetVov() || maxVov <= targetVov());
+}
+
+////////////////////////////////////////////////////////////////////
+
+void InstrumentSystem::endSegment(double weightFactor)
+{
+    for (Instrument* instrument : _instruments) instrument->endSegment(weightFactor);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void InstrumentSystem::writeIntermediate(double weightFactor)
+{
+    for (Instrument* instrument : _instruments) instrument->writeIntermediate(weightFactor);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void InstrumentSystem::writeCheckpoint(Checkpoint* checkpoint) const
+{
+    for (Instrument* instrument : _instruments) instrument->writeCheckpoint(checkpoint);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void InstrumentSystem::readCheckpoint(Checkpoint* checkpoint)
+{
+    for (Instrument* instrument : _instruments) instrument->readCheckpoint(checkpoint);
+}
+
+////////////////////////////////////////////////////////////////////
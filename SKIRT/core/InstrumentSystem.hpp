@@ -14,7 +14,23 @@
 /** An InstrumentSystem instance keeps a list of zero or more instruments and an optional default
     wavelength grid that will be used by an instrument unless it specifies its own wavelength grid.
     The instruments can be of various nature and do not need to be located at the same observing
-    position. */
+    position.
+
+    The instrument system also offers an optional convergence-driven mode for the photon packet
+    segments that perform peel-off towards the instruments, i.e. the primary and secondary
+    emission segments. In this mode, the configured number of photon packets for a segment is
+    considered to be an upper limit. The photon packets are launched in a number of rounds, and
+    after each round the statistical properties of the %SEDs recorded by the instruments are
+    evaluated. The segment is terminated as soon as the requested noise level has been reached for
+    all wavelength bins in a given wavelength range, and the contributions recorded during the
+    segment are rescaled to compensate for the photon packets that were never launched.
+
+    The noise level is measured by the relative error \f$R\f$ and/or the variance of the variance
+    VOV, which are calculated from the sums \f$\sum_i w_i^k\f$ recorded by the instruments (see
+    FluxRecorder). Only instruments that record statistics for an %SED participate in the
+    evaluation; at least one such instrument must be present. Wavelength bins without any detected
+    flux are ignored. Optionally, intermediate instrument output is written after each round for
+    monitoring purposes. */
 class InstrumentSystem : public SimulationItem
 {
     ITEM_CONCRETE(InstrumentSystem, SimulationItem, "an instrument system")
@@ -29,19 +45,78 @@ class InstrumentSystem : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(instruments, "SEDInstrument")
         ATTRIBUTE_REQUIRED_IF(instruments, "false")
 
+        PROPERTY_BOOL(stopAtConvergence, "stop launching photon packets when the target noise level is reached")
+        ATTRIBUTE_DEFAULT_VALUE(stopAtConvergence, "false")
+        ATTRIBUTE_DISPLAYED_IF(stopAtConvergence, "Level3")
+
+        PROPERTY_INT(numConvergenceRounds, "the number of rounds in which the photon packets are launched")
+        ATTRIBUTE_MIN_VALUE(numConvergenceRounds, "2")
+        ATTRIBUTE_MAX_VALUE(numConvergenceRounds, "10000")
+        ATTRIBUTE_DEFAULT_VALUE(numConvergenceRounds, "20")
+        ATTRIBUTE_RELEVANT_IF(numConvergenceRounds, "stopAtConvergence")
+        ATTRIBUTE_DISPLAYED_IF(numConvergenceRounds, "Level3")
+
+        PROPERTY_DOUBLE(targetRelativeError, "the target relative error R (or zero to ignore R)")
+        ATTRIBUTE_MIN_VALUE(targetRelativeError, "[0")
+        ATTRIBUTE_MAX_VALUE(targetRelativeError, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(targetRelativeError, "0.1")
+        ATTRIBUTE_RELEVANT_IF(targetRelativeError, "stopAtConvergence")
+        ATTRIBUTE_DISPLAYED_IF(targetRelativeError, "Level3")
+
+        PROPERTY_DOUBLE(targetVov, "the target variance of the variance VOV (or zero to ignore VOV)")
+        ATTRIBUTE_MIN_VALUE(targetVov, "[0")
+        ATTRIBUTE_MAX_VALUE(targetVov, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(targetVov, "0")
+        ATTRIBUTE_RELEVANT_IF(targetVov, "stopAtConvergence")
+        ATTRIBUTE_DISPLAYED_IF(targetVov, "Level3")
+
+        PROPERTY_DOUBLE(convergenceMinWavelength, "the shortest wavelength considered for convergence")
+        ATTRIBUTE_QUANTITY(convergenceMinWavelength, "wavelength")
+        ATTRIBUTE_MIN_VALUE(convergenceMinWavelength, "1 Angstrom")
+        ATTRIBUTE_MAX_VALUE(convergenceMinWavelength, "1 m")
+        ATTRIBUTE_DEFAULT_VALUE(convergenceMinWavelength, "1 Angstrom")
+        ATTRIBUTE_RELEVANT_IF(convergenceMinWavelength, "stopAtConvergence&Panchromatic")
+        ATTRIBUTE_DISPLAYED_IF(convergenceMinWavelength, "Level3")
+
+        PROPERTY_DOUBLE(convergenceMaxWavelength, "the longest wavelength considered for convergence")
+        ATTRIBUTE_QUANTITY(convergenceMaxWavelength, "wavelength")
+        ATTRIBUTE_MIN_VALUE(convergenceMaxWavelength, "1 Angstrom")
+        ATTRIBUTE_MAX_VALUE(convergenceMaxWavelength, "1 m")
+        ATTRIBUTE_DEFAULT_VALUE(convergenceMaxWavelength, "1 m")
+        ATTRIBUTE_RELEVANT_IF(convergenceMaxWavelength, "stopAtConvergence&Panchromatic")
+        ATTRIBUTE_DISPLAYED_IF(convergenceMaxWavelength, "Level3")
+
+        PROPERTY_BOOL(writeIntermediateOutput, "write intermediate instrument output after each round")
+        ATTRIBUTE_DEFAULT_VALUE(writeIntermediateOutput, "false")
+        ATTRIBUTE_RELEVANT_IF(writeIntermediateOutput, "stopAtConvergence")
+        ATTRIBUTE_DISPLAYED_IF(writeIntermediateOutput, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
 
 protected:
-    /** This function calls the determineSameObserverAsPreceding() function for all instruments in
-        the instrument system except for the first one (because it doesn't have a preceding
-        instrument). */
+    /** This function groups the instruments in the instrument system by observer type, position
+        and viewing direction, regardless of their order in the configuration, and stores the
+        resulting list in which the instruments of each group are adjacent (see
+        groupedInstruments()). For each instrument, it calls the determineSameObserverAsPreceding()
+        function with the first instrument of each existing group until a match is found. If the
+        convergence-driven mode is enabled, it also verifies that at least one instrument records
+        statistics. */
     void setupSelfAfter() override;
 
     //======================== Other Functions =======================
 
 public:
+    /** This function returns the list of instruments in the instrument system, reordered so that
+        instruments with the same observer type, position and viewing direction are adjacent. The
+        isSameObserverAsPreceding() function of each instrument refers to this order. This allows
+        the peel-off procedure to launch a single peel-off photon packet, and thus to calculate a
+        single optical depth along the path towards the observer, for each group of instruments
+        sharing an observer, even if those instruments are not listed consecutively in the
+        configuration. Within each group, the instruments retain their configuration order. */
+    const vector<Instrument*>& groupedInstruments() const { return _groupedInstruments; }
+
     /** This function flushes any information buffered during photon packet detection for the
         complete instrument system. It calls the flush() function for each of the instruments. */
     void flush();
@@ -49,6 +124,45 @@ public:
     /** This function writes the recorded data for the complete instrument system to a set of
         files. It calls the write() function for each of the instruments. */
     void write();
+
+    /** This function marks the start of a photon packet segment for the complete instrument
+        system in convergence-driven mode. It calls the beginSegment() function for each of the
+        instruments. */
+    void beginSegment();
+
+    /** This function returns true if the %SEDs recorded during the current segment by all
+        instruments that record statistics have reached the target noise level, and false
+        otherwise. The argument specifies the number of photon packet histories launched during
+        the current segment (over all processes). In a multi-processing environment, the
+        statistics are aggregated over all processes so that all processes reach the same
+        conclusion. The function logs the maximum relative error and VOV over the relevant
+        wavelength bins. The instrument system should be flushed before calling this function. */
+    bool hasConverged(size_t numHistories);
+
+    /** This function ends the current photon packet segment for the complete instrument system,
+        multiplying the weight of all contributions recorded during the segment by the specified
+        factor. It calls the endSegment() function for each of the instruments. */
+    void endSegment(double weightFactor);
+
+    /** This function writes the intermediate results for the current segment for the complete
+        instrument system, assuming that the segment would be ended with the specified weight
+        factor. It calls the writeIntermediate() function for each of the instruments. */
+    void writeIntermediate(double weightFactor);
+
+    /** This function appends the information recorded by the complete instrument system in the
+        calling process to the specified checkpoint. It calls the writeCheckpoint() function for
+        each of the instruments. */
+    void writeCheckpoint(Checkpoint* checkpoint) const;
+
+    /** This function restores the information written by the writeCheckpoint() function from the
+        specified checkpoint. It calls the readCheckpoint() function for each of the instruments. */
+    void readCheckpoint(Checkpoint* checkpoint);
+
+    //======================== Data Members =======================
+
+private:
+    // the instruments grouped by observer, initialized during setup
+    vector<Instrument*> _groupedInstruments;
 };
 
 ////////////////////////////////////////////////////////////////////
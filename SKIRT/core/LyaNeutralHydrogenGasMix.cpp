@@ -52,7 +52,9 @@ bool LyaNeutralHydrogenGasMix::hasExtraSpecificState() const
 
 vector<StateVariable> LyaNeutralHydrogenGasMix::specificStateVariableInfo() const
 {
-    return vector<StateVariable>{StateVariable::numberDensity(), StateVariable::temperature()};
+    return vector<StateVariable>{StateVariable::numberDensity(), StateVariable::temperature(),
+                                 StateVariable::custom(0, "thermal velocity", "velocity"),
+                                 StateVariable::custom(1, "Voigt parameter", string())};
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -68,6 +70,11 @@ void LyaNeutralHydrogenGasMix::initializeSpecificState(MaterialState* state, dou
 
         // make sure the temperature is at least the local universe CMB temperature
         state->setTemperature(max(Constants::Tcmb(), temperature));
+
+        // precalculate the thermal velocity and Voigt parameter for use in the cross section
+        double vth = LyaUtils::thermalVelocity(state->temperature());
+        state->setCustom(0, vth);
+        state->setCustom(1, LyaUtils::voigtParameter(vth));
     }
 }
 
@@ -112,7 +119,7 @@ double LyaNeutralHydrogenGasMix::opacityAbs(double /*lambda*/, const MaterialSta
 double LyaNeutralHydrogenGasMix::opacitySca(double lambda, const MaterialState* state, const PhotonPacket* /*pp*/) const
 {
     double n = state->numberDensity();
-    return n > 0. ? n * LyaUtils::section(lambda, state->temperature()) : 0.;
+    return n > 0. ? n * LyaUtils::section(lambda, state->custom(0), state->custom(1)) : 0.;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -120,7 +127,7 @@ double LyaNeutralHydrogenGasMix::opacitySca(double lambda, const MaterialState*
 double LyaNeutralHydrogenGasMix::opacityExt(double lambda, const MaterialState* state, const PhotonPacket* /*pp*/) const
 {
     double n = state->numberDensity();
-    return n > 0. ? n * LyaUtils::section(lambda, state->temperature()) : 0.;
+    return n > 0. ? n * LyaUtils::section(lambda, state->custom(0), state->custom(1)) : 0.;
 }
 
 ////////////////////////////////////////////////////////////////////
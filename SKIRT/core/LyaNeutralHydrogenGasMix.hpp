@@ -81,7 +81,9 @@ public:
         MaterialMix::specificStateVariableInfo() function for more information.
 
         The Lyman-alpha material mix requires a gas temperature in addition to the standard number
-        density, so this function returns a list containing these two items. */
+        density. Furthermore, to avoid recalculating these values for each path segment, it stores
+        the thermal velocity and the Voigt parameter corresponding to the gas temperature in two
+        custom variables. This function thus returns a list containing these four items. */
     vector<StateVariable> specificStateVariableInfo() const override;
 
     /** This function initializes any specific state variables requested by this material mix
@@ -89,7 +91,8 @@ public:
         MaterialMix::initializeSpecificState() function for more information. For the Lyman-alpha
         material mix, the function initializes the temperature to the specified imported
         temperature, or if this is not available, to the user-configured default temperature for
-        this material mix. */
+        this material mix. It also initializes the thermal velocity and Voigt parameter
+        corresponding to this temperature. */
     void initializeSpecificState(MaterialState* state, double temperature, const Array& params) const override;
 
     //======== Low-level material properties =======
@@ -122,7 +125,9 @@ public:
     double opacityAbs(double lambda, const MaterialState* state, const PhotonPacket* pp) const override;
 
     /** This function returns the scattering opacity \f$k^\text{sca}=n\varsigma^\text{sca}\f$ for
-        the given wavelength and material state. The photon properties are not used. */
+        the given wavelength and material state. The cross section is calculated from the thermal
+        velocity and Voigt parameter precalculated for the material state. The photon properties
+        are not used. */
     double opacitySca(double lambda, const MaterialState* state, const PhotonPacket* pp) const override;
 
     /** This function returns the extinction opacity \f$k^\text{ext}=k^\text{abs}+k^\text{sca}\f$
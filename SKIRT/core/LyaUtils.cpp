@@ -24,11 +24,31 @@ namespace
 
 double LyaUtils::section(double lambda, double T)
 {
-    double vth = sqrt(2. * kB / mp * T);                 // thermal velocity for T
-    double a = Aa * la / 4. / M_PI / vth;                // Voigt parameter
+    double vth = thermalVelocity(T);
+    return section(lambda, vth, voigtParameter(vth));
+}
+
+////////////////////////////////////////////////////////////////////
+
+double LyaUtils::section(double lambda, double vth, double a)
+{
     double x = (la - lambda) / lambda * c / vth;         // dimensionless frequency
     double sigma0 = 3. * la * la * M_2_SQRTPI / 4. * a;  // cross section at line center
-    return sigma0 * VoigtProfile::value(a, x);           // cross section at given x
+    return sigma0 * VoigtProfile::tabulatedValue(a, x);  // cross section at given x
+}
+
+////////////////////////////////////////////////////////////////////
+
+double LyaUtils::thermalVelocity(double T)
+{
+    return sqrt(2. * kB / mp * T);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double LyaUtils::voigtParameter(double vth)
+{
+    return Aa * la / 4. / M_PI / vth;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -109,6 +109,23 @@ namespace LyaUtils
         the definition given in the class header. */
     double section(double lambda, double T);
 
+    /** This function returns the Lyman-alpha scattering cross section per hydrogen atom
+        \f$\sigma_\alpha(\lambda, T)\f$ at the given photon wavelength, given the thermal velocity
+        \f$v_\mathrm{th}\f$ and the Voigt parameter \f$a\f$ corresponding to the gas temperature.
+        These values can be obtained by calling the thermalVelocity() and voigtParameter()
+        functions, respectively, and can thus be calculated once for each spatial cell. The Voigt
+        function is evaluated using the tabulated version of the approximation offered by the
+        VoigtProfile namespace. */
+    double section(double lambda, double vth, double a);
+
+    /** This function returns the thermal velocity \f$v_\mathrm{th}=\sqrt{2k_\mathrm{B}T/m_\mathrm{p}}\f$
+        corresponding to the given gas temperature. */
+    double thermalVelocity(double T);
+
+    /** This function returns the Voigt parameter \f$a=A_\alpha/(4\pi\nu_\mathrm{th})\f$
+        corresponding to the given thermal velocity, where \f$\nu_\mathrm{th}=v_\mathrm{th}/\lambda_\alpha\f$. */
+    double voigtParameter(double vth);
+
     /** This function draws a random hydrogen atom velocity as seen by an incoming photon from the
         appropriate probability distributions, reflecting the preference for photons to be
         scattered by atoms to which they appear close to resonance. In addition, it determines
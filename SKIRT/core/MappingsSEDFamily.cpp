@@ -47,11 +47,8 @@ Range MappingsSEDFamily::intrinsicWavelengthRange() const
 
 double MappingsSEDFamily::specificLuminosity(double wavelength, const Array& parameters) const
 {
-    double SFR = parameters[0] / Constants::Msun() * Constants::year();
-    double Z = parameters[1];
-    double logC = parameters[2];
-    double p = parameters[3];
-    double fPDR = parameters[4];
+    double Z, logC, p, fPDR;
+    double SFR = decodeParameters(parameters, Z, logC, p, fPDR);
 
     return SFR * _table(wavelength, Z, logC, p, fPDR);
 }
@@ -61,13 +58,47 @@ double MappingsSEDFamily::specificLuminosity(double wavelength, const Array& par
 double MappingsSEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                               const Array& parameters) const
 {
-    double SFR = parameters[0] / Constants::Msun() * Constants::year();
-    double Z = parameters[1];
-    double logC = parameters[2];
-    double p = parameters[3];
-    double fPDR = parameters[4];
+    double Z, logC, p, fPDR;
+    double SFR = decodeParameters(parameters, Z, logC, p, fPDR);
 
     return SFR * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, logC, p, fPDR);
 }
 
 ////////////////////////////////////////////////////////////////////
+
+size_t MappingsSEDFamily::numNodes() const
+{
+    return _table.numNodes();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MappingsSEDFamily::nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const
+{
+    double Z, logC, p, fPDR;
+    double SFR = decodeParameters(parameters, Z, logC, p, fPDR);
+
+    _table.nodeWeights(nodes, Z, logC, p, fPDR);
+    for (auto& node : nodes) node.second *= SFR;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MappingsSEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange, size_t node) const
+{
+    return _table.nodeCdf(lambdav, pv, Pv, wavelengthRange, node);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MappingsSEDFamily::decodeParameters(const Array& parameters, double& Z, double& logC, double& p,
+                                           double& fPDR) const
+{
+    Z = parameters[1];
+    logC = parameters[2];
+    p = parameters[3];
+    fPDR = parameters[4];
+    return parameters[0] / Constants::Msun() * Constants::year();
+}
+
+////////////////////////////////////////////////////////////////////
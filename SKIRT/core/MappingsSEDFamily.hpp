@@ -85,6 +85,31 @@ public:
     double cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                const Array& parameters) const override;
 
+    /** This function returns the number of nodes in the parameter grid of the %SED family, i.e.
+        the number of metallicity, compactness, pressure and PDR covering fraction combinations in the stored table. */
+    size_t numNodes() const override;
+
+    /** This function returns the grid nodes involved in the interpolation of the %SED with the
+        specified parameters and the corresponding weights, as described for the
+        SEDFamily::nodeWeights() function. */
+    void nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const override;
+
+    /** This function constructs the normalized probability density function (pdf) and cumulative
+        distribution function (cdf) for the %SED corresponding to the specified grid node, as
+        described for the SEDFamily::nodeCdf() function. */
+    double nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange, size_t node) const override;
+
+    //================= Private helpers =================
+
+private:
+    /** This function decodes the specified %SED family parameter values, returning the metallicity
+        \f$Z\f$, the compactness \f$\log C\f$, the ISM pressure \f$p\f$ and the PDR covering
+        factor \f$f_\text{PDR}\f$ in the corresponding arguments and the star formation rate (in
+        solar masses per year) as the function value. The specificLuminosity(), cdf() and
+        nodeWeights() functions all use this function, so that they consistently describe the same
+        %SED. */
+    double decodeParameters(const Array& parameters, double& Z, double& logC, double& p, double& fPDR) const;
+
     //====================== Data members =====================
 
 private:
@@ -49,12 +49,8 @@ Range MarastonSEDFamily::intrinsicWavelengthRange() const
 
 double MarastonSEDFamily::specificLuminosity(double wavelength, const Array& parameters) const
 {
-    double M = parameters[0] / Constants::Msun();
-    double Z = parameters[1];
-    double t = parameters[2] / Constants::year();
-
-    // if needed, force the parameter values inside the valid portion of grid
-    if ((Z < 0.000894 || Z > 0.0447) && t < 1e9) t = 1e9;
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
 
     return M * _table(wavelength, Z, t);
 }
@@ -64,14 +60,48 @@ double MarastonSEDFamily::specificLuminosity(double wavelength, const Array& par
 double MarastonSEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                               const Array& parameters) const
 {
-    double M = parameters[0] / Constants::Msun();
-    double Z = parameters[1];
-    double t = parameters[2] / Constants::year();
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
+
+    return M * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, t);
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t MarastonSEDFamily::numNodes() const
+{
+    return _table.numNodes();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MarastonSEDFamily::nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const
+{
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
+
+    _table.nodeWeights(nodes, Z, t);
+    for (auto& node : nodes) node.second *= M;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MarastonSEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange, size_t node) const
+{
+    return _table.nodeCdf(lambdav, pv, Pv, wavelengthRange, node);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MarastonSEDFamily::decodeParameters(const Array& parameters, double& Z, double& t) const
+{
+    Z = parameters[1];
+    t = parameters[2] / Constants::year();
 
     // if needed, force the parameter values inside the valid portion of grid
     if ((Z < 0.000894 || Z > 0.0447) && t < 1e9) t = 1e9;
 
-    return M * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, t);
+    return parameters[0] / Constants::Msun();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -5,14 +5,17 @@
 
 #include "MediumState.hpp"
 #include "FatalError.hpp"
+#include "ParallelFactory.hpp"
 #include "ProcessManager.hpp"
+#include "SpatialGrid.hpp"
 
 //////////////////////////////////////////////////////////////////////
 
-void MediumState::initConfiguration(int numCells, int numMedia)
+void MediumState::initConfiguration(int numCells, int numMedia, bool singlePrecision)
 {
     _numCells = numCells;
     _numMedia = numMedia;
+    _single = singlePrecision;
 
     _off_dens.resize(_numMedia);
     _off_temp.resize(_numMedia);
@@ -21,8 +24,9 @@ void MediumState::initConfiguration(int numCells, int numMedia)
 
 //////////////////////////////////////////////////////////////////////
 
-void MediumState::initCommonStateVariables(const vector<StateVariable>& variables)
+void MediumState::initCommonStateVariables(const vector<StateVariable>& variables, const SpatialGrid* grid)
 {
+    _grid = grid;
     for (const StateVariable& variable : variables)
     {
         switch (variable.identifier())
@@ -42,6 +46,7 @@ void MediumState::initCommonStateVariables(const vector<StateVariable>& variable
                 throw FATALERROR("Requesting common state variable of unsupported type");
         }
     }
+    if (_off_volu < 0 && !_grid) throw FATALERROR("Cell volumes must be either stored or provided by a spatial grid");
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -74,16 +79,114 @@ size_t MediumState::initAllocate()
     if (_nextComponent != _numMedia) throw FATALERROR("Failed to request state variables for all medium components");
     _numVars = _nextOffset;
 
-    size_t numAlloc = static_cast<size_t>(_numVars) * static_cast<size_t>(_numCells);
+    size_t numAlloc = numValues();
+    if (_single)
+    {
+        _fdata.resize(numAlloc);
+        return numAlloc * sizeof(float);
+    }
     _data.resize(numAlloc);
-    return numAlloc;
+    _dvalues = begin(_data);
+    return numAlloc * sizeof(double);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void MediumState::initFirstTouch(ParallelFactory* factory)
+{
+    if (_single)
+        factory->firstTouch(_fdata.data(), _fdata.size() * sizeof(float), _numCells);
+    else
+        factory->firstTouch(_data, _numCells);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void MediumState::initCommunicate()
 {
-    ProcessManager::sumToAll(_data);
+    if (_single)
+    {
+        // communicate in double precision through a temporary array
+        if (!ProcessManager::isMultiProc()) return;
+        Array data;
+        this->data(data);
+        ProcessManager::sumToAll(data);
+        std::copy(begin(data), end(data), _fdata.begin());
+    }
+    else
+    {
+        ProcessManager::sumToAll(_data);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void MediumState::initData(const Array& data)
+{
+    if (data.size() != numValues()) throw FATALERROR("Medium state data does not match the state configuration");
+    if (_single)
+        std::copy(begin(data), end(data), _fdata.begin());
+    else
+    {
+        _shared.reset();
+        _data = data;
+        _dvalues = begin(_data);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+const Array& MediumState::data(Array& buffer) const
+{
+    if (!_single) return _shared ? *_shared : _data;
+    buffer.resize(_fdata.size());
+    std::copy(_fdata.begin(), _fdata.end(), begin(buffer));
+    return buffer;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const Array> MediumState::sharedData()
+{
+    if (_single)
+    {
+        auto shared = std::make_shared<Array>();
+        data(*shared);
+        return shared;
+    }
+    if (!_shared)
+    {
+        _shared = std::make_shared<Array>(std::move(_data));
+        _dvalues = begin(*_shared);
+    }
+    return _shared;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void MediumState::initSharedData(std::shared_ptr<const Array> data)
+{
+    if (data->size() != numValues()) throw FATALERROR("Medium state data does not match the state configuration");
+    if (_single)
+        std::copy(begin(*data), end(*data), _fdata.begin());
+    else
+    {
+        _data.resize(0);
+        _shared = data;
+        _dvalues = begin(*_shared);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void MediumState::makeWritable()
+{
+    if (_shared)
+    {
+        _data = *_shared;
+        _shared.reset();
+        _dvalues = begin(_data);
+    }
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -103,8 +206,8 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
                     // cell index
                     data.push_back(m);
                     // state variables
-                    double* first = &_data[_numVars * m];
-                    data.insert(data.end(), first, first + _numVars);
+                    size_t first = index(m, 0);
+                    for (int i = 0; i != _numVars; ++i) data.push_back(value(first + i));
                     // update status
                     numUpdated++;
                     if (cellFlags[m].isConverged())
@@ -125,7 +228,8 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
                 // cell index
                 int m = *in;
                 // state variables
-                std::copy(in + 1, in + 1 + _numVars, &_data[_numVars * m]);
+                size_t first = index(m, 0);
+                for (int i = 0; i != _numVars; ++i) setValue(first + i, *(in + 1 + i));
                 // update status
                 numUpdated++;
                 if (*(in + 1 + _numVars)) numNotConverged++;
@@ -146,50 +250,57 @@ std::pair<int, int> MediumState::synchronize(const vector<UpdateStatus>& cellFla
 
 //////////////////////////////////////////////////////////////////////
 
+double MediumState::volume(int m) const
+{
+    return _off_volu >= 0 ? value(index(m, _off_volu)) : _grid->volume(m);
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void MediumState::setVolume(int m, double value)
 {
-    _data[_numVars * m + _off_volu] = value;
+    setValue(index(m, _off_volu), value);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void MediumState::setBulkVelocity(int m, Vec value)
 {
-    int i = _numVars * m + _off_velo;
-    _data[i] = value.x();
-    _data[i + 1] = value.y();
-    _data[i + 2] = value.z();
+    size_t i = index(m, _off_velo);
+    setValue(i, value.x());
+    setValue(i + 1, value.y());
+    setValue(i + 2, value.z());
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void MediumState::setMagneticField(int m, Vec value)
 {
-    int i = _numVars * m + _off_mfld;
-    _data[i] = value.x();
-    _data[i + 1] = value.y();
-    _data[i + 2] = value.z();
+    size_t i = index(m, _off_mfld);
+    setValue(i, value.x());
+    setValue(i + 1, value.y());
+    setValue(i + 2, value.z());
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void MediumState::setNumberDensity(int m, int h, double value)
 {
-    _data[_numVars * m + _off_dens[h]] = value;
+    setValue(index(m, _off_dens[h]), value);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void MediumState::setTemperature(int m, int h, double value)
 {
-    _data[_numVars * m + _off_temp[h]] = value;
+    setValue(index(m, _off_temp[h]), value);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void MediumState::setCustom(int m, int h, int i, double value)
 {
-    _data[_numVars * m + _off_cust[h] + i] = value;
+    setValue(index(m, _off_cust[h] + i), value);
 }
 
 //////////////////////////////////////////////////////////////////////
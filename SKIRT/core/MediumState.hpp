@@ -10,6 +10,9 @@
 #include "StateVariable.hpp"
 #include "UpdateStatus.hpp"
 #include "Vec.hpp"
+#include <memory>
+class ParallelFactory;
+class SpatialGrid;
 
 //////////////////////////////////////////////////////////////////////
 
@@ -24,7 +27,7 @@
 
     | Identifier | Symbol | Type | Set | Present
     | -----------|--------|------|-----|--------
-    | Volume        | \f$V\f$      | double | Common   | always
+    | Volume        | \f$V\f$      | double | Common   | unless obtained from the spatial grid
     | BulkVelocity  | \f$v\f$      | Vec    | Common   | if needed for any medium component
     | MagneticField | \f$\bf{B}\f$ | Vec    | Common   | if needed for any medium component
     | NumberDensity | \f$n\f$      | double | Specific | always
@@ -40,12 +43,15 @@
 
     Fully initializing a MediumState object requires calling the following functions in the
     correct order (after default-constructing the object):
-     - the initConfiguration() function specifies the number of spatial cells and the number of
-       medium components in the simulation.
-     - the initCommonStateVariables() function specifies the set of common state variables.
+     - the initConfiguration() function specifies the number of spatial cells, the number of
+       medium components in the simulation, and the precision with which values are stored.
+     - the initCommonStateVariables() function specifies the set of common state variables and,
+       if the volume is not included in this set, the spatial grid providing the cell volumes.
      - the initSpecificStateVariables() function must be called once for each medium component, in
        order of component index, specifying the set of specific state variables for that component.
      - the initAllocate() function finalizes construction and actually allocates storage.
+     - optionally, the initFirstTouch() function distributes the allocated storage over the NUMA
+       nodes of the computer.
      - the initCommunicate() function communicates the state variable values between processes.
 
     The initCommonStateVariables() and initSpecificStateVariables() functions each receive a list
@@ -70,7 +76,13 @@
     provides a mapping to locate a particular state variable in this array. This is accomplished by
     also storing the offset for each variable within the set of variables per spatial cell. To
     facilitate access, these offsets are stored for all supported variables (by name) and not just
-    for the required variables. The offsets for unused variables remain at zero.
+    for the required variables. The offsets for unused common variables are negative, and those for
+    unused specific variables remain at zero.
+
+    By default, the values are stored in double precision. To reduce memory usage for simulations
+    with a large number of spatial cells, the values can optionally be stored in single precision.
+    The values are still passed and returned as type \c double; they are simply rounded to single
+    precision when stored.
 
     Given the offset \f$O_x\f$ for a particular state variable \f$x\f$, a spatial cell index
     \f$m\f$ and a medium component index \f$h\f$, the index of the variable in the data array can
@@ -81,38 +93,87 @@
     <b>Access to undefined variables</b>
 
     In general, an attempt to access (read or write) a variable for which storage has not been
-    requested results in undefined behavior. However, assuming that storage has been requested for
-    the volume (which is always needed anyway), the other variables in the common state can be
-    safely read (not written) even if no storage was requested for them. This allows the bulk
-    velocity and magnetic field vectors to be retrieved without concern for whether they were
+    requested results in undefined behavior. However, the bulk velocity and magnetic field vectors
+    can be safely read (not written) even if no storage was requested for them, in which case they
+    are zero. This allows these vectors to be retrieved without concern for whether they were
     configured in the input model. */
 class MediumState
 {
     //============= Construction =============
 
 public:
-    /** This function initializes the number of spatial cells and number of medium components. */
-    void initConfiguration(int numCells, int numMedia);
+    /** This function initializes the number of spatial cells and number of medium components.
+        If the \em singlePrecision flag is true, the state variable values are stored in single
+        rather than double precision. */
+    void initConfiguration(int numCells, int numMedia, bool singlePrecision = false);
 
-    /** This function initializes the set of required common state variables. */
-    void initCommonStateVariables(const vector<StateVariable>& variables);
+    /** This function initializes the set of required common state variables. If the volume is not
+        included in the list, the volume() function obtains the cell volumes from the specified
+        spatial grid rather than from storage. This saves memory for grids that can calculate cell
+        volumes cheaply. */
+    void initCommonStateVariables(const vector<StateVariable>& variables, const SpatialGrid* grid = nullptr);
 
     /** This function initializes the set of required specific state variables for the next medium
         component. The function must be called once for each medium component, in order of
         component index. */
     void initSpecificStateVariables(const vector<StateVariable>& variables);
 
-    /** This function ends the initialization sequence, allocates memory for the state variables,
-        and returns the total number \f$N = M (C+\sum_h S_h)\f$ of state variables. All newly
-        allocated state variables are guaranteed to have a value of zero. */
+    /** This function ends the initialization sequence, allocates memory for the total number
+        \f$N = M (C+\sum_h S_h)\f$ of state variables, and returns the number of allocated bytes.
+        All newly allocated state variables are guaranteed to have a value of zero. */
     size_t initAllocate();
 
+    /** This function distributes the physical memory pages holding the state variables over the
+        NUMA nodes of the computer according to the threads that will access them in a parallel
+        loop over the spatial cells, using the ParallelFactory::firstTouch() function of the
+        specified factory. It must be called immediately after the initAllocate() function, i.e.
+        before any state variable values have been set. */
+    void initFirstTouch(ParallelFactory* factory);
+
     /** This function communicates the state variable values between processes after each process
         has initialized the values for a subset of the spatial cells and left the values for the
         other cells at zero. (The function uses the ProcessManager::sumToAll() function, so it
         assumes that the uninitialized variables have a zero value). */
     void initCommunicate();
 
+    /** This function replaces the values of all state variables by the values in the specified
+        array, which must have been obtained through the data() function from a medium state with
+        an identical configuration. It can be called instead of initializing the values for the
+        individual cells, e.g. to share an initial medium state between simulations. If the array
+        size does not match the number of state variables, the function throws a fatal error. */
+    void initData(const Array& data);
+
+    /** This function returns a read-only reference to the values of all state variables, in an
+        unspecified order. It is intended to be used in combination with the initData() function.
+        For double precision storage, the function returns a reference to the storage itself
+        without copying the values. For single precision storage, the function converts the values
+        to double precision into the specified buffer and returns a reference to that buffer. */
+    const Array& data(Array& buffer) const;
+
+    /** This function makes the values of all state variables available for sharing with other
+        medium states with an identical configuration, and returns a pointer to the shared array.
+        For double precision storage, the state adopts the returned array as its own read-only
+        storage without copying the values. For single precision storage, the returned array holds
+        a copy of the values converted to double precision. */
+    std::shared_ptr<const Array> sharedData();
+
+    /** This function replaces the values of all state variables by the values in the specified
+        array, which must have been obtained through the sharedData() function from a medium state
+        with an identical configuration. For double precision storage, the state uses the shared
+        array as its read-only storage without copying the values. For single precision storage,
+        the values are copied. If the array size does not match the number of state variables, the
+        function throws a fatal error. */
+    void initSharedData(std::shared_ptr<const Array> data);
+
+    /** This function ensures that the state variables can be modified, copying the values held in
+        read-only storage shared with other medium states, if needed. It must be called before any
+        state variables are set after the sharedData() or initSharedData() function has been
+        called. The function is not thread-safe; it should be called outside of parallel loops. */
+    void makeWritable();
+
+    /** This function returns the total number \f$N\f$ of state variables. */
+    size_t numValues() const { return static_cast<size_t>(_numVars) * static_cast<size_t>(_numCells); }
+
     //============= Synchronization =============
 
     /** This function synchronizes the state variables between processes after each process has
@@ -159,18 +220,19 @@ public:
     //============= Querying =============
 
 public:
-    /** This function returns the volume \f$V\f$ of the spatial cell with index \f$m\f$. */
-    double volume(int m) const { return _data[_numVars * m + _off_volu]; }
+    /** This function returns the volume \f$V\f$ of the spatial cell with index \f$m\f$, either
+        from storage or, if storage was not requested for this variable, from the spatial grid. */
+    double volume(int m) const;
 
     /** This function returns the aggregate bulk velocity \f${\boldsymbol{v}}\f$ of the medium in
         the spatial cell with index \f$m\f$, or zero if storage was not requested for this
         variable. */
     Vec bulkVelocity(int m) const
     {
-        if (_off_velo)
+        if (_off_velo >= 0)
         {
-            int i = _numVars * m + _off_velo;
-            return Vec(_data[i], _data[i + 1], _data[i + 2]);
+            size_t i = index(m, _off_velo);
+            return Vec(value(i), value(i + 1), value(i + 2));
         }
         return Vec();
     }
@@ -179,39 +241,110 @@ public:
         index \f$m\f$, or zero if storage was not requested for this variable. */
     Vec magneticField(int m) const
     {
-        if (_off_mfld)
+        if (_off_mfld >= 0)
         {
-            int i = _numVars * m + _off_mfld;
-            return Vec(_data[i], _data[i + 1], _data[i + 2]);
+            size_t i = index(m, _off_mfld);
+            return Vec(value(i), value(i + 1), value(i + 2));
         }
         return Vec();
     }
 
     /** This function returns the number density of the medium component with index \f$h\f$ in the
         spatial cell with index \f$m\f$. */
-    double numberDensity(int m, int h) const { return _data[_numVars * m + _off_dens[h]]; }
+    double numberDensity(int m, int h) const { return value(index(m, _off_dens[h])); }
 
     /** This function returns the temperature \f$T\f$ of the medium component with index \f$h\f$ in
         the spatial cell with index \f$m\f$. */
-    double temperature(int m, int h) const { return _data[_numVars * m + _off_temp[h]]; }
+    double temperature(int m, int h) const { return value(index(m, _off_temp[h])); }
 
     /** This function returns the value of the custom variable with index \f$i\f$ of the medium
         component with index \f$h\f$ in the spatial cell with index \f$m\f$. */
-    double custom(int m, int h, int i) const { return _data[_numVars * m + _off_cust[h] + i]; }
+    double custom(int m, int h, int i) const { return value(index(m, _off_cust[h] + i)); }
+
+    //============= Querying for a given precision =============
+
+public:
+    /** An instance of the View class template provides read-only access to the number densities
+        and bulk velocities in a medium state, assuming that the values are stored with the type
+        specified as template argument (float or double). Because the storage type is fixed at
+        compile time, the accessors do not need to test the precision with which values are
+        stored. View instances are obtained through the visit() function. */
+    template<typename T> class View
+    {
+    public:
+        /** The constructor is invoked from the visit() function. */
+        View(const MediumState& ms, const T* values) : _ms(ms), _values(values) {}
+
+        /** This function returns the number density of the medium component with index \f$h\f$
+            in the spatial cell with index \f$m\f$. */
+        double numberDensity(int m, int h) const { return _values[_ms.index(m, _ms._off_dens[h])]; }
+
+        /** This function returns the aggregate bulk velocity \f${\boldsymbol{v}}\f$ of the medium
+            in the spatial cell with index \f$m\f$, or zero if storage was not requested for this
+            variable. */
+        Vec bulkVelocity(int m) const
+        {
+            if (_ms._off_velo >= 0)
+            {
+                size_t i = _ms.index(m, _ms._off_velo);
+                return Vec(_values[i], _values[i + 1], _values[i + 2]);
+            }
+            return Vec();
+        }
+
+    private:
+        const MediumState& _ms;
+        const T* _values;
+    };
+
+    /** This function invokes the specified function object once, passing it a View instance for
+        the type with which the state variables are stored, and returns the result. Clients can pass
+        a generic lambda that performs a complete loop (e.g., over the segments of a path), so that
+        the storage type is selected once for the loop rather than for each access to a state
+        variable. */
+    template<class F> decltype(auto) visit(F&& f) const
+    {
+        if (_single) return f(View<float>(*this, _fdata.data()));
+        return f(View<double>(*this, _dvalues));
+    }
+
+    //============= Private helpers =============
+
+private:
+    /** This function returns the index in the data array of the variable with the specified
+        offset in the spatial cell with index \f$m\f$. */
+    size_t index(int m, int offset) const { return static_cast<size_t>(_numVars) * m + offset; }
+
+    /** This function returns the value stored at the specified index in the data array. */
+    double value(size_t i) const { return _single ? _fdata[i] : _dvalues[i]; }
+
+    /** This function stores the specified value at the specified index in the data array. */
+    void setValue(size_t i, double x)
+    {
+        if (_single)
+            _fdata[i] = x;
+        else
+            _data[i] = x;
+    }
 
     //======================== Data Members ========================
 
 private:
-    // data array containing the medium state variables
-    Array _data;
+    // data array containing the medium state variables; only one of these is used depending on the precision
+    Array _data;                          // double precision storage, unless shared
+    std::shared_ptr<const Array> _shared;  // read-only double precision storage shared with other states, if any
+    const double* _dvalues{nullptr};      // the double precision values, in either of the above
+    vector<float> _fdata;                 // single precision storage
+    bool _single{false};                  // true if the single precision storage is used
 
     // configuration and offsets used for mapping to indices in the data array
     int _numCells{0};
     int _numMedia{0};
     int _numVars{0};
-    int _off_volu{0};
-    int _off_velo{0};
-    int _off_mfld{0};
+    const SpatialGrid* _grid{nullptr};  // the grid providing the volumes if these are not stored
+    int _off_volu{-1};
+    int _off_velo{-1};
+    int _off_mfld{-1};
     vector<int> _off_dens;
     vector<int> _off_temp;
     vector<int> _off_cust;
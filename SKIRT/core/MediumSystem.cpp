@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "MediumSystem.hpp"
+#include "Checkpoint.hpp"
 #include "Configuration.hpp"
 #include "Constants.hpp"
 #include "DensityInCellInterface.hpp"
@@ -14,15 +15,19 @@
 #include "LyaUtils.hpp"
 #include "MaterialMix.hpp"
 #include "MaterialState.hpp"
+#include "MemoryRegistry.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
 #include "PathSegmentGenerator.hpp"
+#include "PersistentCache.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
 #include "Random.hpp"
 #include "ShortArray.hpp"
 #include "StringUtils.hpp"
+#include <atomic>
+#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -30,6 +35,9 @@ namespace
 {
     // maximum number of cell densities calculated between two invocations of infoIfElapsed()
     const size_t logProgressChunkSize = 10000;
+
+    // maximum number of times the transverse offset for the escape optical depth cache is halved to fit inside a cell
+    const int maxEscapeOffsetReductions = 10;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -37,6 +45,11 @@ namespace
 void MediumSystem::setupSelfAfter()
 {
     SimulationItem::setupSelfAfter();
+
+    // obtain a key that uniquely identifies our spatial grid within the process
+    static std::atomic<size_t> numGridKeys{0};
+    _gridKey = ++numGridKeys;
+
     auto log = find<Log>();
     auto parfac = find<ParallelFactory>();
     _config = find<Configuration>();
@@ -49,20 +62,21 @@ void MediumSystem::setupSelfAfter()
     // ----- allocate memory for the medium state -----
 
     // basic configuration
-    _state.initConfiguration(_numCells, _numMedia);
+    _state.initConfiguration(_numCells, _numMedia, singlePrecisionState());
 
-    // common state variables
+    // common state variables; volumes in m3 may overflow single precision, so then we obtain them from the grid
     vector<StateVariable> variables;
-    variables.emplace_back(StateVariable::volume());
+    if (storeCellVolumes() && !singlePrecisionState()) variables.emplace_back(StateVariable::volume());
     if (_config->hasMovingMedia()) variables.emplace_back(StateVariable::bulkVelocity());
     if (_config->hasMagneticField()) variables.emplace_back(StateVariable::magneticField());
-    _state.initCommonStateVariables(variables);
+    _state.initCommonStateVariables(variables, _grid);
 
     // specific state variables
     for (auto medium : _media) _state.initSpecificStateVariables(medium->mix()->specificStateVariableInfo());
 
     // finalize
-    allocatedBytes += _state.initAllocate() * sizeof(double);
+    size_t stateBytes = _state.initAllocate();
+    _state.initFirstTouch(parfac);
 
     // ----- allocate memory for the radiation field -----
 
@@ -70,14 +84,19 @@ void MediumSystem::setupSelfAfter()
     {
         _wavelengthGrid = _config->radiationFieldWLG();
         _rf1.resize(_numCells, _wavelengthGrid->numBins());
-        allocatedBytes += _rf1.size() * sizeof(double);
+        parfac->firstTouch(_rf1.data(), _numCells);
+        size_t radiationFieldBytes = _rf1.size() * sizeof(double);
 
         if (_config->hasSecondaryRadiationField())
         {
             _rf2.resize(_numCells, _wavelengthGrid->numBins());
             _rf2c.resize(_numCells, _wavelengthGrid->numBins());
-            allocatedBytes += 2 * _rf2.size() * sizeof(double);
+            parfac->firstTouch(_rf2.data(), _numCells);
+            parfac->firstTouch(_rf2c.data(), _numCells);
+            radiationFieldBytes += 2 * _rf2.size() * sizeof(double);
         }
+        allocatedBytes += radiationFieldBytes;
+        MemoryRegistry::add(this, MemoryRegistry::Category::RadiationField, radiationFieldBytes);
     }
 
     // ----- cache info on the dust emission wavelength grid -----
@@ -91,14 +110,28 @@ void MediumSystem::setupSelfAfter()
 
     if (_config->hasVariableMedia())
     {
-        // we need a separate material mix pointer for each spatial cell (per medium component)
-        _mixv.resize(_numCells * _numMedia);
+        // we need a separate material mix for each spatial cell (per medium component); because the number of
+        // distinct mixes is usually small, we store a compact index into a table of distinct mix pointers
+        _mixIndexv.resize(static_cast<size_t>(_numCells) * _numMedia);
         _mixPerCell = true;
+        std::unordered_map<const MaterialMix*, uint16_t> indices;
         for (int m = 0; m != _numCells; ++m)
         {
             Position bfr = _grid->centralPositionInCell(m);
-            for (int h = 0; h != _numMedia; ++h) _mixv[m * _numMedia + h] = _media[h]->mix(bfr);
+            for (int h = 0; h != _numMedia; ++h)
+            {
+                const MaterialMix* cellMix = _media[h]->mix(bfr);
+                auto inserted = indices.emplace(cellMix, static_cast<uint16_t>(_mixv.size()));
+                if (inserted.second)
+                {
+                    if (_mixv.size() > std::numeric_limits<uint16_t>::max())
+                        throw FATALERROR("Too many distinct material mixes in the medium system");
+                    _mixv.push_back(cellMix);
+                }
+                _mixIndexv[static_cast<size_t>(m) * _numMedia + h] = inserted.first->second;
+            }
         }
+        stateBytes += _mixIndexv.size() * sizeof(uint16_t);
     }
     else
     {
@@ -106,7 +139,9 @@ void MediumSystem::setupSelfAfter()
         _mixv.resize(_numMedia);
         for (int h = 0; h != _numMedia; ++h) _mixv[h] = _media[h]->mix();
     }
-    allocatedBytes += _mixv.size() * sizeof(MaterialMix*);
+    stateBytes += _mixv.size() * sizeof(MaterialMix*);
+    allocatedBytes += stateBytes;
+    MemoryRegistry::add(this, MemoryRegistry::Category::State, stateBytes);
 
     // cache a list of medium component indices for each material type
     for (int h = 0; h != _numMedia; ++h)
@@ -123,6 +158,26 @@ void MediumSystem::setupSelfAfter()
 
     log->info(typeAndName() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
 
+    // ----- obtain the initial medium state shared by a previous simulation, if possible -----
+
+    // the state is shared only if the simulation has been given a medium setup key; it is kept in memory only
+    // because the key does not capture the contents of any imported input files
+    PersistentCache cache(this, "state", true);
+    bool shared = !_config->mediumSetupKey().empty() && cache.isEnabled();
+    if (shared)
+    {
+        cache.addKey(_config->mediumSetupKey());
+        cache.addKey(static_cast<double>(_numCells));
+        cache.addKey(static_cast<double>(_numMedia));
+        cache.addKey(static_cast<double>(_state.numValues()));
+        if (cache.load())
+        {
+            _state.initSharedData(cache.readShared());
+            log->info("Using medium state shared with a previous simulation");
+            return;
+        }
+    }
+
     // ----- calculate cell densities, bulk velocities, and volumes in parallel -----
 
     log->info("Calculating densities for " + std::to_string(_numCells) + " cells...");
@@ -139,8 +194,8 @@ void MediumSystem::setupSelfAfter()
             {
                 Position center = _grid->centralPositionInCell(m);
 
-                // volume
-                _state.setVolume(m, _grid->volume(m));
+                // volume, if stored
+                if (storeCellVolumes() && !singlePrecisionState()) _state.setVolume(m, _grid->volume(m));
 
                 // density: use optional fast-track interface or sample 100 random positions within the cell
                 if (dic)
@@ -199,6 +254,20 @@ void MediumSystem::setupSelfAfter()
     _state.initCommunicate();
 
     log->info("Done calculating cell densities");
+
+    // offer the initial medium state for sharing with subsequent simulations
+    if (shared)
+    {
+        cache.write(_state.sharedData());
+        cache.save();
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<SimulationItem*> MediumSystem::independentSetupChildren() const
+{
+    return vector<SimulationItem*>(_media.begin(), _media.end());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -235,7 +304,7 @@ int MediumSystem::numCells() const
 
 const MaterialMix* MediumSystem::mix(int m, int h) const
 {
-    return _mixPerCell ? _mixv[m * _numMedia + h] : _mixv[h];
+    return _mixPerCell ? _mixv[_mixIndexv[static_cast<size_t>(m) * _numMedia + h]] : _mixv[h];
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -482,14 +551,16 @@ namespace
     // This function returns a thread-local instance of the path segment generator for the specified grid
     // that is initialized to the starting position and direction of the specified path.
     // Providing a thread-local instance avoids creating a new generator for each use.
-    PathSegmentGenerator* getPathSegmentGenerator(SpatialGrid* grid, const SpatialGridPath* path)
+    // The grid is identified by a key that is unique within the process rather than by its address, because
+    // a grid constructed for a subsequent simulation in the same process may reuse the address of a deleted grid.
+    PathSegmentGenerator* getPathSegmentGenerator(SpatialGrid* grid, size_t gridKey, const SpatialGridPath* path)
     {
-        thread_local SpatialGrid* t_grid{nullptr};
+        thread_local size_t t_gridKey{0};
         thread_local std::unique_ptr<PathSegmentGenerator> t_generator;
 
-        if (grid != t_grid)
+        if (gridKey != t_gridKey)
         {
-            t_grid = grid;
+            t_gridKey = gridKey;
             t_generator = grid->createPathSegmentGenerator();
         }
         t_generator->start(path);
@@ -502,7 +573,7 @@ namespace
 double MediumSystem::getOpticalDepth(const SpatialGridPath* path, double lambda, MaterialMix::MaterialType type) const
 {
     // determine the geometric details of the path and calculate the optical depth at the same time
-    auto generator = getPathSegmentGenerator(_grid, path);
+    auto generator = getPathSegmentGenerator(_grid, _gridKey, path);
     double tau = 0.;
     while (generator->next())
     {
@@ -516,7 +587,7 @@ double MediumSystem::getOpticalDepth(const SpatialGridPath* path, double lambda,
 void MediumSystem::setOpticalDepths(PhotonPacket* pp) const
 {
     // determine and store the path segments in the photon packet
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _gridKey, pp);
     pp->clear();
     while (generator->next())
     {
@@ -524,145 +595,148 @@ void MediumSystem::setOpticalDepths(PhotonPacket* pp) const
     }
 
     // calculate the cumulative optical depth and store it in the photon packet for each path segment
-    double tau = 0.;
-    int i = 0;
 
-    // single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
-    {
-        double section = mix(0, 0)->sectionExt(pp->wavelength());
-        for (auto& segment : pp->segments())
+    // the storage type of the medium state is selected once for the complete path
+    _state.visit([this, pp](const auto& state) {
+        // single medium, spatially constant cross sections;
+        // the optical depth for the individual segments is calculated in a separate pass before being accumulated
+        if (_config->hasSingleConstantSectionMedium())
         {
-            if (segment.m >= 0) tau += section * _state.numberDensity(segment.m, 0) * segment.ds;
-            pp->setOpticalDepth(i++, tau);
+            double section = mix(0, 0)->sectionExt(pp->wavelength());
+            pp->setOpticalDepths([&state, section](int m, double ds, double /*s*/) {
+                return section * state.numberDensity(m, 0) * ds;
+            });
         }
-    }
 
-    // multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
-    {
-        ShortArray sectionv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
-        for (auto& segment : pp->segments())
+        // multiple media, spatially constant cross sections;
+        // the contribution of each medium is added directly to the cumulative optical depth, in the same order as
+        // in the other optical depth calculations, so that the results do not depend on the calculation used
+        else if (_config->hasMultipleConstantSectionMedia())
         {
-            if (segment.m >= 0)
-                for (int h = 0; h != _numMedia; ++h)
-                    tau += sectionv[h] * _state.numberDensity(segment.m, h) * segment.ds;
-            pp->setOpticalDepth(i++, tau);
+            ShortArray sectionv(_numMedia);
+            for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
+            const auto& mv = pp->cellIndices();
+            const auto& dsv = pp->segmentLengths();
+            int numSegments = pp->numSegments();
+            double tau = 0.;
+            for (int i = 0; i != numSegments; ++i)
+            {
+                int m = mv[i];
+                if (m >= 0)
+                    for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * state.numberDensity(m, h) * dsv[i];
+                pp->setOpticalDepth(i, tau);
+            }
         }
-    }
 
-    // spatially variable cross sections
-    else
-    {
-        for (auto& segment : pp->segments())
+        // spatially variable cross sections;
+        // the optical depth for the individual segments is calculated in a separate pass before being accumulated
+        else
         {
-            if (segment.m >= 0)
-            {
-                double lambda =
-                    pp->perceivedWavelength(_state.bulkVelocity(segment.m), _config->hubbleExpansionRate() * segment.s);
-                tau += opacityExt(lambda, segment.m) * segment.ds;
-            }
-            pp->setOpticalDepth(i++, tau);
+            pp->setOpticalDepths([this, &state, pp](int m, double ds, double s) {
+                double lambda = pp->perceivedWavelength(state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
+                return opacityExt(lambda, m) * ds;
+            });
         }
-    }
+    });
 }
 
 ////////////////////////////////////////////////////////////////////
 
 bool MediumSystem::setInteractionPoint(PhotonPacket* pp, double tauscat) const
 {
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _gridKey, pp);
     double tau = 0.;
     double s = 0.;
 
-    // loop over the segments of the path until the interaction optical depth is reached or the path ends
-
-    // --> single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
-    {
-        double section = mix(0, 0)->sectionExt(pp->wavelength());
-        while (generator->next())
+    // loop over the segments of the path until the interaction optical depth is reached or the path ends;
+    // the storage type of the medium state is selected once for the complete path
+    return _state.visit([&](const auto& state) {
+        // --> single medium, spatially constant cross sections
+        if (_config->hasSingleConstantSectionMedium())
         {
-            // remember the cumulative optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tau0 = tau;
-            double s0 = s;
-
-            // calculate the cumulative optical depth and distance at the end of this segment
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0) tau += section * _state.numberDensity(m, 0) * generator->ds();
-            s += ds;
-
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauscat < tau)
+            double section = mix(0, 0)->sectionExt(pp->wavelength());
+            while (generator->next())
             {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauscat, tau0, tau, s0, s));
-                return true;
+                // remember the cumulative optical depth and distance at the start of this segment
+                // so that we can interpolate the interaction point should it happen to be inside this segment
+                double tau0 = tau;
+                double s0 = s;
+
+                // calculate the cumulative optical depth and distance at the end of this segment
+                double ds = generator->ds();
+                int m = generator->m();
+                if (m >= 0) tau += section * state.numberDensity(m, 0) * generator->ds();
+                s += ds;
+
+                // if the interaction point is inside this segment, store it in the photon packet
+                if (tauscat < tau)
+                {
+                    pp->setInteractionPoint(m, NR::interpolateLinLin(tauscat, tau0, tau, s0, s));
+                    return true;
+                }
             }
         }
-    }
 
-    // --> multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
-    {
-        ShortArray sectionv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
-        while (generator->next())
+        // --> multiple media, spatially constant cross sections
+        else if (_config->hasMultipleConstantSectionMedia())
         {
-            // remember the cumulative optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tau0 = tau;
-            double s0 = s;
-
-            // calculate the cumulative optical depth and distance at the end of this segment
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0)
-                for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * _state.numberDensity(m, h) * ds;
-            s += ds;
-
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauscat < tau)
+            ShortArray sectionv(_numMedia);
+            for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
+            while (generator->next())
             {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauscat, tau0, tau, s0, s));
-                return true;
+                // remember the cumulative optical depth and distance at the start of this segment
+                // so that we can interpolate the interaction point should it happen to be inside this segment
+                double tau0 = tau;
+                double s0 = s;
+
+                // calculate the cumulative optical depth and distance at the end of this segment
+                double ds = generator->ds();
+                int m = generator->m();
+                if (m >= 0)
+                    for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * state.numberDensity(m, h) * ds;
+                s += ds;
+
+                // if the interaction point is inside this segment, store it in the photon packet
+                if (tauscat < tau)
+                {
+                    pp->setInteractionPoint(m, NR::interpolateLinLin(tauscat, tau0, tau, s0, s));
+                    return true;
+                }
             }
         }
-    }
 
-    // --> spatially variable cross sections
-    else
-    {
-        while (generator->next())
+        // --> spatially variable cross sections
+        else
         {
-            // remember the cumulative optical depth and distance at the start of this segment
-            // so that we can interpolate the interaction point should it happen to be inside this segment
-            double tau0 = tau;
-            double s0 = s;
-
-            // calculate the cumulative optical depth and distance at the end of this segment
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0)
+            while (generator->next())
             {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
-                tau += opacityExt(lambda, m) * ds;
-            }
-            s += ds;
+                // remember the cumulative optical depth and distance at the start of this segment
+                // so that we can interpolate the interaction point should it happen to be inside this segment
+                double tau0 = tau;
+                double s0 = s;
+
+                // calculate the cumulative optical depth and distance at the end of this segment
+                double ds = generator->ds();
+                int m = generator->m();
+                if (m >= 0)
+                {
+                    double lambda = pp->perceivedWavelength(state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
+                    tau += opacityExt(lambda, m) * ds;
+                }
+                s += ds;
 
-            // if the interaction point is inside this segment, store it in the photon packet
-            if (tauscat < tau)
-            {
-                pp->setInteractionPoint(m, NR::interpolateLinLin(tauscat, tau0, tau, s0, s));
-                return true;
+                // if the interaction point is inside this segment, store it in the photon packet
+                if (tauscat < tau)
+                {
+                    pp->setInteractionPoint(m, NR::interpolateLinLin(tauscat, tau0, tau, s0, s));
+                    return true;
+                }
             }
         }
-    }
 
-    // the interaction point is outside of the path
-    return false;
+        // the interaction point is outside of the path
+        return false;
+    });
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -676,64 +750,201 @@ double MediumSystem::getOpticalDepth(PhotonPacket* pp, double distance) const
     double taumax = std::log(L) + 745;
 
     // determine the geometric details of the path and calculate the optical depth at the same time
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _gridKey, pp);
     double tau = 0.;
     double s = 0.;
 
-    // single medium, spatially constant cross sections
-    if (_config->hasSingleConstantSectionMedium())
-    {
-        double section = mix(0, 0)->sectionExt(pp->wavelength());
-        while (generator->next())
+    // the storage type of the medium state is selected once for the complete path
+    return _state.visit([&](const auto& state) {
+        // single medium, spatially constant cross sections
+        if (_config->hasSingleConstantSectionMedium())
         {
-            if (generator->m() >= 0)
+            double section = mix(0, 0)->sectionExt(pp->wavelength());
+            while (generator->next())
             {
-                tau += section * _state.numberDensity(generator->m(), 0) * generator->ds();
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                if (generator->m() >= 0)
+                {
+                    tau += section * state.numberDensity(generator->m(), 0) * generator->ds();
+                    if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                }
+                s += generator->ds();
+                if (s > distance) break;
             }
-            s += generator->ds();
-            if (s > distance) break;
         }
-    }
 
-    // multiple media, spatially constant cross sections
-    else if (_config->hasMultipleConstantSectionMedia())
-    {
-        ShortArray sectionv(_numMedia);
-        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
-        while (generator->next())
+        // multiple media, spatially constant cross sections
+        else if (_config->hasMultipleConstantSectionMedia())
         {
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0)
+            ShortArray sectionv(_numMedia);
+            for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(pp->wavelength());
+            while (generator->next())
             {
-                for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * _state.numberDensity(m, h) * ds;
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                double ds = generator->ds();
+                int m = generator->m();
+                if (m >= 0)
+                {
+                    for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * state.numberDensity(m, h) * ds;
+                    if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                }
+                s += ds;
+                if (s > distance) break;
             }
-            s += ds;
-            if (s > distance) break;
         }
-    }
 
-    // spatially variable cross sections
-    else
-    {
-        while (generator->next())
+        // spatially variable cross sections
+        else
         {
-            double ds = generator->ds();
-            int m = generator->m();
-            if (m >= 0)
+            while (generator->next())
             {
-                double lambda = pp->perceivedWavelength(_state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
-                tau += opacityExt(lambda, m) * ds;
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                double ds = generator->ds();
+                int m = generator->m();
+                if (m >= 0)
+                {
+                    double lambda = pp->perceivedWavelength(state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
+                    tau += opacityExt(lambda, m) * ds;
+                    if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                }
+                s += ds;
+                if (s > distance) break;
             }
-            s += ds;
-            if (s > distance) break;
         }
+
+        return tau;
+    });
+}
+
+////////////////////////////////////////////////////////////////////
+
+int MediumSystem::cacheEscapeOpticalDepths(Direction bfk)
+{
+    // reuse an existing cache for the same direction, if any
+    for (size_t i = 0; i != _escapeCaches.size(); ++i)
+    {
+        const auto& cache = _escapeCaches[i];
+        if (cache.bfk.x() == bfk.x() && cache.bfk.y() == bfk.y() && cache.bfk.z() == bfk.z()) return i;
     }
 
-    return tau;
+    // create a new cache with two unit vectors perpendicular to the direction
+    _escapeCaches.emplace_back();
+    auto& cache = _escapeCaches.back();
+    cache.bfk = bfk;
+    Vec axis = abs(bfk.x()) < 0.9 ? Vec(1., 0., 0.) : Vec(0., 1., 0.);
+    cache.bfu = Vec::cross(axis, bfk);
+    cache.bfu /= cache.bfu.norm();
+    cache.bfv = Vec::cross(bfk, cache.bfu);
+    cache.maxLength = _grid->boundingBox().widths().norm();
+    cache.framevv.resize(_numCells, 3);
+    cache.columnvvv.resize(_numCells, 5, _numMedia);
+    MemoryRegistry::add(this, MemoryRegistry::Category::State,
+                        (cache.framevv.size() + cache.columnvvv.size()) * sizeof(double));
+
+    // trace paths from the center of each cell and from four transversely offset positions in parallel,
+    // skipping the segment inside the cell itself; the offset is reduced until all offset positions lie inside
+    // the cell, so that the paths do not sample column densities for another cell
+    auto log = find<Log>();
+    log->info("Caching escape column densities for " + std::to_string(_numCells) + " cells...");
+    log->infoSetElapsed(_numCells);
+    auto parfac = find<ParallelFactory>();
+    parfac->parallelDistributed()->call(_numCells, [this, log, &cache](size_t firstIndex, size_t numIndices) {
+        SpatialGridPath path;
+        path.setDirection(cache.bfk);
+        while (numIndices)
+        {
+            size_t currentChunkSize = min(logProgressChunkSize, numIndices);
+            for (size_t m = firstIndex; m != firstIndex + currentChunkSize; ++m)
+            {
+                Position center = _grid->centralPositionInCell(m);
+                double delta = 0.25 * _grid->diagonal(m);
+                for (int attempt = 0; delta > 0.; ++attempt)
+                {
+                    if (_grid->cellIndex(Position(center + delta * cache.bfu)) == static_cast<int>(m)
+                        && _grid->cellIndex(Position(center - delta * cache.bfu)) == static_cast<int>(m)
+                        && _grid->cellIndex(Position(center + delta * cache.bfv)) == static_cast<int>(m)
+                        && _grid->cellIndex(Position(center - delta * cache.bfv)) == static_cast<int>(m))
+                        break;
+                    delta = attempt < maxEscapeOffsetReductions ? 0.5 * delta : 0.;
+                }
+                cache.framevv(m, 0) = Vec::dot(center, cache.bfu);
+                cache.framevv(m, 1) = Vec::dot(center, cache.bfv);
+                cache.framevv(m, 2) = delta > 0. ? 1. / delta : 0.;
+
+                const Vec offsetv[5] = {Vec(), delta * cache.bfu, -delta * cache.bfu, delta * cache.bfv,
+                                        -delta * cache.bfv};
+                for (int s = 0; s != 5; ++s)
+                {
+                    path.setPosition(Position(center + offsetv[s]));
+                    auto generator = getPathSegmentGenerator(_grid, _gridKey, &path);
+                    bool inside = true;
+                    while (generator->next())
+                    {
+                        int mc = generator->m();
+                        if (inside && mc == static_cast<int>(m)) continue;
+                        inside = false;
+                        if (mc >= 0)
+                        {
+                            double ds = generator->ds();
+                            for (int h = 0; h != _numMedia; ++h)
+                                cache.columnvvv(m, s, h) += _state.numberDensity(mc, h) * ds;
+                        }
+                    }
+                }
+            }
+            log->infoIfElapsed("Cached escape column densities: ", currentChunkSize);
+            firstIndex += currentChunkSize;
+            numIndices -= currentChunkSize;
+        }
+    });
+
+    // combine the results calculated by each process
+    ProcessManager::sumToAll(cache.framevv.data());
+    ProcessManager::sumToAll(cache.columnvvv.data());
+    return _escapeCaches.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MediumSystem::getEscapeOpticalDepth(int cacheIndex, PhotonPacket* pp, double distance) const
+{
+    // determine the optical depth at which the packet's contribution becomes zero
+    // or abort right away if the contribution is zero to begin with
+    double L = pp->luminosity();
+    if (L <= 0) return std::numeric_limits<double>::infinity();
+    double taumax = std::log(L) + 745;
+
+    // the cached column densities extend to the boundary of the spatial domain, so for a path that may end inside
+    // the domain, calculate the optical depth along the path up to the specified distance
+    const auto& cache = _escapeCaches[cacheIndex];
+    if (distance < cache.maxLength) return getOpticalDepth(pp, distance);
+
+    // determine the path segment in the cell containing the starting position, if any
+    auto generator = getPathSegmentGenerator(_grid, _gridKey, pp);
+    if (!generator->next()) return 0.;
+    int m = generator->m();
+    if (m < 0) return getOpticalDepth(pp, distance);
+
+    // determine the transverse offset of the starting position relative to the cell center,
+    // in units of the offset used for calculating the cache
+    Position bfr = pp->position();
+    double tu = (Vec::dot(bfr, cache.bfu) - cache.framevv(m, 0)) * cache.framevv(m, 2);
+    double tv = (Vec::dot(bfr, cache.bfv) - cache.framevv(m, 1)) * cache.framevv(m, 2);
+
+    // add the column density inside the starting cell to the column density beyond that cell interpolated
+    // quadratically along each transverse axis, and multiply by the spatially constant cross section of each medium
+    double lambda = pp->wavelength();
+    double ds = generator->ds();
+    double tau = 0.;
+    for (int h = 0; h != _numMedia; ++h)
+    {
+        double N0 = cache.columnvvv(m, 0, h);
+        double Nu1 = cache.columnvvv(m, 1, h);
+        double Nu2 = cache.columnvvv(m, 2, h);
+        double Nv1 = cache.columnvvv(m, 3, h);
+        double Nv2 = cache.columnvvv(m, 4, h);
+        double N = N0 + 0.5 * tu * (Nu1 - Nu2 + tu * (Nu1 + Nu2 - 2. * N0))
+                   + 0.5 * tv * (Nv1 - Nv2 + tv * (Nv1 + Nv2 - 2. * N0));
+        tau += mix(0, h)->sectionExt(lambda) * (_state.numberDensity(m, h) * ds + max(0., N));
+    }
+    return tau < taumax ? tau : std::numeric_limits<double>::infinity();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -763,6 +974,16 @@ void MediumSystem::storeRadiationField(bool primary, int m, int ell, double Lds)
 
 ////////////////////////////////////////////////////////////////////
 
+void MediumSystem::scaleRadiationField(bool primary, double factor)
+{
+    if (primary)
+        _rf1.data() *= factor;
+    else
+        _rf2c.data() *= factor;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MediumSystem::communicateRadiationField(bool primary)
 {
     if (primary)
@@ -776,6 +997,35 @@ void MediumSystem::communicateRadiationField(bool primary)
 
 ////////////////////////////////////////////////////////////////////
 
+void MediumSystem::writeCheckpoint(Checkpoint* checkpoint) const
+{
+    checkpoint->write(_rf1.data());
+    checkpoint->write(_rf2.data());
+    checkpoint->write(_rf2c.data());
+    if (_config->hasDynamicState())
+    {
+        Array buffer;
+        checkpoint->write(_state.data(buffer));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::readCheckpoint(Checkpoint* checkpoint)
+{
+    checkpoint->read(_rf1.data());
+    checkpoint->read(_rf2.data());
+    checkpoint->read(_rf2c.data());
+    if (_config->hasDynamicState())
+    {
+        Array data;
+        checkpoint->read(data);
+        _state.initData(data);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MediumSystem::totalAbsorbedDustLuminosity(bool primary) const
 {
     double Labs = 0.;
@@ -896,6 +1146,9 @@ bool MediumSystem::updateDynamicMediumState()
     auto parfac = find<ParallelFactory>();
     auto& recipes = dynamicStateOptions()->recipes();
 
+    // stop sharing the medium state with other simulations, if needed
+    _state.makeWritable();
+
     // tell all recipes to begin the update cycle
     for (auto recipe : recipes) recipe->beginUpdate(_numCells);
 
@@ -19,6 +19,8 @@
 #include "SimulationItem.hpp"
 #include "SpatialGrid.hpp"
 #include "Table.hpp"
+#include <cstdint>
+class Checkpoint;
 class Configuration;
 class PhotonPacket;
 class Random;
@@ -51,6 +53,13 @@ class WavelengthGrid;
     individual medium component. See the MediumState class for more information. The functions in
     this section allow access to the common state variables for a given spatial cell.
 
+    To reduce memory usage for simulations with a large number of spatial cells, the medium state
+    can be stored in single precision, and the cell volumes can be obtained from the spatial grid
+    rather than being stored. The latter is recommended only for grids that calculate cell volumes
+    cheaply, such as Cartesian, tree-based, and 1D or 2D grids. Because cell volumes in SI units
+    usually exceed the range of single precision floating point numbers, they are always obtained
+    from the spatial grid when the medium state is stored in single precision.
+
     <b>Low-level optical properties</b>
 
     These functions allow retrieving absorption, scattering and extinction cross sections for a
@@ -129,6 +138,14 @@ class MediumSystem : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(numDensitySamples, "100")
         ATTRIBUTE_DISPLAYED_IF(numDensitySamples, "Level2")
 
+        PROPERTY_BOOL(storeCellVolumes, "store the volume of each spatial cell rather than recalculating it")
+        ATTRIBUTE_DEFAULT_VALUE(storeCellVolumes, "true")
+        ATTRIBUTE_DISPLAYED_IF(storeCellVolumes, "Level3")
+
+        PROPERTY_BOOL(singlePrecisionState, "store the medium state in single rather than double precision")
+        ATTRIBUTE_DEFAULT_VALUE(singlePrecisionState, "false")
+        ATTRIBUTE_DISPLAYED_IF(singlePrecisionState, "Level3")
+
         PROPERTY_ITEM_LIST(media, Medium, "the transfer media")
         ATTRIBUTE_DEFAULT_VALUE(media, "GeometricMedium")
         ATTRIBUTE_REQUIRED_IF(media, "!NoMedium")
@@ -149,6 +166,10 @@ protected:
         in the wavelength grid returned by the Configuration::radiationFieldWLG() function. */
     void setupSelfAfter() override;
 
+    /** This function returns the media, so that these can be set up concurrently. The spatial grid
+        is set up after all media have been set up. */
+    vector<SimulationItem*> independentSetupChildren() const override;
+
     //=============== Overall medium configuration ===================
 
 public:
@@ -384,8 +405,11 @@ public:
         performance is important. Firstly, separating the geometric and optical depth calculations
         seems to be faster, probably due to memory access and caching issues. So the function first
         determines and stores the path segments and then calculates and stores the cumulative
-        optical depth at the end of each segment. Secondly, the function implements optimized
-        versions for media with spatially constant cross sections.
+        optical depth at the end of each segment. Secondly, the optical depth for the individual
+        segments is calculated in a separate pass before being accumulated (see
+        SpatialGridPath::setOpticalDepths()), so that the calculations for consecutive segments do
+        not depend on each other. Thirdly, the function implements optimized versions for media
+        with spatially constant cross sections.
 
         With the geometric path information given, the function calculates the optical depth for
         each path segment \f$(\Delta s)_m\f$ as it crosses the spatial cell with index \f$m\f$ as
@@ -449,6 +473,61 @@ public:
         happens. */
     double getOpticalDepth(PhotonPacket* pp, double distance) const;
 
+    /** This function calculates and caches, for each spatial cell and for each medium component,
+        the column densities along the specified direction from the points where a number of paths
+        starting inside the cell leave the cell to the outer boundary of the spatial domain. The
+        paths start at the center of the cell and at four positions offset from the center by a
+        quarter of the cell diagonal in opposite directions along two axes perpendicular to the
+        specified direction. If any of the offset positions lies outside of the cell, the offset
+        for that cell is halved until all offset positions lie inside the cell (or set to zero
+        after a number of attempts), so that each path samples the column density beyond the cell
+        itself. The function returns an index that can be passed to the
+        getEscapeOpticalDepth() function to use the cache. If a cache for the same direction
+        already exists, the function simply returns its index.
+
+        The work is distributed over all processes, so this function must be called by all
+        processes in the same order. The cache consumes memory for \f$N_\mathrm{cells}\times
+        (5N_\mathrm{media}+3)\f$ double-precision values.
+
+        Because the cached column densities are combined with a single cross section for each
+        medium component, the cache may be used only if the medium state does not change during
+        the simulation and if the cross sections of all media are spatially constant (see
+        Configuration::hasSingleConstantSectionMedium() and
+        Configuration::hasMultipleConstantSectionMedia()). Furthermore, the interpolation performed
+        by getEscapeOpticalDepth() is meaningful only if each cell is compact, which excludes
+        spatial grids with rotational symmetries. It is up to the caller to verify these
+        conditions. */
+    int cacheEscapeOpticalDepths(Direction bfk);
+
+    /** This function returns an approximation for the optical depth along a path through the
+        medium system defined by the initial position and direction of the specified PhotonPacket
+        object, using the escape optical depth cache with the specified index (see the
+        cacheEscapeOpticalDepths() function). The direction of the photon packet must equal the
+        direction for which the cache was calculated.
+
+        The function determines the path segment in the spatial cell containing the initial
+        position of the photon packet. For each medium component, it interpolates the cached column
+        density beyond the cell quadratically in the transverse offset of the initial position from
+        the cell center, using the three cached paths along each of the transverse axes, and adds
+        the column density for the segment inside the cell. The result is multiplied by the
+        extinction cross section of the medium component at the photon packet's wavelength, so that
+        the wavelength dependence is treated exactly. The result remains an approximation because
+        the column density beyond the cell is not a quadratic function of the transverse offset; the
+        error is largest for coarse grids with strong density gradients across a cell. Starting
+        positions with a transverse offset larger than the one used for calculating the cache are
+        extrapolated, which further increases the error near the cell boundaries.
+
+        The cached column densities extend to the boundary of the spatial domain, which is correct
+        only if the path is not truncated at the specified \em distance inside the domain. If the
+        distance is smaller than the diagonal of the spatial domain, the function therefore
+        calculates the optical depth along the path as the getOpticalDepth() function.
+
+        Like getOpticalDepth(), the function returns positive infinity if the optical depth
+        exceeds the value at which the contribution of the photon packet becomes zero. If the
+        initial position lies outside of the spatial grid, the function falls back to the
+        getOpticalDepth() function for the specified distance. */
+    double getEscapeOpticalDepth(int cacheIndex, PhotonPacket* pp, double distance) const;
+
     //=============== Radiation field ===================
 
 public:
@@ -473,6 +552,13 @@ public:
         are out of range, undefined behavior results. */
     void storeRadiationField(bool primary, int m, int ell, double Lds);
 
+    /** This function multiplies all radiation field bins in the primary table (if the \em primary
+        flag is true) or in the temporary secondary table (if the flag is false) by the specified
+        factor. It is intended for compensating the radiation field accumulated during a
+        simulation segment that was terminated before all photon packets had been launched. The
+        function should be called in serial code after finishing the segment. */
+    void scaleRadiationField(bool primary, double factor);
+
     /** This function accumulates the radiation field between multiple processes. In simulation
         modes that record the radiation field, the function should be called in serial code after
         finishing a simulation segment (i.e. after a before set of photon packets has been
@@ -481,6 +567,16 @@ public:
         synchronized and its contents is copied into the stable secondary table. */
     void communicateRadiationField(bool primary);
 
+    /** This function appends the radiation field tables and, if the simulation has a dynamic
+        medium state, the values of all medium state variables to the specified checkpoint. Because
+        the radiation field tables being accumulated during a segment are not synchronized between
+        processes, each process writes its own version. */
+    void writeCheckpoint(Checkpoint* checkpoint) const;
+
+    /** This function restores the information written by the writeCheckpoint() function from the
+        specified checkpoint. */
+    void readCheckpoint(Checkpoint* checkpoint);
+
     /** This function returns the bolometric luminosity absorbed by dust media across the complete
         domain of the spatial grid, using the partial radiation field stored in the table indicated
         by the \em primary flag (true for the primary table, false for the stable secondary table).
@@ -602,12 +698,14 @@ public:
 
 private:
     Configuration* _config{nullptr};
+    size_t _gridKey{0};  // key identifying the spatial grid for the thread-local path segment generators
 
     // relevant for any simulation mode that includes a medium
     int _numCells{0};  // index m
     int _numMedia{0};  // index h
     bool _mixPerCell{false};
-    vector<const MaterialMix*> _mixv;  // material mixes; indexed on h, or on m and h if mixPerCell is true
+    vector<const MaterialMix*> _mixv;  // material mixes; indexed on h, or on mixIndexv if mixPerCell is true
+    vector<uint16_t> _mixIndexv;       // indices in mixv for each cell and each medium; indexed on m and h
     MediumState _state;                // state info for each cell and each medium
 
     // cached info relevant for any simulation mode that includes a medium
@@ -627,6 +725,21 @@ private:
 
     // relevant for any simulation mode that includes dust emission
     int _numDustEmissionWavelengths{0};
+
+    // escape optical depth caches, each for a given direction and with two unit vectors perpendicular to it;
+    // for each cell, a table holds the projections of the cell center on these vectors and the inverse of the
+    // transverse offset, and another table holds the column densities for the paths from the center (s=0) and
+    // from the offset positions (s=1..4) indexed on m, s and h
+    struct EscapeOpticalDepthCache
+    {
+        Direction bfk;
+        Vec bfu;
+        Vec bfv;
+        double maxLength;  // the diagonal of the spatial domain, i.e. the longest possible path inside it
+        Table<2> framevv;
+        Table<3> columnvvv;
+    };
+    vector<EscapeOpticalDepthCache> _escapeCaches;
 };
 
 ////////////////////////////////////////////////////////////////
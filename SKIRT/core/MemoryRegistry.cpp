@@ -0,0 +1,144 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "MemoryRegistry.hpp"
+#include "Log.hpp"
+#include "ProcessManager.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include "TextOutFile.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the human-readable names for the allocation categories, in the order of the Category enumeration
+    const vector<string> categoryNames = {"grid", "medium state", "radiation field", "detectors", "material mixes",
+                                          "snapshots"};
+
+    // converts a number of bytes to MB
+    double toMB(double bytes)
+    {
+        return bytes / (1024. * 1024.);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+MemoryRegistry::MemoryRegistry(SimulationItem* parent) : _allocated(categoryNames.size())
+{
+    parent->addChild(this);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryRegistry::add(const SimulationItem* item, Category category, size_t bytes)
+{
+    auto registry = item->find<MemoryRegistry>(false);
+    if (registry)
+    {
+        std::unique_lock<std::mutex> lock(registry->_mutex);
+        registry->_allocated[static_cast<int>(category)] += bytes;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryRegistry::beginPhase(string name)
+{
+    endPhase();
+
+    Phase phase;
+    phase.name = name;
+    phase.startUsage = System::currentMemoryUsage();
+    phase.startPeak = System::peakMemoryUsage();
+    _phases.push_back(phase);
+    _inPhase = true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryRegistry::endPhase()
+{
+    if (!_inPhase) return;
+    _inPhase = false;
+
+    Phase& phase = _phases.back();
+    phase.endUsage = System::currentMemoryUsage();
+    size_t peak = System::peakMemoryUsage();
+    phase.peakUsage = max(peak > phase.startPeak ? peak : 0, max(phase.startUsage, phase.endUsage));
+    std::unique_lock<std::mutex> lock(_mutex);
+    phase.allocated = _allocated;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryRegistry::report()
+{
+    endPhase();
+
+    // gather the figures for all processes into a single array at the root, using a separate slice per process
+    int numProcs = ProcessManager::size();
+    int numPhases = _phases.size();
+    int numCategories = categoryNames.size();
+    int numValues = 2 + numCategories;
+    Array values(static_cast<size_t>(numProcs) * numPhases * numValues);
+    for (int p = 0; p != numPhases; ++p)
+    {
+        const Phase& phase = _phases[p];
+        size_t index = (static_cast<size_t>(ProcessManager::rank()) * numPhases + p) * numValues;
+        values[index] = toMB(phase.endUsage);
+        values[index + 1] = toMB(phase.peakUsage);
+        for (int c = 0; c != numCategories; ++c) values[index + 2 + c] = toMB(phase.allocated[c]);
+    }
+    ProcessManager::sumToRoot(values);
+    if (!ProcessManager::isRoot()) return;
+
+    // log the allocations per category at the end of the simulation for the root process
+    auto log = find<Log>();
+    string allocations;
+    for (int c = 0; c != numCategories; ++c)
+    {
+        if (_allocated[c])
+        {
+            if (!allocations.empty()) allocations += ", ";
+            allocations += categoryNames[c] + " " + StringUtils::toMemSizeString(_allocated[c]);
+        }
+    }
+    if (!allocations.empty()) log->info("Memory allocated by category: " + allocations);
+
+    // log the peak memory usage per phase, including the maximum over all processes
+    for (int p = 0; p != numPhases; ++p)
+    {
+        double maxPeak = 0.;
+        for (int r = 0; r != numProcs; ++r)
+            maxPeak = max(maxPeak, values[(static_cast<size_t>(r) * numPhases + p) * numValues + 1]);
+        string message = "Peak memory usage during " + _phases[p].name + ": "
+                         + StringUtils::toMemSizeString(_phases[p].peakUsage);
+        if (numProcs > 1) message += " (largest over all processes: " + StringUtils::toString(maxPeak, 'f', 1) + " MB)";
+        log->info(message);
+    }
+
+    // write the output file on behalf of the simulation, so that the log message mentions a meaningful item type
+    TextOutFile out(static_cast<SimulationItem*>(parent()), "memory", "memory usage per phase");
+    for (int p = 0; p != numPhases; ++p) out.writeLine("# phase " + std::to_string(p) + ": " + _phases[p].name);
+    out.addColumn("process rank", "", 'd');
+    out.addColumn("phase index", "", 'd');
+    out.addColumn("memory usage at the end of the phase", "MB", 'f', 1);
+    out.addColumn("peak memory usage during the phase", "MB", 'f', 1);
+    for (int c = 0; c != numCategories; ++c) out.addColumn("allocated for " + categoryNames[c], "MB", 'f', 3);
+    for (int r = 0; r != numProcs; ++r)
+    {
+        for (int p = 0; p != numPhases; ++p)
+        {
+            size_t index = (static_cast<size_t>(r) * numPhases + p) * numValues;
+            vector<double> row({static_cast<double>(r), static_cast<double>(p)});
+            for (int i = 0; i != numValues; ++i) row.push_back(values[index + i]);
+            out.writeRow(row);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,102 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef MEMORYREGISTRY_HPP
+#define MEMORYREGISTRY_HPP
+
+#include "SimulationItem.hpp"
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+/** A MemoryRegistry object keeps track of the memory allocated by the major data structures in a
+    simulation, and of the memory usage of the process during each phase of the simulation. There
+    is a single memory registry per simulation, held as a non-discoverable property by the
+    Simulation instance at the top of the simulation hierarchy.
+
+    <b>Allocations</b>
+
+    Simulation items and helper objects that allocate a substantial amount of memory report the
+    number of allocated bytes to the registry through the static add() function, tagged with a
+    category from the Category enumeration. The registry accumulates the reported allocations per
+    category. The figures are estimates calculated by the client from the size of its data
+    structures; they do not include the overhead of the memory allocator.
+
+    <b>Phases</b>
+
+    The simulation announces the start of each phase (e.g. setup, primary emission, final output)
+    by calling the beginPhase() function. For each phase, the registry records the memory usage of
+    the process at the end of the phase and the peak memory usage during the phase, in addition to
+    the allocations reported up to that point. The operating system provides only the peak memory
+    usage since the start of the process. If this peak has increased during a phase, it is the
+    exact peak usage for the phase. Otherwise, the peak usage for the phase is approximated by the
+    largest of the current usage at the start and at the end of the phase, which is a lower bound.
+
+    <b>Report</b>
+
+    At the end of the simulation, the report() function combines the information from all
+    processes. It logs the allocations per category and the peak memory usage per phase, and it
+    writes a text file named <tt>prefix_memory.dat</tt> in the output directory with a row for
+    each process and each phase, listing the memory usage at the end of the phase, the peak memory
+    usage during the phase, and the accumulated allocations per category at the end of the phase,
+    all in MB. */
+class MemoryRegistry : public SimulationItem
+{
+public:
+    /** This enumeration lists the categories for the allocations reported to the registry. */
+    enum class Category : int { Grid, State, RadiationField, Detectors, Mixes, Snapshots };
+
+    //============= Construction - Setup - Destruction =============
+
+public:
+    /** This constructor creates a memory registry that is hooked up as a child to the specified
+        parent in the simulation hierarchy, so that it will automatically be deleted. */
+    explicit MemoryRegistry(SimulationItem* parent);
+
+    //====================== Other Functions =======================
+
+public:
+    /** This function adds the specified number of bytes to the allocations for the specified
+        category in the memory registry of the simulation hierarchy containing the specified
+        simulation item. If there is no memory registry in the hierarchy (e.g. because the item is
+        used outside of a simulation), the function does nothing. The function is thread-safe. */
+    static void add(const SimulationItem* item, Category category, size_t bytes);
+
+    /** This function ends the current phase, if any, and starts a new phase with the specified
+        name. */
+    void beginPhase(string name);
+
+    /** This function ends the current phase, if any, combines the information from all processes,
+        logs a summary, and writes the output file. It must be called by all processes at the same
+        point in the execution flow. */
+    void report();
+
+private:
+    /** This function records the memory usage figures for the current phase, if any. */
+    void endPhase();
+
+    //======================== Data Members ========================
+
+private:
+    // the information recorded for each phase
+    struct Phase
+    {
+        string name;
+        size_t startUsage{0};      // current usage at the start of the phase
+        size_t startPeak{0};       // process peak usage at the start of the phase
+        size_t endUsage{0};        // current usage at the end of the phase
+        size_t peakUsage{0};       // (approximate) peak usage during the phase
+        vector<size_t> allocated;  // accumulated allocations per category at the end of the phase
+    };
+
+    std::mutex _mutex;          // guards the allocations
+    vector<size_t> _allocated;  // accumulated allocations per category
+    vector<Phase> _phases;      // the phases recorded so far
+    bool _inPhase{false};       // true if the last phase has not yet ended
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -9,17 +9,40 @@
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
 #include "PhotonPacket.hpp"
+#include "Random.hpp"
 #include "ProcessManager.hpp"
 #include "SecondarySourceSystem.hpp"
 #include "ShortArray.hpp"
 #include "SpecialFunctions.hpp"
 #include "StringUtils.hpp"
 #include "TimeLogger.hpp"
+#include <array>
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the simulation phases identifying the position in the simulation stored in a checkpoint,
+    // in the order in which they are executed
+    enum Phase : int {
+        NoPhase = 0,
+        PrimaryEmissionPhase,
+        DynamicStatePhase,
+        FinalPrimaryEmissionPhase,
+        DustSelfAbsorptionPhase,
+        SecondaryEmissionPhase
+    };
+}
 
 ////////////////////////////////////////////////////////////////////
 
 void MonteCarloSimulation::setupSimulation()
 {
+    // prepare for predicting the run time when running a pilot in emulation mode
+    if (_config->emulationMode() && _config->numPilotPackets() > 0.)
+        _runtimePredictor.reset(new RuntimePredictor(this));
+
     // perform regular setup for the hierarchy and wait for all processes to finish
     {
         TimeLogger logger(log(), "setup");
@@ -35,6 +58,7 @@ void MonteCarloSimulation::setupSimulation()
         // notify the probe system
         probeSystem()->probeSetup();
     }
+    if (_runtimePredictor) _runtimePredictor->endSetup();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -49,6 +73,16 @@ void MonteCarloSimulation::setupSelfBefore()
 
 ////////////////////////////////////////////////////////////////////
 
+vector<SimulationItem*> MonteCarloSimulation::independentSetupChildren() const
+{
+    vector<SimulationItem*> result;
+    if (sourceSystem()) result.push_back(sourceSystem());
+    if (mediumSystem()) result.push_back(mediumSystem());
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Configuration* MonteCarloSimulation::config() const
 {
     return _config;
@@ -62,22 +96,55 @@ void MonteCarloSimulation::runSimulation()
     {
         TimeLogger logger(log(), "the run");
 
+        // initialize the photon life-cycle parameters, which may be tuned by the pilot run or restored on resume
+        _minWeightReduction = _config->minWeightReduction();
+        _pathLengthBias = _config->pathLengthBias();
+
+        // prepare for checkpointing and restore the state from a previous checkpoint, if requested
+        if (_config->checkpointInterval() > 0. || _config->resumeFromCheckpoint())
+        {
+            _checkpoint.reset(new Checkpoint(this));
+            _lastCheckpointTime = std::chrono::steady_clock::now();
+            if (_config->resumeFromCheckpoint()) readCheckpoint();
+        }
+
+        // the memory usage of the pilot run is attributed to the primary emission phase
+        memoryRegistry()->beginPhase("primary emission");
+
+        // pilot run tuning the photon life-cycle parameters, if requested (the tuned values are restored on resume)
+        // (not when predicting the run time, because the pilot launches too few photon packets to be meaningful)
+        if (_config->tuneParameters() && !_resumePhase && !_runtimePredictor) runPilot();
+
         // primary emission segment, possibly with dynamic medium state iterations
         if (_config->hasDynamicState() && sourceSystem()->luminosity())
-            runPrimaryEmissionWithDynamicState();
+        {
+            if (_resumePhase <= FinalPrimaryEmissionPhase) runPrimaryEmissionWithDynamicState();
+        }
         else
-            runPrimaryEmission();
+        {
+            if (_resumePhase <= PrimaryEmissionPhase) runPrimaryEmission();
+        }
 
         // dust self-absorption iteration segments
-        if (_config->hasDustSelfAbsorption()) runDustSelfAbsorptionPhase();
+        if (_config->hasDustSelfAbsorption() && _resumePhase <= DustSelfAbsorptionPhase)
+        {
+            memoryRegistry()->beginPhase("dust self-absorption");
+            runDustSelfAbsorptionPhase();
+        }
 
         // secondary emission segment
-        if (_config->hasSecondaryEmission()) runSecondaryEmission();
+        if (_config->hasSecondaryEmission() && _resumePhase <= SecondaryEmissionPhase)
+        {
+            memoryRegistry()->beginPhase("secondary emission");
+            runSecondaryEmission();
+        }
     }
 
     // write final output
     {
         TimeLogger logger(log(), "final output");
+        memoryRegistry()->beginPhase("final output");
+        if (_runtimePredictor) _runtimePredictor->beginPhase();
 
         // notify the probe system
         probeSystem()->probeRun();
@@ -86,6 +153,13 @@ void MonteCarloSimulation::runSimulation()
         instrumentSystem()->flush();
         instrumentSystem()->write();
     }
+
+    // report the predicted run time, if requested
+    if (_runtimePredictor)
+    {
+        _runtimePredictor->endOutput();
+        _runtimePredictor->report();
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -94,9 +168,10 @@ void MonteCarloSimulation::runPrimaryEmission()
 {
     string segment = "primary emission";
     TimeLogger logger(log(), segment);
+    if (_runtimePredictor) _runtimePredictor->beginPhase();
 
-    // clear the radiation field
-    if (_config->hasRadiationField()) mediumSystem()->clearRadiationField(true);
+    // clear the radiation field, unless it has been restored from a checkpoint
+    if (_config->hasRadiationField() && !isResuming(PrimaryEmissionPhase)) mediumSystem()->clearRadiationField(true);
 
     // shoot photons from primary sources, if needed
     size_t Npp = _config->numPrimaryPackets();
@@ -108,19 +183,146 @@ void MonteCarloSimulation::runPrimaryEmission()
     {
         log()->warning("Skipping primary emission because the total luminosity of primary sources is zero");
     }
+    else if (instrumentSystem()->stopAtConvergence())
+    {
+        sourceSystem()->prepareForLaunch(Npp);
+        double weightFactor = launchUntilConverged(segment, Npp, true, _config->hasRadiationField());
+        if (_config->hasRadiationField() && weightFactor != 1.)
+            mediumSystem()->scaleRadiationField(true, weightFactor);
+    }
     else
     {
-        initProgress(segment, Npp);
         sourceSystem()->prepareForLaunch(Npp);
-        auto parallel = find<ParallelFactory>()->parallelDistributed();
-        parallel->call(
-            Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, true, _config->hasRadiationField()); });
-        instrumentSystem()->flush();
+        setCheckpointPosition(PrimaryEmissionPhase, 0);
+        launchSegment(segment, Npp, true, true, _config->hasRadiationField());
     }
 
     // wait for all processes to finish and synchronize the radiation field
     wait(segment);
     if (_config->hasRadiationField()) mediumSystem()->communicateRadiationField(true);
+    if (_runtimePredictor) _runtimePredictor->endSegment(RuntimePredictor::Segment::Primary, Npp);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::runPilot()
+{
+    string segment = "pilot run";
+    TimeLogger logger(log(), segment);
+
+    // verify that there is something to tune for
+    size_t Npp = _config->numPrimaryPackets();
+    const auto& instruments = _instrumentSystem->instruments();
+    if (!Npp || !sourceSystem()->luminosity() || instruments.empty())
+    {
+        log()->warning("Skipping pilot run because there are no primary photon packets or no instruments");
+        return;
+    }
+
+    // a setting consists of the values for the source bias, the minimum weight reduction and the path length bias
+    using Setting = std::array<double, 3>;
+    const char* names[] = {"sourceBias", "minWeightReduction", "pathLengthBias"};
+    auto settingString = [&names](const Setting& setting) {
+        string result;
+        for (int p = 0; p != 3; ++p)
+            result += string(p ? ", " : "") + names[p] + " = " + StringUtils::toString(setting[p], 'g', 3);
+        return result;
+    };
+
+    // determine the candidate values for each parameter; a parameter is tuned only if it is relevant
+    vector<vector<double>> candidates(3);
+    if (sourceSystem()->numSources() > 1) candidates[0] = {0., 0.5, 0.9};
+    if (_config->hasMedium() && _config->forceScattering())
+    {
+        candidates[1] = {1e3, 1e4, 1e5};
+        if (_config->supportsPathLengthStretching()) candidates[2] = {0., 0.5, 0.9};
+    }
+
+    // determine the number of photon packets for each evaluation
+    size_t numEvaluations = 1;
+    for (const auto& values : candidates) numEvaluations += values.size();
+    size_t Npilot =
+        max(static_cast<size_t>(1000), static_cast<size_t>(_config->pilotFraction() * Npp / numEvaluations));
+    log()->info("Evaluating up to " + std::to_string(numEvaluations) + " settings with "
+                + std::to_string(Npilot) + " photon packets each");
+
+    // evaluate the figure of merit for the given setting, or return the previously evaluated figure of merit
+    // if the setting was already evaluated (after applying the setting, which might force some values)
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+    vector<std::pair<Setting, double>> evaluated;
+    auto evaluate = [this, &instruments, &parallel, &evaluated, &settingString, Npilot, segment](Setting& setting) {
+        // apply the setting and read back the values that are actually used
+        sourceSystem()->setSourceBias(setting[0]);
+        _minWeightReduction = setting[1];
+        _pathLengthBias = setting[2];
+        setting = {{sourceSystem()->sourceBias(), _minWeightReduction, _pathLengthBias}};
+        for (const auto& pair : evaluated)
+            if (pair.first == setting) return pair.second;
+
+        // launch the pilot photon packets with peel-off in pilot mode, measuring the elapsed time
+        for (Instrument* instrument : instruments) instrument->beginPilot();
+        initProgress(segment, Npilot);
+        sourceSystem()->prepareForLaunch(Npilot);
+        auto start = std::chrono::steady_clock::now();
+        parallel->call(Npilot, [this](size_t i, size_t n) { performLifeCycle(i, n, true, true, false, 1, 0, true); });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // aggregate the measurements over all processes
+        Array sums(1 + 2 * instruments.size());
+        sums[0] = elapsed.count();
+        for (size_t i = 0; i != instruments.size(); ++i)
+            std::tie(sums[1 + 2 * i], sums[2 + 2 * i]) = instruments[i]->endPilot();
+        ProcessManager::sumToAll(sums);
+
+        // calculate the figure of merit 1/(time x variance), using the time per photon packet and the sum of the
+        // relative variances per photon packet over all instruments that detected some flux
+        double timePerPacket = sums[0] / ProcessManager::size() / Npilot;
+        double relVariance = 0.;
+        for (size_t i = 0; i != instruments.size(); ++i)
+        {
+            double sum = sums[1 + 2 * i];
+            double sum2 = sums[2 + 2 * i];
+            if (sum > 0.) relVariance += max(0., Npilot * sum2 / (sum * sum) - 1.);
+        }
+        double fom = relVariance > 0. ? 1. / (timePerPacket * relVariance) : 0.;
+        log()->info("  " + settingString(setting) + ": " + StringUtils::toString(timePerPacket * 1e6, 'g', 3)
+                    + " microseconds per packet, relative variance " + StringUtils::toString(relVariance, 'g', 3)
+                    + ", figure of merit " + StringUtils::toString(fom, 'g', 3));
+        evaluated.emplace_back(setting, fom);
+        return fom;
+    };
+
+    // optimize one parameter at a time, starting from the configured setting
+    Setting configured = {{sourceSystem()->sourceBias(), _minWeightReduction, _pathLengthBias}};
+    Setting best = configured;
+    double bestFom = evaluate(best);
+    for (int p = 0; p != 3; ++p)
+    {
+        Setting bestForParameter = best;
+        for (double value : candidates[p])
+        {
+            Setting setting = best;
+            setting[p] = value;
+            double fom = evaluate(setting);
+            if (fom > bestFom)
+            {
+                bestFom = fom;
+                bestForParameter = setting;
+            }
+        }
+        best = bestForParameter;
+    }
+
+    // apply the optimal setting, or restore the configured setting if no figure of merit could be determined
+    if (bestFom <= 0.)
+    {
+        log()->warning("Retaining configured parameters because the instruments did not detect any flux");
+        best = configured;
+    }
+    sourceSystem()->setSourceBias(best[0]);
+    _minWeightReduction = best[1];
+    _pathLengthBias = best[2];
+    log()->info("Selected " + settingString(best));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -133,9 +335,6 @@ void MonteCarloSimulation::runPrimaryEmissionWithDynamicState()
 
     TimeLogger logger(log(), "the primary emission phase");
 
-    // get the parallel engine
-    auto parallel = find<ParallelFactory>()->parallelDistributed();
-
     // get the parameters controlling the dynamic state iteration
     size_t Npp = _config->numDynamicStatePackets();
     int minIters = _config->minDynamicStateIterations();
@@ -147,8 +346,9 @@ void MonteCarloSimulation::runPrimaryEmissionWithDynamicState()
     // loop over the dynamic state iterations; the loop exits
     //   - if convergence is reached after the minimum number of iterations, or
     //   - if the maximum number of iterations has completed, even if there is no convergence
-    int iter = 0;
-    while (true)
+    // when resuming from a checkpoint, skip the completed iterations (or all iterations)
+    int iter = _resumePhase == DynamicStatePhase ? _resumeIteration - 1 : 0;
+    while (_resumePhase != FinalPrimaryEmissionPhase)
     {
         ++iter;
         bool converged = false;
@@ -156,13 +356,12 @@ void MonteCarloSimulation::runPrimaryEmissionWithDynamicState()
             string segment = "dynamic medium state iteration " + std::to_string(iter);
             TimeLogger logger(log(), segment);
 
-            // clear the radiation field
-            mediumSystem()->clearRadiationField(true);
+            // clear the radiation field, unless it has been restored from a checkpoint
+            if (!isResuming(DynamicStatePhase, iter)) mediumSystem()->clearRadiationField(true);
 
             // launch photon packets
-            initProgress(segment, Npp);
-            parallel->call(Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, false, true); });
-            instrumentSystem()->flush();
+            setCheckpointPosition(DynamicStatePhase, iter);
+            launchSegment(segment, Npp, true, false, true);
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
@@ -206,13 +405,12 @@ void MonteCarloSimulation::runPrimaryEmissionWithDynamicState()
         string segment = "final primary emission";
         TimeLogger logger(log(), segment);
 
-        // clear the radiation field
-        mediumSystem()->clearRadiationField(true);
+        // clear the radiation field, unless it has been restored from a checkpoint
+        if (!isResuming(FinalPrimaryEmissionPhase)) mediumSystem()->clearRadiationField(true);
 
         // shoot photon packets
-        initProgress(segment, Npp);
-        parallel->call(Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, true, true); });
-        instrumentSystem()->flush();
+        setCheckpointPosition(FinalPrimaryEmissionPhase, 0);
+        launchSegment(segment, Npp, true, true, true);
 
         // wait for all processes to finish and synchronize the radiation field
         wait(segment);
@@ -234,28 +432,33 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
         return;
     }
 
-    // get the parallel engine
-    auto parallel = find<ParallelFactory>()->parallelDistributed();
-
     // get the parameters controlling the self-absorption iteration
     int minIters = _config->minIterations();
     int maxIters = _config->maxIterations();
     double fractionOfPrimary = _config->maxFractionOfPrimary();
     double fractionOfPrevious = _config->maxFractionOfPrevious();
 
-    // initialize the total absorbed luminosity in the previous iteration
+    // initialize the total absorbed luminosity in the previous iteration and the first iteration,
+    // restoring these values when resuming from a checkpoint
     double prevLabsdust = 0.;
+    int firstIter = 1;
+    if (_resumePhase == DustSelfAbsorptionPhase)
+    {
+        prevLabsdust = _resumePhaseValue;
+        firstIter = _resumeIteration;
+    }
 
     // iterate over the maximum number of iterations; the loop body returns from the function
     // when convergence is reached after the minimum number of iterations have been completed
-    for (int iter = 1; iter <= maxIters; iter++)
+    for (int iter = firstIter; iter <= maxIters; iter++)
     {
         string segment = "dust self-absorption iteration " + std::to_string(iter);
         {
             TimeLogger logger(log(), segment);
+            if (_runtimePredictor) _runtimePredictor->beginPhase();
 
-            // clear the secondary radiation field
-            mediumSystem()->clearRadiationField(false);
+            // clear the secondary radiation field, unless it has been restored from a checkpoint
+            if (!isResuming(DustSelfAbsorptionPhase, iter)) mediumSystem()->clearRadiationField(false);
 
             // prepare the source system; terminate if the dust has zero luminosity (which should never happen)
             if (!_secondarySourceSystem->prepareForLaunch(Npp))
@@ -265,13 +468,15 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
             }
 
             // launch photon packets
-            initProgress(segment, Npp);
-            parallel->call(Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, false, false, true); });
-            instrumentSystem()->flush();
+            setCheckpointPosition(DustSelfAbsorptionPhase, iter, prevLabsdust);
+            launchSegment(segment, Npp, false, false, true);
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
             mediumSystem()->communicateRadiationField(false);
+            if (_runtimePredictor)
+                _runtimePredictor->endSegment(RuntimePredictor::Segment::DustSelfAbsorption, Npp,
+                                              _secondarySourceSystem);
         }
 
         // determine and log the total absorbed luminosity
@@ -337,6 +542,7 @@ void MonteCarloSimulation::runSecondaryEmission()
 {
     string segment = "secondary emission";
     TimeLogger logger(log(), segment);
+    if (_runtimePredictor) _runtimePredictor->beginPhase();
 
     // determine whether we need to store the radiation field during secondary emission
     bool storeRF = _config->storeEmissionRadiationField();
@@ -351,17 +557,200 @@ void MonteCarloSimulation::runSecondaryEmission()
     {
         log()->warning("Skipping secondary emission because the total luminosity of secondary sources is zero");
     }
+    else if (instrumentSystem()->stopAtConvergence() && !storeRF)
+    {
+        launchUntilConverged(segment, Npp, false, false);
+    }
     else
     {
-        initProgress(segment, Npp);
-        auto parallel = find<ParallelFactory>()->parallelDistributed();
-        parallel->call(Npp, [this, storeRF](size_t i, size_t n) { performLifeCycle(i, n, false, true, storeRF); });
-        instrumentSystem()->flush();
+        if (instrumentSystem()->stopAtConvergence())
+            log()->warning("Launching all secondary photon packets because the radiation field is being stored");
+        setCheckpointPosition(SecondaryEmissionPhase, 0);
+        launchSegment(segment, Npp, false, true, storeRF);
     }
 
     // wait for all processes to finish and synchronize the radiation field if needed
     wait(segment);
     if (storeRF) mediumSystem()->communicateRadiationField(false);
+    if (_runtimePredictor)
+        _runtimePredictor->endSegment(RuntimePredictor::Segment::Secondary, Npp, _secondarySourceSystem);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MonteCarloSimulation::launchUntilConverged(string segment, size_t numPackets, bool primary, bool store)
+{
+    auto is = instrumentSystem();
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+    size_t numRounds = min(static_cast<size_t>(is->numConvergenceRounds()), numPackets);
+
+    is->beginSegment();
+    initProgress(segment, numPackets);
+    size_t numLaunched = 0;
+    for (size_t round = 0; round != numRounds; ++round)
+    {
+        // launch the history indices that are congruent to the round index modulo the number of rounds,
+        // so that each round covers the complete range of history indices (and thus all sources)
+        size_t numInRound = (numPackets - round + numRounds - 1) / numRounds;
+        if (_runtimePredictor) _runtimePredictor->beginLaunch();
+        parallel->call(numInRound, [this, primary, store, round, numRounds](size_t i, size_t n) {
+            performLifeCycle(i, n, primary, true, store, numRounds, round);
+        });
+        is->flush();
+        if (_runtimePredictor) _runtimePredictor->endLaunch();
+        numLaunched += numInRound;
+        if (numLaunched == numPackets) break;
+
+        // evaluate convergence and output intermediate results if requested
+        double weightFactor = static_cast<double>(numPackets) / numLaunched;
+        log()->info("Evaluating convergence after " + StringUtils::toString(static_cast<double>(numLaunched)) + " "
+                    + segment + " photon packets (round " + std::to_string(round + 1) + " of "
+                    + std::to_string(numRounds) + ")");
+        bool converged = is->hasConverged(numLaunched);
+        if (is->writeIntermediateOutput()) is->writeIntermediate(weightFactor);
+        if (converged)
+        {
+            log()->info("Target noise level reached; skipping the remaining "
+                        + StringUtils::toString(static_cast<double>(numPackets - numLaunched)) + " " + segment
+                        + " photon packets");
+            break;
+        }
+    }
+
+    // compensate the contributions for the photon packets that have not been launched
+    double weightFactor = static_cast<double>(numPackets) / numLaunched;
+    is->endSegment(weightFactor);
+    return weightFactor;
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the minimum and the maximum number of blocks in which the photon packets of a segment are launched
+    // when checkpointing is enabled (the minimum block size prevails over the maximum number of blocks)
+    const size_t minCheckpointBlockSize = 10000;
+    const size_t maxCheckpointBlocks = 1000;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::launchSegment(string segment, size_t numPackets, bool primary, bool peel, bool store)
+{
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+
+    // skip the photon packets completed before the checkpoint, if resuming
+    size_t numDone = 0;
+    if (_resumePhase)
+    {
+        numDone = _resumeNumDone;
+        _resumePhase = NoPhase;
+        log()->info("Resuming " + segment + " after " + StringUtils::toString(static_cast<double>(numDone))
+                    + " photon packets");
+    }
+    initProgress(segment, numPackets - numDone);
+
+    // launch the photon packets in blocks if checkpointing is enabled, and in a single block otherwise
+    bool checkpointing = _config->checkpointInterval() > 0.;
+    size_t blockSize = checkpointing ? max(minCheckpointBlockSize, numPackets / maxCheckpointBlocks) : numPackets;
+    while (numDone < numPackets)
+    {
+        size_t numInBlock = min(blockSize, numPackets - numDone);
+        if (_runtimePredictor) _runtimePredictor->beginLaunch();
+        parallel->call(numInBlock, [this, numDone, primary, peel, store](size_t i, size_t n) {
+            performLifeCycle(numDone + i, n, primary, peel, store);
+        });
+        if (_runtimePredictor) _runtimePredictor->endLaunch();
+        numDone += numInBlock;
+
+        // write a checkpoint if the interval has elapsed, using the clock of the root process for all processes
+        if (checkpointing)
+        {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _lastCheckpointTime;
+            Array due({ProcessManager::isRoot() && elapsed.count() >= _config->checkpointInterval() ? 1. : 0.});
+            ProcessManager::sumToAll(due);
+            if (due[0])
+            {
+                instrumentSystem()->flush();
+                writeCheckpoint(numDone);
+            }
+        }
+    }
+    instrumentSystem()->flush();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::setCheckpointPosition(int phase, int iteration, double value)
+{
+    _phase = phase;
+    _iteration = iteration;
+    _phaseValue = value;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MonteCarloSimulation::isResuming(int phase, int iteration) const
+{
+    return _resumePhase == phase && _resumeIteration == iteration;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::writeCheckpoint(size_t numDone)
+{
+    log()->info("Writing checkpoint after " + StringUtils::toString(static_cast<double>(numDone)) + " " + _segment
+                + " photon packets...");
+
+    _checkpoint->beginWrite();
+    _checkpoint->write(Array({static_cast<double>(_generation), static_cast<double>(_phase),
+                              static_cast<double>(_iteration), _phaseValue, static_cast<double>(numDone),
+                              sourceSystem()->sourceBias(), _minWeightReduction, _pathLengthBias}));
+    instrumentSystem()->writeCheckpoint(_checkpoint.get());
+    if (_config->hasMedium()) mediumSystem()->writeCheckpoint(_checkpoint.get());
+    _checkpoint->endWrite();
+
+    wait("writing checkpoint");
+    _lastCheckpointTime = std::chrono::steady_clock::now();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::readCheckpoint()
+{
+    if (!_checkpoint->beginRead())
+    {
+        log()->warning("No valid checkpoint found; starting the simulation from the beginning");
+        return;
+    }
+
+    // restore the position and the photon life-cycle parameters, provided all processes resume from the same position
+    Array position(8);
+    if (!_checkpoint->readConsistent(position))
+    {
+        log()->warning("Checkpoint files of the processes are inconsistent; "
+                       "starting the simulation from the beginning");
+        return;
+    }
+    _generation = static_cast<int>(position[0]) + 1;
+    _resumePhase = static_cast<int>(position[1]);
+    _resumeIteration = static_cast<int>(position[2]);
+    _resumePhaseValue = position[3];
+    _resumeNumDone = static_cast<size_t>(position[4]);
+    sourceSystem()->setSourceBias(position[5]);
+    _minWeightReduction = position[6];
+    _pathLengthBias = position[7];
+
+    // restore the recorded information
+    instrumentSystem()->readCheckpoint(_checkpoint.get());
+    if (_config->hasMedium()) mediumSystem()->readCheckpoint(_checkpoint.get());
+    _checkpoint->endRead();
+
+    // avoid repeating the random sequence used before the checkpoint
+    random()->resumeWithGeneration(_generation);
+
+    log()->info("Resuming the simulation from a checkpoint (phase " + std::to_string(_resumePhase) + ", iteration "
+                + std::to_string(_resumeIteration) + ")");
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -404,24 +793,30 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
-void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store)
+void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store,
+                                            size_t stride, size_t offset, bool pilot)
 {
     PhotonPacket pp, ppp;
 
-    // loop over the history indices, with interruptions for progress logging
+    // loop over the indices, with interruptions for progress logging
     while (numIndices)
     {
         size_t currentChunkSize = min(logProgressChunkSize, numIndices);
-        for (size_t historyIndex = firstIndex; historyIndex != firstIndex + currentChunkSize; ++historyIndex)
+        for (size_t index = firstIndex; index != firstIndex + currentChunkSize; ++index)
         {
+            size_t historyIndex = offset + index * stride;
+
             // launch a photon packet from the requested source
             if (primary)
-                sourceSystem()->launch(&pp, historyIndex);
+                sourceSystem()->launch(&pp, historyIndex, !pilot);
             else
                 _secondarySourceSystem->launch(&pp, historyIndex);
             if (pp.luminosity() > 0)
             {
-                if (peel) peelOffEmission(&pp, &ppp);
+                // determine the luminosity below which peel-off photon packets are subject to Russian roulette
+                double Lroulette = pp.luminosity() * _config->peelOffRouletteThreshold();
+
+                if (peel) peelOffEmission(&pp, &ppp, Lroulette);
 
                 // trace the packet through the media, if any
                 if (_config->hasMedium())
@@ -429,7 +824,7 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                     if (_config->forceScattering())
                     {
                         // perform cycle with forced scattering
-                        double Lthreshold = pp.luminosity() / _config->minWeightReduction();
+                        double Lthreshold = pp.luminosity() / _minWeightReduction;
                         int minScattEvents = _config->minScattEvents();
                         while (true)
                         {
@@ -446,7 +841,7 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                                 break;
 
                             // process the scattering event
-                            if (peel) peelOffScattering(&pp, &ppp);
+                            if (peel) peelOffScattering(&pp, &ppp, Lroulette);
                             mediumSystem()->simulateScattering(random(), &pp);
                         }
                     }
@@ -466,7 +861,7 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                             simulateNonForcedPropagation(&pp);
 
                             // process the scattering event
-                            if (peel) peelOffScattering(&pp, &ppp);
+                            if (peel) peelOffScattering(&pp, &ppp, Lroulette);
                             mediumSystem()->simulateScattering(random(), &pp);
                         }
                     }
@@ -483,9 +878,11 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
 
 ////////////////////////////////////////////////////////////////////
 
-void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket* ppp)
+void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket* ppp, double Lroulette)
 {
-    for (Instrument* instrument : _instrumentSystem->instruments())
+    bool played = false;   // true if the peel-off for the current observer was subject to roulette
+    bool survived = true;  // true if the peel-off for the current observer should be detected
+    for (Instrument* instrument : _instrumentSystem->groupedInstruments())
     {
         if (!instrument->isSameObserverAsPreceding())
         {
@@ -497,8 +894,12 @@ void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket*
             {
                 ppp->rotateIntoPlane(bfkobs, instrument->bfky(pp->position()));
             }
+
+            played = ppp->luminosity() < Lroulette;
+            survived = !played || playPeelOffRoulette(ppp, Lroulette);
         }
-        instrument->detect(ppp);
+        if (played) instrument->recordPeelOffRoulette(survived);
+        if (survived) instrument->detect(ppp);
     }
 }
 
@@ -506,27 +907,39 @@ void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket*
 
 void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
 {
+    // get the segment information for the path of the photon packet
+    int numSegments = pp->numSegments();
+    const auto& mv = pp->cellIndices();
+    const auto& dsv = pp->segmentLengths();
+    const auto& tauv = pp->opticalDepths();
+
     // use a faster version in case there are no kinematics
     if (_config->hasConstantPerceivedWavelength())
     {
         int ell = _config->radiationFieldWLG()->bin(pp->wavelength());
         if (ell >= 0)
         {
+            // calculate the extinction factor at the end of each segment in a separate pass,
+            // so that the exponentials for the individual segments can be evaluated independently of each other
+            thread_local vector<double> t_extv;
+            t_extv.resize(numSegments);
+            for (int i = 0; i != numSegments; ++i) t_extv[i] = exp(-tauv[i]);
+
             double luminosity = pp->luminosity();
             bool hasPrimaryOrigin = pp->hasPrimaryOrigin();
 
             double lnExtBeg = 0.;  // extinction factor and its logarithm at begin of current segment
             double extBeg = 1.;
-            for (const auto& segment : pp->segments())
+            for (int i = 0; i != numSegments; ++i)
             {
-                double lnExtEnd = -segment.tau;  // extinction factor and its logarithm at end of current segment
-                double extEnd = exp(lnExtEnd);
-                int m = segment.m;
+                double lnExtEnd = -tauv[i];  // extinction factor and its logarithm at end of current segment
+                double extEnd = t_extv[i];
+                int m = mv[i];
                 if (m >= 0)
                 {
                     // use this flavor of the lnmean function to avoid recalculating the logarithm of the extinction
                     double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
-                    double Lds = luminosity * extMean * segment.ds;
+                    double Lds = luminosity * extMean * dsv[i];
                     mediumSystem()->storeRadiationField(hasPrimaryOrigin, m, ell, Lds);
                 }
                 lnExtBeg = lnExtEnd;
@@ -536,23 +949,29 @@ void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
     }
     else
     {
+        // the extinction factors are evaluated only for the segments that are actually stored;
+        // a negative value indicates that the extinction factor at the begin of the current segment is not yet known
+        const auto& sv = pp->cumulativeLengths();
         double lnExtBeg = 0.;  // extinction factor and its logarithm at begin of current segment
         double extBeg = 1.;
-        for (const auto& segment : pp->segments())
+        for (int i = 0; i != numSegments; ++i)
         {
-            double lnExtEnd = -segment.tau;  // extinction factor and its logarithm at end of current segment
-            double extEnd = exp(lnExtEnd);
-            int m = segment.m;
+            double lnExtEnd = -tauv[i];  // extinction factor and its logarithm at end of current segment
+            double extEnd = -1.;
+            int m = mv[i];
             if (m >= 0)
             {
-                double lambda = pp->perceivedWavelength(mediumSystem()->bulkVelocity(m),
-                                                        _config->hubbleExpansionRate() * segment.s);
+                double lambda =
+                    pp->perceivedWavelength(mediumSystem()->bulkVelocity(m), _config->hubbleExpansionRate() * sv[i]);
                 int ell = _config->radiationFieldWLG()->bin(lambda);
                 if (ell >= 0)
                 {
+                    if (extBeg < 0.) extBeg = exp(lnExtBeg);
+                    extEnd = exp(lnExtEnd);
+
                     // use this flavor of the lnmean function to avoid recalculating the logarithm of the extinction
                     double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
-                    double Lds = pp->perceivedLuminosity(lambda) * extMean * segment.ds;
+                    double Lds = pp->perceivedLuminosity(lambda) * extMean * dsv[i];
                     mediumSystem()->storeRadiationField(pp->hasPrimaryOrigin(), m, ell, Lds);
                 }
             }
@@ -577,7 +996,7 @@ void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp)
     }
 
     // generate a random optical depth
-    double xi = _config->pathLengthBias();
+    double xi = _pathLengthBias;
     double tau = 0.;
     if (xi == 0.)
     {
@@ -621,7 +1040,7 @@ void MonteCarloSimulation::simulateNonForcedPropagation(PhotonPacket* pp)
 
 ////////////////////////////////////////////////////////////////////
 
-void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp)
+void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp, double Lroulette)
 {
     // determine the perceived wavelength at the scattering location
     double lambda = mediumSystem()->perceivedWavelengthForScattering(pp);
@@ -632,7 +1051,9 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
     if (!mediumSystem()->weightsForScattering(wv, lambda, pp)) return;
 
     // now do the actual peel-off for each instrument
-    for (Instrument* instr : _instrumentSystem->instruments())
+    bool played = false;   // true if the peel-off for the current observer was subject to roulette
+    bool survived = true;  // true if the peel-off for the current observer should be detected
+    for (Instrument* instr : _instrumentSystem->groupedInstruments())
     {
         if (!instr->isSameObserverAsPreceding())
         {
@@ -643,11 +1064,26 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
             // calculate peel-off for all medium components and launch the peel-off photon packet
             // (all media must either support polarization or not; combining these support levels is not allowed)
             mediumSystem()->peelOffScattering(lambda, wv, bfkobs, bfky, pp, ppp);
+
+            // subject a peel-off with a negligible phase-function-weighted luminosity to Russian roulette
+            played = ppp->luminosity() < Lroulette;
+            survived = !played || playPeelOffRoulette(ppp, Lroulette);
         }
 
-        // have the peel-off photon packet detected
-        instr->detect(ppp);
+        // have the peel-off photon packet detected, unless it was eliminated by Russian roulette
+        if (played) instr->recordPeelOffRoulette(survived);
+        if (survived) instr->detect(ppp);
     }
 }
 
 ////////////////////////////////////////////////////////////////////
+
+bool MonteCarloSimulation::playPeelOffRoulette(PhotonPacket* ppp, double Lroulette)
+{
+    double survivalProbability = ppp->luminosity() / Lroulette;
+    if (random()->uniform() >= survivalProbability) return false;
+    ppp->applyBias(1. / survivalProbability);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
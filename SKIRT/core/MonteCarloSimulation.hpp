@@ -6,13 +6,17 @@
 #ifndef MONTECARLOSIMULATION_HPP
 #define MONTECARLOSIMULATION_HPP
 
+#include "Checkpoint.hpp"
 #include "Configuration.hpp"
 #include "Cosmology.hpp"
 #include "InstrumentSystem.hpp"
 #include "MediumSystem.hpp"
 #include "ProbeSystem.hpp"
+#include "RuntimePredictor.hpp"
 #include "Simulation.hpp"
 #include "SourceSystem.hpp"
+#include <chrono>
+#include <memory>
 class SecondarySourceSystem;
 
 //////////////////////////////////////////////////////////////////////
@@ -38,7 +42,37 @@ class SecondarySourceSystem;
     automatically set to an instance of the Configuration class. The setup() function of the config
     object is invoked at the very early stages of overall simulation setup, so that it can
     initialize its internal state to reflect the simulation configuration. As a result, it is safe
-    for other simulation items to retrieve information from the config object during setup. */
+    for other simulation items to retrieve information from the config object during setup.
+
+    <b>Checkpoints</b>
+
+    If requested through the Configuration::setCheckpointOptions() function (corresponding to the
+    \c -a and \c -u command line options), the simulation writes checkpoints at regular
+    wall-clock time intervals, so that a long simulation can be resumed after an interruption
+    such as a node failure or the end of a batch allocation. To this end, the photon packets for
+    each segment are launched in a number of consecutive blocks of history indices. After each
+    block, if the checkpoint interval has elapsed, each process writes its own checkpoint file (see
+    Checkpoint) in parallel. A checkpoint holds the position in the simulation (the phase, the
+    iteration, and the number of history indices completed in the current segment), the
+    photon life-cycle parameters (which may have been tuned in a pilot run), the instrument
+    detector arrays, the radiation field tables, and the dynamic medium state.
+
+    When resuming, the simulation performs setup as usual (which is deterministic), restores the
+    information from the checkpoint, skips the completed phases, iterations and photon packets,
+    and continues with the remaining photon packets in the segment that was interrupted. The
+    predictable random generator in each process is reinitialized to a different state (see
+    Random::resumeWithGeneration()) so that the resumed run does not repeat the random sequence of
+    the original run. As a result, the outcome of a resumed simulation is statistically equivalent
+    to, but not identical to, the outcome of an uninterrupted simulation. Emission segments
+    running in convergence-driven mode (see InstrumentSystem) are not checkpointed internally.
+
+    <b>Run time prediction</b>
+
+    If the simulation runs in emulation mode with a positive number of pilot photon packets (see
+    Configuration::setEmulationMode(), corresponding to the \c -e and \c -n command line options),
+    the simulation launches at most that number of photon packets in each segment, skips the pilot
+    run tuning the photon life-cycle parameters, and uses a RuntimePredictor instance to predict
+    the run time of the actual simulation from the timings of the emulated run. */
 class MonteCarloSimulation : public Simulation
 {
     /** The enumeration type indicating the simulation mode, which determines the overall structure
@@ -145,6 +179,11 @@ protected:
         secondary emission. */
     void setupSelfBefore() override;
 
+    /** This function returns the source system and the medium system, so that these can be set up
+        concurrently. For example, a source snapshot can be imported while the media are being
+        imported and the spatial grid is being constructed. */
+    vector<SimulationItem*> independentSetupChildren() const override;
+
     //======== Getters for Non-Discoverable Properties =======
 
 public:
@@ -216,6 +255,77 @@ private:
         to be converged (or simply immutable). */
     void runSecondaryEmission();
 
+    /** This function performs a pilot run that tunes the parameters controlling the photon packet
+        life cycle for the primary emission segment. It is invoked before the primary emission
+        segment if requested by the configuration. The tuned parameters are the \em sourceBias
+        property of the source system (if there are multiple sources) and, if forced scattering is
+        enabled, the minimum weight reduction factor and the path length bias.
+
+        The function evaluates a number of candidate settings, varying one parameter at a time
+        starting from the configured values. For each setting, it launches a small number of
+        primary photon packets with peel-off towards the instruments in pilot mode (see
+        FluxRecorder::beginPilot()), so that no contributions are actually recorded. It measures
+        the elapsed time per photon packet and, for each instrument, the relative variance per
+        photon packet of the total detected flux. The figure of merit for a setting is defined as
+        \f$1/(t\,\sum_i \sigma_i^2)\f$, where \f$t\f$ is the time per photon packet and
+        \f$\sigma_i^2\f$ is the relative variance for instrument \f$i\f$. The setting with the
+        largest figure of merit is retained for the remainder of the simulation. The measurements
+        for each setting and the final choice are logged.
+
+        The total number of photon packets launched in the pilot run is a configurable fraction of
+        the number of primary photon packets. These photon packets do not contribute to the
+        simulation results and are not passed to any photon packet launch probes. The candidate
+        settings are applied to the photon life-cycle parameters held by this class, so that the
+        Configuration object is not modified. */
+    void runPilot();
+
+    /** This function implements the convergence-driven mode for an emission segment that performs
+        peel-off towards the instruments (see InstrumentSystem::stopAtConvergence). The source
+        system must have been prepared for launching the specified number of photon packets. The
+        function launches the photon packets in the configured number of rounds. Round \f$r\f$
+        launches the photon packets with a history index that is congruent to \f$r\f$ modulo the
+        number of rounds, so that each round samples all sources and the complete range of history
+        indices within each source. After each round, the instrument system determines whether
+        the target noise level has been reached, in which case the remaining rounds are skipped.
+
+        Finally, the contributions recorded by the instruments during the segment are multiplied
+        by the ratio of the requested number of photon packets to the number of photon packets
+        actually launched. This weight factor is returned, so that the caller can apply it to the
+        radiation field if needed. */
+    double launchUntilConverged(string segment, size_t numPackets, bool primary, bool store);
+
+    /** This function launches the specified number of photon packets for the current segment,
+        calling the performLifeCycle() function with the specified flags in appropriately
+        parallelized code. The caller must have prepared the appropriate source system for launch
+        and must have set the checkpoint position for the segment through setCheckpointPosition().
+
+        If checkpointing is enabled, the photon packets are launched in consecutive blocks of
+        history indices, and a checkpoint is written after a block if the checkpoint interval has
+        elapsed. If the simulation is resuming from a checkpoint written during the current
+        segment, the photon packets that were completed before the checkpoint are skipped. */
+    void launchSegment(string segment, size_t numPackets, bool primary, bool peel, bool store);
+
+    /** This function sets the position in the simulation that will be stored in a checkpoint
+        written during the next segment: the phase, the iteration within the phase (or zero), and
+        a phase-specific value needed to continue the phase after resuming. */
+    void setCheckpointPosition(int phase, int iteration, double value = 0.);
+
+    /** This function returns true if the simulation is resuming from a checkpoint written during
+        the segment with the specified phase and iteration, in which case the caller should not
+        reinitialize the information restored from the checkpoint. */
+    bool isResuming(int phase, int iteration = 0) const;
+
+    /** This function writes a checkpoint for the current position in the simulation, given the
+        number of history indices completed in the current segment. It must be called by all
+        processes at the same point in the execution flow. */
+    void writeCheckpoint(size_t numDone);
+
+    /** This function restores the simulation state from the checkpoint written by a previous run,
+        if available. It must be called by all processes at the start of the run. If there is no
+        valid checkpoint, the function logs a warning and the simulation starts from the beginning.
+        */
+    void readCheckpoint();
+
     /** In a multi-processing environment, this function logs a message and waits for all processes
         to finish the work (i.e. it places a barrier). The string argument is included in the log
         message to indicate the scope of work that is being finished. If there is only a single
@@ -252,12 +362,16 @@ private:
         packet has lost a substantial part of its original luminosity (and hence becomes
         irrelevant).
 
-        The first two arguments of this function specify the range of photon packet history indices
-        to be handled. The \em primary flag is true to launch from primary sources, false for
-        secondary sources. The \em peel flag indicates whether peeloff photon packets should be
-        sent towards the instruments. The \em store flag indicates whether the contribution to the
-        radiation field should be stored. */
-    void performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store);
+        The first two arguments of this function specify the range of indices to be handled. The
+        \em primary flag is true to launch from primary sources, false for secondary sources. The
+        \em peel flag indicates whether peeloff photon packets should be sent towards the
+        instruments. The \em store flag indicates whether the contribution to the radiation field
+        should be stored. The last two arguments specify the mapping from index \f$i\f$ to photon
+        packet history index, i.e. \f$\mathrm{offset} + i \times \mathrm{stride}\f$. By default,
+        the index is the history index. The \em pilot flag is true for the photon packets launched
+        by the pilot run, which are not passed to the launch call-back of the source system. */
+    void performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store,
+                          size_t stride = 1, size_t offset = 0, bool pilot = false);
 
     /** This function implements the peel-off of a photon packet after an emission event. This
         means that we create a peel-off photon packet for every instrument in the instrument
@@ -274,8 +388,10 @@ private:
         the wavelength of the peel-off photon packet is Doppler-shifted for the new direction.
 
         The first argument specifies the photon packet that was just emitted; the second argument
-        provides a placeholder peel off photon packet for use by the function. */
-    void peelOffEmission(const PhotonPacket* pp, PhotonPacket* ppp);
+        provides a placeholder peel off photon packet for use by the function. The third argument
+        specifies the luminosity below which a peel-off photon packet is subject to Russian
+        roulette (see playPeelOffRoulette()), or zero to disable roulette. */
+    void peelOffEmission(const PhotonPacket* pp, PhotonPacket* ppp, double Lroulette);
 
     /** This function stores the contribution of the specified photon packet to the radiation field
         in the cells crossed by the packet's path. The function assumes that both the geometric and
@@ -299,7 +415,10 @@ private:
         \f$\text{lnmean}()\f$ is the logarithmic mean, \f$\tau_{n-1}\f$ and \f$\tau_n\f$ represent
         the cumulative optical depth at the start and end of the segment, and \f$(\Delta s)_n\f$ is
         the distance covered by the segment. Using the logarithmic mean assumes an exponential
-        behavior of the exinction with distance within the segment.
+        behavior of the exinction with distance within the segment. The extinction factors
+        \f$\text{e}^{-\tau_n}\f$ for all segments are calculated in a separate pass before the
+        contributions are stored, so that the exponentials can be evaluated independently of each
+        other.
 
         Once this information has been accumulated for all photon packets launched during a segment
         of the simulation, the mean intensity of the radiation field in each spatial/wavelength bin
@@ -432,8 +551,24 @@ private:
 
         The first argument to this function specifies the photon packet that is about to be
         scattered; the second argument provides a placeholder peel off photon packet for use by the
-        function. */
-    void peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp);
+        function. The third argument specifies the luminosity below which a peel-off photon packet
+        is subject to Russian roulette (see playPeelOffRoulette()), or zero to disable roulette. */
+    void peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp, double Lroulette);
+
+    /** This function plays Russian roulette with the specified peel-off photon packet, which has a
+        luminosity \f$L\f$ below the specified roulette threshold \f$L_\mathrm{r}\f$. The peel-off
+        survives with probability \f$p=L/L_\mathrm{r}\f$, in which case its weight is multiplied by
+        \f$1/p\f$ and the function returns true. Otherwise the function returns false and the
+        peel-off should not be detected. Because the expected contribution of the peel-off remains
+        unchanged, the procedure is unbiased. It avoids the cost of calculating the optical depth
+        towards the instruments for many peel-offs with a negligible contribution, for example
+        deep inside optically thick regions, at the expense of some extra noise.
+
+        The roulette threshold is a user-configurable fraction of the luminosity of the photon
+        packet at launch. All instruments with the same observer share the outcome of the roulette,
+        and each instrument keeps track of the number of peel-offs subject to roulette and the
+        number of survivors (see Instrument::recordPeelOffRoulette()). */
+    bool playPeelOffRoulette(PhotonPacket* ppp, double Lroulette);
 
     //======================== Data Members ========================
 
@@ -444,6 +579,25 @@ private:
 
     // data members used by the XXXprogress() functions in this class
     string _segment;  // a string identifying the photon shooting segment for use in the log message
+
+    // data members used for checkpointing
+    std::unique_ptr<Checkpoint> _checkpoint;                    // nonnull if checkpointing or resuming is enabled
+    std::chrono::steady_clock::time_point _lastCheckpointTime;  // time of the start of the run or the last checkpoint
+    int _generation{0};                                         // number of times the simulation has been resumed
+    int _phase{0};                                              // the phase of the current segment
+    int _iteration{0};                                          // the iteration of the current segment
+    double _phaseValue{0.};                                     // phase-specific value for the current segment
+    int _resumePhase{0};                                        // the phase being resumed, or zero if not resuming
+    int _resumeIteration{0};                                    // the iteration being resumed
+    double _resumePhaseValue{0.};                               // the phase-specific value being resumed
+    size_t _resumeNumDone{0};                                   // the number of history indices already completed
+
+    // photon life-cycle parameters, initialized from the configuration and possibly tuned by the pilot run
+    double _minWeightReduction{0.};  // the minimum weight reduction factor before a photon packet is terminated
+    double _pathLengthBias{0.};      // the fraction of path lengths sampled from a linear distribution
+
+    // data members used for predicting the run time in emulation mode
+    std::unique_ptr<RuntimePredictor> _runtimePredictor;  // nonnull if predicting the run time
 };
 
 ////////////////////////////////////////////////////////////////////
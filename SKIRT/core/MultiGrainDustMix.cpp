@@ -7,12 +7,14 @@
 #include "Configuration.hpp"
 #include "Constants.hpp"
 #include "FatalError.hpp"
+#include "FilePaths.hpp"
 #include "GrainComposition.hpp"
 #include "GrainSizeDistribution.hpp"
 #include "Log.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
+#include "PersistentCache.hpp"
 #include "ProcessManager.hpp"
 #include "StoredTable.hpp"
 
@@ -33,6 +35,37 @@ void MultiGrainDustMix::addPopulation(GrainComposition* composition, GrainSizeDi
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // constructs a logarithmic grain size integration grid over the range [amin,amax] for the given size distribution,
+    // storing "a", "da", "dnda" and the integration weight (1/2 or 1 times the specified normalization) for each point;
+    // the number of points is determined by the specified size ratio, which defaults to the ratio of the range limits
+    void buildSizeGrid(const GrainSizeDistribution* sizeDistribution, double amin, double amax, double norm, Array& av,
+                       Array& dav, Array& dndav, Array& weightv, double ratio = 0.)
+    {
+        int numSizes = max(3., 100 * log10(ratio > 0. ? ratio : amax / amin));
+        av.resize(numSizes);
+        dav.resize(numSizes);
+        dndav.resize(numSizes);
+        weightv.resize(numSizes);
+
+        double logamin = log10(amin);
+        double logamax = log10(amax);
+        double dloga = (logamax - logamin) / (numSizes - 1);
+        for (int i = 0; i != numSizes; ++i)
+        {
+            av[i] = pow(10, logamin + i * dloga);
+            dav[i] = av[i] * M_LN10 * dloga;
+            dndav[i] = sizeDistribution->dnda(av[i]);
+            weightv[i] = norm;
+        }
+        weightv[0] *= 0.5;
+        weightv[numSizes - 1] *= 0.5;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MultiGrainDustMix::getOpticalProperties(const Array& lambdav, const Array& thetav, Array& sigmaabsv,
                                                Array& sigmascav, Array& asymmparv, Table<2>& S11vv, Table<2>& S12vv,
                                                Table<2>& S33vv, Table<2>& S34vv, ArrayTable<2>& sigmaabsvv,
@@ -70,30 +103,21 @@ double MultiGrainDustMix::getOpticalProperties(const Array& lambdav, const Array
     // dust mass per hydrogen atom accumulated over all populations
     double mu = 0.;
 
-    // accumulate the relevant properties over all populations
+    // the cache key includes all information that determines the result of the calculations below
+    PersistentCache cache(this, "opticalprops");
+    cache.addKey(static_cast<double>(mode));
+    cache.addKey(lambdav);
+    cache.addKey(thetav);
+
+    // determine the normalization for each population
     for (auto population : _populations)
     {
         // construct a grain size integration grid for this population
         double amin = population->sizeDistribution()->amin();
         double amax = population->sizeDistribution()->amax();
-        int numSizes = max(3., 100 * log10(amax / amin));
-        Array av(numSizes);       // "a" for each point
-        Array dav(numSizes);      // "da" for each point
-        Array dndav(numSizes);    // "dnda" for each point
-        Array weightv(numSizes);  // integration weight for each point (1/2 or 1 in addition to normalization)
-        {
-            double logamin = log10(amin);
-            double logamax = log10(amax);
-            double dloga = (logamax - logamin) / (numSizes - 1);
-            for (int i = 0; i != numSizes; ++i)
-            {
-                av[i] = pow(10, logamin + i * dloga);
-                dav[i] = av[i] * M_LN10 * dloga;
-                dndav[i] = population->sizeDistribution()->dnda(av[i]);
-                weightv[i] = 1.;
-            }
-            weightv[0] = weightv[numSizes - 1] = 0.5;
-        }
+        Array av, dav, dndav, weightv;
+        buildSizeGrid(population->sizeDistribution(), amin, amax, 1., av, dav, dndav, weightv);
+        int numSizes = av.size();
 
         // calculate the mass per hydrogen atom for this population according to the bare size distribution
         // (i.e. without applying any normalization)
@@ -127,9 +151,66 @@ double MultiGrainDustMix::getOpticalProperties(const Array& lambdav, const Array
         mu += mupop;
 
         // remember the size distribution normalization factor for this population
-        // and adjust the integration weight for further calculations
         _normv.push_back(mupop / baremupop);
-        weightv *= mupop / baremupop;
+
+        // add the grain material and the normalized size distribution to the cache key
+        cache.addKey(population->composition()->resourceNameForOpticalProps());
+        cache.addKey(population->composition()->resourceNameForMuellerMatrix());
+        if (needSpheroidalPolarization)
+        {
+            bool resource = false;
+            double q = 0.;
+            string tableName1, tableName2;
+            if (population->composition()->resourcesForSpheroidalEmission(resource, q, tableName1, tableName2))
+            {
+                if (resource)
+                {
+                    cache.addKey(tableName1);
+                    cache.addKey(tableName2);
+                }
+                else
+                {
+                    cache.addFileKey(find<FilePaths>()->input(tableName1));
+                    cache.addFileKey(find<FilePaths>()->input(tableName2));
+                }
+                cache.addKey(q);
+            }
+        }
+        cache.addKey(av);
+        cache.addKey(_normv.back() * weightv * dndav);
+    }
+
+    // if the optical properties have been calculated before for the same configuration, simply load them
+    if (cache.load())
+    {
+        cache.read(sigmaabsv);
+        cache.read(sigmascav);
+        cache.read(asymmparv);
+        if (needMaterialPhaseFunction) cache.read(S11vv.data());
+        if (needSphericalPolarization)
+        {
+            cache.read(S12vv.data());
+            cache.read(S33vv.data());
+            cache.read(S34vv.data());
+        }
+        if (needSpheroidalPolarization)
+        {
+            for (int ell = 0; ell != numLambda; ++ell) cache.read(sigmaabsvv[ell]);
+            for (int ell = 0; ell != numLambda; ++ell) cache.read(sigmaabspolvv[ell]);
+        }
+        return mu;
+    }
+
+    // accumulate the relevant properties over all populations
+    int c = 0;  // population index
+    for (auto population : _populations)
+    {
+        // construct a grain size integration grid for this population, including the normalization
+        double amin = population->sizeDistribution()->amin();
+        double amax = population->sizeDistribution()->amax();
+        Array av, dav, dndav, weightv;
+        buildSizeGrid(population->sizeDistribution(), amin, amax, _normv[c++], av, dav, dndav, weightv);
+        int numSizes = av.size();
 
         // open the stored tables for the basic optical properties
         string opticalPropsName = population->composition()->resourceNameForOpticalProps();
@@ -315,6 +396,24 @@ double MultiGrainDustMix::getOpticalProperties(const Array& lambdav, const Array
             ProcessManager::sumToAll(sigmaabspolvv[ell]);
         }
     }
+
+    // store the results in the cache so that they can be reused by subsequent simulations
+    cache.write(sigmaabsv);
+    cache.write(sigmascav);
+    cache.write(asymmparv);
+    if (needMaterialPhaseFunction) cache.write(S11vv.data());
+    if (needSphericalPolarization)
+    {
+        cache.write(S12vv.data());
+        cache.write(S33vv.data());
+        cache.write(S34vv.data());
+    }
+    if (needSpheroidalPolarization)
+    {
+        for (int ell = 0; ell != numLambda; ++ell) cache.write(sigmaabsvv[ell]);
+        for (int ell = 0; ell != numLambda; ++ell) cache.write(sigmaabspolvv[ell]);
+    }
+    cache.save();
     return mu;
 }
 
@@ -364,25 +463,11 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
             for (int bb = 0; bb != numPopBins; ++bb)
             {
                 // create an integration grid over grain size within this bin
-                int numSizes = max(3., 100 * log10(amax / amin));
-                Array av(numSizes);       // "a" for each point
-                Array dav(numSizes);      // "da" for each point
-                Array dndav(numSizes);    // "dnda" for each point
-                Array weightv(numSizes);  // integration weight for each point (1/2 or 1 in addition to normalization)
-                {
-                    double logamin = log10(aborderv[bb]);
-                    double logamax = log10(aborderv[bb + 1]);
-                    double dloga = (logamax - logamin) / (numSizes - 1);
-                    for (int i = 0; i != numSizes; ++i)
-                    {
-                        av[i] = pow(10, logamin + i * dloga);
-                        dav[i] = av[i] * M_LN10 * dloga;
-                        dndav[i] = population->sizeDistribution()->dnda(av[i]);
-                        weightv[i] = _normv[c];
-                    }
-                    weightv[0] *= 0.5;
-                    weightv[numSizes - 1] *= 0.5;
-                }
+                // (the number of integration points is determined by the size range of the complete population)
+                Array av, dav, dndav, weightv;
+                buildSizeGrid(population->sizeDistribution(), aborderv[bb], aborderv[bb + 1], _normv[c], av, dav,
+                              dndav, weightv, amax / amin);
+                int numSizes = av.size();
 
                 // size-integrate the absorption cross sections for this bin
                 // this can take a few seconds for all populations/size bins combined,
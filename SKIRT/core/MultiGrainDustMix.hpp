@@ -72,6 +72,13 @@ class GrainSizeDistribution;
     the size distribution, \f[ \mu = \sum_c \int_{a_{\text{min},c}}^{a_{\text{max},c}}
     \Omega_c(a)\, \rho_{\text{bulk},c}\, \frac{4\pi}{3}\, a^3\, {\text{d}}a. \f]
 
+    Integrating the Mueller matrix coefficients and the spheroidal grain properties over the size
+    distribution can take a substantial amount of time. If a persistent cache directory has been
+    configured, the resulting properties are stored in and reloaded from the cache (see
+    PersistentCache). The cache key includes the wavelength and scattering angle grids, the
+    resource names for each grain population, and the normalized size distributions sampled on
+    the integration grid.
+
     <b>Calculating dust emission</b>
 
     The representative grain properties described above and offered by the public MaterialMix
@@ -9,9 +9,9 @@
 
 ////////////////////////////////////////////////////////////////////
 
-MultiHybridParallel::MultiHybridParallel(int threadCount)
+MultiHybridParallel::MultiHybridParallel(int threadCount, bool pinThreads)
 {
-    constructThreads(threadCount);
+    constructThreads(threadCount, pinThreads);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -5,13 +5,15 @@
 
 #include "MultiParallel.hpp"
 #include "FatalError.hpp"
+#include "System.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
-void MultiParallel::constructThreads(int numThreads)
+void MultiParallel::constructThreads(int numThreads, bool pinThreads)
 {
-    // Remember the number of threads
+    // Remember the number of threads and whether they should be pinned
     _numThreads = numThreads;
+    _pinThreads = pinThreads;
 
     // Launch the child threads in a critical section
     {
@@ -55,6 +57,17 @@ void MultiParallel::activateThreads()
 
 ////////////////////////////////////////////////////////////////////
 
+void MultiParallel::reactivateThreads()
+{
+    // Reactivate threads in a critical section, leaving the exception state untouched
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_terminate) return;
+    _active.assign(_numThreads, true);
+    _conditionChildren.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MultiParallel::waitForThreads()
 {
     // Wait until all parallel threads are inactive
@@ -72,8 +85,28 @@ void MultiParallel::waitForThreads()
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the index of the current thread if it is a child thread of a MultiParallel instance, or -1 if not
+    thread_local int t_threadIndex = -1;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int MultiParallel::currentThreadIndex()
+{
+    return t_threadIndex;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MultiParallel::run(int threadIndex)
 {
+    t_threadIndex = threadIndex;
+
+    // Bind this thread to a core if so requested; failure is not fatal, the thread simply remains unbound
+    if (_pinThreads) System::pinCurrentThread(threadIndex);
+
     while (true)
     {
         // Wait for new work in a critical section
@@ -91,8 +124,13 @@ void MultiParallel::run(int threadIndex)
             {
                 _conditionChildren.wait(lock);
 
-                // Check for termination request (don't bother with _active; it's no longer used)
-                if (_terminate) return;
+                // Check for termination request; after an exception, the parent may still be waiting for us
+                if (_terminate)
+                {
+                    _active[threadIndex] = false;
+                    if (!threadsActive()) _conditionParent.notify_all();
+                    return;
+                }
 
                 // Check that we actually have new work
                 if (_active[threadIndex]) break;
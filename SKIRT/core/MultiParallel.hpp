@@ -39,8 +39,10 @@ class MultiParallel : public Parallel
 
 protected:
     /** This function constructs the specified number of parallel child threads (not including the
-        parent thread) and waits for them to become ready (in the inactive state). */
-    void constructThreads(int numThreads);
+        parent thread) and waits for them to become ready (in the inactive state). If the \em
+        pinThreads flag is true, each child thread binds itself to a separate logical core (see
+        System::pinCurrentThread()) before becoming ready. */
+    void constructThreads(int numThreads, bool pinThreads = false);
 
     /** This function destructs the child threads constucted with the constructThreads() function.
         */
@@ -50,6 +52,14 @@ protected:
         doSomeWork() function until it returns false). */
     void activateThreads();
 
+    /** This function reactivates the child threads that have become inactive during the current
+        cycle (i.e. after a call to activateThreads() and before waitForThreads() returns), so that
+        they start calling the doSomeWork() function again. This allows a subclass to hand out
+        additional work that becomes available while the cycle is in progress, such as the tasks
+        for a nested call. The function should be called only from a child thread that is still
+        active, so that the cycle cannot end concurrently. */
+    void reactivateThreads();
+
     /** This function blocks until all child threads have become inactive (i.e. the doSomeWork()
         function has returned false for all threads). */
     void waitForThreads();
@@ -58,6 +68,12 @@ protected:
         thread) specified to constructThreads(). */
     int numThreads() { return _numThreads; }
 
+    /** This function returns the zero-based index of the calling thread if it is one of the child
+        threads of any MultiParallel instance, or -1 if it is not (e.g., for the parent thread). If
+        the child threads are bound to logical cores, the index determines the core (see
+        System::pinCurrentThread()). */
+    static int currentThreadIndex();
+
 private:
     /** This function gets executed inside each of the parallel threads. */
     void run(int threadIndex);
@@ -82,6 +98,7 @@ private:
 private:
     // the threads
     int _numThreads{0};                 // the number of child threads (not including the parent thread)
+    bool _pinThreads{false};            // true if the child threads bind themselves to a logical core
     std::vector<std::thread> _threads;  // the child threads
 
     // synchronization
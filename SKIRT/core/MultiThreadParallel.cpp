@@ -4,12 +4,13 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "MultiThreadParallel.hpp"
+#include "FatalError.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
-MultiThreadParallel::MultiThreadParallel(int threadCount)
+MultiThreadParallel::MultiThreadParallel(int threadCount, bool pinThreads)
 {
-    constructThreads(threadCount);
+    constructThreads(threadCount, pinThreads);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -21,24 +22,186 @@ MultiThreadParallel::~MultiThreadParallel()
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the MultiThreadParallel instance for which the current thread is performing tasks, if any
+    thread_local MultiThreadParallel* t_current = nullptr;
+
+    // the call context of the current thread, if any
+    thread_local void* t_callContext = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MultiThreadParallel::call(size_t maxIndex, std::function<void(size_t, size_t)> target)
 {
-    // Copy the target function so it can be invoked from any of the threads
-    _target = target;
+    // Initialize a job for this call
+    Job job;
+    job.target = target;
+    job.chunkMaker.initialize(maxIndex, numThreads());
+    job.context = t_callContext;
+
+    // For a top-level call, activate child threads and wait until they are done
+    if (t_current != this)
+    {
+        performTopLevelJob(job);
+        return;
+    }
+
+    // For a nested call, push the job on the stack and reactivate any child threads that ran out of work
+    job.nested = true;
+    {
+        std::unique_lock<std::mutex> lock(_jobMutex);
+        _jobs.push_back(&job);
+    }
+    reactivateThreads();
+
+    // Help perform the chunks for this job, and then wait until the chunks handed out to other threads are done;
+    // stop handing out chunks as soon as one of them throws an exception, and rethrow that exception to our caller
+    size_t firstIndex, numIndices;
+    std::unique_lock<std::mutex> lock(_jobMutex);
+    while (!job.exception && job.chunkMaker.next(firstIndex, numIndices))
+    {
+        job.numBusy++;
+        lock.unlock();
+        try
+        {
+            target(firstIndex, numIndices);
+            lock.lock();
+        }
+        catch (...)
+        {
+            lock.lock();
+            if (!job.exception) job.exception = std::current_exception();
+        }
+        job.numBusy--;
+    }
+    _jobDone.wait(lock, [&job] { return job.numBusy == 0; });
+    _jobs.erase(std::find(_jobs.begin(), _jobs.end(), &job));
+    if (job.exception) std::rethrow_exception(job.exception);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MultiThreadParallel::callOncePerThread(std::function<void(int, int)> target)
+{
+    if (t_current == this) throw FATALERROR("Cannot call a target once per thread from within a child thread");
+
+    // Initialize a job that hands out a single chunk to each child thread, identified by the thread index
+    int numChildren = numThreads();
+    Job job;
+    job.target = [target, numChildren](size_t threadIndex, size_t) { target(threadIndex, numChildren); };
+    job.threadDone.assign(numChildren, false);
+    job.context = t_callContext;
+    performTopLevelJob(job);
+}
 
-    // Initialize the chunk maker
-    _chunkMaker.initialize(maxIndex, numThreads());
+////////////////////////////////////////////////////////////////////
 
+void MultiThreadParallel::performTopLevelJob(Job& job)
+{
     // Activate child threads and wait until they are done; we don't do anything in the parent thread
-    activateThreads();
-    waitForThreads();
+    _jobs.push_back(&job);
+    try
+    {
+        activateThreads();
+        waitForThreads();
+    }
+    catch (...)
+    {
+        _jobs.clear();
+        throw;
+    }
+    _jobs.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void* MultiThreadParallel::callContext()
+{
+    return t_callContext;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MultiThreadParallel::setCallContext(void* context)
+{
+    t_callContext = context;
+}
+
+////////////////////////////////////////////////////////////////////
+
+MultiThreadParallel* MultiThreadParallel::current()
+{
+    return t_current;
 }
 
 ////////////////////////////////////////////////////////////////////
 
 bool MultiThreadParallel::doSomeWork()
 {
-    return _chunkMaker.callForNext(_target);
+    t_current = this;
+    bool result = doNextChunk();
+    t_current = nullptr;
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MultiThreadParallel::doNextChunk()
+{
+    // Obtain a chunk from the innermost job that still has chunks available;
+    // for a per-thread job, the single chunk for each thread is identified by the thread index
+    Job* job = nullptr;
+    size_t firstIndex, numIndices;
+    {
+        std::unique_lock<std::mutex> lock(_jobMutex);
+        for (auto it = _jobs.rbegin(); it != _jobs.rend() && !job; ++it)
+        {
+            bool available = false;
+            if ((*it)->threadDone.empty())
+                available = !(*it)->exception && (*it)->chunkMaker.next(firstIndex, numIndices);
+            else
+            {
+                int threadIndex = currentThreadIndex();
+                available = !(*it)->threadDone[threadIndex];
+                (*it)->threadDone[threadIndex] = true;
+                firstIndex = threadIndex;
+                numIndices = 1;
+            }
+            if (available)
+            {
+                job = *it;
+                job->numBusy++;
+            }
+        }
+    }
+    if (!job) return false;
+
+    // Perform the chunk in the call context of the thread that issued the call, and signal its completion even if an
+    // exception is thrown; an exception in a nested call is handed to the thread that issued the call, and any other
+    // exception is reported to the parent thread
+    void* previousContext = t_callContext;
+    t_callContext = job->context;
+    try
+    {
+        job->target(firstIndex, numIndices);
+    }
+    catch (...)
+    {
+        t_callContext = previousContext;
+        std::unique_lock<std::mutex> lock(_jobMutex);
+        job->numBusy--;
+        _jobDone.notify_all();
+        if (!job->nested) throw;
+        if (!job->exception) job->exception = std::current_exception();
+        return true;
+    }
+    t_callContext = previousContext;
+    std::unique_lock<std::mutex> lock(_jobMutex);
+    job->numBusy--;
+    _jobDone.notify_all();
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////
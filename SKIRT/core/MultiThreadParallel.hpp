@@ -8,11 +8,24 @@
 
 #include "ChunkMaker.hpp"
 #include "MultiParallel.hpp"
+#include <exception>
 
 ////////////////////////////////////////////////////////////////////
 
 /** This class implements the Parallel base class interface using multiple execution threads in a
-    single process. It uses the facilities offered by the MultiParallel base class. */
+    single process. It uses the facilities offered by the MultiParallel base class.
+
+    In addition to the regular use, this class supports nested invocations of the call() function,
+    i.e. from within a target function being executed by one of the instance's own child threads.
+    The tasks for a nested call are added to a stack of active calls, and the child threads that
+    have run out of work for the enclosing call(s) are reactivated so that they can help perform
+    them. Child threads always take their next chunk from the innermost call that still has chunks
+    available, so that nested calls complete as soon as possible and the thread that issued the
+    nested call can resume its work on the enclosing call. The thread issuing a nested call
+    participates in performing its tasks, and then waits until the chunks that have been handed
+    out to other threads have been completed. If any of the chunks of a nested call throws an
+    exception, no further chunks are handed out for that call, and the exception is rethrown in
+    the thread that issued the nested call, regardless of the thread that performed the chunk. */
 class MultiThreadParallel : public MultiParallel
 {
     friend class ParallelFactory;  // so ParallelFactory can access our private constructor
@@ -20,9 +33,10 @@ class MultiThreadParallel : public MultiParallel
     //============= Construction - Destruction =============
 
 private:
-    /** Constructs a MultiThreadParallel instance with the specified number of execution threads.
-        The constructor is private; use the ParallelFactory::parallel() function instead. */
-    explicit MultiThreadParallel(int threadCount);
+    /** Constructs a MultiThreadParallel instance with the specified number of execution threads,
+        optionally binding each thread to a separate logical core. The constructor is private; use
+        the ParallelFactory::parallel() function instead. */
+    MultiThreadParallel(int threadCount, bool pinThreads);
 
 public:
     /** Destructs the instance and its parallel threads. */
@@ -32,18 +46,73 @@ public:
 
 public:
     /** This function implements the call() interface described in the Parallel base class for the
-        parallelization scheme offered by this subclass. */
+        parallelization scheme offered by this subclass. If the function is invoked from one of the
+        child threads of this instance, it performs a nested call as described in the class header.
+        */
     void call(size_t maxIndex, std::function<void(size_t firstIndex, size_t numIndices)> target) override;
 
+    /** This function calls the specified target function exactly once in each of the child
+        threads of this instance, passing the zero-based index of the thread and the number of
+        child threads, and returns when all invocations have completed. The parent thread does not
+        call the target function. In contrast to the call() function, the work performed by each
+        thread is thus determined by the thread index. This is useful for operations whose effect
+        depends on the thread performing them, such as the placement of physical memory pages on
+        NUMA nodes. The function cannot be invoked from one of the child threads of this instance.
+        */
+    void callOncePerThread(std::function<void(int threadIndex, int numThreads)> target);
+
+    /** This function returns the call context of the calling thread, i.e. an opaque pointer that a
+        client can associate with the logical task being performed by the thread through the
+        setCallContext() function. Each invocation of the call() or callOncePerThread() functions
+        captures the call context of the calling thread, and the child threads adopt that context
+        while performing chunks for the invocation. As a result, the context of a task carries over
+        to the threads that help perform a parallel loop nested in that task. The call context of a
+        thread that is not performing chunks for any invocation is null unless it has been set
+        explicitly. */
+    static void* callContext();
+
+    /** This function sets the call context of the calling thread to the specified pointer, as
+        described for the callContext() function. The caller is responsible for restoring the
+        previous call context when the associated task completes. */
+    static void setCallContext(void* context);
+
+    /** This function returns a pointer to the MultiThreadParallel instance owning the calling
+        thread, if the calling thread is a child thread currently performing tasks for a
+        MultiThreadParallel instance, or a null pointer otherwise. */
+    static MultiThreadParallel* current();
+
 protected:
     /** The function to do the actual work, one chunk at a time. */
     bool doSomeWork() override;
 
+private:
+    /** This structure holds the information for a (possibly nested) call in progress. */
+    struct Job
+    {
+        std::function<void(size_t, size_t)> target;  // the target function to be called
+        ChunkMaker chunkMaker;                       // the chunk maker
+        int numBusy{0};                              // the number of chunks handed out but not yet completed
+        bool nested{false};                          // true if this is a nested call
+        void* context{nullptr};                      // the call context of the thread that issued the call
+        std::exception_ptr exception;                // the first exception thrown by a chunk of a nested call
+        vector<bool> threadDone;  // for a per-thread call, flag for each child thread indicating it has been called
+    };
+
+    /** This function performs the specified top-level job by activating the child threads and
+        waiting until they are done. */
+    void performTopLevelJob(Job& job);
+
+    /** This function obtains the next chunk from the innermost job that still has chunks available
+        and performs it in the calling thread. If no chunks are available for any of the jobs, the
+        function returns false. */
+    bool doNextChunk();
+
     //======================== Data Members ========================
 
 private:
-    std::function<void(size_t, size_t)> _target;  // the target function to be called
-    ChunkMaker _chunkMaker;                       // the chunk maker
+    std::mutex _jobMutex;              // the mutex guarding the job stack and the busy counts
+    std::condition_variable _jobDone;  // the wait condition signaled when a chunk completes
+    vector<Job*> _jobs;                // the stack of calls in progress; the first one is the top-level call
 };
 
 ////////////////////////////////////////////////////////////////////
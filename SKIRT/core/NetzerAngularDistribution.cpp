@@ -25,6 +25,9 @@ void NetzerAngularDistribution::setupSelfBefore()
         _Xv[i] = (1. / 2.) + (2. / 7.) * ct * ct * ct + sign * (3. / 14.) * ct * ct;
     }
     _Xv[n] = 1.;
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLinLin(_costhetav, _Xv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -39,7 +42,7 @@ double NetzerAngularDistribution::probabilityForInclinationCosine(double costhet
 
 double NetzerAngularDistribution::generateInclinationCosine() const
 {
-    return random()->cdfLinLin(_costhetav, _Xv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define NETZERANGULARDISTRIBUTION_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "AxAngularDistribution.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -56,6 +57,7 @@ private:
     // data members initialized during setup
     Array _costhetav;
     Array _Xv;
+    CdfSampler _sampler;
 };
 
 ////////////////////////////////////////////////////////////////////
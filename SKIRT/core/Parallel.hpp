@@ -39,8 +39,12 @@
     schem. One can also use multiple Parallel instances in a program. For example, a parallelized
     target function can invoke the call() function on another Parallel subclass instance that is
     requested from a ParallelFactory constructed and destructed within the scope of the target
-    function. Recursively invoking the call() function on the same Parallel instance is not allowed
-    and results in undefined behavior. */
+    function. Recursively invoking the call() function on the same Parallel instance is supported
+    for the SerialParallel and MultiThreadParallel subclasses (see the ParallelFactory class for
+    more information); for the other subclasses, it results in undefined behavior.
+
+    The callTasks() function offers a convenient way to perform a number of independent and
+    possibly heterogeneous tasks concurrently, such as independent setup steps. */
 class Parallel
 {
     //============= Construction - Destruction =============
@@ -69,6 +73,17 @@ public:
          the available parallel resources, while still maximally reducing the overhead of handing
          out the chunks. */
     virtual void call(size_t maxIndex, std::function<void(size_t firstIndex, size_t numIndices)> target) = 0;
+
+    /** This function performs each of the specified tasks exactly once, distributing them over the
+        parallel resources in the same way as the call() function, and returns when all tasks have
+        been completed. The tasks may be performed in arbitrary order and should therefore be
+        independent of each other. */
+    void callTasks(const vector<std::function<void()>>& tasks)
+    {
+        call(tasks.size(), [&tasks](size_t firstIndex, size_t numIndices) {
+            for (size_t i = firstIndex; i != firstIndex + numIndices; ++i) tasks[i]();
+        });
+    }
 };
 
 ////////////////////////////////////////////////////////////////////
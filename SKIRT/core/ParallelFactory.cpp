@@ -10,6 +10,7 @@
 #include "NullParallel.hpp"
 #include "ProcessManager.hpp"
 #include "SerialParallel.hpp"
+#include "System.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -42,6 +43,20 @@ int ParallelFactory::maxThreadCount() const
 
 ////////////////////////////////////////////////////////////////////
 
+void ParallelFactory::setPinThreads(bool value)
+{
+    _pinThreads = value;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool ParallelFactory::pinThreads() const
+{
+    return _pinThreads;
+}
+
+////////////////////////////////////////////////////////////////////
+
 int ParallelFactory::defaultThreadCount()
 {
     int count = std::thread::hardware_concurrency();
@@ -54,9 +69,32 @@ int ParallelFactory::defaultThreadCount()
 
 Parallel* ParallelFactory::parallel(TaskMode mode, int maxThreadCount)
 {
-    // Verify that we're being called from our parent thread
+    // Verify that we're being called from our parent thread; as an exception, a target function being executed by
+    // one of our multi-threaded children receives that same child so that it can perform a nested call
     if (std::this_thread::get_id() != _parentThread)
+    {
+        Parallel* current = MultiThreadParallel::current();
+        for (const auto& child : _children)
+        {
+            if (current && child.second.get() == current)
+            {
+                // a nested call is local to the current process, so it cannot distribute tasks across processes;
+                // for root-only mode, the nested tasks are skipped in all processes except for the root
+                if (ProcessManager::isMultiProc())
+                {
+                    if (mode == TaskMode::Distributed)
+                        throw FATALERROR("Nested parallel call cannot distribute tasks across multiple processes");
+                    if (!ProcessManager::isRoot())
+                    {
+                        static NullParallel nestedNull(1);
+                        return &nestedNull;
+                    }
+                }
+                return current;
+            }
+        }
         throw FATALERROR("Parallel not spawned from thread that constructed the factory");
+    }
 
     // Determine the number of threads,
     // limited by both the factory maximum and the maximum specified here as an argument
@@ -81,12 +119,45 @@ Parallel* ParallelFactory::parallel(TaskMode mode, int maxThreadCount)
         {
             case ParallelType::Null: child.reset(new NullParallel(numThreads)); break;
             case ParallelType::Serial: child.reset(new SerialParallel(numThreads)); break;
-            case ParallelType::MultiThread: child.reset(new MultiThreadParallel(numThreads)); break;
-            case ParallelType::MultiProcess: child.reset(new MultiHybridParallel(1)); break;
-            case ParallelType::MultiHybrid: child.reset(new MultiHybridParallel(numThreads)); break;
+            case ParallelType::MultiThread: child.reset(new MultiThreadParallel(numThreads, _pinThreads)); break;
+            case ParallelType::MultiProcess: child.reset(new MultiHybridParallel(1, _pinThreads)); break;
+            case ParallelType::MultiHybrid: child.reset(new MultiHybridParallel(numThreads, _pinThreads)); break;
         }
     }
     return child.get();
 }
 
 ////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // arrays smaller than this number of bytes are not worth distributing across NUMA nodes
+    const size_t minFirstTouchBytes = 16 * 1024 * 1024;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void ParallelFactory::firstTouch(void* data, size_t numBytes, size_t numItems)
+{
+    // skip the operation if it makes no sense or if we cannot obtain a multi-threaded child
+    if (numBytes < minFirstTouchBytes || !numItems || numBytes % numItems) return;
+    if (_maxThreadCount < 2 || ProcessManager::isMultiProc() || std::this_thread::get_id() != _parentThread) return;
+    auto multi = dynamic_cast<MultiThreadParallel*>(parallel(TaskMode::Distributed));
+    if (!multi) return;
+
+    // discard the physical pages; skip the operation if this is not supported on the current platform
+    if (!System::discardMemoryPages(data, numBytes)) return;
+
+    // touch the bytes for a contiguous block of items from each child thread, in the order of the thread index
+    // (and thus of the cores to which the threads are bound); the parent thread, which is not bound, does not
+    // touch any items
+    size_t itemBytes = numBytes / numItems;
+    char* bytes = static_cast<char*>(data);
+    multi->callOncePerThread([bytes, itemBytes, numItems](int threadIndex, int numThreads) {
+        size_t firstIndex = numItems * threadIndex / numThreads;
+        size_t lastIndex = numItems * (threadIndex + 1) / numThreads;
+        std::fill(bytes + firstIndex * itemBytes, bytes + lastIndex * itemBytes, 0);
+    });
+}
+
+////////////////////////////////////////////////////////////////////
@@ -6,6 +6,7 @@
 #ifndef PARALLELFACTORY_HPP
 #define PARALLELFACTORY_HPP
 
+#include "Array.hpp"
 #include "SimulationItem.hpp"
 #include <map>
 #include <thread>
@@ -25,10 +26,25 @@ class Parallel;
     (see below) and with the appropriate number of threads already exists, it will be handed out
     again. As a result, a particular Parallel instance may be reused several times, reducing the
     overhead of creating and destroying the threads. However, the children of a particular factory
-    should \em never be used in parallel. Also, recursively invoking the call() function on a
-    Parallel instance is not allowed and results in undefined behavior. The recommended use is to
-    have a single ParallelFactory instance per simulation, and to use yet another ParallelFactory
-    instance to run multiple simulations at the same time.
+    should \em never be used in parallel. The recommended use is to have a single ParallelFactory
+    instance per simulation, and to use yet another ParallelFactory instance to run multiple
+    simulations at the same time.
+
+    Parallel objects are normally requested from the thread that constructed the factory. As an
+    exception, when a target function being executed by a child thread of a MultiThreadParallel
+    instance handed out by this factory requests a Parallel object, it receives that same
+    instance, regardless of the requested thread count. This allows the target function to perform
+    a nested call, which is executed by the threads of the enclosing call with proper load
+    balancing (see MultiThreadParallel). Nested calls are local to the current process. Therefore,
+    when running with multiple processes, requesting a nested Parallel object in Distributed mode
+    results in a fatal error, and requesting one in RootOnly mode returns an object that ignores
+    all tasks in processes other than the root process. Recursively invoking the call() function
+    on other Parallel subclasses is not allowed and results in undefined behavior.
+
+    On computers with multiple NUMA nodes (e.g., dual-socket nodes), a factory can optionally bind
+    each of the threads handed to its children to a separate logical core (see setPinThreads()).
+    Furthermore, the firstTouch() function allows clients to distribute the physical memory pages
+    of a large array over the NUMA nodes according to the threads that will be using them.
 
     ParallelFactory clients can request a Parallel instance for one of the two task allocation
     modes described in the table below.
@@ -89,6 +105,18 @@ public:
         this factory object. */
     int maxThreadCount() const;
 
+    /** Sets the flag indicating whether the threads handed out to Parallel objects manufactured by
+        this factory object should be bound to a separate logical core each. Pinning threads avoids
+        migration of threads between cores and NUMA nodes, so that memory pages placed close to a
+        thread remain close to that thread. Pinning is not recommended when multiple simulations
+        run in parallel in the same process, because their threads would compete for the same
+        cores. By default, threads are not pinned. */
+    void setPinThreads(bool value);
+
+    /** Returns the flag indicating whether the threads handed out to Parallel objects
+        manufactured by this factory object are bound to a separate logical core each. */
+    bool pinThreads() const;
+
     /** Returns the number of logical cores detected on the computer running the code, with a
         minimum of one and a maximum of 24 (additional threads in single process do not increase
         performance). */
@@ -115,12 +143,43 @@ public:
     /** This function calls the parallel() function for the RootOnly task allocation mode. */
     Parallel* parallelRootOnly(int maxThreadCount = 0) { return parallel(TaskMode::RootOnly, maxThreadCount); }
 
+    /** This function prepares a freshly allocated memory block of \em numBytes bytes starting at
+        \em data, which must contain all zeros, for being accessed by multiple threads. The block
+        is assumed to hold data for \em numItems consecutive items (e.g., spatial cells) with the
+        same number of bytes per item. The function discards the physical memory pages of the
+        block (see System::discardMemoryPages()) and then zeros the bytes for each item in
+        parallel. The items are statically partitioned into contiguous ranges of nearly equal size,
+        and each child thread zeros the range corresponding to its thread index (see
+        MultiThreadParallel::callOncePerThread()). The parent thread, which is never bound to a
+        core, does not zero any items. As a result, the physical pages are placed on the NUMA nodes
+        closest to the threads first writing them, rather than all on the node of the thread
+        allocating the block, and the placement does not depend on the timing of the threads. When
+        the threads are bound to cores (see setPinThreads()), each NUMA node thus holds a contiguous
+        range of items. Parallel loops over the items hand out chunks in increasing index order to
+        whichever thread is available, so that the placement is a statistical rather than an exact
+        match for the items processed by each thread. The contents of the block remain all zeros.
+
+        The function does nothing for small blocks, when a single thread is being used, when
+        invoked from a child thread, or when running with multiple processes (in which case each
+        process typically runs on a single NUMA node). */
+    void firstTouch(void* data, size_t numBytes, size_t numItems);
+
+    /** This function calls the firstTouch() function for the memory block held by the specified
+        array. */
+    void firstTouch(Array& array, size_t numItems)
+    {
+        firstTouch(begin(array), array.size() * sizeof(double), numItems);
+    }
+
     //======================== Data Members ========================
 
 private:
     // The maximum thread count for the factory, initialized to the default maximum number of threads
     int _maxThreadCount{defaultThreadCount()};
 
+    // True if the threads handed out to our children should be bound to a logical core
+    bool _pinThreads{false};
+
     // The thread that invoked our constructor, initialized - obviously - upon construction
     std::thread::id _parentThread{std::this_thread::get_id()};
 
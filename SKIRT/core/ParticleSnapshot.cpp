@@ -5,6 +5,7 @@
 
 #include "ParticleSnapshot.hpp"
 #include "Log.hpp"
+#include "MemoryRegistry.hpp"
 #include "NR.hpp"
 #include "Random.hpp"
 #include "SmoothedParticleGrid.hpp"
@@ -56,6 +57,11 @@ void ParticleSnapshot::readAndClose()
         log()->info("  Number of particles retained: " + std::to_string(_propv.size()));
     }
 
+    // report the memory allocated for the imported properties
+    if (!_propv.empty())
+        MemoryRegistry::add(log(), MemoryRegistry::Category::Snapshots,
+                            _propv.size() * (sizeof(Array) + _propv[0].size() * sizeof(double)));
+
     // we can calculate mass and densities only if a policy has been set
     if (!hasMassDensityPolicy()) return;
 
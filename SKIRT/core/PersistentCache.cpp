@@ -0,0 +1,409 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "PersistentCache.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
+#include "Log.hpp"
+#include "ProcessManager.hpp"
+#include "System.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the alternate interpretations for 8-byte items in the cache file format
+    union CacheItem
+    {
+        double doubleType;
+        size_t sizeType;
+        char stringType[8];
+    };
+    const size_t itemSize = sizeof(CacheItem);
+
+    static_assert((sizeof(size_t) == 8) & (sizeof(double) == 8) & (itemSize == 8),
+                  "Cannot properly declare union for items in cache file format");
+
+    // the tags at the start and end of a cache file
+    const char* headTag = "SKIRT C\n";
+    const char* tailTag = "CACHEEND";
+
+    // returns the 64-bit FNV-1a hash of the specified byte sequence, continuing from the specified hash value
+    size_t hash(const char* bytes, size_t numBytes, size_t result = 0xcbf29ce484222325)
+    {
+        for (size_t i = 0; i != numBytes; ++i)
+        {
+            result ^= static_cast<unsigned char>(bytes[i]);
+            result *= 0x100000001b3;
+        }
+        return result;
+    }
+    size_t hash(const string& key) { return hash(key.data(), key.size()); }
+
+    // returns the number of 8-byte items needed to hold the specified number of bytes
+    size_t numItems(size_t numBytes) { return (numBytes + itemSize - 1) / itemSize; }
+
+    // the process-wide in-memory store, keyed on the complete cache key, and the mutex guarding it
+    std::mutex _storeMutex;
+    bool _storeEnabled{false};
+    std::unordered_map<string, vector<std::shared_ptr<const Array>>> _store;
+}
+
+////////////////////////////////////////////////////////////////////
+
+PersistentCache::PersistentCache(const SimulationItem* item, string name, bool memoryOnly) : _item(item), _name(name)
+{
+    if (!memoryOnly) _cachePath = item->find<FilePaths>()->cachePath();
+
+    // seed the key with the item type, the entry name, and the version numbers of the installed resource packs
+    addKey(item->type());
+    addKey(name);
+    for (const string& packname : FilePaths::expectedPacks())
+    {
+        addKey(packname);
+        addKey(FilePaths::installedPackVersion(packname));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool PersistentCache::isEnabled() const
+{
+    std::unique_lock<std::mutex> lock(_storeMutex);
+    return !_cachePath.empty() || _storeEnabled;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::setMemoryStore(bool enable)
+{
+    std::unique_lock<std::mutex> lock(_storeMutex);
+    _storeEnabled = enable;
+    if (!enable) _store.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::addKey(string value)
+{
+    _key += value;
+    _key += '\0';
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::addKey(double value)
+{
+    _key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::addKey(const Array& values)
+{
+    addKey(static_cast<double>(values.size()));
+    if (values.size()) _key.append(reinterpret_cast<const char*>(begin(values)), values.size() * sizeof(double));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::addFileKey(string path)
+{
+    addKey(path);
+
+    std::ifstream in = System::ifstream(path);
+    if (in)
+    {
+        size_t result = 0xcbf29ce484222325;
+        size_t numBytes = 0;
+        char buffer[65536];
+        while (in)
+        {
+            in.read(buffer, sizeof(buffer));
+            size_t count = in.gcount();
+            result = hash(buffer, count, result);
+            numBytes += count;
+        }
+        addKey(static_cast<double>(numBytes));
+        addKey(string(reinterpret_cast<const char*>(&result), sizeof(result)));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::writeTag(std::ostream& out, const char* tag)
+{
+    CacheItem item;
+    memcpy(item.stringType, tag, itemSize);
+    out.write(item.stringType, itemSize);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::writeSize(std::ostream& out, size_t value)
+{
+    CacheItem item;
+    item.sizeType = value;
+    out.write(item.stringType, itemSize);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::writeArray(std::ostream& out, const Array& values)
+{
+    writeSize(out, values.size());
+    if (values.size()) out.write(reinterpret_cast<const char*>(begin(values)), values.size() * sizeof(double));
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool PersistentCache::readSize(std::istream& in, size_t& value)
+{
+    CacheItem item;
+    if (!in.read(item.stringType, itemSize)) return false;
+    value = item.sizeType;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool PersistentCache::isTag(size_t value, const char* tag)
+{
+    CacheItem item;
+    item.sizeType = value;
+    return !memcmp(item.stringType, tag, itemSize);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool PersistentCache::readValues(std::istream& in, Array& values)
+{
+    return !values.size()
+           || static_cast<bool>(in.read(reinterpret_cast<char*>(begin(values)), values.size() * sizeof(double)));
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t PersistentCache::hashString(const string& value)
+{
+    return hash(value);
+}
+
+////////////////////////////////////////////////////////////////////
+
+string PersistentCache::entryName() const
+{
+    std::ostringstream name;
+    name << _item->type() << '_' << _name << '_' << std::hex << hash(_key) << ".cache";
+    return name.str();
+}
+
+////////////////////////////////////////////////////////////////////
+
+string PersistentCache::filePath() const
+{
+    return _cachePath + entryName();
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool PersistentCache::load()
+{
+    _data.clear();
+    _next = 0;
+
+    bool found = false;
+    bool inMemory = false;
+
+    // look for the entry in the in-memory store
+    {
+        std::unique_lock<std::mutex> lock(_storeMutex);
+        if (_storeEnabled)
+        {
+            auto it = _store.find(_key);
+            if (it != _store.end())
+            {
+                _data = it->second;
+                found = inMemory = true;
+            }
+        }
+    }
+
+    // look for the entry in the cache directory
+    if (!found && !_cachePath.empty())
+    {
+        string path = filePath();
+        if (System::isFile(path))
+        {
+            // acquire a memory map for the file and copy the data, verifying the structure as we go
+            auto map = System::acquireMemoryMap(path);
+            bool collision = false;
+            size_t keyItems = numItems(_key.size());
+            if (map.first && map.second >= (6 + keyItems) * itemSize && map.second % itemSize == 0)
+            {
+                const CacheItem* currentItem = static_cast<const CacheItem*>(map.first);
+                const CacheItem* endItem = currentItem + map.second / itemSize;
+                if (!memcmp(headTag, currentItem++->stringType, itemSize) && currentItem++->sizeType == hash(_key)
+                    && !memcmp(tailTag, (endItem - 1)->stringType, itemSize))
+                {
+                    // verify the complete key, so that a hash collision is not mistaken for a match
+                    collision = currentItem->sizeType != _key.size()
+                                || memcmp((currentItem + 1)->stringType, _key.data(), _key.size());
+                    currentItem += 1 + keyItems;
+                    size_t numArrays = collision ? 0 : currentItem++->sizeType;
+                    found = !collision;
+                    for (size_t i = 0; i != numArrays && found; ++i)
+                    {
+                        // compare sizes rather than pointers, so that a corrupt length cannot overflow the pointer
+                        size_t length = currentItem++->sizeType;
+                        if (length >= static_cast<size_t>(endItem - currentItem))
+                            found = false;
+                        else
+                        {
+                            auto values = std::make_shared<Array>(length);
+                            if (length) memcpy(begin(*values), &currentItem->doubleType, length * itemSize);
+                            _data.push_back(values);
+                            currentItem += length;
+                        }
+                    }
+                    if (!collision && currentItem != endItem - 1) found = false;
+                }
+            }
+            if (map.first) System::releaseMemoryMap(System::canonicalPath(path));
+            if (!found && !collision) _item->find<Log>()->warning("Ignoring invalid cache file " + path);
+        }
+    }
+
+    // make sure that all processes take the same decision
+    if (ProcessManager::isMultiProc())
+    {
+        Array flag(1);
+        flag[0] = found ? 1. : 0.;
+        ProcessManager::sumToAll(flag);
+        found = (flag[0] == ProcessManager::size());
+    }
+
+    if (found)
+    {
+        if (inMemory)
+            _item->find<Log>()->info(_item->type() + " loaded " + _name + " from in-memory cache");
+        else
+        {
+            _item->find<Log>()->info(_item->type() + " loaded " + _name + " from cache file " + filePath());
+
+            // retain the entry in the in-memory store, if enabled
+            std::unique_lock<std::mutex> lock(_storeMutex);
+            if (_storeEnabled) _store[_key] = _data;
+        }
+    }
+    else
+        _data.clear();
+    return found;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::read(Array& values)
+{
+    if (_next >= _data.size()) throw FATALERROR("Reading beyond the end of cache entry " + filePath());
+    const Array& cached = *_data[_next++];
+    if (values.size() && values.size() != cached.size())
+        throw FATALERROR("Array size does not match contents of cache entry " + filePath());
+    values.resize(cached.size());
+    values = cached;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double PersistentCache::read()
+{
+    Array values;
+    read(values);
+    if (values.size() != 1) throw FATALERROR("Expected single value in cache entry " + filePath());
+    return values[0];
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const Array> PersistentCache::readShared()
+{
+    if (_next >= _data.size()) throw FATALERROR("Reading beyond the end of cache entry " + filePath());
+    return _data[_next++];
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::write(const Array& values)
+{
+    _data.push_back(std::make_shared<Array>(values));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::write(double value)
+{
+    auto values = std::make_shared<Array>(1);
+    (*values)[0] = value;
+    _data.push_back(values);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::write(std::shared_ptr<const Array> values)
+{
+    _data.push_back(values);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PersistentCache::save()
+{
+    // retain the entry in the in-memory store, if enabled
+    {
+        std::unique_lock<std::mutex> lock(_storeMutex);
+        if (_storeEnabled) _store[_key] = _data;
+    }
+
+    if (_cachePath.empty() || !ProcessManager::isRoot()) return;
+
+    // write the data to a temporary file with a name that is unlikely to be used by another thread or process
+    string path = filePath();
+    std::ostringstream suffix;
+    suffix << ".tmp" << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id())
+           << std::chrono::steady_clock::now().time_since_epoch().count();
+    string tmpPath = path + suffix.str();
+    {
+        std::ofstream out = System::ofstream(tmpPath);
+        if (!out) throw FATALERROR("Cannot create cache file " + tmpPath);
+        writeTag(out, headTag);
+        writeSize(out, hash(_key));
+        writeSize(out, _key.size());
+        string paddedKey = _key;
+        paddedKey.resize(numItems(_key.size()) * itemSize, '\0');
+        out.write(paddedKey.data(), paddedKey.size());
+        writeSize(out, _data.size());
+        for (const auto& values : _data) writeArray(out, *values);
+        writeTag(out, tailTag);
+        if (!out) throw FATALERROR("Error while writing cache file " + tmpPath);
+    }
+
+    // move the file into place, replacing any file with the same name that may have been written concurrently
+    if (std::rename(tmpPath.c_str(), path.c_str()))
+    {
+        System::removeFile(tmpPath);
+        _item->find<Log>()->warning("Cannot store cache file " + path);
+    }
+    else
+        _item->find<Log>()->info(_item->type() + " stored " + _name + " in cache file " + path);
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,211 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef PERSISTENTCACHE_HPP
+#define PERSISTENTCACHE_HPP
+
+#include "Array.hpp"
+#include <iosfwd>
+#include <memory>
+class SimulationItem;
+
+////////////////////////////////////////////////////////////////////
+
+/** A PersistentCache instance manages a single entry in a content-addressed on-disk cache for
+    derived data that is expensive to calculate but depends only on the simulation configuration
+    and on the installed resource files, such as the representative optical properties of a dust
+    mix integrated over the grain size distributions. The cache allows such data to be reused by
+    subsequent simulations (e.g. in a parameter sweep) without repeating the calculation.
+
+    The cache is enabled only if a cache directory has been configured through the
+    FilePaths::setCachePath() function (corresponding to the \c -c command line option), or if the
+    process-wide in-memory store has been turned on through the setMemoryStore() function (which
+    is used by long-running processes that perform many simulations). If the cache is disabled,
+    the load() function always returns false and the save() function does nothing, so that client
+    code does not need to handle this case separately.
+
+    <b>Cache key</b>
+
+    The client constructs the key for a cache entry by passing all the data that determines the
+    result of the calculation to the addKey() functions, in a fixed order. The cache implementation
+    automatically includes the type of the simulation item requesting the cache entry, the name of
+    the entry as specified by the client, and the version numbers of all installed resource packs.
+    The cache key is hashed to form the name of the corresponding cache file, so that an entry
+    becomes automatically invalid when any of its inputs change. Because different keys may
+    produce the same hash, the complete key is stored in the cache file as well, and an entry is
+    loaded only if the stored key matches. Input files that are not part of a versioned resource
+    pack are added to the key through the addFileKey() function, which includes a hash of the file
+    contents, so that editing such a file also invalidates the entries depending on it.
+
+    <b>Cache contents</b>
+
+    After a successful call to the load() function, the client retrieves the cached data by
+    calling the read() functions in the same order as the data was passed to the write()
+    functions when the cache entry was created. If the calculation must be performed, the client
+    passes the results to the write() functions and then calls save() to store them in the cache.
+
+    A cache file consists of a sequence of 8-byte items, similar to a stored table file (see
+    StoredTable): a tag, the 64-bit key hash, the key length, the key itself padded with zero bytes
+    to a multiple of 8 bytes, the number of arrays, and for each array its length followed by its
+    values, terminated by an end-of-file tag. The file is memory-mapped for reading, and the
+    structure of the mapped contents is verified before any data is used. Because the Array type
+    always owns its storage, the array values are copied out of the memory map rather than being
+    used in place, and the memory map is released as soon as the entry has been loaded. The
+    cached data (e.g. optical properties on the simulation's wavelength grid) is small enough for
+    this copy to be negligible compared to the calculation it replaces; large data is shared
+    between simulations through the in-memory store instead (see below). To avoid
+    exposing partially written files to other simulations running concurrently, a new cache file
+    is written under a temporary name and then renamed.
+
+    The in-memory store holds the arrays through shared pointers, so that large read-only data
+    can be handed to multiple simulations without copying through the readShared() and
+    write(std::shared_ptr<const Array>) functions.
+
+    <b>Multiple processes</b>
+
+    When running with multiple processes, the load() and save() functions must be called by all
+    processes at the same point in the execution flow. The load() function returns true only if
+    the cache entry is available to all processes, so that all processes perform the calculation
+    (which may involve collective communication) if it is missing for any of them. The save()
+    function writes the cache file only in the root process. */
+class PersistentCache
+{
+public:
+    /** The constructor initializes a cache entry with the specified name for the specified
+        simulation item. The name should differ for each type of data cached by the item's class.
+        If the optional \em memoryOnly flag is true, the entry is never loaded from or saved to the
+        cache directory, so that it is handled only by the in-memory store (if enabled). This is
+        appropriate for data that is too large to be stored on disk or that depends on input files
+        not captured by the cache key. */
+    PersistentCache(const SimulationItem* item, string name, bool memoryOnly = false);
+
+    /** This function returns true if the cache has been enabled (i.e. a cache directory has been
+        configured or the in-memory store has been turned on) and false otherwise. */
+    bool isEnabled() const;
+
+    /** This function turns the process-wide in-memory store on or off. When the store is on,
+        cache entries saved or loaded by any simulation in the current process are retained in
+        memory, and subsequent requests for the same entry are served from memory without
+        accessing the file system. Turning the store off releases all entries held in memory. The
+        function is thread-safe. */
+    static void setMemoryStore(bool enable);
+
+    //================= Composing the key =================
+
+    /** This function adds the specified string to the key for the cache entry. */
+    void addKey(string value);
+
+    /** This function adds the specified floating point value to the key for the cache entry. */
+    void addKey(double value);
+
+    /** This function adds the size and the values of the specified array to the key for the
+        cache entry. */
+    void addKey(const Array& values);
+
+    /** This function adds the specified file path, the size of the file, and a 64-bit hash of the
+        file contents to the key for the cache entry. If the file cannot be read, only the path is
+        added; the client will report the error when it attempts to open the file. */
+    void addFileKey(string path);
+
+    //================= Loading and reading =================
+
+    /** This function attempts to load the cache entry corresponding to the key composed so far.
+        It returns true if the entry was found and successfully loaded, and false otherwise. In the
+        latter case, the client should perform the calculation and store the results in the cache.
+        */
+    bool load();
+
+    /** This function copies the next array in the loaded cache entry into the specified array.
+        If the array already has a nonzero size that differs from the size of the cached array, or
+        if there are no remaining arrays in the cache entry, the function throws a fatal error. */
+    void read(Array& values);
+
+    /** This function returns the next value in the loaded cache entry, assuming that it has been
+        stored as an array with a single element through the write(double) function. */
+    double read();
+
+    /** This function returns a pointer to the next array in the loaded cache entry, without
+        copying its values. The array is shared with the in-memory store and with other clients
+        loading the same entry, so it must not be modified. If there are no remaining arrays in the
+        cache entry, the function throws a fatal error. */
+    std::shared_ptr<const Array> readShared();
+
+    //================= Writing and saving =================
+
+    /** This function appends a copy of the specified array to the cache entry being composed. */
+    void write(const Array& values);
+
+    /** This function appends the specified value to the cache entry being composed, as an array
+        with a single element. */
+    void write(double value);
+
+    /** This function appends the specified array to the cache entry being composed without
+        copying its values. The array will be shared with the in-memory store and with subsequent
+        clients loading the same entry, so the caller must not modify it after this call. */
+    void write(std::shared_ptr<const Array> values);
+
+    /** This function saves the cache entry being composed to the in-memory store, if it has been
+        turned on, and to the cache directory, if it has been configured. The cache file is
+        written only by the root process. If the cache is disabled, the function does nothing. */
+    void save();
+
+    //================= Binary item format =================
+
+    /** This function writes the specified 8-character tag as an 8-byte item to the specified output
+        stream. The functions in this section implement the binary item format used by cache files,
+        so that other files with a similar structure (see Checkpoint) can share it. */
+    static void writeTag(std::ostream& out, const char* tag);
+
+    /** This function writes the specified size value as an 8-byte item to the specified output
+        stream. */
+    static void writeSize(std::ostream& out, size_t value);
+
+    /** This function writes the specified array to the specified output stream as an 8-byte item
+        holding its length followed by its values. */
+    static void writeArray(std::ostream& out, const Array& values);
+
+    /** This function reads an 8-byte item from the specified input stream and stores its value
+        interpreted as a size into \em value. It returns false if the item could not be read. */
+    static bool readSize(std::istream& in, size_t& value);
+
+    /** This function returns true if the specified item value, obtained through readSize(),
+        contains the specified 8-character tag, and false otherwise. */
+    static bool isTag(size_t value, const char* tag);
+
+    /** This function reads the values of an array written by writeArray() from the specified input
+        stream into the specified array, assuming that the length item has already been read and
+        that the array has been resized accordingly. It returns false if the values could not be
+        read. */
+    static bool readValues(std::istream& in, Array& values);
+
+    /** This function returns the 64-bit hash of the specified string, using the same hash function
+        as for cache keys. */
+    static size_t hashString(const string& value);
+
+    //================= Private helpers =================
+
+private:
+    /** This function returns the name (without directory) of the cache entry corresponding to
+        the key composed so far. */
+    string entryName() const;
+
+    /** This function returns the absolute path of the cache file corresponding to the key
+        composed so far. */
+    string filePath() const;
+
+    //================= Data members =================
+
+private:
+    const SimulationItem* _item{nullptr};
+    string _name;
+    string _cachePath;    // empty if there is no cache directory
+    string _key;          // the key composed so far
+    vector<std::shared_ptr<const Array>> _data;  // the data loaded from or to be saved to the cache file
+    size_t _next{0};                             // the index of the next array to be read
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -44,6 +44,24 @@ class PhotonPacketOptions : public SimulationItem
         ATTRIBUTE_RELEVANT_IF(pathLengthBias, "(ForceScattering|Emission)&(!Lya)")
         ATTRIBUTE_DISPLAYED_IF(pathLengthBias, "Level3")
 
+        PROPERTY_DOUBLE(peelOffRouletteThreshold,
+                        "the fraction of the launch luminosity below which a peel-off is subject to Russian roulette")
+        ATTRIBUTE_MIN_VALUE(peelOffRouletteThreshold, "[0")
+        ATTRIBUTE_MAX_VALUE(peelOffRouletteThreshold, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(peelOffRouletteThreshold, "0")
+        ATTRIBUTE_DISPLAYED_IF(peelOffRouletteThreshold, "Level3")
+
+        PROPERTY_BOOL(tuneParameters, "tune the photon life-cycle parameters in a pilot run")
+        ATTRIBUTE_DEFAULT_VALUE(tuneParameters, "false")
+        ATTRIBUTE_DISPLAYED_IF(tuneParameters, "Level3")
+
+        PROPERTY_DOUBLE(pilotFraction, "the fraction of primary photon packets launched in the pilot run")
+        ATTRIBUTE_MIN_VALUE(pilotFraction, "[0.001")
+        ATTRIBUTE_MAX_VALUE(pilotFraction, "0.5]")
+        ATTRIBUTE_DEFAULT_VALUE(pilotFraction, "0.05")
+        ATTRIBUTE_RELEVANT_IF(pilotFraction, "tuneParameters")
+        ATTRIBUTE_DISPLAYED_IF(pilotFraction, "Level3")
+
     ITEM_END()
 };
 
@@ -35,6 +35,9 @@ void PseudoSersicGeometry::setupSelfBefore()
     }
     _Xv[0] = 0.0;
     _Xv[N - 1] = 1.0;
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLinLin(_rv, _Xv);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -50,7 +53,7 @@ double PseudoSersicGeometry::density(double r) const
 
 double PseudoSersicGeometry::randomRadius() const
 {
-    return random()->cdfLinLin(_rv, _Xv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define PSEUDOSERSICGEOMETRY_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SpheGeometry.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -82,6 +83,7 @@ private:
     double _rhon{0.};
     Array _rv;
     Array _Xv;
+    CdfSampler _sampler;
 };
 
 ////////////////////////////////////////////////////////////////////
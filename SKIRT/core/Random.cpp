@@ -8,6 +8,7 @@
 #include "NR.hpp"
 #include "Position.hpp"
 #include "SpecialFunctions.hpp"
+#include <cstdint>
 #include <random>
 
 //////////////////////////////////////////////////////////////////////
@@ -34,11 +35,27 @@ namespace
             _generator.seed(seedseq);
         }
 
-        // turn into predictable generator, seeded with fixed sequence depending on given seed
-        void setState(int seed)
+        // turn into predictable generator, seeded with fixed sequence depending on given 64-bit seed;
+        // the high-order word is appended to the sequence only if it is nonzero, so that seeds below 2^32
+        // produce the same generator state as before
+        void setState(uint64_t seed)
         {
-            std::seed_seq seedseq{979364188u + seed, 871244425u + seed, 1693909487u + seed, 1290454318u + seed,
-                                  210509498u + seed, 542237529u + seed, 3429911442u + seed, 3321294726u + seed};
+            uint32_t low = static_cast<uint32_t>(seed);
+            uint32_t high = static_cast<uint32_t>(seed >> 32);
+            std::vector<uint32_t> seeds{979364188u + low, 871244425u + low, 1693909487u + low, 1290454318u + low,
+                                        210509498u + low, 542237529u + low, 3429911442u + low, 3321294726u + low};
+            if (high) seeds.push_back(high);
+            std::seed_seq seedseq(seeds.begin(), seeds.end());
+            _generator.seed(seedseq);
+        }
+
+        // turn into predictable generator, seeded with fixed sequence depending on the next output of the current
+        // generator and on the given index
+        void derive(uint64_t index)
+        {
+            uint64_t base = _generator();
+            std::seed_seq seedseq{static_cast<uint32_t>(base), static_cast<uint32_t>(base >> 32),
+                                  static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), 2654435769u};
             _generator.seed(seedseq);
         }
 
@@ -62,6 +79,48 @@ void Random::setupSelfBefore()
 
 //////////////////////////////////////////////////////////////////////
 
+void Random::resumeWithGeneration(int generation)
+{
+    // the seed property is limited to 1e6, so that the resulting seeds never coincide with a configured seed;
+    // calculate in 64-bit so that the seed does not overflow for large generation numbers
+    _rng.setState(static_cast<uint64_t>(seed()) + 1000001 * static_cast<uint64_t>(generation));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+class Random::State
+{
+public:
+    Rand rand;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Random::State> Random::saveState() const
+{
+    auto state = std::make_shared<State>();
+    state->rand = _rng;
+    return state;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Random::restoreState(const State& state)
+{
+    _rng = state.rand;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Random::State> Random::deriveState(const State& state, size_t index) const
+{
+    auto derived = std::make_shared<State>(state);
+    derived->rand.derive(index);
+    return derived;
+}
+
+//////////////////////////////////////////////////////////////////////
+
 double Random::uniform()
 {
     return _rng.get();
@@ -183,3 +242,10 @@ double Random::cdfLogLog(const Array& xv, const Array& pv, const Array& Pv)
 }
 
 //////////////////////////////////////////////////////////////////////
+
+double Random::cdf(const CdfSampler& sampler)
+{
+    return sampler.sample(uniform());
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define RANDOM_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SimulationItem.hpp"
 class Box;
 class Direction;
@@ -71,6 +72,37 @@ protected:
     //======================== Other Functions =======================
 
 public:
+    /** This function reinitializes the random generator for the calling thread (which should be
+        the parent thread) to a fixed state depending on the value of the user-configurable \em
+        seed property and on the specified nonzero generation number. This is used when a
+        simulation resumes from a checkpoint, so that the photon packets launched after resuming
+        do not repeat the pseudo-random sequence used before the checkpoint was written, while
+        the generator remains predictable and identical in all processes. */
+    void resumeWithGeneration(int generation);
+
+    /** This class holds a copy of the state of the random generator for a thread. Its definition is
+        private to the implementation of the Random class. */
+    class State;
+
+    /** This function returns a copy of the current state of the random generator for the calling
+        thread. */
+    std::shared_ptr<State> saveState() const;
+
+    /** This function sets the random generator for the calling thread to the specified state,
+        obtained earlier through saveState(). Together, these functions allow a serial task to be
+        performed in a child thread with a copy of the predictable generator of the parent thread,
+        restoring the arbitrary generator of the child thread afterwards. This is used, for example,
+        when independent parts of the simulation hierarchy are set up concurrently. */
+    void restoreState(const State& state);
+
+    /** This function returns a state derived from the specified state, obtained earlier through
+        saveState(), in a way that depends only on that state and on the specified index. The
+        derived states for different indices produce distinct pseudo-random sequences. This allows
+        a list of serial tasks, started from the same state, to be performed in any order or
+        concurrently, while each task receives a predictable random sequence that depends only on
+        its position in the list. */
+    std::shared_ptr<State> deriveState(const State& state, size_t index) const;
+
     /** This function generates a uniform deviate, i.e. a random double precision number in the
         open interval (0,1). The interval borders zero and one are never returned. */
     double uniform();
@@ -147,6 +179,15 @@ public:
         generalized exponential, defined in the description of respectively the
         SpecialFunctions::gln() and SpecialFunctions::gexp() functions. */
     double cdfLogLog(const Array& xv, const Array& pv, const Array& Pv);
+
+    /** This function generates a random number drawn from the probability distribution
+        represented by the specified CdfSampler instance, which must have been initialized with a
+        discretized version of the distribution's cdf. A uniform deviate is generated and passed
+        to the sampler, which locates the corresponding cdf interval in constant time using a guide
+        table. Apart from round-off errors, the result is identical to that of the cdfLinLin() or
+        cdfLogLog() function for the same distribution and the same uniform deviate. This function
+        is therefore preferred for distributions that are sampled repeatedly. */
+    double cdf(const CdfSampler& sampler);
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -14,6 +14,9 @@ void ResourceSED::setupSelfBefore()
 
     _table.open(this, resourceName(), "lambda(m)", "Llambda(W/m)", false);
     _Ltot = _table.cdf(_lambdav, _pv, _Pv, normalizationWavelengthRange());
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLogLog(_lambdav, _pv, _Pv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -51,7 +54,7 @@ double ResourceSED::integratedLuminosity(const Range& wavelengthRange) const
 
 double ResourceSED::generateWavelength() const
 {
-    return random()->cdfLogLog(_lambdav, _pv, _Pv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define RESOURCESED_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SED.hpp"
 #include "StoredTable.hpp"
 
@@ -62,6 +63,7 @@ private:
     Array _lambdav;
     Array _pv;
     Array _Pv;
+    CdfSampler _sampler;
     double _Ltot{0};
 };
 
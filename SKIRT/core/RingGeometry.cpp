@@ -32,6 +32,9 @@ void RingGeometry::setupSelfBefore()
     }
     _Xv[0] = 0.0;
     _Xv[NR - 1] = 1.0;
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLinLin(_Rv, _Xv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -46,7 +49,7 @@ double RingGeometry::density(double R, double z) const
 
 double RingGeometry::randomCylRadius() const
 {
-    return random()->cdfLinLin(_Rv, _Xv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
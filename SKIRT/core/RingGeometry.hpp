@@ -7,6 +7,7 @@
 #define RINGGEOMETRY_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SepAxGeometry.hpp"
 
 //////////////////////////////////////////////////////////////////////
@@ -100,6 +101,7 @@ private:
     double _A{0.};
     Array _Rv;
     Array _Xv;
+    CdfSampler _sampler;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -0,0 +1,228 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "RuntimePredictor.hpp"
+#include "Configuration.hpp"
+#include "Log.hpp"
+#include "MediumSystem.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
+#include "SecondarySourceSystem.hpp"
+#include "StringUtils.hpp"
+#include "TextOutFile.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the maximum number of emitting cells used for calibrating the cost of an emission spectrum calculation
+    const int maxCalibrationCells = 50;
+
+    // returns the number of seconds elapsed since the specified time point
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // returns a human-readable representation of the specified time range in seconds
+    string timeRange(double minTime, double maxTime)
+    {
+        string result = StringUtils::toString(minTime, 'f', 1) + " s";
+        if (maxTime > minTime) result += " to " + StringUtils::toString(maxTime, 'f', 1) + " s";
+        return result;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+RuntimePredictor::RuntimePredictor(const SimulationItem* item)
+    : _item(item), _setupStart(std::chrono::steady_clock::now())
+{}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::endSetup()
+{
+    _setupTime = secondsSince(_setupStart);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::beginPhase()
+{
+    _phaseStart = std::chrono::steady_clock::now();
+    _launchTime = 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::beginLaunch()
+{
+    _launchStart = std::chrono::steady_clock::now();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::endLaunch()
+{
+    _launchTime += secondsSince(_launchStart);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::endSegment(Segment segment, size_t numPackets, const SecondarySourceSystem* sss)
+{
+    auto& timings = _timings[static_cast<int>(segment)];
+    timings.measured = true;
+    timings.fixedTime = max(0., secondsSince(_phaseStart) - _launchTime);
+    timings.launchTime = _launchTime;
+    timings.numPackets = numPackets;
+
+    // for secondary segments, determine the number of library entries for the pilot and for the actual run
+    if (sss && numPackets)
+    {
+        auto& size = _item->find<Configuration>()->configuredRunSize();
+        double numFullPackets =
+            segment == Segment::DustSelfAbsorption ? size.numIterationPackets : size.numSecondaryPackets;
+        timings.numPilotEntries = sss->numLaunchEntries(numPackets);
+        timings.numFullEntries = sss->numLaunchEntries(numFullPackets);
+        calibrateEntryCost();
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::endOutput()
+{
+    _outputTime = secondsSince(_phaseStart);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::calibrateEntryCost()
+{
+    if (_entryCost >= 0.) return;
+    _entryCost = 0.;
+
+    // library entries represent dust emission spectra; without dust emission there is nothing to calibrate
+    auto ms = _item->find<MediumSystem>(false);
+    if (!_item->find<Configuration>()->hasDustEmission() || !ms || !ms->hasDust()) return;
+
+    // time the emission spectrum calculation for a sample of emitting cells spread over the spatial grid
+    int numCells = ms->numCells();
+    int numSamples = min(numCells, maxCalibrationCells);
+    int numTimed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k != numSamples; ++k)
+    {
+        int m = static_cast<int>((k + 0.5) * numCells / numSamples);
+        if (ms->dustLuminosity(m) > 0.)
+        {
+            ms->dustEmissionSpectrum(m);
+            numTimed++;
+        }
+    }
+    if (numTimed) _entryCost = secondsSince(start) / numTimed;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double RuntimePredictor::predictSegment(Segment segment, double numPackets) const
+{
+    const auto& timings = _timings[static_cast<int>(segment)];
+    if (!timings.measured) return 0.;
+    if (!timings.numPackets) return timings.fixedTime;
+
+    // express the launch cost in seconds for a single core, separating the emission spectrum calculations,
+    // and distribute it over the cores of the target layout
+    double entryCost = max(0., _entryCost);
+    double packetCost = max(0., timings.launchTime * _numPilotCores - timings.numPilotEntries * entryCost);
+    packetCost /= timings.numPackets;
+    return timings.fixedTime + (packetCost * numPackets + timings.numFullEntries * entryCost) / _numTargetCores;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RuntimePredictor::report()
+{
+    auto config = _item->find<Configuration>();
+    auto& size = config->configuredRunSize();
+    int numPilotThreads = _item->find<ParallelFactory>()->maxThreadCount();
+    int numPilotProcs = ProcessManager::size();
+    int numThreads = config->predictionThreadCount() > 0 ? config->predictionThreadCount() : numPilotThreads;
+    int numProcs = config->predictionProcessCount() > 0 ? config->predictionProcessCount() : numPilotProcs;
+    _numPilotCores = numPilotThreads * numPilotProcs;
+    _numTargetCores = numThreads * numProcs;
+
+    // primary emission, including the pilot run tuning the photon life-cycle parameters, if any
+    const auto& primary = _timings[static_cast<int>(Segment::Primary)];
+    double primaryPacketTime =
+        primary.numPackets ? primary.launchTime * _numPilotCores / _numTargetCores / primary.numPackets : 0.;
+    double tuningTime = config->tuneParameters()
+                            ? primaryPacketTime * config->pilotFraction() * size.numPrimaryPackets
+                            : 0.;
+    double primaryTime = predictSegment(Segment::Primary, size.numPrimaryPackets);
+
+    // dynamic medium state iterations, if any
+    double dynamicTime = 0.;
+    if (size.hasDynamicState) dynamicTime = primary.fixedTime + primaryPacketTime * size.numDynamicStatePackets;
+    double minDynamicTime = dynamicTime * size.minDynamicStateIterations;
+    double maxDynamicTime = dynamicTime * size.maxDynamicStateIterations;
+
+    // dust self-absorption iterations and secondary emission
+    double iterationTime = predictSegment(Segment::DustSelfAbsorption, size.numIterationPackets);
+    double minIterationTime = iterationTime * size.minIterations;
+    double maxIterationTime = iterationTime * size.maxIterations;
+    double secondaryTime = predictSegment(Segment::Secondary, size.numSecondaryPackets);
+
+    // totals
+    double fixedTime = _setupTime + tuningTime + primaryTime + secondaryTime + _outputTime;
+    double minTotalTime = fixedTime + minDynamicTime + minIterationTime;
+    double maxTotalTime = fixedTime + maxDynamicTime + maxIterationTime;
+
+    // log the prediction
+    auto log = _item->find<Log>();
+    log->info("Predicted run time for " + std::to_string(numProcs) + " process(es) x " + std::to_string(numThreads)
+              + " thread(s), based on pilot segments with up to "
+              + StringUtils::toString(config->numPilotPackets(), 'g') + " photon packets:");
+    if (_numTargetCores != _numPilotCores)
+        log->info("  (extrapolated from the pilot run for " + std::to_string(numPilotProcs) + " process(es) x "
+                  + std::to_string(numPilotThreads) + " thread(s); setup and fixed costs are not rescaled)");
+    log->info("  Setup and setup output: " + timeRange(_setupTime, _setupTime));
+    if (tuningTime > 0.)
+        log->info("  Pilot run tuning the photon life-cycle parameters: " + timeRange(tuningTime, tuningTime));
+    if (maxDynamicTime > 0.)
+        log->info("  Dynamic medium state iterations: " + timeRange(minDynamicTime, maxDynamicTime));
+    log->info("  Primary emission: " + timeRange(primaryTime, primaryTime));
+    if (maxIterationTime > 0.)
+        log->info("  Dust self-absorption iterations: " + timeRange(minIterationTime, maxIterationTime));
+    if (secondaryTime > 0.) log->info("  Secondary emission: " + timeRange(secondaryTime, secondaryTime));
+    log->info("  Final output: " + timeRange(_outputTime, _outputTime));
+    log->info("  Total: " + timeRange(minTotalTime, maxTotalTime));
+    if (_entryCost > 0.)
+        log->info("  (calibrated emission spectrum calculation at " + StringUtils::toString(_entryCost * 1e3, 'g', 3)
+                  + " ms per library entry)");
+
+    // write the prediction to a text file
+    TextOutFile out(_item, "runtime", "predicted run time");
+    out.addColumn("number of processes", "", 'd');
+    out.addColumn("number of threads per process", "", 'd');
+    out.addColumn("setup and setup output", "s", 'f', 3);
+    out.addColumn("pilot run tuning the photon life-cycle parameters", "s", 'f', 3);
+    out.addColumn("dynamic medium state iterations (minimum)", "s", 'f', 3);
+    out.addColumn("dynamic medium state iterations (maximum)", "s", 'f', 3);
+    out.addColumn("primary emission", "s", 'f', 3);
+    out.addColumn("dust self-absorption iterations (minimum)", "s", 'f', 3);
+    out.addColumn("dust self-absorption iterations (maximum)", "s", 'f', 3);
+    out.addColumn("secondary emission", "s", 'f', 3);
+    out.addColumn("final output", "s", 'f', 3);
+    out.addColumn("total (minimum)", "s", 'f', 3);
+    out.addColumn("total (maximum)", "s", 'f', 3);
+    out.writeRow(vector<double>{static_cast<double>(numProcs), static_cast<double>(numThreads), _setupTime,
+                                tuningTime, minDynamicTime, maxDynamicTime, primaryTime, minIterationTime,
+                                maxIterationTime, secondaryTime, _outputTime, minTotalTime, maxTotalTime});
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,135 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef RUNTIMEPREDICTOR_HPP
+#define RUNTIMEPREDICTOR_HPP
+
+#include "Basics.hpp"
+#include <chrono>
+class SecondarySourceSystem;
+class SimulationItem;
+
+////////////////////////////////////////////////////////////////////
+
+/** A RuntimePredictor instance predicts the wall-clock run time of a simulation from an emulated
+    pilot run, i.e. a run in emulation mode that launches a limited number of photon packets per
+    simulation segment (see Configuration::setEmulationMode()). The emulated run performs the full
+    setup of the simulation and a single iteration of each simulation segment, so that the setup
+    time is measured directly, while the time spent in each segment is measured and extrapolated
+    to the number of photon packets and iterations configured by the user.
+
+    For each segment, the predictor distinguishes between the fixed cost, i.e. the time spent
+    outside of the photon packet launch loop (e.g. preparing the sources or synchronizing the
+    radiation field), and the launch cost. For primary emission, the launch cost is assumed to be
+    proportional to the number of photon packets. For secondary emission, the launch loop also
+    includes the calculation of the emission spectrum for each library entry that receives photon
+    packets. Because the number of such entries depends on the number of photon packets in a
+    nonlinear way, the predictor calibrates the cost of a single spectrum calculation on a sample
+    of emitting cells, subtracts the spectrum calculations performed during the pilot from the
+    measured launch time, and adds the spectrum calculations required for the configured number of
+    photon packets (see SecondarySourceSystem::numLaunchEntries()).
+
+    The cost model assumes that the launch loops scale perfectly with the number of execution
+    cores (threads times processes). The prediction refers to the parallelization layout specified
+    through Configuration::setPredictionLayout(), which defaults to the layout of the pilot run.
+    The launch costs measured during the pilot are converted to single-core costs and distributed
+    over the cores of the target layout. The setup time, the output time and the fixed cost of each
+    segment are used as measured, because they include serial work and synchronization that does
+    not scale in a predictable way; the prediction for a layout that differs substantially from
+    the pilot run is therefore less reliable. If the simulation has no dust emission, there are no
+    library entries and the entry cost calibration is skipped.
+
+    The cost of dynamic medium state iterations is estimated from the primary emission launch
+    cost, ignoring the time needed to update the medium state. If the number of iterations is not
+    fixed, the predictor reports the range corresponding to the minimum and maximum number of
+    iterations.
+
+    The prediction is logged and written to a text file named <tt>prefix_runtime.dat</tt> in the
+    output directory, with a single row listing the parallelization layout, the predicted time for
+    each phase, and the predicted total time. */
+class RuntimePredictor
+{
+public:
+    /** This enumeration lists the simulation segments for which the predictor records timings. */
+    enum class Segment : int { Primary, DustSelfAbsorption, Secondary };
+
+    /** The constructor initializes a predictor for the simulation hierarchy containing the
+        specified simulation item, and starts the timer for the setup phase. */
+    explicit RuntimePredictor(const SimulationItem* item);
+
+    //================= Recording =================
+
+    /** This function records the time elapsed since the construction of the predictor as the
+        setup time. */
+    void endSetup();
+
+    /** This function starts the timer for a simulation segment or for the final output phase. */
+    void beginPhase();
+
+    /** This function starts the timer for a photon packet launch loop in the current segment. */
+    void beginLaunch();
+
+    /** This function stops the timer for a photon packet launch loop within the current segment,
+        accumulating the launch time for the segment. */
+    void endLaunch();
+
+    /** This function records the timings for the specified segment, in which the specified number
+        of photon packets has been launched. For secondary segments, the secondary source system
+        must be specified so that the predictor can determine the number of library entries for
+        which an emission spectrum is calculated during the pilot and during the actual run. */
+    void endSegment(Segment segment, size_t numPackets, const SecondarySourceSystem* sss = nullptr);
+
+    /** This function records the time elapsed since the most recent invocation of beginPhase() as
+        the final output time. */
+    void endOutput();
+
+    //================= Reporting =================
+
+    /** This function calculates the predicted run time of the actual simulation for each phase,
+        logs the results, and writes them to the output file. */
+    void report();
+
+    //================= Private helpers =================
+
+private:
+    /** This function calibrates the average time, in seconds for a single execution core, for
+        calculating the dust emission spectrum of a library entry, if this has not yet been done.
+        If the simulation has no dust emission, the entry cost is set to zero. */
+    void calibrateEntryCost();
+
+    /** This function returns the predicted wall-clock time for a single iteration of the
+        specified segment when launching the specified number of photon packets. */
+    double predictSegment(Segment segment, double numPackets) const;
+
+    //================= Data members =================
+
+private:
+    // the timings recorded for each segment
+    struct SegmentTimings
+    {
+        bool measured{false};
+        double fixedTime{0.};        // wall-clock time spent outside of the launch loops
+        double launchTime{0.};       // wall-clock time spent inside the launch loops
+        double numPackets{0.};       // number of photon packets launched during the pilot
+        double numPilotEntries{0.};  // number of library entries calculated during the pilot
+        double numFullEntries{0.};   // number of library entries calculated during the actual run
+    };
+
+    const SimulationItem* _item{nullptr};
+    int _numPilotCores{1};   // number of execution cores (threads times processes) in the pilot run
+    int _numTargetCores{1};  // number of execution cores in the layout for which the run time is predicted
+    std::chrono::steady_clock::time_point _setupStart;
+    std::chrono::steady_clock::time_point _phaseStart;
+    std::chrono::steady_clock::time_point _launchStart;
+    double _launchTime{0.};  // the launch time accumulated during the current segment
+    double _setupTime{0.};
+    double _outputTime{0.};
+    double _entryCost{-1.};  // negative if not yet calibrated
+    SegmentTimings _timings[3];
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
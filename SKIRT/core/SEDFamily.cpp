@@ -0,0 +1,33 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SEDFamily.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+size_t SEDFamily::numNodes() const
+{
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SEDFamily::nodeWeights(const Array& /*parameters*/, vector<std::pair<size_t, double>>& nodes) const
+{
+    nodes.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
+double SEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& /*wavelengthRange*/,
+                          size_t /*node*/) const
+{
+    lambdav.resize(0);
+    pv.resize(0);
+    Pv.resize(0);
+    return 0.;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -51,6 +51,38 @@ public:
         factor, i.e. the value of Pv[n] before normalization. */
     virtual double cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                        const Array& parameters) const = 0;
+
+    //============= Support for caching spectra for grid nodes =============
+
+    /** %SED families that interpolate the spectra from a grid in parameter space can override
+        this function and the two functions below to allow clients to cache the spectra for the
+        nodes of the parameter grid, rather than constructing the interpolated spectrum for each
+        set of parameter values. Specifically, for a given set of parameter values, the
+        nodeWeights() function returns the grid nodes involved in the interpolation and the
+        corresponding weights, and the nodeCdf() function constructs the normalized spectrum for a
+        given grid node. For families that interpolate linearly in the tabulated luminosities, the
+        specific luminosity for the parameter values then equals the weighted sum of the specific
+        luminosities for the grid nodes. For families that interpolate logarithmically, the
+        weighted sum offers just an approximation.
+
+        The present function returns the number of nodes in the parameter grid, or zero if the
+        %SED family does not support caching spectra for grid nodes. The default implementation
+        returns zero. */
+    virtual size_t numNodes() const;
+
+    /** This function replaces the contents of the \em nodes argument by the index (between zero
+        and numNodes()-1) and the weight of each grid node involved in the interpolation of the %SED
+        with the specified parameters, as described for the numNodes() function. Nodes with zero
+        weight are omitted. The weights include the scaling of the %SED with the parameter values
+        (e.g., the mass of a single stellar population), so that the weighted sum of the specific
+        luminosities of the grid nodes equals (or approximates) the specific luminosity of the %SED.
+        The default implementation clears the \em nodes argument. */
+    virtual void nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const;
+
+    /** This function behaves as the cdf() function for the %SED corresponding to the grid node
+        with the specified index (between zero and numNodes()-1), with unit weight. The default
+        implementation clears the output arrays and returns zero. */
+    virtual double nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange, size_t node) const;
 };
 
 ////////////////////////////////////////////////////////////////////
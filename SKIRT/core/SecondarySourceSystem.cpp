@@ -527,6 +527,32 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
+size_t SecondarySourceSystem::numLaunchEntries(size_t numPackets) const
+{
+    // replicate the history index allocation performed by prepareForLaunch() for the specified number of
+    // packets; because cells belonging to the same entry are consecutive, it suffices to count entry changes
+    size_t numEntries = 0;
+    int previous = -1;
+    size_t first = 0;
+    double W = 0.;
+    int numCells = _mv.size();
+    for (int p = 0; p != numCells; ++p)
+    {
+        W += _Wv[_mv[p]];
+        size_t last = p + 1 == numCells ? numPackets : min(numPackets, static_cast<size_t>(std::round(W * numPackets)));
+        int n = _nv[_mv[p]];
+        if (last > first && n >= 0 && n != previous)
+        {
+            numEntries++;
+            previous = n;
+        }
+        first = last;
+    }
+    return numEntries;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void SecondarySourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
 {
     // select the spatial cell from which to launch based on the history index of this photon packet
@@ -154,6 +154,14 @@ public:
         launched), and true otherwise. */
     bool prepareForLaunch(size_t numPackets);
 
+    /** This function returns the number of library entries for which the launch() function would
+        calculate an emission spectrum when the specified number of photon packets were launched
+        with the launch weights determined by the most recent invocation of the prepareForLaunch()
+        function, i.e. the number of entries with at least one mapped cell receiving a nonzero
+        number of history indices. This information is used to predict the run time of a
+        simulation from an emulated run with fewer photon packets (see RuntimePredictor). */
+    size_t numLaunchEntries(size_t numPackets) const;
+
     /** This function causes the photon packet \em pp to be launched from one of the cells in the
         spatial grid using the given history index; see the description in the class header for
         more information. The photon packet's contents is fully (re-)initialized so that it is
@@ -31,9 +31,11 @@ void Simulation::setupAndRun()
     _log->setup();
     TimeLogger logger(_log, "simulation " + _paths->outputPrefix() + processInfo);
 
-    // setup and run the simulation
+    // setup and run the simulation, and report memory usage for each phase
+    _memory->beginPhase("setup");
     setupSimulation();
     runSimulation();
+    _memory->report();
 
     // repeat any warnings and errors that have been issued during this simulation
     if (ProcessManager::isRoot())
@@ -81,3 +83,10 @@ ParallelFactory* Simulation::parallelFactory() const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+MemoryRegistry* Simulation::memoryRegistry() const
+{
+    return _memory;
+}
+
+////////////////////////////////////////////////////////////////////
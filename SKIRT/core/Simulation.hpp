@@ -8,6 +8,7 @@
 
 #include "ConsoleLog.hpp"
 #include "FilePaths.hpp"
+#include "MemoryRegistry.hpp"
 #include "ParallelFactory.hpp"
 #include "Random.hpp"
 #include "SimulationItem.hpp"
@@ -19,18 +20,19 @@
     simulation and sits at the top of a run-time simulation hierarchy (i.e. it has no parent). A
     Simulation instance holds a number of essential simulation-wide property instances. Some of
     these (a random number generator and a system of units) are discoverable and hence fully
-    user-configurable. The other properties (a file paths object, a logging mechanism, and a
-    parallel factory) are not discoverable. When a Simulation instance is constructed, a default
-    instance is created for each of these properties. A reference to these property instances can
-    be retrieved through the corresponding getter, and in some cases, the property can be further
-    configured under program control (e.g., to set the input and output file paths for the
-    simulation).
+    user-configurable. The other properties (a file paths object, a logging mechanism, a parallel
+    factory, and a memory registry) are not discoverable. When a Simulation instance is
+    constructed, a default instance is created for each of these properties. A reference to these
+    property instances can be retrieved through the corresponding getter, and in some cases, the
+    property can be further configured under program control (e.g., to set the input and output
+    file paths for the simulation).
 
     Specifically, when a Simulation instance is constructed, the \em log property is set to an
     instance of the ConsoleLog class; the \em filePaths property is set to an instance of the
-    FilePaths class with default paths and no filename prefix; and the \em parallelFactory property
-    is set to an instance of the ParallelFactory class with the default maximum number of parallel
-    threads. */
+    FilePaths class with default paths and no filename prefix; the \em parallelFactory property is
+    set to an instance of the ParallelFactory class with the default maximum number of parallel
+    threads; and the \em memoryRegistry property is set to an instance of the MemoryRegistry class
+    without any recorded allocations. */
 class Simulation : public SimulationItem
 {
     /** The enumeration type indicating the user experience level:
@@ -92,6 +94,9 @@ public:
     /** Returns the logging mechanism for this simulation hierarchy. */
     ParallelFactory* parallelFactory() const;
 
+    /** Returns the memory registry for this simulation hierarchy. */
+    MemoryRegistry* memoryRegistry() const;
+
     //======================== Data Members ========================
 
 private:
@@ -99,6 +104,7 @@ private:
     Log* _log{new ConsoleLog(this)};
     FilePaths* _paths{new FilePaths(this)};
     ParallelFactory* _factory{new ParallelFactory(this)};
+    MemoryRegistry* _memory{new MemoryRegistry(this)};
 };
 
 ////////////////////////////////////////////////////////////////////
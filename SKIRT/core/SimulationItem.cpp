@@ -5,21 +5,192 @@
 
 #include "SimulationItem.hpp"
 #include "FatalError.hpp"
+#include "MultiThreadParallel.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the setup states of a simulation item
+    enum SetupState : int { NotStarted = 0, InProgress, Done, Failed };
+
+    // a setup context represents a concurrent setup task; it refers to the context of the task that
+    // launched it (or null for the top-level setup thread)
+    struct SetupContext
+    {
+        const SetupContext* launcher{nullptr};
+    };
+
+    // returns the context of the concurrent setup task being performed by the current thread, if any; the context
+    // is kept as the call context of the thread, so that it carries over to the threads helping to perform parallel
+    // loops nested in the task
+    const SetupContext* currentContext()
+    {
+        return static_cast<const SetupContext*>(MultiThreadParallel::callContext());
+    }
+
+    // the mutex guarding the setup states and owners of all items and the list of waiting contexts
+    std::mutex setupMutex;
+
+    // the wait condition signaled when setup for an item in progress completes or fails
+    std::condition_variable setupFinished;
+
+    // for each thread that is currently waiting for setup of an item, the context of the task it is performing
+    // and the context owning the item, guarded by the setup mutex; there may be multiple entries for the same task
+    vector<std::pair<const SetupContext*, const SetupContext*>> waitingContexts;
+
+    // returns true if the given context equals the specified task context or one of its launchers
+    bool isInChain(const SetupContext* context, const SetupContext* task)
+    {
+        for (; task; task = task->launcher)
+            if (task == context) return true;
+        return context == nullptr;
+    }
+
+    // returns true if waiting for an item owned by the given context would close a cycle of waiting tasks;
+    // a task that launched other tasks implicitly waits for them to complete
+    bool closesCycle(const SetupContext* owner, const SetupContext* task)
+    {
+        vector<const SetupContext*> todo{owner};
+        vector<const SetupContext*> done;
+        while (!todo.empty())
+        {
+            auto context = todo.back();
+            todo.pop_back();
+            if (isInChain(context, task)) return true;
+            if (std::find(done.begin(), done.end(), context) != done.end()) continue;
+            done.push_back(context);
+            for (const auto& waiting : waitingContexts)
+                if (isInChain(context, waiting.first)) todo.push_back(waiting.second);
+        }
+        return false;
+    }
+}
 
 ////////////////////////////////////////////////////////////////////
 
 void SimulationItem::setup()
 {
-    if (_setupStarted) return;
-    _setupStarted = true;
+    // in the common case, setup has already been completed
+    if (_setupState.load(std::memory_order_acquire) == Done) return;
 
-    setupSelfBefore();
-    for (Item* child : children())
     {
-        SimulationItem* item = dynamic_cast<SimulationItem*>(child);
-        if (item) item->setup();
+        std::unique_lock<std::mutex> lock(setupMutex);
+        if (_setupState != NotStarted)
+        {
+            // wait only if the setup is being performed by an unrelated concurrent setup task;
+            // otherwise the item is further up the calling chain, or it has already been set up
+            auto context = currentContext();
+            if (!context || _setupState != InProgress) return;
+            auto owner = static_cast<const SetupContext*>(_setupOwner);
+            if (isInChain(owner, context)) return;
+            if (closesCycle(owner, context))
+                throw FATALERROR("Circular dependency between concurrently set up items involving " + typeAndName());
+
+            auto waiting = std::make_pair(context, owner);
+            waitingContexts.push_back(waiting);
+            setupFinished.wait(lock, [this] { return _setupState != InProgress; });
+            waitingContexts.erase(std::find(waitingContexts.begin(), waitingContexts.end(), waiting));
+
+            if (_setupState == Failed) throw FATALERROR("Setup failed for " + typeAndName());
+            return;
+        }
+        _setupState = InProgress;
+        _setupOwner = currentContext();
     }
-    setupSelfAfter();
+
+    // perform the setup, and mark its completion (or failure) for any waiting threads
+    try
+    {
+        setupSelfBefore();
+
+        // the independent children are set up concurrently only if there are multiple threads in a single process;
+        // otherwise all children are set up in order, as if there were no independent children
+        auto independent = independentSetupChildren();
+        auto factory = independent.size() > 1 ? find<ParallelFactory>(false) : nullptr;
+        if (!factory || factory->maxThreadCount() < 2 || ProcessManager::isMultiProc()) independent.clear();
+
+        bool launched = false;
+        for (Item* child : children())
+        {
+            SimulationItem* item = dynamic_cast<SimulationItem*>(child);
+            if (item)
+            {
+                if (std::find(independent.begin(), independent.end(), item) == independent.end())
+                    item->setup();
+                else if (!launched)
+                {
+                    setupConcurrently(independent);
+                    launched = true;
+                }
+            }
+        }
+        setupSelfAfter();
+    }
+    catch (...)
+    {
+        std::unique_lock<std::mutex> lock(setupMutex);
+        _setupState = Failed;
+        setupFinished.notify_all();
+        throw;
+    }
+    std::unique_lock<std::mutex> lock(setupMutex);
+    _setupState.store(Done, std::memory_order_release);
+    setupFinished.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SimulationItem::setupConcurrently(const vector<SimulationItem*>& items) const
+{
+    // derive a distinct state of the predictable random generator for each item from the state of the launching
+    // thread, depending only on the position of the item in the list, so that the setup results do not depend on
+    // the order of execution or on the number of threads; the state of the launching thread is left unchanged
+    auto random = find<Random>(false);
+    auto state = random ? random->saveState() : nullptr;
+    vector<std::shared_ptr<Random::State>> states;
+    for (size_t index = 0; index != items.size(); ++index)
+        states.push_back(random ? random->deriveState(*state, index) : nullptr);
+
+    // perform setup for each item in a separate task with its own context; the context is installed as the call
+    // context of the thread performing the task, so that it is adopted by threads helping to perform parallel loops
+    // nested in the task, and a find() or interface() lookup from such a loop body behaves as if it were performed
+    // by the task itself
+    auto launcher = currentContext();
+    vector<std::function<void()>> tasks;
+    for (size_t index = 0; index != items.size(); ++index)
+    {
+        auto item = items[index];
+        const Random::State* itemState = states[index].get();
+        tasks.push_back([item, launcher, random, itemState]() {
+            SetupContext context;
+            context.launcher = launcher;
+            auto saved = random ? random->saveState() : nullptr;
+            if (random) random->restoreState(*itemState);
+            void* previous = MultiThreadParallel::callContext();
+            MultiThreadParallel::setCallContext(&context);
+            try
+            {
+                item->setup();
+            }
+            catch (...)
+            {
+                MultiThreadParallel::setCallContext(previous);
+                if (random) random->restoreState(*saved);
+                throw;
+            }
+            MultiThreadParallel::setCallContext(previous);
+            if (random) random->restoreState(*saved);
+        });
+    }
+    find<ParallelFactory>(false)->parallelDistributed()->callTasks(tasks);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -32,6 +203,13 @@ void SimulationItem::setupSelfAfter() {}
 
 ////////////////////////////////////////////////////////////////////
 
+vector<SimulationItem*> SimulationItem::independentSetupChildren() const
+{
+    return vector<SimulationItem*>();
+}
+
+////////////////////////////////////////////////////////////////////
+
 string SimulationItem::typeAndName() const
 {
     string result = type();
@@ -7,6 +7,7 @@
 #define SIMULATIONITEM_HPP
 
 #include "ItemInfo.hpp"
+#include <atomic>
 #include <typeinfo>
 
 ////////////////////////////////////////////////////////////////////
@@ -31,7 +32,34 @@ public:
         construction time). Thus all attributes in the simulation hierarchy must have been
         explicitly set by the caller before invoking setup(). If setup() has already been invoked
         for the same item, this function does nothing. Do not override this function in subclasses;
-        implement setupSelfBefore() and/or setupSelfAfter() instead. */
+        implement setupSelfBefore() and/or setupSelfAfter() instead.
+
+        A subclass can declare some of its children as independent by overriding the
+        independentSetupChildren() function. When the children loop arrives at the first of these
+        items, they are all set up concurrently on the thread pool of the simulation, provided this
+        is a single-process run with multiple threads. The other children are set up sequentially
+        as usual. Otherwise, all children are set up in order, exactly as if there were no
+        independent children. Dependencies between the concurrently set up
+        items are resolved through the find() and interface() lookups: if one of these functions
+        requests an item that is being set up by another concurrent task, the calling thread waits
+        until that setup has completed. An item whose setup is in progress higher up the calling
+        chain, i.e. an ancestor of the requested item that launched the concurrent setup, is
+        returned right away, as in the sequential case. Circular dependencies between concurrent
+        tasks cause a fatal error.
+
+        When set up concurrently, each independent child is set up with its own predictable random
+        generator state, derived from the state of the launching thread and the position of the
+        child in the list (see Random::deriveState()), so that the setup results do not depend on
+        the order of execution or on the number of threads. The state of the launching thread is
+        restored afterwards. In contrast, sequential setup uses the random sequence of the
+        launching thread as usual. As a result, the results of a simulation that draws random
+        numbers during setup of independent children differ between sequential and concurrent
+        setup, although both are statistically equivalent.
+
+        Threads that help perform a parallel loop started from within a concurrent setup task
+        adopt the context of that task (see MultiThreadParallel::callContext()). As a result, a
+        find() or interface() lookup performed by the body of such a loop waits for an item that is
+        being set up by another task, just like a lookup performed by the task itself. */
     void setup();
 
 protected:
@@ -48,6 +76,19 @@ protected:
         by calling the same function in its immediate base class. */
     virtual void setupSelfAfter();
 
+    /** This function can be overridden in a subclass to return a list of children that can be set
+        up concurrently, as described for the setup() function. The setup of each of these
+        children (including their descendents) should depend only on items outside of the list, or
+        on items that are set up as part of the same child. This implementation here in the
+        SimulationItem class returns an empty list. */
+    virtual vector<SimulationItem*> independentSetupChildren() const;
+
+private:
+    /** This function performs setup for the specified items concurrently, each in a separate task
+        on the thread pool of the simulation. It is used by the setup() function if the run-time
+        environment allows concurrent setup. */
+    void setupConcurrently(const vector<SimulationItem*>& items) const;
+
     //======================== Other Functions =======================
 
 public:
@@ -151,7 +192,8 @@ protected:
     //======================== Data Members ========================
 
 private:
-    bool _setupStarted{false};  // becomes true when setup for the item begins
+    std::atomic<int> _setupState{0};   // the setup state: not started, in progress, done, or failed
+    const void* _setupOwner{nullptr};  // the concurrent setup task performing setup for the item, if any
 };
 
 ////////////////////////////////////////////////////////////////////
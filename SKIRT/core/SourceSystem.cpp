@@ -29,15 +29,39 @@ void SourceSystem::setupSelfAfter()
     if (!_L) return;
     _Lv /= _L;
 
+    // calculate the launch weight for each source
+    calculateLaunchWeights();
+
+    // resize the history index mapping vector
+    _Iv.resize(Ns + 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+vector<SimulationItem*> SourceSystem::independentSetupChildren() const
+{
+    return vector<SimulationItem*>(_sources.begin(), _sources.end());
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SourceSystem::calculateLaunchWeights()
+{
     // calculate the launch weight for each source, normalized to unity
+    int Ns = _sources.size();
     Array wv(Ns);
     for (int h = 0; h != Ns; ++h) wv[h] = _sources[h]->sourceWeight();
     Array wLv = wv * _Lv;
     double xi = sourceBias();
     _Wv = (1 - xi) * wLv / wLv.sum() + xi * wv / wv.sum();
+}
 
-    // resize the history index mapping vector
-    _Iv.resize(Ns + 1);
+//////////////////////////////////////////////////////////////////////
+
+void SourceSystem::setSourceBias(double value)
+{
+    _sourceBias = value;
+    if (_L) calculateLaunchWeights();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -99,9 +123,12 @@ void SourceSystem::prepareForLaunch(size_t numPackets)
 
 //////////////////////////////////////////////////////////////////////
 
-void SourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
+void SourceSystem::launch(PhotonPacket* pp, size_t historyIndex, bool probe) const
 {
-    // ask the appropriate source to prepare the photon packet for launch
+    // ask the appropriate source to prepare the photon packet for launch;
+    // the source is located through an exact integer search rather than with a CdfSampler, because a history
+    // index must map to the same source as in prepareForLaunch() even for sources with an empty index range,
+    // which floating point comparisons cannot guarantee, and because the number of sources is usually small
     auto h = std::upper_bound(_Iv.cbegin(), _Iv.cend(), historyIndex) - _Iv.cbegin() - 1;
     double weight = _Lv[h] / _Wv[h];
     _sources[h]->launch(pp, historyIndex, _Lpp * weight);
@@ -109,8 +136,8 @@ void SourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
     // add additional info
     pp->setPrimaryOrigin(h);
 
-    // invoke launch call-back if installed
-    if (_callback) _callback->probePhotonPacket(pp);
+    // invoke launch call-back if installed and requested
+    if (_callback && probe) _callback->probePhotonPacket(pp);
 }
 
 //////////////////////////////////////////////////////////////////////
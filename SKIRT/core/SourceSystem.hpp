@@ -101,12 +101,26 @@ protected:
     /** This function obtains the bolometric luminosity of each source for later use. */
     void setupSelfAfter() override;
 
+    /** This function returns the primary sources, so that these can be set up concurrently. */
+    vector<SimulationItem*> independentSetupChildren() const override;
+
 public:
     /** This function installs the specified interface as photon packet launch call-back. The
         function probePhotonPacket() provided by the interface will be called for each photon
         packet that is ready to be launched. */
     void installLaunchCallBack(ProbePhotonPacketInterface* callback);
 
+    /** This function replaces the value of the \em sourceBias property by the specified value and
+        recalculates the launch weight for each source accordingly. It is intended for use by the
+        pilot run that tunes the photon life-cycle parameters (see MonteCarloSimulation::runPilot()),
+        and it must be called before the prepareForLaunch() function for the next segment. */
+    void setSourceBias(double value);
+
+private:
+    /** This function calculates the launch weight for each source from its luminosity, its source
+        weight, and the current value of the \em sourceBias property. */
+    void calculateLaunchWeights();
+
     //======================== Other Functions =======================
 
 public:
@@ -130,8 +144,10 @@ public:
 
     /** This function causes the photon packet \em pp to be launched from one of the sources in the
         source system using the given history index. The photon packet's contents is fully
-        (re-)initialized so that it is ready to start its lifecycle. */
-    void launch(PhotonPacket* pp, size_t historyIndex) const;
+        (re-)initialized so that it is ready to start its lifecycle. If the \em probe flag is false,
+        the launch call-back (if installed) is not invoked; this is used for photon packets that do
+        not contribute to the simulation results, such as those launched by a pilot run. */
+    void launch(PhotonPacket* pp, size_t historyIndex, bool probe = true) const;
 
     //======================== Data Members ========================
 
@@ -102,7 +102,7 @@ public:
                 double rmin = _grid->minRadius();
                 double r = sqrt(rx() * rx() + ry() * ry() + rz() * rz());
                 _q = rx() * kx() + ry() * ky() + rz() * kz();
-                _p = sqrt((r - _q) * (r + _q));
+                _p = sqrt(max(0., (r - _q) * (r + _q)));  // guard against roundoff for rays through the center
                 if (r > rmax)
                 {
                     if (_q > 0. || _p > rmax)
@@ -170,15 +170,6 @@ namespace
         return 0;
     }
 
-    // returns the smallest positive solution of a*x^2 + 2*b*x + c = 0, or 0 if there is no positive solution
-    double smallestPositiveSolution(double a, double b, double c)
-    {
-        if (fabs(a) > 1e-9) return smallestPositiveSolution(b / a, c / a);
-        double x = -0.5 * c / b;
-        if (x > 0) return x;
-        return 0;
-    }
-
     // returns the distance to the first intersection between the ray (bfr,bfk) and the sphere with given radius,
     // or 0 if there is no intersection
     double firstIntersectionSphere(Vec bfr, Vec bfk, double r)
@@ -186,14 +177,6 @@ namespace
         return smallestPositiveSolution(Vec::dot(bfr, bfk), bfr.norm2() - r * r);
     }
 
-    // returns the distance to the first intersection between the ray (bfr,bfk) and the cone with given cos(theta),
-    // or 0 if there is no intersection (the degenarate cone with zero cosine is treated separately)
-    double firstIntersectionCone(Vec bfr, Vec bfk, double c)
-    {
-        return c ? smallestPositiveSolution(c * c - bfk.z() * bfk.z(), c * c * Vec::dot(bfr, bfk) - bfr.z() * bfk.z(),
-                                            c * c * bfr.norm2() - bfr.z() * bfr.z())
-                 : -bfr.z() / bfk.z();  // degenerate cone identical to xy-plane
-    }
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -204,6 +187,12 @@ class Sphere2DSpatialGrid::MySegmentGenerator : public PathSegmentGenerator
     double _eps{0.};
     int _i{-1}, _k{-1};
 
+    // the path is parametrized by the distance s along the ray from the reference position r0
+    double _b{0.}, _q{0.}, _p2{0.}, _z0{0.}, _kz{0.};  // r0.k, r0^2, squared impact parameter, r0_z, k_z
+    double _s{0.};                                     // the distance to the current position
+    double _sR{0.}, _sC{0.};                           // the distance to the next radial and angular crossings
+    int _iR{-1}, _kC{-1};                              // the cell indices beyond these crossings
+
 public:
     MySegmentGenerator(const Sphere2DSpatialGrid* grid) : _grid(grid) {}
 
@@ -217,6 +206,129 @@ public:
         _k = NR::locateClip(_grid->_thetav, theta);
     }
 
+    // initialize the path parameters with the current position as reference position
+    void setReference()
+    {
+        _b = rx() * kx() + ry() * ky() + rz() * kz();
+        _q = rx() * rx() + ry() * ry() + rz() * rz();
+        _p2 = max(0., _q - _b * _b);
+        _z0 = rz();
+        _kz = kz();
+        _s = 0.;
+    }
+
+    // determine the next crossing with a radial boundary sphere for the current cell;
+    // the path moves inwards up to the tangent point at s = -b, and outwards beyond that point
+    void setNextRadialCrossing()
+    {
+        double Ri = _grid->_rv[_i];
+        if (_s < -_b && _i > 0 && Ri * Ri > _p2)
+        {
+            _sR = -_b - sqrt(Ri * Ri - _p2);
+            _iR = _i - 1;
+        }
+        else
+        {
+            double RN = _grid->_rv[_i + 1];
+            _sR = -_b + sqrt(max(0., RN * RN - _p2));
+            _iR = _i + 1;  // may be incremented beyond the outermost boundary
+        }
+    }
+
+    // return the smallest intersection distance with the cone with given cos(theta) beyond the specified
+    // distance, or DBL_MAX if there is no such intersection (the degenerate cone with zero cosine is the xy-plane)
+    double nextConeCrossing(double c, double smin) const
+    {
+        double s = DBL_MAX;
+        if (c == 0.)
+        {
+            double x = -_z0 / _kz;
+            if (x > smin && x < s) s = x;  // also discards infinity and NaN
+        }
+        else
+        {
+            // the intersections are the solutions of a*s^2 + 2*b*s + c = 0
+            double c2 = c * c;
+            double qa = _kz * _kz - c2;
+            double qb = _z0 * _kz - c2 * _b;
+            double qc = _z0 * _z0 - c2 * _q;
+            if (fabs(qa) > 1e-9)
+            {
+                double D = qb * qb - qa * qc;
+                if (D >= 0.)
+                {
+                    double t = -(qb + copysign(sqrt(D), qb));
+                    double x1 = t / qa;
+                    double x2 = t != 0. ? qc / t : x1;
+                    if (x1 > smin && x1 < s) s = x1;
+                    if (x2 > smin && x2 < s) s = x2;
+                }
+            }
+            else if (qb != 0.)
+            {
+                double x = -0.5 * qc / qb;
+                if (x > smin) s = x;
+            }
+        }
+        return s;
+    }
+
+    // determine the next crossing with an angular boundary cone for the current cell; intersections
+    // within a tiny distance from the current position are ignored so that the boundary that has just been
+    // crossed is not found again; intersections with the reflected cones are automatically ignored because
+    // the xy-plane is always a boundary between them and the current position
+    void setNextAngularCrossing()
+    {
+        double smin = _s + _eps;
+        _sC = DBL_MAX;
+        _kC = _k;
+        if (_k > 0)
+        {
+            double s = nextConeCrossing(_grid->_cv[_k], smin);
+            if (s < _sC)
+            {
+                _sC = s;
+                _kC = _k - 1;
+            }
+        }
+        if (_k < _grid->_Ntheta - 1)
+        {
+            double s = nextConeCrossing(_grid->_cv[_k + 1], smin);
+            if (s < _sC)
+            {
+                _sC = s;
+                _kC = _k + 1;
+            }
+        }
+    }
+
+    // return true if the position at distance s lies in the current cell within a tolerance of the order of
+    // eps; this allows verifying the running cell indices against the path parametrization
+    bool isInCurrentCell(double s) const
+    {
+        double r = sqrt(max(0., _q + s * (2. * _b + s)));
+        double z = _z0 + _kz * s;
+        return r >= _grid->_rv[_i] - _eps && r <= _grid->_rv[_i + 1] + _eps && z <= _grid->_cv[_k] * r + _eps
+               && z >= _grid->_cv[_k + 1] * r - _eps;
+    }
+
+    // move the position a tiny distance beyond the current position, locate the cell indices from scratch,
+    // and reinitialize the path parameters and crossings; return false if the new position is outside the grid
+    bool relocate()
+    {
+        propagater(_s + _eps);
+        setCellIndices();
+        if (_i < 0)
+        {
+            setState(State::Outside);
+            return false;
+        }
+        setReference();
+        setNextRadialCrossing();
+        setNextAngularCrossing();
+        return true;
+    }
+
     bool next() override
     {
         switch (state())
@@ -229,116 +341,73 @@ public:
 
                 // if necessary, try moving the photon packet inside the grid
                 double r2 = r().norm2();
+                double ds = 0.;
                 if (r2 > rmax * rmax)
                 {
-                    double ds = firstIntersectionSphere(r(), k(), rmax);
+                    ds = firstIntersectionSphere(r(), k(), rmax);
                     if (ds > 0.)
                     {
                         propagater(ds + _eps);
                         setCellIndices();
-                        if (_i >= 0)
-                        {
-                            // return an empty path segment with the appropriate length
-                            setEmptySegment(ds);
-                            setState(State::Inside);
-                            return true;
-                        }
                     }
-                    // there is no intersection with the grid; return an empty path
-                    setState(State::Outside);
-                    return false;
+                    // if there is no intersection with the grid, return an empty path
+                    if (ds <= 0. || _i < 0)
+                    {
+                        setState(State::Outside);
+                        return false;
+                    }
+                }
+                else
+                {
+                    // the original position was inside the grid
+                    // if necessary, move the position away from the origin so that it has meaningful cell indices
+                    if (r2 == 0.) propagater(_eps);
+                    setCellIndices();
                 }
 
-                // the original position was inside the grid
-                // if necessary, move the position away from the origin so that it has meaningful cell indices
-                if (r2 == 0.) propagater(_eps);
-                setCellIndices();
+                // initialize the path parameters and the first crossings
+                setReference();
+                setNextRadialCrossing();
+                setNextAngularCrossing();
                 setState(State::Inside);
 
-                // fall through to determine the first actual segment
+                // if the photon packet started outside the grid, return an empty path segment with the
+                // appropriate length; otherwise fall through to determine the first actual segment
+                if (ds > 0.)
+                {
+                    setEmptySegment(ds);
+                    return true;
+                }
             }
 
             // intentionally falls through
             case State::Inside:
             {
-                while (true)  // the loop is executed more than once only if no exit point is found
+                // if roundoff errors have made the running cell indices inconsistent with the path, as verified
+                // at the midpoint of the upcoming segment, relocate the cell from a slightly advanced position
+                if (!isInCurrentCell(0.5 * (_s + min(_sR, _sC))) && !relocate()) return false;
+
+                // the nearest of the next radial and angular crossings determines the exit point of the cell;
+                // only the crossing that has been passed needs to be recalculated for the next cell
+                int m = _grid->index(_i, _k);
+                if (_sR <= _sC)
                 {
-                    // remember the indices of the current cell
-                    int icur = _i;
-                    int kcur = _k;
-
-                    // calculate the distance travelled inside the cell by considering
-                    // the potential exit points for each of the four cell boundaries;
-                    // the smallest positive intersection "distance" wins.
-                    double ds = DBL_MAX;  // very large, but not infinity (so that infinite values are discarded)
-
-                    // inner radial boundary (not applicable to innermost cell)
-                    if (icur > 0)
-                    {
-                        double s = firstIntersectionSphere(r(), k(), _grid->_rv[icur]);
-                        if (s > 0 && s < ds)
-                        {
-                            ds = s;
-                            _i = icur - 1;
-                            _k = kcur;
-                        }
-                    }
-
-                    // outer radial boundary (always applicable)
-                    {
-                        double s = firstIntersectionSphere(r(), k(), _grid->_rv[icur + 1]);
-                        if (s > 0 && s < ds)
-                        {
-                            ds = s;
-                            _i = icur + 1;  // may be incremented beyond the outermost boundary
-                            _k = kcur;
-                        }
-                    }
-
-                    // upper angular boundary (not applicable to uppermost cell)
-                    if (kcur > 0)
-                    {
-                        double s = firstIntersectionCone(r(), k(), _grid->_cv[kcur]);
-                        if (s > 0 && s < ds)
-                        {
-                            ds = s;
-                            _i = icur;
-                            _k = kcur - 1;
-                        }
-                    }
-
-                    // lower angular boundary (not applicable to lowest cell)
-                    if (kcur < _grid->_Ntheta - 1)
-                    {
-                        double s = firstIntersectionCone(r(), k(), _grid->_cv[kcur + 1]);
-                        if (s > 0 && s < ds)
-                        {
-                            ds = s;
-                            _i = icur;
-                            _k = kcur + 1;
-                        }
-                    }
-
-                    // if an exit point was found, add a segment to the path
-                    if (_i != icur || _k != kcur)
-                    {
-                        setSegment(_grid->index(icur, kcur), ds);
-                        propagater(ds + _eps);
-                        if (_i >= _grid->_Nr) setState(State::Outside);
-                        return true;
-                    }
-
-                    // otherwise, move a tiny bit along the path and reset the current cell indices
-                    propagater(_eps);
-                    setCellIndices();
-                    if (_i < 0)
-                    {
-                        // the new current point is outside the grid; there is no segment to return
+                    setSegment(m, max(0., _sR - _s));
+                    _s = _sR;
+                    _i = _iR;
+                    if (_i >= _grid->_Nr)
                         setState(State::Outside);
-                        return false;
-                    }
-                    // try again from the start of this loop
+                    else
+                        setNextRadialCrossing();
+                }
+                else
+                {
+                    setSegment(m, _sC - _s);
+                    _s = _sC;
+                    _k = _kC;
+                    setNextAngularCrossing();
                 }
+                return true;
             }
 
             case State::Outside:
@@ -82,16 +82,25 @@ public:
         private PathSegmentGenerator subclass. The algorithm used to construct the path is
         described below.
 
-        We represent the path by its parameter equation \f${\bf{x}}={\bf{r}}+s\,{\bf{k}}\f$, and we
-        assume that \f${\bf{k}}\f$ is a unit vector. The two intersection points with a radial
-        boundary sphere \f${\bf{x}}^2=R^2\f$ are obtained by solving the quadratic equation \f$s^2
-        + 2\,({\bf{r}}\cdot{\bf{k}})\,s + ({\bf{r}}^2-R^2)=0\f$ for \f$s\f$. The two intersection
+        We represent the path by its parameter equation \f${\bf{x}}={\bf{r}}_0+s\,{\bf{k}}\f$, where
+        \f${\bf{r}}_0\f$ is the first position inside the grid and \f${\bf{k}}\f$ is a unit vector.
+        With \f$b={\bf{r}}_0\cdot{\bf{k}}\f$ and the squared impact parameter
+        \f$p^2={\bf{r}}_0^2-b^2\f$, the intersection points with a radial boundary sphere
+        \f${\bf{x}}^2=R^2\f$ are given by \f$s=-b\mp\sqrt{R^2-p^2}\f$. The path moves inwards up
+        to the tangent point \f$s=-b\f$ and outwards beyond that point, so that the next radial
+        crossing requires a single square root and no search in the radial grid. The intersection
         points with an angular boundary cone \f$x_z^2=c^2\,{\bf{x}}^2\f$ (with \f$c=\cos\theta\f$)
-        are obtained by solving the quadratic equation \f$(c^2-k_z^2)\,s^2 +
-        2\,(c^2\,{\bf{r}}\cdot{\bf{k}}-r_z k_z)\,s + (c^2\,{\bf{r}}^2-r_z^2)=0\f$ for \f$s\f$. The
-        intersection points with the reflected cone are always more distant than the other cell
-        boundaries (the requirement to include the xy-plane \f$\theta=\pi/2\f$ in the grid ensures
-        that this is true) and thus these phantom points are automatically ignored. */
+        are obtained by solving the quadratic equation \f$(k_z^2-c^2)\,s^2 + 2\,(r_{0,z} k_z -
+        c^2 b)\,s + (r_{0,z}^2-c^2\,{\bf{r}}_0^2)=0\f$ for \f$s\f$, using the pre-calculated
+        cosines. The intersection points with the reflected cone are always more distant than the
+        other cell boundaries (the requirement to include the xy-plane \f$\theta=\pi/2\f$ in the
+        grid ensures that this is true) and thus these phantom points are automatically ignored.
+
+        Because all intersection distances are expressed relative to the same reference position,
+        the generator keeps track of the next radial and the next angular crossing. When the path
+        crosses a radial boundary, only the next radial crossing is recalculated, and vice versa.
+        The current position is never propagated along the path, and the cell indices are located
+        in the grid only once, at the start of the path. */
     std::unique_ptr<PathSegmentGenerator> createPathSegmentGenerator() const override;
 
 protected:
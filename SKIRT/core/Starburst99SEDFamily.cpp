@@ -45,9 +45,8 @@ Range Starburst99SEDFamily::intrinsicWavelengthRange() const
 
 double Starburst99SEDFamily::specificLuminosity(double wavelength, const Array& parameters) const
 {
-    double M = parameters[0] / Constants::Msun();
-    double Z = parameters[1];
-    double t = parameters[2] / Constants::year();
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
 
     return M * _table(wavelength, Z, t);
 }
@@ -57,11 +56,45 @@ double Starburst99SEDFamily::specificLuminosity(double wavelength, const Array&
 double Starburst99SEDFamily::cdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
                                  const Array& parameters) const
 {
-    double M = parameters[0] / Constants::Msun();
-    double Z = parameters[1];
-    double t = parameters[2] / Constants::year();
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
 
     return M * _table.cdf(lambdav, pv, Pv, wavelengthRange, Z, t);
 }
 
 ////////////////////////////////////////////////////////////////////
+
+size_t Starburst99SEDFamily::numNodes() const
+{
+    return _table.numNodes();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Starburst99SEDFamily::nodeWeights(const Array& parameters, vector<std::pair<size_t, double>>& nodes) const
+{
+    double Z, t;
+    double M = decodeParameters(parameters, Z, t);
+
+    _table.nodeWeights(nodes, Z, t);
+    for (auto& node : nodes) node.second *= M;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Starburst99SEDFamily::nodeCdf(Array& lambdav, Array& pv, Array& Pv, const Range& wavelengthRange,
+                                     size_t node) const
+{
+    return _table.nodeCdf(lambdav, pv, Pv, wavelengthRange, node);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Starburst99SEDFamily::decodeParameters(const Array& parameters, double& Z, double& t) const
+{
+    Z = parameters[1];
+    t = parameters[2] / Constants::year();
+    return parameters[0] / Constants::Msun();
+}
+
+////////////////////////////////////////////////////////////////////
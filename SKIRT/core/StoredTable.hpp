@@ -105,6 +105,21 @@
     alive between consecutive invocations of a program (assuming memory is available), increasing
     performance when, for example, interactively testing the program.
 
+    To speed up interpolation, the logarithms of the grid points for logarithmic axes are
+    precalculated. Furthermore, the values of the quantity associated with the instance must be
+    available as a contiguous block in interpolation scale, i.e. as logarithms for a logarithmic
+    quantity. For a table with a single linear quantity, the memory-mapped values satisfy this
+    requirement as is. Otherwise (the file interleaves the values of all quantities), the values
+    are repacked into memory, unless the table holds more values than the limit configured for
+    the simulation (see Configuration::maxRepackedTableValues(); by default about eight million
+    values, i.e. 64 MB). The repacked copy is shared by all instances in a process that are
+    associated with the same file and quantity, but it is not shared between processes.
+    Interpolation for given values of all but the first axis involves at most
+    \f$2^{N-1}\f$ rows along the first axis. As a result, the values along the first axis
+    corresponding to the internal grid points, as needed by the cdf() function, are obtained as a
+    weighted sum of contiguous rows, which the compiler can vectorize. The values of tables that
+    are not repacked are interpolated directly from the interleaved memory map.
+
     On the downside, a program requesting a huge chunk of data from a large stored table in a
     serial fashion would run faster using regular file I/O, because the separate page loads take
     more time than sequentially reading data in bulk. More importantly, performance usually
@@ -183,7 +198,7 @@ public:
               bool resource = true)
     {
         StoredTable_Impl::open(N, item, filename, resource, axes, quantity, _filePath, &_axBeg[0], &_qtyBeg, &_axLen[0],
-                               &_qtyStep, &_axLog[0], &_qtyLog);
+                               &_qtyStep, &_axLog[0], &_qtyLog, &_axIpBeg[0], &_rowBeg, _repacked);
         _clamp = clampFirstAxis;
     }
 
@@ -204,99 +219,11 @@ public:
     template<typename... Values, typename = std::enable_if_t<CompileTimeUtils::isFloatArgList<N, Values...>()>>
     double operator()(Values... values) const
     {
-        // storage for each axis
         std::array<double, N> value = {{static_cast<double>(values)...}};
-        std::array<size_t, N> i2;  // upper grid bin boundary index
-        std::array<double, N> f;   // fraction of axis value in bin
-
-        // precompute for each axis
-        for (size_t k = 0; k != N; ++k)
-        {
-            // get the index of the upper border of the axis grid bin containing the specified axis value
-            double x = value[k];
-            size_t right = std::lower_bound(_axBeg[k], _axBeg[k] + _axLen[k], x) - _axBeg[k];
-
-            // if the value is beyond the grid borders:
-            //    - if we're not clamping, simply return zero
-            //    - if we're clamping, adjust both the bin border and the value
-            if (right == 0)
-            {
-                if (!_clamp && k == 0 && x != _axBeg[k][0]) return 0.;
-                right++;
-                x = _axBeg[k][0];
-            }
-            else if (right == _axLen[k])
-            {
-                if (!_clamp && k == 0) return 0.;
-                right--;
-                x = _axBeg[k][right];
-            }
-            i2[k] = right;
-
-            // get the axis values at the grid borders
-            double x1 = _axBeg[k][right - 1];
-            double x2 = _axBeg[k][right];
-
-            // if requested, compute logarithm of coordinate values
-            if (_axLog[k])
-            {
-                x = log(x);
-                x1 = log(x1);
-                x2 = log(x2);
-            }
-
-            // calculate the fraction of the requested axis value in the bin
-            f[k] = (x - x1) / (x2 - x1);
-        }
-
-        // storage for each term in the interpolation
-        constexpr size_t numTerms = 1 << N;  // there are 2^N terms
-        std::array<double, numTerms> ff;     // front factor
-        std::array<double, numTerms> yy;     // tabulated value
-
-        // determine front factor and tabulated value for each term of the interpolation
-        std::array<size_t, N> indices;  // storage for indices of the current term
-        for (size_t t = 0; t != numTerms; ++t)
-        {
-            // use the binary representation of the term index to determine left/right for each axis
-            size_t term = t;  // temporary version of term index that will be bit-shifted
-            double front = 1.;
-            for (size_t k = 0; k != N; ++k)
-            {
-                size_t left = term & 1;  // lowest significant digit = 1 means lower border
-                indices[k] = i2[k] - left;
-                front *= left ? (1 - f[k]) : f[k];
-                term >>= 1;
-            }
-            if (front)
-            {
-                ff[t] = front;
-                yy[t] = valueAtIndices(indices);
-
-                // if logarithmic interpolation of y value is requested and not all bordering values are positive,
-                // we can't comply with the request, so return zero
-                if (_qtyLog && yy[t] <= 0) return 0.;
-            }
-            else
-            {
-                ff[t] = 0.;
-                yy[t] = 0.;
-            }
-        }
-
-        // calculate sum
-        double y = 0.;
-        if (_qtyLog)
-        {
-            for (size_t t = 0; t != numTerms; ++t)
-                if (ff[t]) y += ff[t] * log(yy[t]);
-            y = exp(y);
-        }
-        else
-        {
-            for (size_t t = 0; t != numTerms; ++t) y += ff[t] * yy[t];
-        }
-        return y;
+        std::array<size_t, numRows> rowv;  // offset of the first-axis row for each term in the interpolation
+        std::array<double, numRows> ffv;   // front factor for each term in the interpolation
+        size_t numTerms = prepareRows(value, rowv, ffv);
+        return interpolateRows(value[0], rowv, ffv, numTerms);
     }
 
     /** For a one-dimensional table only, this function returns the value of the quantity
@@ -319,156 +246,14 @@ public:
     template<typename... Values, typename = std::enable_if_t<CompileTimeUtils::isFloatArgList<N - 1, Values...>()>>
     void valueArray(Array& yv, const Array& xv, Values... values) const
     {
-        // storage for each axis
         std::array<double, N> value = {{0., static_cast<double>(values)...}};
-        std::array<size_t, N> i2;       // upper grid bin boundary index
-        std::array<double, N> f;        // fraction of axis value in bin
-        std::array<size_t, N> indices;  // indices of the current term
-
-        // storage for each term in the interpolation
-        constexpr size_t numTerms = 1 << N;  // there are 2^N terms
-        std::array<double, numTerms> ff;     // front factor
-        std::array<double, numTerms> yy;     // tabulated value
+        std::array<size_t, numRows> rowv;  // offset of the first-axis row for each term in the interpolation
+        std::array<double, numRows> ffv;   // front factor for each term in the interpolation
+        size_t numTerms = prepareRows(value, rowv, ffv);
 
-        // resize output array
-        size_t n = xv.size();  // number of values to calculate
+        size_t n = xv.size();
         yv.resize(n);
-
-        // precompute grid index and fraction for all but the first axis
-        for (size_t k = 1; k != N; ++k)
-        {
-            // get the index of the upper border of the axis grid bin containing the specified axis value
-            double x = value[k];
-            size_t right = std::lower_bound(_axBeg[k], _axBeg[k] + _axLen[k], x) - _axBeg[k];
-
-            // if the value is beyond the grid borders, adjust both the bin border and the value
-            if (right == 0)
-            {
-                right++;
-                x = _axBeg[k][0];
-            }
-            else if (right == _axLen[k])
-            {
-                right--;
-                x = _axBeg[k][right];
-            }
-            i2[k] = right;
-
-            // get the axis values at the grid borders
-            double x1 = _axBeg[k][right - 1];
-            double x2 = _axBeg[k][right];
-
-            // if requested, compute logarithm of coordinate values
-            if (_axLog[k])
-            {
-                x = log(x);
-                x1 = log(x1);
-                x2 = log(x2);
-            }
-
-            // calculate the fraction of the requested axis value in the bin
-            f[k] = (x - x1) / (x2 - x1);
-        }
-
-        // calculate each value in the array
-        for (size_t i = 0; i != n; ++i)
-        {
-            value[0] = xv[i];
-
-            // compute grid index and fraction for the first axis
-            {
-                // get the index of the upper border of the axis grid bin containing the specified axis value
-                double x = value[0];
-                size_t right = std::lower_bound(_axBeg[0], _axBeg[0] + _axLen[0], x) - _axBeg[0];
-
-                // if the value is beyond the grid borders:
-                //    - if we're not clamping, simply return zero
-                //    - if we're clamping, adjust both the bin border and the value
-                if (right == 0)
-                {
-                    if (!_clamp && x != _axBeg[0][0])
-                    {
-                        yv[i] = 0.;
-                        continue;
-                    };
-                    right++;
-                    x = _axBeg[0][0];
-                }
-                else if (right == _axLen[0])
-                {
-                    if (!_clamp)
-                    {
-                        yv[i] = 0.;
-                        continue;
-                    };
-                    right--;
-                    x = _axBeg[0][right];
-                }
-                i2[0] = right;
-
-                // get the axis values at the grid borders
-                double x1 = _axBeg[0][right - 1];
-                double x2 = _axBeg[0][right];
-
-                // if requested, compute logarithm of coordinate values
-                if (_axLog[0])
-                {
-                    x = log(x);
-                    x1 = log(x1);
-                    x2 = log(x2);
-                }
-
-                // calculate the fraction of the requested axis value in the bin
-                f[0] = (x - x1) / (x2 - x1);
-            }
-
-            // determine front factor and tabulated value for each term of the interpolation
-            for (size_t t = 0; t != numTerms; ++t)
-            {
-                // use the binary representation of the term index to determine left/right for each axis
-                size_t term = t;  // temporary version of term index that will be bit-shifted
-                double front = 1.;
-                for (size_t k = 0; k != N; ++k)
-                {
-                    size_t left = term & 1;  // lowest significant digit = 1 means lower border
-                    indices[k] = i2[k] - left;
-                    front *= left ? (1 - f[k]) : f[k];
-                    term >>= 1;
-                }
-                if (front)
-                {
-                    ff[t] = front;
-                    yy[t] = valueAtIndices(indices);
-
-                    // if logarithmic interpolation of y value is requested and not all bordering values are positive,
-                    // we can't comply with the request, so return zero
-                    if (_qtyLog && yy[t] <= 0)
-                    {
-                        yv[i] = 0.;
-                        continue;
-                    };
-                }
-                else
-                {
-                    ff[t] = 0.;
-                    yy[t] = 0.;
-                }
-            }
-
-            // calculate sum
-            double y = 0.;
-            if (_qtyLog)
-            {
-                for (size_t t = 0; t != numTerms; ++t)
-                    if (ff[t]) y += ff[t] * log(yy[t]);
-                y = exp(y);
-            }
-            else
-            {
-                for (size_t t = 0; t != numTerms; ++t) y += ff[t] * yy[t];
-            }
-            yv[i] = y;
-        }
+        for (size_t i = 0; i != n; ++i) yv[i] = interpolateRows(xv[i], rowv, ffv, numTerms);
     }
 
     // ------------------------------------------
@@ -504,8 +289,17 @@ public:
         for (size_t j = minRight; j < maxRight;) xv[i++] = _axBeg[0][j++];
         xv[i++] = xrange.max();
 
-        // interpolate or copy the corresponding probability density values
-        valueArray(pv, xv, values...);
+        // interpolate the probability density values at the outer points; the values at the internal points
+        // are obtained by blending the first-axis rows for the other axes, because these points coincide with
+        // grid points so that there is no need for interpolation along the first axis
+        std::array<double, N> value = {{0., static_cast<double>(values)...}};
+        std::array<size_t, numRows> rowv;  // offset of the first-axis row for each term in the interpolation
+        std::array<double, numRows> ffv;   // front factor for each term in the interpolation
+        size_t numTerms = prepareRows(value, rowv, ffv);
+        pv.resize(i);
+        pv[0] = interpolateRows(xv[0], rowv, ffv, numTerms);
+        pv[i - 1] = interpolateRows(xv[i - 1], rowv, ffv, numTerms);
+        blendRows(&pv[1], minRight, maxRight - minRight, rowv, ffv, numTerms);
 
         // perform the rest of the operation in a non-templated function
         return NR::cdf2(_axLog[0] && _qtyLog, xv, pv, Pv);
@@ -513,6 +307,75 @@ public:
 
     // ------------------------------------------
 
+    /** This function is available only for tables with two or more axes. It returns the number of
+        nodes in the grid spanned by all but the first axis, i.e. the product of the number of grid
+        points in each of these axes. A node is identified by its flattened index in this grid,
+        with the second axis index varying most rapidly. */
+    size_t numNodes() const
+    {
+        static_assert(N >= 2, "This function is available only for tables with two or more axes");
+        size_t result = 1;
+        for (size_t k = 1; k != N; ++k) result *= _axLen[k];
+        return result;
+    }
+
+    /** This function is available only for tables with two or more axes. It determines the nodes
+        in the grid spanned by all but the first axis that contribute to the interpolation of the
+        tabulated quantity for the specified values of these axes (the arguments at the end of the
+        list), and replaces the contents of the \em nodes argument by the index (see numNodes())
+        and the interpolation front factor of each of these nodes. Nodes with a zero front factor
+        are omitted. Out-of-range axes values are clamped to the grid borders, in the same way as
+        is done by the valueArray() function.
+
+        If the table uses linear interpolation for the quantity values, the quantity for the
+        specified axes values equals the sum of the quantity at each node multiplied by its front
+        factor, for all first-axis values. If the table uses logarithmic interpolation for the
+        quantity values, this is true only for the logarithm of the quantity, so that the weighted
+        sum offers just an approximation. */
+    template<typename... Values, typename = std::enable_if_t<CompileTimeUtils::isFloatArgList<N - 1, Values...>()>>
+    void nodeWeights(vector<std::pair<size_t, double>>& nodes, Values... values) const
+    {
+        static_assert(N >= 2, "This function is available only for tables with two or more axes");
+
+        std::array<double, N> value = {{0., static_cast<double>(values)...}};
+        std::array<size_t, numRows> rowv;
+        std::array<double, numRows> ffv;
+        size_t numTerms = prepareRows(value, rowv, ffv);
+
+        nodes.clear();
+        for (size_t t = 0; t != numTerms; ++t) nodes.emplace_back(rowv[t] / _axLen[0], ffv[t]);
+    }
+
+    /** This function is available only for tables with two or more axes. It behaves as the cdf()
+        function for the axes values corresponding to the grid node with the specified index (see
+        numNodes()) in all but the first axis. */
+    double nodeCdf(Array& xv, Array& pv, Array& Pv, Range xrange, size_t node) const
+    {
+        static_assert(N >= 2, "This function is available only for tables with two or more axes");
+
+        // convert the node index to the corresponding axes values
+        std::array<double, N> value;
+        for (size_t k = 1; k != N; ++k)
+        {
+            value[k] = _axBeg[k][node % _axLen[k]];
+            node /= _axLen[k];
+        }
+        return cdfForAxesValues(xv, pv, Pv, xrange, value, std::make_index_sequence<N - 1>());
+    }
+
+private:
+    /** This function calls the cdf() function with the values for all but the first axis taken
+        from the specified array. */
+    template<size_t... Is>
+    double cdfForAxesValues(Array& xv, Array& pv, Array& Pv, Range xrange, const std::array<double, N>& value,
+                            std::index_sequence<Is...>) const
+    {
+        return cdf(xv, pv, Pv, xrange, value[Is + 1]...);
+    }
+
+public:
+    // ------------------------------------------
+
     /** This function returns the range of the table axis indicated by the zero-based index in the
         template argument. */
     template<size_t axisIndex, typename = std::enable_if_t<axisIndex <= N>> Range axisRange() const
@@ -550,41 +413,166 @@ public:
         return _qtyBeg;
     }
 
-    // ================== Accessing the raw data ==================
+    // ================== Interpolation helpers ==================
 
 private:
-    /** This template function returns a copy of the value at the specified N indices. There is no
-        range checking. Out-of-range index values cause unpredictable behavior. */
-    template<typename... Indices, typename = std::enable_if_t<CompileTimeUtils::isFloatArgList<N, Indices...>()>>
-    double valueAtIndices(Indices... indices) const
+    // the maximum number of terms in the interpolation over all but the first axis
+    static constexpr size_t numRows = static_cast<size_t>(1) << (N - 1);
+
+    /** This function locates the specified value in the grid for the axis with index \em k. It
+        stores the index of the upper border of the grid bin containing the value in \em right, and
+        the fraction of the value in that bin in \em f, using the interpolation type for the axis.
+        Values beyond the grid borders are clamped to the outer grid points. The function returns
+        false if the value is beyond the grid borders, and true otherwise. */
+    bool locate(size_t k, double x, size_t& right, double& f) const
+    {
+        const double* beg = _axBeg[k];
+        size_t len = _axLen[k];
+        right = std::lower_bound(beg, beg + len, x) - beg;
+        if (right == 0)
+        {
+            right = 1;
+            f = 0.;
+            return x == beg[0];
+        }
+        if (right == len)
+        {
+            right = len - 1;
+            f = 1.;
+            return false;
+        }
+
+        // use the precalculated logarithm of the grid points for logarithmic axes
+        const double* ip = _axIpBeg[k];
+        if (_axLog[k]) x = log(x);
+        f = (x - ip[right - 1]) / (ip[right] - ip[right - 1]);
+        return true;
+    }
+
+    /** This function determines the terms of the interpolation over all but the first axis for the
+        values of these axes in the specified array (the value for the first axis is ignored). For
+        each term with a nonzero front factor, it stores the offset of the corresponding first-axis
+        row in the flattened quantity data, and the front factor. The function returns the number
+        of terms. */
+    size_t prepareRows(const std::array<double, N>& value, std::array<size_t, numRows>& rowv,
+                       std::array<double, numRows>& ffv) const
+    {
+        // precompute grid index and fraction for all but the first axis
+        std::array<size_t, N> i2;  // upper grid bin boundary index
+        std::array<double, N> f;   // fraction of axis value in bin
+        for (size_t k = 1; k != N; ++k) locate(k, value[k], i2[k], f[k]);
+
+        // determine the row offset and front factor for each term of the interpolation
+        size_t numTerms = 0;
+        for (size_t t = 0; t != numRows; ++t)
+        {
+            // use the binary representation of the term index to determine left/right for each axis
+            size_t term = t;  // temporary version of term index that will be bit-shifted
+            double front = 1.;
+            size_t offset = 0;
+            size_t stride = _axLen[0];
+            for (size_t k = 1; k != N; ++k)
+            {
+                size_t left = term & 1;  // lowest significant digit = 1 means lower border
+                offset += (i2[k] - left) * stride;
+                stride *= _axLen[k];
+                front *= left ? (1 - f[k]) : f[k];
+                term >>= 1;
+            }
+            if (front)
+            {
+                rowv[numTerms] = offset;
+                ffv[numTerms] = front;
+                numTerms++;
+            }
+        }
+        return numTerms;
+    }
+
+    /** This function returns the quantity value interpolated along the first axis for the
+        specified first-axis value, blended over the specified first-axis rows with the specified
+        front factors, as prepared by the prepareRows() function. Out-of-range first-axis values
+        are handled according to the policy set by the \em clampFirstAxis flag in the open()
+        function. */
+    double interpolateRows(double x, const std::array<size_t, numRows>& rowv, const std::array<double, numRows>& ffv,
+                           size_t numTerms) const
     {
-        return _qtyBeg[flattenedIndex(std::array<size_t, N>({{static_cast<size_t>(indices)...}}))];
+        // get the index of the upper border of the first-axis bin and the fraction of the value in that bin
+        size_t right;
+        double f;
+        if (!locate(0, x, right, f) && !_clamp) return 0.;
+
+        // blend the values at both bin borders over all rows, omitting terms with a zero front factor
+        double y = 0.;
+        for (size_t t = 0; t != numTerms; ++t)
+        {
+            size_t index = rowv[t] + right;
+            double yr = 0.;
+            if (f != 1.) yr += (1. - f) * interpolationValue(index - 1);
+            if (f != 0.) yr += f * interpolationValue(index);
+            y += ffv[t] * yr;
+        }
+        return _qtyLog ? exp(y) : y;
     }
 
-    /** This function returns a copy of the value at the specified N indices. There is no range
-        checking. Out-of-range index values cause unpredictable behavior. */
-    double valueAtIndices(const std::array<size_t, N>& indices) const { return _qtyBeg[flattenedIndex(indices)]; }
+    /** This function stores in the \em yv output buffer the quantity values for the \em n
+        consecutive first-axis grid points starting at index \em first, blended over the specified
+        first-axis rows with the specified front factors, as prepared by the prepareRows()
+        function. If the quantity values have been repacked in memory, the blend consists of
+        weighted sums of contiguous rows, which the compiler can vectorize. */
+    void blendRows(double* yv, size_t first, size_t n, const std::array<size_t, numRows>& rowv,
+                   const std::array<double, numRows>& ffv, size_t numTerms) const
+    {
+        if (_rowBeg)
+        {
+            std::fill(yv, yv + n, 0.);
+            for (size_t t = 0; t != numTerms; ++t)
+            {
+                const double* row = _rowBeg + rowv[t] + first;
+                double front = ffv[t];
+                for (size_t i = 0; i != n; ++i) yv[i] += front * row[i];
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i != n; ++i)
+            {
+                double y = 0.;
+                for (size_t t = 0; t != numTerms; ++t) y += ffv[t] * interpolationValue(rowv[t] + first + i);
+                yv[i] = y;
+            }
+        }
+        if (_qtyLog)
+            for (size_t i = 0; i != n; ++i) yv[i] = exp(yv[i]);
+    }
 
-    /** This function returns the flattened index in the underlying data array for the specified N
-        indices. */
-    size_t flattenedIndex(const std::array<size_t, N>& indices) const
+    /** This function returns the quantity value at the specified index in the flattened quantity
+        data, or, for logarithmic quantity interpolation, the natural logarithm of that value. For
+        values that are not positive, the logarithm is replaced by negative infinity, so that the
+        interpolated value becomes zero as soon as one of the terms with a nonzero front factor
+        has a value that is not positive. There is no range checking. */
+    double interpolationValue(size_t index) const
     {
-        size_t result = indices[N - 1];
-        for (size_t k = N - 2; k < N; --k) result = result * _axLen[k] + indices[k];
-        return result * _qtyStep;
+        if (_rowBeg) return _rowBeg[index];
+        double y = _qtyBeg[index * _qtyStep];
+        if (_qtyLog) return y > 0. ? log(y) : -std::numeric_limits<double>::infinity();
+        return y;
     }
 
     // ================== Data members ==================
 
 private:
-    string _filePath;                     // the canonical path to the associated stored table file
-    std::array<const double*, N> _axBeg;  // pointer to first grid point for each axis
-    const double* _qtyBeg;                // pointer to first quantity value
-    std::array<size_t, N> _axLen;         // number of grid points for each axis
-    size_t _qtyStep;                      // step size from one quantity value to the next (1=adjacent)
-    std::array<bool, N> _axLog;           // interpolation type (true=log, false=linear) for each axis
-    bool _qtyLog;                         // interpolation type (true=log, false=linear) for quantity
-    bool _clamp;                          // value for out-of-range first-axis indices: true=clamped, false=zero
+    string _filePath;                       // the canonical path to the associated stored table file
+    std::array<const double*, N> _axBeg;    // pointer to first grid point for each axis
+    const double* _qtyBeg;                  // pointer to first quantity value
+    std::array<size_t, N> _axLen;           // number of grid points for each axis
+    size_t _qtyStep;                        // step size from one quantity value to the next (1=adjacent)
+    std::array<bool, N> _axLog;             // interpolation type (true=log, false=linear) for each axis
+    bool _qtyLog;                           // interpolation type (true=log, false=linear) for quantity
+    bool _clamp;                            // value for out-of-range first-axis indices: true=clamped, false=zero
+    std::array<const double*, N> _axIpBeg;  // pointer to first grid point in interpolation scale for each axis
+    const double* _rowBeg{nullptr};         // pointer to first contiguous value in interpolation scale, or null
+    std::shared_ptr<const vector<double>> _repacked;  // the repacked data, shared between instances
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -4,12 +4,16 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "StoredTableImpl.hpp"
+#include "Configuration.hpp"
 #include "FatalError.hpp"
 #include "FilePaths.hpp"
 #include "Log.hpp"
 #include "StringUtils.hpp"
 #include "System.hpp"
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -62,10 +66,26 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the buffers with precalculated logarithms and (optionally) repacked values, indexed on file path, quantity
+    // index and repacking flag; a buffer is released as soon as the last stored table instance using it is destroyed
+    std::mutex buffersMutex;
+    std::map<std::tuple<string, size_t, bool>, std::weak_ptr<const vector<double>>> buffers;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void StoredTable_Impl::open(size_t numAxes, const SimulationItem* item, string filename, bool resource, string axes,
                             string quantity, string& filePath, const double** axBeg, const double** qtyBeg,
-                            size_t* axLen, size_t* qtyStep, bool* axLog, bool* qtyLog)
+                            size_t* axLen, size_t* qtyStep, bool* axLog, bool* qtyLog, const double** axIpBeg,
+                            const double** rowBeg, std::shared_ptr<const vector<double>>& buffer)
 {
+    // remember the start of the output arrays so that they can be used after they have been filled
+    const double** axBegStart = axBeg;
+    size_t* axLenStart = axLen;
+    bool* axLogStart = axLog;
+
     // add the mandatory filename extension if needed
     if (!StringUtils::endsWith(filename, ".stab")) filename += ".stab";
 
@@ -164,6 +184,62 @@ void StoredTable_Impl::open(size_t numAxes, const SimulationItem* item, string f
     *qtyBeg = &currentItem->doubleType + qtyIndex;
     *qtyStep = numQties;
 
+    // the values of a single linear quantity are stored contiguously and in interpolation scale in the file, so that
+    // they can be used directly from the memory map; the values of other tables are repacked in memory unless the
+    // table holds more values than the limit configured for the simulation
+    size_t numValues = 1;
+    for (size_t i = 0; i < numAxes; ++i) numValues *= axLenStart[i];
+    auto config = item->find<Configuration>(false);
+    bool direct = numQties == 1 && !*qtyLog;
+    bool repack = !direct && config && numValues <= config->maxRepackedTableValues();
+
+    // get the buffer with precalculated logarithms and repacked values for this file and quantity,
+    // or construct it if it does not yet exist
+    {
+        std::unique_lock<std::mutex> lock(buffersMutex);
+        auto& cached = buffers[std::make_tuple(filePath, qtyIndex, repack)];
+        buffer = cached.lock();
+        if (!buffer)
+        {
+            auto data = std::make_shared<vector<double>>();
+
+            // precalculate the logarithm of the grid points for logarithmic axes
+            for (size_t i = 0; i < numAxes; ++i)
+                if (axLogStart[i])
+                    for (size_t j = 0; j < axLenStart[i]; ++j) data->push_back(log(axBegStart[i][j]));
+
+            // repack the values for the quantity in interpolation scale
+            if (repack)
+            {
+                const double* value = *qtyBeg;
+                data->reserve(data->size() + numValues);
+                for (size_t j = 0; j < numValues; ++j, value += numQties)
+                {
+                    if (*qtyLog)
+                        data->push_back(*value > 0. ? log(*value) : -std::numeric_limits<double>::infinity());
+                    else
+                        data->push_back(*value);
+                }
+            }
+            buffer = data;
+            cached = buffer;
+        }
+    }
+
+    // store the pointers into the buffer
+    const double* bufferItem = buffer->data();
+    for (size_t i = 0; i < numAxes; ++i)
+    {
+        if (axLogStart[i])
+        {
+            axIpBeg[i] = bufferItem;
+            bufferItem += axLenStart[i];
+        }
+        else
+            axIpBeg[i] = axBegStart[i];
+    }
+    *rowBeg = direct ? *qtyBeg : repack ? bufferItem : nullptr;
+
     // log success, unless the same thread already successfully opened the same file for the same item
     thread_local const SimulationItem* previousItem = nullptr;
     thread_local string previousFilePath;
@@ -21,14 +21,29 @@ namespace StoredTable_Impl
 
     /** This function performs the open() operation as described for the function with the same name in the
         StoredTable class template. It receives references or pointers to all data members of the
-        stored table instance, in addition to the input parameters of the open() function. */
-    void open(size_t numAxes, const SimulationItem* item,   // input parameters
-              string filename, bool resource,               //   "
-              string axes, string quantity,                 //   "
-              string& filePath,                             // output parameter by reference
-              const double** axBeg, const double** qtyBeg,  // output parameters via pointers
-              size_t* axLen, size_t* qtyStep,               //   "
-              bool* axLog, bool* qtyLog);                   //   "
+        stored table instance, in addition to the input parameters of the open() function.
+
+        In addition to the memory-mapped data, the function provides the grid points for each axis
+        in interpolation scale, i.e. the natural logarithm of the grid points for logarithmic axes
+        and the grid points themselves for linear axes. The function also provides a pointer to
+        the values for the requested quantity stored contiguously in the same order as in the file
+        and in interpolation scale, i.e. the natural logarithm of the values (or negative infinity
+        for values that are not positive) for logarithmic quantities and the values themselves for
+        linear quantities. If the table holds a single linear quantity, the pointer refers directly
+        into the memory map. Otherwise, the values are repacked in memory unless the number of
+        values in the table exceeds the limit returned by Configuration::maxRepackedTableValues(),
+        in which case the pointer is set to null. The precalculated logarithms and the repacked
+        values are held in a buffer that is shared by all stored table instances for the same file
+        and quantity. */
+    void open(size_t numAxes, const SimulationItem* item,      // input parameters
+              string filename, bool resource,                  //   "
+              string axes, string quantity,                    //   "
+              string& filePath,                                // output parameter by reference
+              const double** axBeg, const double** qtyBeg,     // output parameters via pointers
+              size_t* axLen, size_t* qtyStep,                  //   "
+              bool* axLog, bool* qtyLog,                       //   "
+              const double** axIpBeg, const double** rowBeg,   //   "
+              std::shared_ptr<const vector<double>>& buffer);  // output parameter by reference
 
     /** This function performs the close() operation as described for the destructor of the
         StoredTable class template. It receives the canonical path to the associated resource file,
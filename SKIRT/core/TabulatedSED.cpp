@@ -23,6 +23,9 @@ void TabulatedSED::setupSelfBefore()
     // construct the regular and cumulative distributions
     double norm = NR::cdf<NR::interpolateLogLog>(_lambdav, _pv, _Pv, _inlambdav, _inpv, normalizationWavelengthRange());
 
+    // prepare for sampling the distribution in constant time
+    _sampler.initLogLog(_lambdav, _pv, _Pv);
+
     // also normalize the intrinsic distribution
     _inpv /= norm;
 }
@@ -61,7 +64,7 @@ double TabulatedSED::integratedLuminosity(const Range& wavelengthRange) const
 
 double TabulatedSED::generateWavelength() const
 {
-    return random()->cdfLogLog(_lambdav, _pv, _Pv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define TABULATEDSED_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "SED.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -69,6 +70,8 @@ private:
     Array _lambdav;    // wavelengths within source range
     Array _pv;         // normalized specific luminosities within source range
     Array _Pv;         // normalized cumulative distribution within source range
+
+    CdfSampler _sampler;  // sampler for the cumulative distribution
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -26,6 +26,9 @@ void TabulatedWavelengthDistribution::setupSelfBefore()
 
     // construct the regular and cumulative distributions in the intersected range
     NR::cdf<NR::interpolateLogLog>(_lambdav, _pv, _Pv, inlambdav, inpv, range);
+
+    // prepare for sampling the distribution in constant time
+    _sampler.initLogLog(_lambdav, _pv, _Pv);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -39,7 +42,7 @@ double TabulatedWavelengthDistribution::probability(double wavelength) const
 
 double TabulatedWavelengthDistribution::generateWavelength() const
 {
-    return random()->cdfLogLog(_lambdav, _pv, _Pv);
+    return random()->cdf(_sampler);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define TABULATEDWAVELENGTHDISTRIBUTION_HPP
 
 #include "Array.hpp"
+#include "CdfSampler.hpp"
 #include "WavelengthDistribution.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -56,6 +57,8 @@ private:
     Array _lambdav;  // wavelengths
     Array _pv;       // probability distribution, normalized to unity
     Array _Pv;       // cumulative probability distribution
+
+    CdfSampler _sampler;  // sampler for the cumulative distribution
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -4,8 +4,13 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "TreeSpatialGrid.hpp"
+#include "BinTreeNode.hpp"
+#include "Configuration.hpp"
 #include "Log.hpp"
+#include "MemoryRegistry.hpp"
+#include "OctTreeNode.hpp"
 #include "PathSegmentGenerator.hpp"
+#include "PersistentCache.hpp"
 #include "Random.hpp"
 #include "SpatialGridPath.hpp"
 #include "SpatialGridPlotFile.hpp"
@@ -14,6 +19,41 @@
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // returns the topology of the tree with the specified nodes: the number of children of the root node, followed
+    // by the indices of the subdivided nodes in the order in which they were subdivided during tree construction
+    Array topology(const vector<TreeNode*>& nodev)
+    {
+        vector<double> topv{static_cast<double>(nodev[0]->children().size())};
+        for (auto node : nodev)
+        {
+            // a node's children are created together, so the first child indicates the order of subdivision
+            TreeNode* parent = node->parent();
+            if (parent && parent->children()[0] == node) topv.push_back(parent->id());
+        }
+        Array result(topv.size());
+        std::copy(topv.begin(), topv.end(), begin(result));
+        return result;
+    }
+
+    // returns the nodes of a new tree with the specified topology and spatial extent, reproducing the node order
+    // and thus the node identifiers of the original tree
+    vector<TreeNode*> rebuildTree(const Array& topv, const Box& extent)
+    {
+        vector<TreeNode*> nodev;
+        if (topv[0] == 2.)
+            nodev.push_back(new BinTreeNode(extent));
+        else
+            nodev.push_back(new OctTreeNode(extent));
+        for (size_t i = 1; i < topv.size(); ++i) nodev[static_cast<size_t>(topv[i])]->subdivide(nodev);
+        for (auto node : nodev) node->sortNeighbors();
+        return nodev;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 TreeSpatialGrid::~TreeSpatialGrid()
 {
     for (auto node : _nodev) delete node;
@@ -28,10 +68,28 @@ void TreeSpatialGrid::setupSelfAfter()
     // determine a small fraction relative to the spatial extent of the grid; used during path traversal
     _eps = 1e-12 * extent().widths().norm();
 
-    // make subclass construct the tree
+    // make subclass construct the tree, or rebuild the topology shared by a previous simulation, if possible;
+    // the topology is shared only if the simulation has been given a medium setup key, and it is kept in memory only
     Log* log = find<Log>();
-    log->info("Constructing the spatial tree grid...");
-    _nodev = constructTree();
+    string setupKey = find<Configuration>()->mediumSetupKey();
+    PersistentCache cache(this, "topology", true);
+    bool shared = !setupKey.empty() && cache.isEnabled();
+    if (shared) cache.addKey(setupKey);
+    if (shared && cache.load())
+    {
+        log->info("Rebuilding the spatial tree grid shared with a previous simulation...");
+        _nodev = rebuildTree(*cache.readShared(), extent());
+    }
+    else
+    {
+        log->info("Constructing the spatial tree grid...");
+        _nodev = constructTree();
+        if (shared)
+        {
+            cache.write(topology(_nodev));
+            cache.save();
+        }
+    }
 
     // construct the vectors to help translating between node indices (leaf and nonleaf) and cell indices (leaf only)
     //  _cellindexv : cell index m corresponding to each node in nodev; -1 for nonleaf nodes
@@ -49,6 +107,17 @@ void TreeSpatialGrid::setupSelfAfter()
         }
     }
 
+    // report the memory allocated for the tree, including the child and neighbor lists of the nodes
+    size_t numLinks = 0;
+    for (const TreeNode* node : _nodev)
+    {
+        numLinks += node->children().size();
+        for (int wall = 0; wall != 6; ++wall) numLinks += node->neighbors(static_cast<TreeNode::Wall>(wall)).size();
+    }
+    MemoryRegistry::add(this, MemoryRegistry::Category::Grid,
+                        numNodes * (sizeof(TreeNode) + sizeof(TreeNode*) + sizeof(int)) + _idv.size() * sizeof(int)
+                            + numLinks * sizeof(TreeNode*));
+
     // determine the number of cells at each level in the tree hierarchy
     vector<int> countv;
     int numCells = _idv.size();
@@ -47,7 +47,13 @@ protected:
         cells. Conversely, the function also creates a vector with the cell indices of all the
         nodes, i.e. the rank \f$m\f$ of the node in the ID vector if the node is a leaf, and the
         number -1 if the node is not a leaf (and hence not a spatial cell). Finally, the function
-        logs some details on the number of cells in the tree. */
+        logs some details on the number of cells in the tree.
+
+        When the simulation shares its medium setup with other simulations (see the
+        Configuration::mediumSetupKey() function), the tree topology constructed by the first of
+        these simulations is kept in memory. Subsequent simulations rebuild the tree from this
+        topology rather than invoking the constructTree() function, so that the tree construction
+        criteria (which may involve sampling the medium density) are not evaluated again. */
     void setupSelfAfter() override;
 
     /** This function must be implemented in a subclass. It constructs the hierarchical tree and
@@ -9,7 +9,7 @@
 
 ////////////////////////////////////////////////////////////////////
 
-double VoigtProfile::value(double a, double x)
+namespace
 {
     // coefficients for the approximation function (Table A1, Smith+15)
     constexpr double A0 = 15.75328153963877;
@@ -29,6 +29,64 @@ double VoigtProfile::value(double a, double x)
     constexpr double B7 = 23.7489999060;
     constexpr double B8 = 1.82106170570;
 
+    // the approximation can be written as H(a,x) = H0(z) + a * H1(z) with z = x^2, where the functions H0 and H1
+    // do not depend on a; these functions return H0 and H1 for z < 25, i.e. in the core and inner wings
+    double H0(double z) { return exp(-z); }
+    double H1(double z)
+    {
+        if (z <= 3.0) return -exp(-z) * (A0 + A1 / (z - A2 + A3 / (z - A4 + A5 / (z - A6))));
+        return B0 + B1 / (z - B2 + B3 / (z + B4 + B5 / (z - B6 + B7 / (z - B8))));
+    }
+
+    // this function returns H1 for z >= 25, i.e. in the outer wings (where H0 is zero)
+    double H1wings(double z) { return 0.5 * M_2_SQRTPI / (z - 1.5 - 1.5 / (z - 3.5 - 5.0 / (z - 5.5))); }
+
+    // the functions H0 and H1 are tabulated on a regular grid in |x| from zero to the transition to the outer wings
+    constexpr double xmax = 5.;
+    constexpr int numIntervals = 5000;
+
+    class VoigtTable
+    {
+    public:
+        VoigtTable() : _H0v(numIntervals + 1), _H1v(numIntervals + 1)
+        {
+            for (int i = 0; i <= numIntervals; ++i)
+            {
+                // make sure that the last grid point uses the inner-wing expression
+                double x = xmax * i / numIntervals;
+                double z = min(x * x, std::nextafter(xmax * xmax, 0.));
+                _H0v[i] = H0(z);
+                _H1v[i] = H1(z);
+            }
+        }
+
+        double value(double a, double x) const
+        {
+            double u = abs(x) * (numIntervals / xmax);
+            if (u >= numIntervals) return a * H1wings(x * x);
+            int i = static_cast<int>(u);
+            double f = u - i;
+            return _H0v[i] + f * (_H0v[i + 1] - _H0v[i]) + a * (_H1v[i] + f * (_H1v[i + 1] - _H1v[i]));
+        }
+
+    private:
+        vector<double> _H0v;
+        vector<double> _H1v;
+    };
+
+    // returns the table, which is constructed on first use; the initialization of a function-local static
+    // object is thread-safe, and binaries that do not use the table do not construct it
+    const VoigtTable& voigtTable()
+    {
+        static const VoigtTable table;
+        return table;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+double VoigtProfile::value(double a, double x)
+{
     // calculation of the approximation (Appendix A1, Smith+15)
     double z = x * x;
     if (z <= 3.0) return exp(-z) * (1.0 - a * (A0 + A1 / (z - A2 + A3 / (z - A4 + A5 / (z - A6)))));
@@ -38,6 +96,13 @@ double VoigtProfile::value(double a, double x)
 
 ////////////////////////////////////////////////////////////////////
 
+double VoigtProfile::tabulatedValue(double a, double x)
+{
+    return voigtTable().value(a, x);
+}
+
+////////////////////////////////////////////////////////////////////
+
 double VoigtProfile::sample(double a, double x, Random* random)
 {
     // make x positive and remember the orginal sign
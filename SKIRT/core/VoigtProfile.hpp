@@ -39,6 +39,20 @@ namespace VoigtProfile
         values of \f$a\f$, i.e. for higher gas temperatures. */
     double value(double a, double x);
 
+    /** This function returns the same approximation to the Voigt function \f$H(a,x)\f$ as the
+        value() function, but it uses precalculated tables to avoid evaluating the exponential and
+        the rational functions involved. Specifically, the approximation by Smith et al. 2015 can be
+        written as \f$H(a,x) = H_0(x^2) + a\,H_1(x^2)\f$, where the functions \f$H_0\f$ and
+        \f$H_1\f$ do not depend on \f$a\f$. For \f$|x|<5\f$, these two functions are tabulated on
+        a regular grid in \f$|x|\f$ with 5000 intervals and linearly interpolated. For
+        \f$|x|\geq5\f$, where \f$H_0=0\f$ and \f$H_1\f$ is an inexpensive rational function, the
+        value is calculated directly. As a result, the tabulated value differs from the value
+        returned by the value() function by less than \f$10^{-5}\f$ in relative terms, except in
+        the immediate vicinity of \f$|x|=\sqrt{3}\f$, where the approximation itself switches
+        between two expressions that differ by up to \f$2\times10^{-4}\f$. This is well below the
+        accuracy of the approximation. */
+    double tabulatedValue(double a, double x);
+
     /** This function samples a random value from the probability distribution \f$P(u)\f$ defined
         by \f[ P(u) \propto \frac{\mathrm{e}^{-u^2}}{(u-x)^2+a^2} \f] where \f$a\f$ and \f$x\f$ are
         parameters given as arguments and the proportionality factor is determined by
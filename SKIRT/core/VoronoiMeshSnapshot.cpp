@@ -6,6 +6,7 @@
 #include "VoronoiMeshSnapshot.hpp"
 #include "FatalError.hpp"
 #include "Log.hpp"
+#include "MemoryRegistry.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -20,6 +21,11 @@
 #include "TextInFile.hpp"
 #include "Units.hpp"
 #include "voro_compute.hh"
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -87,17 +93,12 @@ private:
     Vec _r;                  // site position
     Vec _c;                  // centroid position
     double _volume{0.};      // volume
-    vector<int> _neighbors;  // list of neighbor indices in _cells vector
-    Array _properties;       // user-defined properties, if any
+    vector<int> _neighbors;  // list of neighbor indices in cells vector
 
 public:
     // constructor stores the specified site position; the other data members are set to zero or empty
     Cell(Vec r) : _r(r) {}
 
-    // constructor derives the site position from the first three property values and stores the user properties;
-    // the other data members are set to zero or empty
-    Cell(const Array& prop) : _r(prop[0], prop[1], prop[2]), _properties{prop} {}
-
     // adjusts the site position with the specified offset
     void relax(double cx, double cy, double cz) { _r += Vec(cx, cy, cz); }
 
@@ -155,9 +156,6 @@ public:
     // returns a list of neighboring cell/site ids
     const vector<int>& neighbors() { return _neighbors; }
 
-    // returns the cell/site user properties, if any
-    const Array& properties() { return _properties; }
-
     // writes the Voronoi cell geometry to the serialized data buffer, preceded by the specified cell index,
     // if the cell geometry has been calculated for this cell; otherwise does nothing
     void writeGeometryIfPresent(SerializedWrite& wdata, int m)
@@ -224,7 +222,7 @@ namespace
 class VoronoiMeshSnapshot::Node
 {
 private:
-    int _m;        // index in _cells to the site defining the split at this node
+    int _m;        // index in cells to the site defining the split at this node
     int _axis;     // split axis for this node (0,1,2)
     Node* _up;     // ptr to the parent node
     Node* _left;   // ptr to the left child node
@@ -336,35 +334,177 @@ public:
 
 ////////////////////////////////////////////////////////////////////
 
-VoronoiMeshSnapshot::VoronoiMeshSnapshot() {}
+// class to hold the decomposition of a Voronoi cell into tetrahedra that share the cell's site as a vertex
+class VoronoiMeshSnapshot::Decomposition
+{
+public:
+    // a tetrahedron, represented by the indices of the vertices of the face triangle completing the tetrahedron
+    // with the site, and the corresponding entry in the alias table (Vose 1991, IEEE Trans. Softw. Eng. 17.9)
+    // used for selecting a tetrahedron according to its volume; the record fits in 16 bytes
+    struct Tetrahedron
+    {
+        double threshold;  // probability of selecting this tetrahedron rather than its alias
+        uint16_t alias;    // index in tetrahedra of the alias
+        uint16_t v[3];     // indices in vertices of the triangle
+    };
+
+    Vec r;                           // site position
+    vector<Vec> vertices;            // vertices of the cell polyhedron, relative to the site position
+    vector<Tetrahedron> tetrahedra;  // tetrahedra in the decomposition
+
+    // returns the number of bytes allocated by the decomposition
+    size_t bytes() const
+    {
+        return sizeof(Decomposition) + vertices.size() * sizeof(Vec) + tetrahedra.size() * sizeof(Tetrahedron);
+    }
+};
+
+////////////////////////////////////////////////////////////////////
+
+// class to hold the Voronoi cells and the search data structures for a given list of sites
+class VoronoiMeshSnapshot::Tessellation
+{
+public:
+    // data members initialized by BuildMesh()
+    vector<Cell*> cells;  // cell objects, indexed on m
+    int nb{0};            // number of blocks in each dimension (limit for indices i,j,k)
+    int nb2{0};           // nb*nb
+    int nb3{0};           // nb*nb*nb
+
+    // data members initialized by BuildSearch()
+    std::once_flag searchFlag;       // guards the construction of the search data structures
+    vector<vector<int>> blocklists;  // list of cell indices per block, indexed on i*nb2+j*nb+k
+    vector<Node*> blocktrees;        // root node of search tree or null for each block, indexed on i*nb2+j*nb+k
+
+    // data members initialized by BuildMesh() and updated on demand by generatePosition() and decomposition()
+    std::unique_ptr<std::atomic<int>[]> numAttempts;  // number of rejection sampling attempts, indexed on m
+    std::unique_ptr<std::atomic<const Decomposition*>[]> decompositions;  // indexed on m, null if not yet built
+
+    // destructor destroys the cell objects, the search trees and the cell decompositions
+    ~Tessellation()
+    {
+        for (auto tree : blocktrees) delete tree;
+        if (decompositions)
+            for (size_t m = 0; m != cells.size(); ++m) delete decompositions[m].load();
+        for (auto cell : cells) delete cell;
+    }
+};
 
 ////////////////////////////////////////////////////////////////////
 
-VoronoiMeshSnapshot::~VoronoiMeshSnapshot()
+namespace
 {
-    for (auto cell : _cells) delete cell;
-    for (auto tree : _blocktrees) delete tree;
+    // the number of rejection sampling attempts in a cell after which generatePosition() builds the cell's
+    // decomposition into tetrahedra; building the decomposition takes about as long as this number of attempts
+    const int maxRejectionAttempts = 64;
+
+    // an entry in the registry of Voronoi tessellations: the retained sites in canonical order, which are compared
+    // before sharing because the registry key includes only a hash of the site coordinates, and a future holding a
+    // weak pointer to the tessellation, which becomes ready when the snapshot that registered the entry has
+    // finished building the tessellation (or has failed to do so, in which case the future holds an exception)
+    struct RegistryEntry
+    {
+        vector<Vec> sites;
+        std::shared_future<std::weak_ptr<void>> tessellation;
+    };
+
+    // the process-wide registry of the Voronoi tessellations in use or being built, keyed on the retained sites,
+    // the domain extent and the relaxation flag, and the mutex guarding it; the registry holds weak pointers so
+    // that each tessellation is destroyed as soon as the last snapshot using it is destroyed
+    std::mutex _registryMutex;
+    std::unordered_map<string, std::shared_ptr<RegistryEntry>> _registry;
+
+    // returns the tessellation published by the specified registry entry, waiting for it if it is still being
+    // built, or a null pointer if building the tessellation failed or the tessellation has been destroyed
+    std::shared_ptr<void> publishedTessellation(const RegistryEntry& entry)
+    {
+        try
+        {
+            return entry.tessellation.get().lock();
+        }
+        catch (const std::future_error&)
+        {
+            return nullptr;
+        }
+    }
+
+    // returns true if the specified registry entry is no longer useful, i.e. if its tessellation has been built
+    // and has since been destroyed, or if building it failed
+    bool isExpired(const RegistryEntry& entry)
+    {
+        return entry.tessellation.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+               && !publishedTessellation(entry);
+    }
+
+    // returns the registry key for the specified sites, domain extent and relaxation flag; the site positions
+    // are represented by the number of sites and a 64-bit FNV-1a hash of their coordinates
+    string registryKey(const vector<Vec>& sites, const vector<int>& indices, const Box& extent, bool relax)
+    {
+        size_t hash = 0xcbf29ce484222325;
+        for (int index : indices)
+        {
+            const Vec& r = sites[index];
+            for (double coord : {r.x(), r.y(), r.z()})
+            {
+                auto bytes = reinterpret_cast<const unsigned char*>(&coord);
+                for (size_t i = 0; i != sizeof(double); ++i)
+                {
+                    hash ^= bytes[i];
+                    hash *= 0x100000001b3;
+                }
+            }
+        }
+
+        string key;
+        for (double value : {extent.xmin(), extent.ymin(), extent.zmin(), extent.xmax(), extent.ymax(), extent.zmax()})
+            key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        key += relax ? 'R' : 'N';
+        key += std::to_string(indices.size()) + '_' + std::to_string(hash);
+        return key;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+VoronoiMeshSnapshot::VoronoiMeshSnapshot() {}
+
+////////////////////////////////////////////////////////////////////
+
+VoronoiMeshSnapshot::~VoronoiMeshSnapshot() {}
+
+////////////////////////////////////////////////////////////////////
+
 void VoronoiMeshSnapshot::readAndClose()
 {
     // read the site info into memory
+    vector<Array> rows;
+    vector<Vec> sites;
     Array prop;
-    while (infile()->readRow(prop)) _cells.push_back(new Cell(prop));
+    while (infile()->readRow(prop))
+    {
+        sites.emplace_back(prop[0], prop[1], prop[2]);
+        rows.push_back(prop);
+    }
 
     // close the file
     Snapshot::readAndClose();
 
-    // calculate the Voronoi cells
-    buildMesh(false);
+    // calculate the Voronoi cells and store the user-defined properties in the order of the cells
+    vector<int> indices = buildMesh(sites, false);
+    _propv.reserve(indices.size());
+    for (int index : indices) _propv.push_back(std::move(rows[index]));
+    rows.clear();
+
+    // report the memory allocated for the imported properties
+    if (!_propv.empty())
+        MemoryRegistry::add(log(), MemoryRegistry::Category::Snapshots,
+                            _propv.size() * (sizeof(Array) + _propv[0].size() * sizeof(double)));
 
     // if a mass density policy has been set, calculate masses and densities for all cells
     if (hasMassDensityPolicy())
     {
         // allocate vectors for mass and density
-        size_t n = _cells.size();
+        size_t n = _propv.size();
         Array Mv(n);
         _rhov.resize(n);
 
@@ -380,7 +520,7 @@ void VoronoiMeshSnapshot::readAndClose()
         int numIgnored = 0;
         for (size_t m = 0; m != n; ++m)
         {
-            const Array& prop = _cells[m]->properties();
+            const Array& prop = _propv[m];
 
             // original mass is zero if temperature is above cutoff or if imported mass/density is not positive
             double originalMass = 0.;
@@ -388,13 +528,13 @@ void VoronoiMeshSnapshot::readAndClose()
                 numIgnored++;
             else
                 originalMass =
-                    max(0., massIndex() >= 0 ? prop[massIndex()] : prop[densityIndex()] * _cells[m]->volume());
+                    max(0., massIndex() >= 0 ? prop[massIndex()] : prop[densityIndex()] * volume(m));
 
             double metallicMass = originalMass * (useMetallicity() ? prop[metallicityIndex()] : 1.);
             double effectiveMass = metallicMass * multiplier();
 
             Mv[m] = effectiveMass;
-            _rhov[m] = effectiveMass / _cells[m]->volume();
+            _rhov[m] = effectiveMass / volume(m);
 
             totalOriginalMass += originalMass;
             totalMetallicMass += metallicMass;
@@ -439,14 +579,15 @@ VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box&
     in.addColumn("position x", "length", "pc");
     in.addColumn("position y", "length", "pc");
     in.addColumn("position z", "length", "pc");
+    vector<Vec> sites;
     Array coords;
-    while (in.readRow(coords)) _cells.push_back(new Cell(Vec(coords[0], coords[1], coords[2])));
+    while (in.readRow(coords)) sites.emplace_back(coords[0], coords[1], coords[2]);
     in.close();
 
     // calculate the Voronoi cells
     setContext(item);
     setExtent(extent);
-    buildMesh(relax);
+    buildMesh(sites, relax);
     buildSearch();
 }
 
@@ -457,13 +598,13 @@ VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box&
 {
     // prepare the data
     int n = sli->numSites();
-    _cells.resize(n);
-    for (int m = 0; m != n; ++m) _cells[m] = new Cell(sli->sitePosition(m));
+    vector<Vec> sites(n);
+    for (int m = 0; m != n; ++m) sites[m] = sli->sitePosition(m);
 
     // calculate the Voronoi cells
     setContext(item);
     setExtent(extent);
-    buildMesh(relax);
+    buildMesh(sites, relax);
     buildSearch();
 }
 
@@ -472,15 +613,10 @@ VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box&
 VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box& extent, const vector<Vec>& sites,
                                          bool relax)
 {
-    // prepare the data
-    int n = sites.size();
-    _cells.resize(n);
-    for (int m = 0; m != n; ++m) _cells[m] = new Cell(sites[m]);
-
     // calculate the Voronoi cells
     setContext(item);
     setExtent(extent);
-    buildMesh(relax);
+    buildMesh(sites, relax);
     buildSearch();
 }
 
@@ -494,33 +630,29 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
-void VoronoiMeshSnapshot::buildMesh(bool relax)
+vector<int> VoronoiMeshSnapshot::buildMesh(const vector<Vec>& sites, bool relax)
 {
-    // remove sites that lie outside of the domain
-    int numOutside = 0;
-    for (int m = _cells.size() - 1; m >= 0; --m)
-    {
-        if (!_extent.contains(_cells[m]->position()))
-        {
-            delete _cells[m];
-            _cells.erase(_cells.cbegin() + m);
-            numOutside++;
-        }
-    }
-
-    // sort sites in order of increasing x coordinate to accelerate search for nearby sites
-    std::sort(_cells.begin(), _cells.end(), [](Cell* c1, Cell* c2) { return c1->x() < c2->x(); });
+    // remove sites that lie outside of the domain, keeping track of the indices of the remaining sites
+    vector<int> indices;
+    indices.reserve(sites.size());
+    for (size_t index = 0; index != sites.size(); ++index)
+        if (_extent.contains(sites[index])) indices.push_back(index);
+    int numOutside = sites.size() - indices.size();
+
+    // sort sites in order of increasing x coordinate to accelerate search for nearby sites;
+    // the other coordinates break ties so that the order does not depend on the order of the input sites
+    std::sort(indices.begin(), indices.end(),
+              [&sites](int i1, int i2) { return lessthan(sites[i1], sites[i2], 0); });
 
     // remove sites that lie too nearby another site
     int numNearby = 0;
-    for (int m = _cells.size() - 1; m >= 0; --m)
+    for (int m = indices.size() - 1; m >= 0; --m)
     {
-        for (int j = m - 1; j >= 0 && _cells[m]->x() - _cells[j]->x() < _eps; --j)
+        for (int j = m - 1; j >= 0 && sites[indices[m]].x() - sites[indices[j]].x() < _eps; --j)
         {
-            if ((_cells[m]->position() - _cells[j]->position()).norm2() < _eps * _eps)
+            if ((sites[indices[m]] - sites[indices[j]]).norm2() < _eps * _eps)
             {
-                delete _cells[m];
-                _cells.erase(_cells.cbegin() + m);
+                indices.erase(indices.cbegin() + m);
                 numNearby++;
                 break;
             }
@@ -528,7 +660,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     }
 
     // log the number of sites
-    int numCells = _cells.size();
+    int numCells = indices.size();
     if (!numOutside && !numNearby)
     {
         log()->info("  Number of sites: " + std::to_string(numCells));
@@ -541,12 +673,65 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     }
 
     // abort if there are no cells to calculate
-    if (numCells <= 0) return;
+    if (numCells <= 0)
+    {
+        _tess = std::make_shared<Tessellation>();
+        return indices;
+    }
+
+    // look for a registry entry for the same sites, removing any expired entries; if there is none,
+    // register a pending entry so that other snapshots requesting the same tessellation wait for this one
+    string key = registryKey(sites, indices, _extent, relax);
+    vector<Vec> retained;
+    retained.reserve(numCells);
+    for (int index : indices) retained.push_back(sites[index]);
+    std::promise<std::weak_ptr<void>> promise;  // fulfilled when this snapshot has built a registered tessellation
+    std::shared_ptr<RegistryEntry> entry;
+    bool registered = false;
+    {
+        std::unique_lock<std::mutex> lock(_registryMutex);
+        for (auto it = _registry.begin(); it != _registry.end();)
+            it = isExpired(*it->second) ? _registry.erase(it) : std::next(it);
+        auto it = _registry.find(key);
+        if (it != _registry.end())
+        {
+            entry = it->second;
+        }
+        else
+        {
+            entry = std::make_shared<RegistryEntry>(RegistryEntry{std::move(retained), promise.get_future().share()});
+            _registry[key] = entry;
+            registered = true;
+        }
+    }
+
+    // if another snapshot has built or is building a tessellation for the same sites, wait for it and use it;
+    // if the site coordinates differ despite the hash collision, or if the other build failed, build our own
+    // tessellation without registering it
+    auto same = [](const Vec& a, const Vec& b) { return a.x() == b.x() && a.y() == b.y() && a.z() == b.z(); };
+    if (!registered && std::equal(entry->sites.begin(), entry->sites.end(), retained.begin(), retained.end(), same))
+    {
+        _tess = std::static_pointer_cast<Tessellation>(publishedTessellation(*entry));
+        if (_tess)
+        {
+            log()->info("Using shared Voronoi tessellation with " + std::to_string(numCells) + " cells");
+            return indices;
+        }
+    }
+
+    // otherwise, construct a new tessellation with the retained sites
+    _tess = std::make_shared<Tessellation>();
+    auto& cells = _tess->cells;
+    cells.reserve(numCells);
+    for (int index : indices) cells.push_back(new Cell(sites[index]));
+    _tess->numAttempts.reset(new std::atomic<int>[numCells]());
+    _tess->decompositions.reset(new std::atomic<const Decomposition*>[numCells]());
 
     // calculate number of blocks in each direction based on number of cells
-    _nb = max(3, min(250, static_cast<int>(cbrt(numCells))));
-    _nb2 = _nb * _nb;
-    _nb3 = _nb * _nb * _nb;
+    _tess->nb = max(3, min(250, static_cast<int>(cbrt(numCells))));
+    _tess->nb2 = _tess->nb * _tess->nb;
+    _tess->nb3 = _tess->nb * _tess->nb * _tess->nb;
+    int nb = _tess->nb;
 
     // if requested, perform a single relaxation step
     if (relax)
@@ -557,10 +742,10 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
 
         // add the retained original sites to a temporary Voronoi container, using the cell index m as ID
         voro::container vcon(_extent.xmin(), _extent.xmax(), _extent.ymin(), _extent.ymax(), _extent.zmin(),
-                             _extent.zmax(), _nb, _nb, _nb);
+                             _extent.zmax(), nb, nb, nb);
         for (int m = 0; m != numCells; ++m)
         {
-            Vec r = _cells[m]->position();
+            Vec r = cells[m]->position();
             vcon.put(m, r.x(), r.y(), r.z());
         }
 
@@ -600,15 +785,15 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
 
         // communicate the calculated offsets between parallel processes, if needed, and apply them to the cells
         ProcessManager::sumToAll(offsets.data());
-        for (int m = 0; m != numCells; ++m) _cells[m]->relax(offsets(m, 0), offsets(m, 1), offsets(m, 2));
+        for (int m = 0; m != numCells; ++m) cells[m]->relax(offsets(m, 0), offsets(m, 1), offsets(m, 2));
     }
 
     // add the final sites to a temporary Voronoi container, using the cell index m as ID
     voro::container vcon(_extent.xmin(), _extent.xmax(), _extent.ymin(), _extent.ymax(), _extent.zmin(), _extent.zmax(),
-                         _nb, _nb, _nb);
+                         nb, nb, nb);
     for (int m = 0; m != numCells; ++m)
     {
-        Vec r = _cells[m]->position();
+        Vec r = cells[m]->position();
         vcon.put(m, r.x(), r.y(), r.z());
     }
 
@@ -618,7 +803,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     log()->info("Constructing Voronoi tessellation with " + std::to_string(numCells) + " cells");
     log()->infoSetElapsed(numCells);
     auto parallel = log()->find<ParallelFactory>()->parallelDistributed();
-    parallel->call(numCells, [this, &vcon](size_t firstIndex, size_t numIndices) {
+    parallel->call(numCells, [this, &vcon, &cells](size_t firstIndex, size_t numIndices) {
         // allocate space for the cell calculator object and for the resulting cell info
         voro::compute vcompute(vcon);
         voro::cell vcell;
@@ -637,7 +822,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
                     if (!ok) throw FATALERROR("Can't compute Voronoi cell");
 
                     // copy all relevant information to the cell object that will stay around
-                    _cells[m]->init(vcell);
+                    cells[m]->init(vcell);
 
                     // log message if the minimum time has elapsed
                     numDone = (numDone + 1) % logProgressChunkSize;
@@ -650,14 +835,14 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     // communicate the calculated cell information between parallel processes, if needed
     if (ProcessManager::isMultiProc())
     {
-        auto producer = [this](vector<double>& data) {
+        auto producer = [&cells](vector<double>& data) {
             SerializedWrite wdata(data);
-            int numCells = _cells.size();
-            for (int m = 0; m != numCells; ++m) _cells[m]->writeGeometryIfPresent(wdata, m);
+            int numCells = cells.size();
+            for (int m = 0; m != numCells; ++m) cells[m]->writeGeometryIfPresent(wdata, m);
         };
-        auto consumer = [this](const vector<double>& data) {
+        auto consumer = [&cells](const vector<double>& data) {
             SerializedRead rdata(data);
-            while (!rdata.empty()) _cells[rdata.readInt()]->readGeometry(rdata);
+            while (!rdata.empty()) cells[rdata.readInt()]->readGeometry(rdata);
         };
         ProcessManager::broadcastAllToAll(producer, consumer);
     }
@@ -668,13 +853,19 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     int64_t totNeighbors = 0;
     for (int m = 0; m < numCells; m++)
     {
-        int ns = _cells[m]->neighbors().size();
+        int ns = cells[m]->neighbors().size();
         totNeighbors += ns;
         minNeighbors = min(minNeighbors, ns);
         maxNeighbors = max(maxNeighbors, ns);
     }
     double avgNeighbors = double(totNeighbors) / numCells;
 
+    // report the memory allocated for the cell objects, including their neighbor lists
+    MemoryRegistry::add(log(), MemoryRegistry::Category::Grid,
+                        numCells * (sizeof(Cell) + sizeof(Cell*) + sizeof(std::atomic<int>)
+                                    + sizeof(std::atomic<const Decomposition*>))
+                            + totNeighbors * sizeof(int));
+
     // log neighbor statistics
     log()->info("Done computing Voronoi tessellation with " + std::to_string(numCells) + " cells");
     log()->info("  Average number of neighbors per cell: " + StringUtils::toString(avgNeighbors, 'f', 1));
@@ -684,17 +875,22 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     // verify that neighbors are mutual as they should be
     for (int m = 0; m < numCells; m++)
     {
-        for (int m1 : _cells[m]->neighbors())
+        for (int m1 : cells[m]->neighbors())
         {
             if (m1 >= 0)
             {
-                const vector<int>& neighbors1 = _cells[m1]->neighbors();
+                const vector<int>& neighbors1 = cells[m1]->neighbors();
                 if (std::find(neighbors1.begin(), neighbors1.end(), m) == neighbors1.end())
                     log()->warning("Neighbors are not mutual for cells " + std::to_string(m) + " and "
                                    + std::to_string(m1));
             }
         }
     }
+
+    // publish the new tessellation to the snapshots waiting for it, if it has been registered;
+    // if this function exits with an exception, the promise is broken and the waiting snapshots build their own
+    if (registered) promise.set_value(_tess);
+    return indices;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -707,7 +903,7 @@ VoronoiMeshSnapshot::Node* VoronoiMeshSnapshot::buildTree(vector<int>::iterator
     {
         auto median = length >> 1;
         std::nth_element(first, first + median, last, [this, depth](int m1, int m2) {
-            return m1 != m2 && lessthan(_cells[m1]->position(), _cells[m2]->position(), depth % 3);
+            return m1 != m2 && lessthan(_tess->cells[m1]->position(), _tess->cells[m2]->position(), depth % 3);
         });
         return new VoronoiMeshSnapshot::Node(*(first + median), depth, buildTree(first, first + median, depth + 1),
                                              buildTree(first + median + 1, last, depth + 1));
@@ -720,73 +916,84 @@ VoronoiMeshSnapshot::Node* VoronoiMeshSnapshot::buildTree(vector<int>::iterator
 void VoronoiMeshSnapshot::buildSearch()
 {
     // abort if there are no cells
-    int numCells = _cells.size();
+    int numCells = _tess->cells.size();
     if (!numCells) return;
 
-    log()->info("Building data structures to accelerate searching the Voronoi tesselation");
+    // build the search data structures only once for a shared tessellation
+    std::call_once(_tess->searchFlag, [this, numCells]() {
+        const auto& cells = _tess->cells;
+        auto& blocklists = _tess->blocklists;
+        auto& blocktrees = _tess->blocktrees;
+        int nb = _tess->nb;
+        int nb2 = _tess->nb2;
+        int nb3 = _tess->nb3;
 
-    // -------------  block lists  -------------
+        log()->info("Building data structures to accelerate searching the Voronoi tesselation");
 
-    // initialize a vector of nb x nb x nb lists, each containing the cells overlapping a certain block in the domain
-    _blocklists.resize(_nb3);
+        // -------------  block lists  -------------
 
-    // add the cell object to the lists for all blocks it may overlap
-    int i1, j1, k1, i2, j2, k2;
-    for (int m = 0; m != numCells; ++m)
-    {
-        _extent.cellIndices(i1, j1, k1, _cells[m]->rmin() - Vec(_eps, _eps, _eps), _nb, _nb, _nb);
-        _extent.cellIndices(i2, j2, k2, _cells[m]->rmax() + Vec(_eps, _eps, _eps), _nb, _nb, _nb);
-        for (int i = i1; i <= i2; i++)
-            for (int j = j1; j <= j2; j++)
-                for (int k = k1; k <= k2; k++) _blocklists[i * _nb2 + j * _nb + k].push_back(m);
-    }
+        // initialize a vector of nb x nb x nb lists, each containing the cells overlapping a certain block
+        // in the domain
+        blocklists.resize(nb3);
 
-    // compile block list statistics
-    int minRefsPerBlock = INT_MAX;
-    int maxRefsPerBlock = 0;
-    int64_t totalBlockRefs = 0;
-    for (int b = 0; b < _nb3; b++)
-    {
-        int refs = _blocklists[b].size();
-        totalBlockRefs += refs;
-        minRefsPerBlock = min(minRefsPerBlock, refs);
-        maxRefsPerBlock = max(maxRefsPerBlock, refs);
-    }
-    double avgRefsPerBlock = double(totalBlockRefs) / _nb3;
+        // add the cell object to the lists for all blocks it may overlap
+        int i1, j1, k1, i2, j2, k2;
+        for (int m = 0; m != numCells; ++m)
+        {
+            _extent.cellIndices(i1, j1, k1, cells[m]->rmin() - Vec(_eps, _eps, _eps), nb, nb, nb);
+            _extent.cellIndices(i2, j2, k2, cells[m]->rmax() + Vec(_eps, _eps, _eps), nb, nb, nb);
+            for (int i = i1; i <= i2; i++)
+                for (int j = j1; j <= j2; j++)
+                    for (int k = k1; k <= k2; k++) blocklists[i * nb2 + j * nb + k].push_back(m);
+        }
 
-    // log block list statistics
-    log()->info("  Number of blocks in search grid: " + std::to_string(_nb3) + " (" + std::to_string(_nb) + "^3)");
-    log()->info("  Average number of cells per block: " + StringUtils::toString(avgRefsPerBlock, 'f', 1));
-    log()->info("  Minimum number of cells per block: " + std::to_string(minRefsPerBlock));
-    log()->info("  Maximum number of cells per block: " + std::to_string(maxRefsPerBlock));
+        // compile block list statistics
+        int minRefsPerBlock = INT_MAX;
+        int maxRefsPerBlock = 0;
+        int64_t totalBlockRefs = 0;
+        for (int b = 0; b < nb3; b++)
+        {
+            int refs = blocklists[b].size();
+            totalBlockRefs += refs;
+            minRefsPerBlock = min(minRefsPerBlock, refs);
+            maxRefsPerBlock = max(maxRefsPerBlock, refs);
+        }
+        double avgRefsPerBlock = double(totalBlockRefs) / nb3;
 
-    // -------------  search trees  -------------
+        // log block list statistics
+        log()->info("  Number of blocks in search grid: " + std::to_string(nb3) + " (" + std::to_string(nb) + "^3)");
+        log()->info("  Average number of cells per block: " + StringUtils::toString(avgRefsPerBlock, 'f', 1));
+        log()->info("  Minimum number of cells per block: " + std::to_string(minRefsPerBlock));
+        log()->info("  Maximum number of cells per block: " + std::to_string(maxRefsPerBlock));
 
-    // for each block that contains more than a predefined number of cells,
-    // construct a search tree on the site locations of the cells
-    _blocktrees.resize(_nb3);
-    for (int b = 0; b < _nb3; b++)
-    {
-        vector<int>& ids = _blocklists[b];
-        if (ids.size() > 9) _blocktrees[b] = buildTree(ids.begin(), ids.end(), 0);
-    }
+        // -------------  search trees  -------------
+
+        // for each block that contains more than a predefined number of cells,
+        // construct a search tree on the site locations of the cells
+        blocktrees.resize(nb3);
+        for (int b = 0; b < nb3; b++)
+        {
+            vector<int>& ids = blocklists[b];
+            if (ids.size() > 9) blocktrees[b] = buildTree(ids.begin(), ids.end(), 0);
+        }
 
-    // compile and log search tree statistics
-    int numTrees = 0;
-    for (int b = 0; b < _nb3; b++)
-        if (_blocktrees[b]) numTrees++;
-    log()->info("  Number of search trees: " + std::to_string(numTrees) + " ("
-                + StringUtils::toString(100. * numTrees / _nb3, 'f', 1) + "% of blocks)");
+        // compile and log search tree statistics
+        int numTrees = 0;
+        for (int b = 0; b < nb3; b++)
+            if (blocktrees[b]) numTrees++;
+        log()->info("  Number of search trees: " + std::to_string(numTrees) + " ("
+                    + StringUtils::toString(100. * numTrees / nb3, 'f', 1) + "% of blocks)");
+    });
 }
 
 ////////////////////////////////////////////////////////////////////
 
 bool VoronoiMeshSnapshot::isPointClosestTo(Vec r, int m, const vector<int>& ids) const
 {
-    double target = _cells[m]->squaredDistanceTo(r);
+    double target = _tess->cells[m]->squaredDistanceTo(r);
     for (int id : ids)
     {
-        if (id >= 0 && _cells[id]->squaredDistanceTo(r) < target) return false;
+        if (id >= 0 && _tess->cells[id]->squaredDistanceTo(r) < target) return false;
     }
     return true;
 }
@@ -802,12 +1009,12 @@ void VoronoiMeshSnapshot::writeGridPlotFiles(const SimulationItem* probe) const
     SpatialGridPlotFile plotxyz(probe, probe->itemName() + "_grid_xyz");
 
     // load all sites in a Voro container
-    int numCells = _cells.size();
+    int numCells = _tess->cells.size();
     voro::container vcon(_extent.xmin(), _extent.xmax(), _extent.ymin(), _extent.ymax(), _extent.zmin(), _extent.zmax(),
-                         _nb, _nb, _nb);
+                         _tess->nb, _tess->nb, _tess->nb);
     for (int m = 0; m != numCells; ++m)
     {
-        Vec r = _cells[m]->position();
+        Vec r = _tess->cells[m]->position();
         vcon.put(m, r.x(), r.y(), r.z());
     }
 
@@ -832,7 +1039,7 @@ void VoronoiMeshSnapshot::writeGridPlotFiles(const SimulationItem* probe) const
             vcell.face_vertices(indices);
 
             // write the edges of the cell to the plot files
-            Box bounds = _cells[vloop.pid()]->extent();
+            Box bounds = _tess->cells[vloop.pid()]->extent();
             if (bounds.zmin() <= 0 && bounds.zmax() >= 0) plotxy.writePolyhedron(coords, indices);
             if (bounds.ymin() <= 0 && bounds.ymax() >= 0) plotxz.writePolyhedron(coords, indices);
             if (bounds.xmin() <= 0 && bounds.xmax() >= 0) plotyz.writePolyhedron(coords, indices);
@@ -855,42 +1062,42 @@ Box VoronoiMeshSnapshot::extent() const
 
 int VoronoiMeshSnapshot::numEntities() const
 {
-    return _cells.size();
+    return _tess->cells.size();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position VoronoiMeshSnapshot::position(int m) const
 {
-    return Position(_cells[m]->position());
+    return Position(_tess->cells[m]->position());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position VoronoiMeshSnapshot::centroidPosition(int m) const
 {
-    return Position(_cells[m]->centroid());
+    return Position(_tess->cells[m]->centroid());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double VoronoiMeshSnapshot::volume(int m) const
 {
-    return _cells[m]->volume();
+    return _tess->cells[m]->volume();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Box VoronoiMeshSnapshot::extent(int m) const
 {
-    return _cells[m]->extent();
+    return _tess->cells[m]->extent();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double VoronoiMeshSnapshot::temperature(int m) const
 {
-    const Array& prop = _cells[m]->properties();
+    const Array& prop = _propv[m];
     return prop[temperatureIndex()];
 }
 
@@ -906,7 +1113,7 @@ double VoronoiMeshSnapshot::temperature(Position bfr) const
 
 Vec VoronoiMeshSnapshot::velocity(int m) const
 {
-    const Array& prop = _cells[m]->properties();
+    const Array& prop = _propv[m];
     return Vec(prop[velocityIndex() + 0], prop[velocityIndex() + 1], prop[velocityIndex() + 2]);
 }
 
@@ -922,7 +1129,7 @@ Vec VoronoiMeshSnapshot::velocity(Position bfr) const
 
 double VoronoiMeshSnapshot::velocityDispersion(int m) const
 {
-    const Array& prop = _cells[m]->properties();
+    const Array& prop = _propv[m];
     return prop[velocityDispersionIndex()];
 }
 
@@ -938,7 +1145,7 @@ double VoronoiMeshSnapshot::velocityDispersion(Position bfr) const
 
 Vec VoronoiMeshSnapshot::magneticField(int m) const
 {
-    const Array& prop = _cells[m]->properties();
+    const Array& prop = _propv[m];
     return Vec(prop[magneticFieldIndex() + 0], prop[magneticFieldIndex() + 1], prop[magneticFieldIndex() + 2]);
 }
 
@@ -956,7 +1163,7 @@ void VoronoiMeshSnapshot::parameters(int m, Array& params) const
 {
     int n = numParameters();
     params.resize(n);
-    const Array& prop = _cells[m]->properties();
+    const Array& prop = _propv[m];
     for (int i = 0; i != n; ++i) params[i] = prop[parametersIndex() + i];
 }
 
@@ -995,17 +1202,168 @@ double VoronoiMeshSnapshot::mass() const
 
 ////////////////////////////////////////////////////////////////////
 
+const VoronoiMeshSnapshot::Decomposition* VoronoiMeshSnapshot::decomposition(int m) const
+{
+    // return the decomposition if it has already been built
+    std::atomic<const Decomposition*>& slot = _tess->decompositions[m];
+    const Decomposition* existing = slot.load(std::memory_order_acquire);
+    if (existing) return existing;
+
+    // reconstruct the cell polyhedron, relative to the site position, by cutting the domain with the bisector
+    // planes between the site and each of its neighbors (the negative neighbor ids represent the domain walls);
+    // the Voro++ cell object and the scratch vectors are reused by each thread because allocating them is costly
+    thread_local voro::cell t_vcell;
+    thread_local vector<double> t_coords;
+    thread_local vector<int> t_faces;
+    voro::cell& vcell = t_vcell;
+    Cell* cell = _tess->cells[m];
+    Vec r = cell->position();
+    vcell.init(_extent.xmin() - r.x(), _extent.xmax() - r.x(), _extent.ymin() - r.y(), _extent.ymax() - r.y(),
+               _extent.zmin() - r.z(), _extent.zmax() - r.z());
+    for (int id : cell->neighbors())
+    {
+        if (id >= 0)
+        {
+            Vec d = _tess->cells[id]->position() - r;
+            if (!vcell.nplane(d.x(), d.y(), d.z(), d.norm2(), id)) return nullptr;
+        }
+    }
+
+    // get the vertices and the faces of the polyhedron
+    vector<double>& coords = t_coords;
+    vector<int>& faces = t_faces;
+    vcell.vertices(coords);
+    vcell.face_vertices(faces);
+    int numVertices = coords.size() / 3;
+    int numFaceValues = faces.size();
+    int numTetrahedra = 0;
+    for (int i = 0; i < numFaceValues; i += faces[i] + 1) numTetrahedra += faces[i] - 2;
+    if (numVertices > 65536 || numTetrahedra > 65536) return nullptr;
+
+    // split each face into triangles fanning out from its first vertex,
+    // and calculate the volume of the tetrahedron formed by each triangle and the site
+    auto dec = new Decomposition;
+    dec->r = r;
+    dec->vertices.reserve(numVertices);
+    for (int i = 0; i != numVertices; ++i)
+        dec->vertices.emplace_back(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+    dec->tetrahedra.reserve(numTetrahedra);
+    vector<double> volumes;
+    volumes.reserve(numTetrahedra);
+    for (int i = 0; i < numFaceValues; i += faces[i] + 1)
+    {
+        int n = faces[i];
+        const int* f = &faces[i + 1];
+        for (int k = 1; k < n - 1; ++k)
+        {
+            Vec a = dec->vertices[f[0]];
+            Vec b = dec->vertices[f[k]];
+            Vec c = dec->vertices[f[k + 1]];
+            volumes.push_back(abs(Vec::dot(a, Vec::cross(b, c))) / 6.);
+            dec->tetrahedra.push_back({1., 0, {static_cast<uint16_t>(f[0]), static_cast<uint16_t>(f[k]),
+                                                static_cast<uint16_t>(f[k + 1])}});
+        }
+    }
+
+    // bail out if the polyhedron is degenerate
+    double volume = std::accumulate(volumes.begin(), volumes.end(), 0.);
+    if (!(volume > 0.))
+    {
+        delete dec;
+        return nullptr;
+    }
+
+    // construct the alias table by repeatedly pairing a tetrahedron with less than average probability
+    // with a tetrahedron with more than average probability, which serves as the alias for the former
+    vector<int> small, large;
+    for (int t = 0; t != numTetrahedra; ++t)
+    {
+        volumes[t] *= numTetrahedra / volume;
+        (volumes[t] < 1. ? small : large).push_back(t);
+    }
+    while (!small.empty() && !large.empty())
+    {
+        int s = small.back();
+        int l = large.back();
+        small.pop_back();
+        dec->tetrahedra[s].threshold = volumes[s];
+        dec->tetrahedra[s].alias = l;
+        volumes[l] -= 1. - volumes[s];
+        if (volumes[l] < 1.)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // store the new decomposition unless another thread has already done so in the meantime
+    if (slot.compare_exchange_strong(existing, dec, std::memory_order_acq_rel))
+    {
+        MemoryRegistry::add(log(), MemoryRegistry::Category::Grid, dec->bytes());
+        return dec;
+    }
+    delete dec;
+    return existing;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Position VoronoiMeshSnapshot::generatePosition(int m) const
 {
-    // get loop-invariant information about the cell
-    const Box& box = _cells[m]->extent();
-    const vector<int>& neighbors = _cells[m]->neighbors();
+    // get the cell's decomposition, building it if the number of rejection sampling attempts exceeds the threshold
+    const Decomposition* dec = _tess->decompositions[m].load(std::memory_order_acquire);
+    if (!dec && _tess->numAttempts[m].load(std::memory_order_relaxed) >= maxRejectionAttempts)
+    {
+        dec = decomposition(m);
+        if (!dec) _tess->numAttempts[m].store(0, std::memory_order_relaxed);  // postpone the next try
+    }
+
+    // if the cell's decomposition is available, select a tetrahedron according to its volume, and generate
+    // a uniform random point inside it by folding a random point in the unit cube into the unit simplex
+    if (dec)
+    {
+        int n = dec->tetrahedra.size();
+        double x = n * random()->uniform();
+        int t = min(n - 1, static_cast<int>(x));
+        const Decomposition::Tetrahedron* tet = &dec->tetrahedra[t];
+        if (x - t >= tet->threshold) tet = &dec->tetrahedra[tet->alias];
+        double s = random()->uniform();
+        double u = random()->uniform();
+        double v = random()->uniform();
+        if (s + u > 1.)
+        {
+            s = 1. - s;
+            u = 1. - u;
+        }
+        if (u + v > 1.)
+        {
+            double w = v;
+            v = 1. - s - u;
+            u = 1. - w;
+        }
+        else if (s + u + v > 1.)
+        {
+            double w = v;
+            v = s + u + v - 1.;
+            s = 1. - u - w;
+        }
+        return Position(dec->r + s * dec->vertices[tet->v[0]] + u * dec->vertices[tet->v[1]]
+                        + v * dec->vertices[tet->v[2]]);
+    }
+
+    // otherwise, get loop-invariant information about the cell
+    const Box& box = _tess->cells[m]->extent();
+    const vector<int>& neighbors = _tess->cells[m]->neighbors();
 
     // generate random points in the enclosing box until one happens to be inside the cell
-    for (int i = 0; i < 10000; i++)
+    for (int i = 1; i <= 10000; i++)
     {
         Position r = random()->position(box);
-        if (isPointClosestTo(r, m, neighbors)) return r;
+        if (isPointClosestTo(r, m, neighbors))
+        {
+            _tess->numAttempts[m].fetch_add(i, std::memory_order_relaxed);
+            return r;
+        }
     }
     throw FATALERROR("Can't find random position in cell");
 }
@@ -1015,7 +1373,7 @@ Position VoronoiMeshSnapshot::generatePosition(int m) const
 Position VoronoiMeshSnapshot::generatePosition() const
 {
     // if there are no sites, return the origin
-    if (_cells.empty()) return Position();
+    if (_tess->cells.empty()) return Position();
 
     // select a site according to its mass contribution
     int m = NR::locateClip(_cumrhov, random()->uniform());
@@ -1032,21 +1390,21 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
 
     // determine the block in which the point falls
     int i, j, k;
-    _extent.cellIndices(i, j, k, bfr, _nb, _nb, _nb);
-    int b = i * _nb2 + j * _nb + k;
+    _extent.cellIndices(i, j, k, bfr, _tess->nb, _tess->nb, _tess->nb);
+    int b = i * _tess->nb2 + j * _tess->nb + k;
 
     // look for the closest site in this block, using the search tree if there is one
-    Node* tree = _blocktrees[b];
-    if (tree) return tree->nearest(bfr, _cells)->m();
+    Node* tree = _tess->blocktrees[b];
+    if (tree) return tree->nearest(bfr, _tess->cells)->m();
 
     // if there is no search tree, simply loop over the index list
-    const vector<int>& ids = _blocklists[b];
+    const vector<int>& ids = _tess->blocklists[b];
     int m = -1;
     double mdist = DBL_MAX;
     int n = ids.size();
     for (int i = 0; i < n; i++)
     {
-        double idist = _cells[ids[i]]->squaredDistanceTo(bfr);
+        double idist = _tess->cells[ids[i]]->squaredDistanceTo(bfr);
         if (idist < mdist)
         {
             m = ids[i];
@@ -1061,10 +1419,11 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
 class VoronoiMeshSnapshot::MySegmentGenerator : public PathSegmentGenerator
 {
     const VoronoiMeshSnapshot* _grid{nullptr};
+    const vector<Cell*>& _cells;
     int _mr{-1};
 
 public:
-    MySegmentGenerator(const VoronoiMeshSnapshot* grid) : _grid(grid) {}
+    MySegmentGenerator(const VoronoiMeshSnapshot* grid) : _grid(grid), _cells(grid->_tess->cells) {}
 
     bool next() override
     {
@@ -1090,7 +1449,7 @@ public:
                 while (true)
                 {
                     // get the site position for this cell
-                    Vec pr = _grid->_cells[_mr]->position();
+                    Vec pr = _cells[_mr]->position();
 
                     // initialize the smallest nonnegative intersection distance and corresponding index
                     double sq = DBL_MAX;  // very large, but not infinity (so that infinite si values are discarded)
@@ -1098,7 +1457,7 @@ public:
                     int mq = NO_INDEX;
 
                     // loop over the list of neighbor indices
-                    const vector<int>& mv = _grid->_cells[_mr]->neighbors();
+                    const vector<int>& mv = _cells[_mr]->neighbors();
                     int n = mv.size();
                     for (int i = 0; i < n; i++)
                     {
@@ -1111,7 +1470,7 @@ public:
                         if (mi >= 0)
                         {
                             // get the site position for this neighbor
-                            Vec pi = _grid->_cells[mi]->position();
+                            Vec pi = _cells[mi]->position();
 
                             // calculate the (unnormalized) normal on the bisecting plane
                             Vec n = pi - pr;
@@ -44,7 +44,22 @@ class SpatialGridPath;
 
     This class uses the Voro++ code written by Chris H. Rycroft (LBL / UC Berkeley) to build the
     Voronoi tesselation. Once an VoronoiMeshSnapshot object has been constructed and fully
-    configured, its data is no longer modified. Consequently all getters are re-entrant. */
+    configured, its data is no longer modified. Consequently all getters are re-entrant.
+
+    The Voronoi tessellation and the data structures for locating the cell containing a given
+    point are held in a separate object that can be shared between multiple VoronoiMeshSnapshot
+    instances. This happens, for example, when a ski file configures a VoronoiMeshSource and a
+    VoronoiMeshMedium importing the same sites (as is typical for moving-mesh snapshots), and a
+    VoronoiMeshSpatialGrid using the sites imported by the medium. A process-wide registry keeps
+    track of the tessellations in use, keyed on the list of retained sites (after discarding
+    sites outside of the domain and sites that are too close to another site, and sorting the
+    remaining sites in a canonical order), the extent of the domain, and the relaxation flag.
+    When a snapshot requests a tessellation that matches an existing one (verified by comparing the
+    site coordinates), it simply acquires a reference to that tessellation instead of constructing a
+    new one. If the matching tessellation is still being built by another snapshot in a concurrent
+    simulation, the snapshot waits for it to be completed. The tessellation is
+    released when the last snapshot using it is destroyed. The imported site properties, on the
+    other hand, are stored separately by each snapshot, in the order of the shared cells. */
 class VoronoiMeshSnapshot : public Snapshot
 {
     //================= Construction - Destruction =================
@@ -143,18 +158,32 @@ private:
         and buildSearch() functions. */
     class Node;
 
-    /** Given a list of generating sites (represented as partially initialized Cell
-        objects), this private function builds the Voronoi tessellation and stores the
-        corresponding cell information, including any properties relevant for supporting the
-        interrogation capabilities offered by this class. All other data (such as Voronoi cell
-        vertices, edges and faces) are discarded. In practice, the function adds the sites to a
-        Voro++ container, computes the Voronoi cells one by one, and copies the relevant cell
-        information (such as the list of neighboring cells) from the Voro++ data structures into
-        its own.
-
-        Before actually starting to build the Voronoi tessellation, the function discards sites
-        (represented as Cell objects) outside of the domain and sites that are too close to
-        another site.
+    /** Private class to hold the Voronoi cells and the search data structures for a given list
+        of sites, so that they can be shared between snapshots; see the buildMesh() function. */
+    class Tessellation;
+
+    /** Private class to hold the decomposition of a Voronoi cell into tetrahedra, used for
+        generating random positions inside the cell; see the decomposition() function. */
+    class Decomposition;
+
+    /** Given a list of generating sites, this private function obtains the Voronoi tessellation
+        for these sites, storing a reference to it in the snapshot, and returns a list with the
+        index in the specified list of the site corresponding to each cell in the tessellation.
+        The caller can use this list to reorder any site properties.
+
+        The function first discards sites outside of the domain and sites that are too close to
+        another site, and sorts the remaining sites in a canonical order. If the registry of
+        shared tessellations holds a tessellation built (or being built) from the same sites and for
+        the same domain extent and relaxation flag, the function waits for it to be completed, if
+        needed, and acquires a reference to that tessellation. Otherwise, it registers a pending
+        entry, builds a new tessellation, and publishes it to any snapshots waiting for it.
+
+        To build the tessellation, the function stores the corresponding cell information,
+        including any properties relevant for supporting the interrogation capabilities offered
+        by this class. All other data (such as Voronoi cell vertices, edges and faces) are
+        discarded. In practice, the function adds the sites to a Voro++ container, computes the
+        Voronoi cells one by one, and copies the relevant cell information (such as the list of
+        neighboring cells) from the Voro++ data structures into its own.
 
         If the \em relax argument is true, the function performs a single relaxation step on the
         site positions using Lloyd's algorithm (Lloyd 1982; Du, Faber and Gunzburger 1999, SIAM
@@ -164,14 +193,15 @@ private:
         constructed with these adjusted site positions, which are distributed more uniformly,
         thereby avoiding overly elongated cells in the Voronoi tessellation. Relaxation can be
         quite time-consuming because the Voronoi tessellation must be constructed twice. */
-    void buildMesh(bool relax);
+    vector<int> buildMesh(const vector<Vec>& sites, bool relax);
 
     /** Private function to recursively build a binary search tree (see
         en.wikipedia.org/wiki/Kd-tree) */
     Node* buildTree(vector<int>::iterator first, vector<int>::iterator last, int depth) const;
 
     /** This private function builds data structures that allow accelerating the operation of the
-        cellIndex() function.
+        cellIndex() function, unless these data structures have already been built for the
+        (shared) tessellation used by the snapshot.
 
         The domain is partitioned using a linear cubodial grid into cells that are called \em
         blocks. For each block, the function builds and stores a list of all Voronoi cells that
@@ -191,6 +221,27 @@ private:
         than to the sites with indices ids. */
     bool isPointClosestTo(Vec r, int m, const vector<int>& ids) const;
 
+    /** This private function returns the decomposition into tetrahedra of the cell with index m,
+        building it if this has not yet been done for the (shared) tessellation used by the
+        snapshot. The decomposition is built on demand by the generatePosition() function rather
+        than during setup, because it consumes several times more memory than the other cell
+        information and it is worthwhile only for cells in which many random positions are
+        generated.
+
+        To build the decomposition, the function reconstructs the cell's polyhedron by cutting the
+        domain with the bisector planes between the cell's site and each of its neighbors, using
+        the Voro++ library. Each face of the polyhedron is split into triangles fanning out from
+        the face's first vertex, and each triangle forms a tetrahedron with the cell's site, which
+        is always inside the cell. The function stores the vertices of the polyhedron, the vertex
+        indices of the triangles, and an alias table for selecting a tetrahedron according to its
+        volume (Vose 1991, IEEE Trans. Softw. Eng. 17.9, pp 972-975). The function is thread-safe:
+        if multiple threads build the decomposition of the same cell concurrently, only one of the
+        results is retained.
+
+        If the polyhedron cannot be reconstructed (which should not happen), the function returns
+        a null pointer, and the caller should revert to rejection sampling. */
+    const Decomposition* decomposition(int m) const;
+
     //====================== Output =====================
 
 public:
@@ -297,9 +348,22 @@ public:
     /** This function returns a random position drawn uniformly from the (polyhedron) volume of the
         cell with index \em m. If the index is out of range, the behavior is undefined.
 
-        The function generates uniformly distributed random points in the enclosing cuboid until
-        one happens to be inside the cell. The candidate point is inside the cell if it is closer
-        to the cell's site position than to any neighbor cell's site positions. */
+        Initially, the function generates uniformly distributed random points in the enclosing
+        cuboid until one happens to be inside the cell. The candidate point is inside the cell if
+        it is closer to the cell's site position than to any neighbor cell's site positions. The
+        number of attempts depends on the shape of the cell and can be large for elongated cells.
+
+        Once the total number of attempts for a cell exceeds a threshold chosen so that the
+        attempts have taken about as long as building the cell's decomposition into tetrahedra
+        (see the private decomposition() function), the function builds that decomposition and
+        uses it for all subsequent positions in the cell. It selects one of the tetrahedra from
+        the discrete probability distribution formed by their volumes using an alias table, and
+        then generates a uniformly distributed random point inside that tetrahedron by folding a
+        random point in the unit cube into the unit simplex (Rocchini & Cignoni 2000, Journal of
+        Graphics Tools 5.4, pp 9-12). The cost per position is then small and does not depend on
+        the shape of the cell. With this policy, the decomposition is built only for cells that
+        are sampled repeatedly, and the time spent on a cell is at most about twice the time
+        needed by the best of both methods. */
     Position generatePosition(int m) const override;
 
     /** This function returns a random position within the spatial domain of the snapshot, drawn
@@ -417,21 +481,17 @@ private:
     Box _extent;      // the spatial domain of the mesh
     double _eps{0.};  // small fraction of extent
 
-    // data members initialized when processing snapshot input and further completed by BuildMesh()
-    vector<Cell*> _cells;  // cell objects, indexed on m
+    // data members initialized by BuildMesh(); the tessellation may be shared with other snapshots
+    std::shared_ptr<Tessellation> _tess;  // cell objects and search data structures
+
+    // data members initialized when processing snapshot input
+    vector<Array> _propv;  // user-defined properties for each cell, if any
 
     // data members initialized when processing snapshot input, but only if a density policy has been set
     Array _rhov;       // density for each cell (not normalized)
     Array _cumrhov;    // normalized cumulative density distribution for cells
     double _mass{0.};  // total effective mass
 
-    // data members initialized by BuildSearch()
-    int _nb{0};                       // number of blocks in each dimension (limit for indices i,j,k)
-    int _nb2{0};                      // nb*nb
-    int _nb3{0};                      // nb*nb*nb
-    vector<vector<int>> _blocklists;  // list of cell indices per block, indexed on i*_nb2+j*_nb+k
-    vector<Node*> _blocktrees;        // root node of search tree or null for each block, indexed on i*_nb2+j*_nb+k
-
     // allow our path segment generator to access our private data members
     class MySegmentGenerator;
     friend class MySegmentGenerator;
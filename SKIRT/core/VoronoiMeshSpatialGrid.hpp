@@ -22,7 +22,11 @@ class VoronoiMeshSnapshot;
     the positions can be copied from the sites in the imported distribution(s).
 
     Furthermore, the user can opt to perform a relaxation step on the site positions to avoid
-    overly elongated cells. */
+    overly elongated cells.
+
+    If the sites are copied from an imported Voronoi mesh distribution with the same domain and
+    without relaxation, the grid shares the Voronoi tessellation constructed for the imported
+    distribution rather than building an identical copy (see the VoronoiMeshSnapshot class). */
 class VoronoiMeshSpatialGrid : public BoxSpatialGrid, public DensityInCellInterface
 {
     /** The enumeration type indicating the policy for determining the positions of the sites. */
@@ -6,6 +6,7 @@
 #include "SkirtCommandLineHandler.hpp"
 #include "BuildInfo.hpp"
 #include "Console.hpp"
+#include "Configuration.hpp"
 #include "ConsoleHierarchyCreator.hpp"
 #include "FatalError.hpp"
 #include "FileLog.hpp"
@@ -13,6 +14,7 @@
 #include "MonteCarloSimulation.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
+#include "PersistentCache.hpp"
 #include "ProcessManager.hpp"
 #include "SchemaDef.hpp"
 #include "SimulationItemRegistry.hpp"
@@ -22,13 +24,15 @@
 #include "TimeLogger.hpp"
 #include "XmlHierarchyCreator.hpp"
 #include "XmlHierarchyWriter.hpp"
+#include <iostream>
+#include <sstream>
 
 ////////////////////////////////////////////////////////////////////
 
 namespace
 {
     // the allowed options list, in the format consumed by the CommandLineArguments constructor
-    static const char* allowedOptions = "-t* -s* -d -b -v -m -e -k -i* -o* -r -x";
+    static const char* allowedOptions = "-t* -s* -g -p -d -b -v -m -e -n* -l* -a* -u -z* -k -i* -o* -c* -r -w -x";
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -51,10 +55,13 @@ int SkirtCommandLineHandler::perform()
     try
     {
         // if there are no arguments at all --> interactive mode
+        // if the -w option is present --> server mode
         // if there is at least one file path argument --> batch mode
         // if the -x option is present --> export smile schema (undocumented option)
         // otherwise --> error
         if (_args.isValid() && !_args.hasOptions() && !_args.hasFilepaths()) return doInteractive();
+        verifyPredictionOptions();
+        if (_args.isPresent("-w")) return doServe();
         if (_args.hasFilepaths()) return doBatch();
         if (_args.isPresent("-x")) return doSmileSchema();
         _console.error("Invalid command line arguments", false);
@@ -124,6 +131,33 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
+void SkirtCommandLineHandler::verifyPredictionOptions()
+{
+    if (_args.isPresent("-n"))
+    {
+        if (!_args.isPresent("-e")) throw FATALERROR("The -n option requires emulation mode (-e option)");
+        if (_args.doubleValue("-n") <= 0.) throw FATALERROR("The -n option requires a positive number of packets");
+    }
+    if (_args.isPresent("-l"))
+    {
+        if (!_args.isPresent("-n")) throw FATALERROR("The -l option requires a run time prediction (-n option)");
+
+        // parse "<threads>" or "<threads>x<processes>"
+        auto segments = StringUtils::split(_args.value("-l"), "x");
+        bool valid = segments.size() <= 2;
+        for (const auto& segment : segments) valid = valid && StringUtils::isValidInt(segment);
+        if (valid)
+        {
+            _targetThreads = StringUtils::toInt(segments[0]);
+            if (segments.size() == 2) _targetProcesses = StringUtils::toInt(segments[1]);
+        }
+        if (!valid || _targetThreads < 1 || (segments.size() == 2 && _targetProcesses < 1))
+            throw FATALERROR("The -l option requires a layout of the form <threads> or <threads>x<processes>");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 int SkirtCommandLineHandler::doInteractive()
 {
     if (ProcessManager::isMultiProc()) throw FATALERROR("Interactive mode cannot be run with multiple processes");
@@ -189,36 +223,224 @@ int SkirtCommandLineHandler::doBatch()
         // determine the number of parallel simulations
         _parallelSims = max(_args.intValue("-s"), 1);
 
-        // handle the serial case separately to avoid using MPI nested within a Parallel instance
-        if (_parallelSims == 1)
-        {
-            // perform a simulation for each ski file
-            TimeLogger logger(&_console, "a set of " + std::to_string(numSkiFiles) + " simulations");
-            for (size_t i = 0; i != numSkiFiles; ++i) doSimulation(i);
-        }
+        // prevent multiple simulations to be launched in parallel while MPI parallelization is used
+        if (_parallelSims > 1 && ProcessManager::isMultiProc())
+            throw FATALERROR("Cannot run multiple simulations in parallel when there are multiple MPI processes");
+
+        // perform a simulation for each ski file
+        string description = "a set of " + std::to_string(numSkiFiles) + " simulations";
+        if (_parallelSims > 1) description += ", " + std::to_string(_parallelSims) + " in parallel";
+        TimeLogger logger(&_console, description);
+        if (_args.isPresent("-g"))
+            doGroupedSimulations();
         else
+            doSimulations(0, numSkiFiles);
+    }
+
+    // report memory statistics for the complete run
+    reportPeakMemory(&_console);
+
+    // report stopwatch results, if any
+    for (string line : StopWatch::report()) _console.warning(line, false);
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int SkirtCommandLineHandler::doServe()
+{
+    if (ProcessManager::isMultiProc()) throw FATALERROR("Server mode cannot be run with multiple processes");
+
+    // alert the user about problems with the installed resource packs
+    reportResourceIssues(&_console);
+
+    // keep resource file memory maps and derived data in memory across simulations
+    System::setMemoryMapRetention(true);
+    PersistentCache::setMemoryStore(true);
+
+    // simulations are served one after the other
+    if (_args.isPresent("-s") && _args.intValue("-s") > 1)
+        _console.warning("Ignoring -s option in server mode; simulations are performed one after the other");
+    _parallelSims = 1;
+
+    // handle the file paths specified on the command line, if any, and then those read from standard input
+    vector<string> requests = _args.filepaths();
+    size_t numRequests = 0;
+    size_t numSucceeded = 0;
+    size_t numFailed = 0;
+    _console.info("Waiting for ski file paths on standard input; enter 'quit' or end of file to stop");
+    while (true)
+    {
+        // get the next request
+        string request;
+        if (numRequests < requests.size())
+            request = requests[numRequests];
+        else if (!std::getline(std::cin, request))
+            break;
+        numRequests++;
+        request = StringUtils::squeeze(request);
+        if (request.empty()) continue;
+        if (request == "quit" || request == "exit") break;
+
+        // build a list of filenames for existing ski files matching the request
+        _skifiles.clear();
+        _hasError = false;
+        addSkiFilesFor(request);
+        if (_hasError) numFailed++;
+
+        // perform a simulation for each ski file, catching and reporting any errors so that we can continue serving;
+        // determine the medium setup key for each ski file so that simulations with the same medium system share
+        // the initial medium state
+        _setupKeys.assign(_skifiles.size(), string());
+        for (size_t i = 0; i != _skifiles.size(); ++i)
         {
-            // prevent multiple simulations to be launched in parallel while MPI parallelization is used
-            if (ProcessManager::isMultiProc())
-                throw FATALERROR("Cannot run multiple simulations in parallel when there are multiple MPI processes");
-
-            // perform a simulation for each ski file
-            TimeLogger logger(&_console, "a set of " + std::to_string(numSkiFiles) + " simulations, "
-                                             + std::to_string(_parallelSims) + " in parallel");
-            ParallelFactory factory;
-            factory.setMaxThreadCount(_parallelSims);
-            factory.parallelRootOnly()->call(numSkiFiles, [this](size_t first, size_t size) {
-                for (size_t i = 0; i != size; ++i) doSimulation(first + i);
-            });
+            try
+            {
+                _setupKeys[i] = mediumSetupKey(_skifiles[i]);
+                doSimulation(i);
+                _console.success("Served simulation for ski file '" + _skifiles[i] + "'");
+                numSucceeded++;
+            }
+            catch (FatalError& error)
+            {
+                for (string line : error.message()) _console.error(line, false);
+                _console.error("Failed simulation for ski file '" + _skifiles[i] + "'", false);
+                numFailed++;
+            }
+            catch (const std::exception& except)
+            {
+                _console.error("Standard Library Exception: " + string(except.what()), false);
+                _console.error("Failed simulation for ski file '" + _skifiles[i] + "'", false);
+                numFailed++;
+            }
         }
     }
+    _setupKeys.clear();
+    _console.info("Served " + std::to_string(numSucceeded) + " simulation(s); " + std::to_string(numFailed)
+                  + " request(s) failed");
+
+    // release the memory held across simulations
+    PersistentCache::setMemoryStore(false);
+    System::setMemoryMapRetention(false);
 
     // report memory statistics for the complete run
     reportPeakMemory(&_console);
 
     // report stopwatch results, if any
     for (string line : StopWatch::report()) _console.warning(line, false);
-    return EXIT_SUCCESS;
+    return numFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtCommandLineHandler::doGroupedSimulations()
+{
+    // determine the medium setup key for each ski file; report and skip ski files that cannot be read
+    vector<std::pair<string, string>> keyedFiles;
+    for (const string& skipath : _skifiles)
+    {
+        try
+        {
+            keyedFiles.emplace_back(mediumSetupKey(skipath), skipath);
+        }
+        catch (FatalError& error)
+        {
+            for (string line : error.message()) _console.error(line);
+            _console.error("Skipping ski file '" + skipath + "'");
+            logErrorToFile(error.message(), skipath);
+        }
+    }
+    size_t numSkiFiles = keyedFiles.size();
+
+    // order the ski files by key, retaining the original order within each group
+    std::stable_sort(keyedFiles.begin(), keyedFiles.end(),
+                     [](const std::pair<string, string>& a, const std::pair<string, string>& b) {
+                         return a.first < b.first;
+                     });
+    _setupKeys.clear();
+    _skifiles.clear();
+    for (const auto& keyedFile : keyedFiles)
+    {
+        _setupKeys.push_back(keyedFile.first);
+        _skifiles.push_back(keyedFile.second);
+    }
+
+    // determine the index of the first ski file in each group, plus a sentinel
+    vector<size_t> starts;
+    for (size_t i = 0; i != numSkiFiles; ++i)
+        if (!i || _setupKeys[i] != _setupKeys[i - 1]) starts.push_back(i);
+    size_t numGroups = starts.size();
+    starts.push_back(numSkiFiles);
+    _console.info("Grouped " + std::to_string(numSkiFiles) + " ski files into " + std::to_string(numGroups)
+                  + " group(s) with a shared medium setup");
+
+    // keep resources and the shared medium state in memory across the simulations in a group
+    System::setMemoryMapRetention(true);
+    PersistentCache::setMemoryStore(true);
+    for (size_t g = 0; g != numGroups; ++g)
+    {
+        size_t first = starts[g];
+        size_t num = starts[g + 1] - first;
+        _console.info("Performing group #" + std::to_string(g + 1) + " of " + std::to_string(numGroups) + " with "
+                      + std::to_string(num) + " simulation(s)");
+
+        // the first simulation builds the shared medium state; the others reuse it
+        doSimulation(first);
+        if (num > 1) doSimulations(first + 1, num - 1);
+
+        // release the shared state before proceeding to the next group
+        PersistentCache::setMemoryStore(false);
+        PersistentCache::setMemoryStore(true);
+    }
+    PersistentCache::setMemoryStore(false);
+    System::setMemoryMapRetention(false);
+    _setupKeys.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SkirtCommandLineHandler::doSimulations(size_t firstIndex, size_t numIndices)
+{
+    // handle the serial case separately to avoid using MPI nested within a Parallel instance
+    if (_parallelSims == 1)
+    {
+        for (size_t i = 0; i != numIndices; ++i) doSimulation(firstIndex + i);
+    }
+    else
+    {
+        ParallelFactory factory;
+        factory.setMaxThreadCount(_parallelSims);
+        factory.parallelRootOnly()->call(numIndices, [this, firstIndex](size_t first, size_t size) {
+            for (size_t i = 0; i != size; ++i) doSimulation(firstIndex + first + i);
+        });
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+string SkirtCommandLineHandler::mediumSetupKey(string skipath)
+{
+    auto schema = SimulationItemRegistry::getSchemaDef();
+    auto topitem = XmlHierarchyCreator::readFile(schema, skipath);  // unique pointer to Item
+    auto simulation = dynamic_cast<MonteCarloSimulation*>(topitem.get());
+    if (!simulation || !simulation->mediumSystem()) return string();
+
+    // include the medium system and any other items or properties that may affect the medium setup
+    std::ostringstream key;
+    key.precision(17);
+    key << static_cast<int>(simulation->simulationMode()) << '\n';
+    if (_args.isPresent("-k")) key << StringUtils::dirPath(skipath) << '\n';
+    XmlHierarchyWriter::writeFragment(simulation->random(), schema, key);
+    XmlHierarchyWriter::writeFragment(simulation->cosmology(), schema, key);
+    auto sourceSystem = simulation->sourceSystem();
+    key << sourceSystem->minWavelength() << ' ' << sourceSystem->maxWavelength() << '\n';
+    for (double wavelength : sourceSystem->wavelengths()) key << wavelength << ' ';
+    key << '\n';
+    auto instrumentSystem = simulation->instrumentSystem();
+    if (instrumentSystem && instrumentSystem->defaultWavelengthGrid())
+        XmlHierarchyWriter::writeFragment(instrumentSystem->defaultWavelengthGrid(), schema, key);
+    XmlHierarchyWriter::writeFragment(simulation->mediumSystem(), schema, key);
+    return key.str();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -322,9 +544,18 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         simulation->filePaths()->setInputPath(inpath);
         simulation->filePaths()->setOutputPath(outpath);
 
+        //  - the path for the persistent cache of derived data, if requested
+        if (_args.isPresent("-c")) simulation->filePaths()->setCachePath(_args.value("-c"));
+
+        //  - the key for sharing the initial medium state, in shared-setup or server mode
+        if (!_setupKeys.empty()) simulation->config()->setMediumSetupKey(_setupKeys[index]);
+
         //  - the number of parallel threads
         if (_args.intValue("-t") > 0) simulation->parallelFactory()->setMaxThreadCount(_args.intValue("-t"));
 
+        //  - the binding of parallel threads to cores, unless multiple simulations compete for the same cores
+        if (_args.isPresent("-p") && _parallelSims == 1) simulation->parallelFactory()->setPinThreads(true);
+
         //  - the activation of data parallelization
         if (_args.isPresent("-d") && ProcessManager::isMultiProc())
         {
@@ -346,11 +577,30 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
                                       _producerInfo);
         }
 
+        //  - the checkpoint interval (in minutes on the command line) and resuming from a checkpoint,
+        //    identifying the configuration through the serialized simulation hierarchy
+        if (_args.isPresent("-a") || _args.isPresent("-u"))
+        {
+            std::ostringstream key;
+            XmlHierarchyWriter::writeFragment(simulation, schema, key);
+            simulation->config()->setCheckpointOptions(max(_args.doubleValue("-a"), 0.) * 60., _args.isPresent("-u"),
+                                                       key.str());
+        }
+
+        //  - the maximum size of the in-memory copy of a stored table quantity (in MB on the command line)
+        if (_args.isPresent("-z"))
+        {
+            double megabytes = _args.doubleValue("-z");
+            if (megabytes < 0.) throw FATALERROR("The -z option requires a nonnegative number of megabytes");
+            simulation->config()->setMaxRepackedTableValues(static_cast<size_t>(megabytes * 1024 * 1024 / 8));
+        }
+
         // put the simulation in emulation mode if requested
         if (_args.isPresent("-e"))
         {
             simulation->log()->setLowestLevel(Log::Level::Error);
-            simulation->config()->setEmulationMode();
+            simulation->config()->setEmulationMode(max(_args.doubleValue("-n"), 0.));
+            simulation->config()->setPredictionLayout(_targetThreads, _targetProcesses);
         }
 
         // issue welcome message to the simulation log file
@@ -425,22 +675,32 @@ void SkirtCommandLineHandler::printHelp()
     _console.warning("To create a new ski file interactively:    skirt");
     _console.warning("To run a simulation with default options:  skirt <ski-filename>");
     _console.warning("");
-    _console.warning("  skirt [-t <threads>] [-s <simulations>] [-d]");
-    _console.warning("        [-b] [-v] [-m] [-e]");
-    _console.warning("        [-k] [-i <dirpath>] [-o <dirpath>]");
-    _console.warning("        [-r] {<filepath>}*");
+    _console.warning("  skirt [-t <threads>] [-s <simulations>] [-g] [-p] [-d]");
+    _console.warning("        [-b] [-v] [-m] [-e] [-n <packets>] [-l <threads>[x<processes>]]");
+    _console.warning("        [-a <minutes>] [-u] [-z <megabytes>]");
+    _console.warning("        [-k] [-i <dirpath>] [-o <dirpath>] [-c <dirpath>]");
+    _console.warning("        [-r] [-w] {<filepath>}*");
     _console.warning("");
     _console.warning("  -t <threads> : the number of parallel threads for each simulation");
     _console.warning("  -s <simulations> : the number of parallel simulations per process");
+    _console.warning("  -g : share the medium setup between simulations with the same medium system");
+    _console.warning("  -p : bind the parallel threads of a simulation to separate cores");
     _console.warning("  -d : enable data parallelization mode for multiple processes");
     _console.warning("  -b : force brief console logging");
     _console.warning("  -v : force verbose logging for multiple processes");
     _console.warning("  -m : state the amount of used memory at the start of each log message");
     _console.warning("  -e : run the simulation in emulation mode to get an estimate of the memory consumption");
+    _console.warning("  -n <packets> : with -e, predict the run time from pilot segments with this number of packets");
+    _console.warning("  -l <threads>[x<processes>] : with -n, predict the run time for this parallelization layout");
+    _console.warning("  -a <minutes> : write a checkpoint each time the given wall-clock interval has elapsed");
+    _console.warning("  -u : resume the simulation from the most recent checkpoint, if available");
+    _console.warning("  -z <megabytes> : the maximum size of a stored table quantity repacked in memory");
     _console.warning("  -k : make the input/output paths relative to the ski file being processed");
     _console.warning("  -i <dirpath> : the relative or absolute path for simulation input files");
     _console.warning("  -o <dirpath> : the relative or absolute path for simulation output files");
+    _console.warning("  -c <dirpath> : the relative or absolute path for the cache of derived data");
     _console.warning("  -r : cause recursive directory descent for all specified ski file paths");
+    _console.warning("  -w : server mode; read additional ski file paths from standard input");
     _console.warning("  <filepath> : the relative or absolute file path for a ski file");
     _console.warning("               (the filename may contain ? and * wildcards)");
     _console.warning("");
@@ -20,10 +20,11 @@ result in a ski file, without actually performing the simulation. Otherwise, it
 simulations in the ski files specified on the command line according to the following syntax:
 
 \verbatim
- skirt [-t <threads>] [-s <simulations>] [-d]
-       [-b] [-v] [-m] [-e]
-       [-k] [-i <dirpath>] [-o <dirpath>]
-       [-r] {<filepath>}*
+ skirt [-t <threads>] [-s <simulations>] [-g] [-p] [-d]
+       [-b] [-v] [-m] [-e] [-n <packets>] [-l <threads>[x<processes>]]
+       [-a <minutes>] [-u] [-z <megabytes>]
+       [-k] [-i <dirpath>] [-o <dirpath>] [-c <dirpath>]
+       [-r] [-w] {<filepath>}*
 \endverbatim
 
 - The -t option specifies the number of parallel threads for each simulation. The default value
@@ -31,6 +32,22 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -s option specifies the number of simulations to be executed in parallel. The default value is one.
 
+- The -g option enables shared-setup mode for batches of multiple ski files. The ski files are grouped by the
+  configuration of their medium system (including the simulation mode and, with the -k option, the input path). The
+  simulations in each group are performed consecutively, after those of the previous group have completed. The first
+  simulation in a group calculates the initial medium state and retains it in memory, and the other simulations in the
+  group (which are executed in parallel if so requested by the -s option) reuse this state rather than recalculating
+  it, in addition to sharing resources as in server mode (see the -w option). This is useful for parameter sweeps
+  that vary only the sources, the instruments or the number of photon packets.
+
+- The -p option causes the parallel threads of each simulation to be bound to separate logical cores, selected from
+  the cores on which the process is allowed to run. This prevents threads from migrating between cores and, on
+  computers with multiple NUMA nodes (e.g., dual-socket nodes), keeps each thread close to the memory pages it first
+  touched. Large per-cell arrays such as the medium state and the radiation field are always initialized in parallel
+  so that their pages are distributed over the NUMA nodes. The -p option is ignored when multiple simulations are
+  executed in parallel (see the -s option), because their threads would compete for the same cores. Thread binding is
+  currently supported only on Linux.
+
 - The -d option enables data parallelization mode for multiple processes.
 
 - The -b option forces brief console logging, i.e. only success and error messages are shown rather than all progress
@@ -47,6 +64,32 @@ simulations in the ski files specified on the command line according to the foll
 - The -e option activates emulation mode, which can be used to estimate the amount of memory used by
   a given simulation without actually performing the simulation.
 
+- The -n option, in combination with the -e option, causes the emulated simulation to launch up to the specified
+  number of photon packets in each segment, and to predict the run time of the actual simulation by extrapolating the
+  timings of these pilot segments (see RuntimePredictor). The prediction is written to the simulation log file and to
+  the file <tt>prefix_runtime.dat</tt>. It is an error to specify the -n option without the -e option.
+
+- The -l option, in combination with the -n option, specifies the parallelization layout for which the run time is
+  predicted, as the number of threads per process optionally followed by an 'x' and the number of processes (e.g.
+  "-l 32x4"). If the number of processes is omitted, it is taken from the pilot run. By default, the prediction refers
+  to the layout of the pilot run itself.
+
+- The -a option causes the simulation to write a checkpoint each time the specified number of minutes of wall-clock
+  time has elapsed since the start of the run or since the previous checkpoint. Each process writes its own
+  checkpoint file in the output directory, replacing the previous one. The checkpoint is written at the next boundary
+  between blocks of photon packets, so the actual interval may be somewhat longer than requested.
+
+- The -u option causes the simulation to resume from the checkpoint written by a previous run with the same ski file,
+  output path and number of processes. Setup is performed as usual, but the completed simulation phases and photon
+  packets are skipped. If there is no valid checkpoint, the simulation starts from the beginning. The -u option can
+  be combined with the -a option to continue writing checkpoints.
+
+- The -z option specifies the maximum size, in megabytes, of the in-memory copy of the values of a quantity in a
+  stored table. To speed up interpolation, the values of a quantity in a stored table holding multiple quantities or
+  a logarithmically interpolated quantity are copied into a contiguous block of memory, unless this block would
+  exceed the specified size (see StoredTable). Tables holding a single linearly interpolated quantity are always
+  interpolated directly from the memory map. The default value is 64 MB; a value of zero disables the copies.
+
 - The -k option causes the simulation input/output paths to be relative to the ski file being processed, rather than
   to the current directory. This is useful, for example, when processing multiple ski files organized in a nested
   directory hierarchy (see the -r option).
@@ -55,9 +98,26 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -o option specifies the absolute or relative path for simulation output files.
 
+- The -c option specifies the absolute or relative path for a directory holding a persistent cache of derived data,
+  such as the optical properties of dust mixes integrated over the grain size distributions. The directory is created
+  if needed. Simulations with the same configuration for a given item reuse the cached data rather than recalculating
+  it, which can substantially reduce setup time for parameter sweeps. By default, no cache is used.
+
 - The -r option causes recursive directory descent for all specified \<filepath\> arguments, in other words
   all directories inside the specified base paths are searched for the specified filename (or filename pattern).
 
+- The -w option activates server mode. After handling the \<filepath\> arguments on the command line, if any, SKIRT
+  reads additional \<filepath\> arguments from standard input, one per line, and performs the corresponding
+  simulations one after the other until it encounters the end of the input or a line containing "quit". A failing
+  simulation is reported but does not stop the server. Because a single process handles all simulations, immutable
+  resources are shared between consecutive simulations: memory maps on resource files remain in place, and derived
+  data such as the integrated optical properties of dust mixes is retained in memory (see PersistentCache). In
+  addition, simulations with the same medium setup key (see the -g option) share the initial medium state, so that
+  it is calculated only once for each distinct medium system. Because these states are retained for the lifetime of
+  the server, a server handling many different medium systems may accumulate a large amount of memory. The other
+  options apply to each of the simulations, except for the -s option, which is ignored with a warning because the
+  simulations are performed one after the other. Server mode cannot be used with multiple processes.
+
 In the simplest case, a \<filepath\> argument specifies the relative or absolute file path for a
 single ski file, with or without the ".ski" filename extension. However the filename (\em not the base path)
 may also contain ? and * wildcards forming a pattern to match multiple files. If the -r option
@@ -87,6 +147,12 @@ public:
     int perform();
 
 private:
+    /** This function verifies the consistency of the options for predicting the run time of a
+        simulation (-e, -n and -l), and parses the target parallelization layout specified with the
+        -l option, if any. If the options are inconsistent or invalid, the function throws a fatal
+        error. */
+    void verifyPredictionOptions();
+
     /** This function conducts an interactive session to construct a simulation and save the result
         in a ski file. The function returns an appropriate application exit value. */
     int doInteractive();
@@ -96,6 +162,31 @@ private:
         returns an appropriate application exit value. */
     int doBatch();
 
+    /** This function implements server mode: it performs the simulations for the ski files
+        specified on the command line and subsequently on standard input, keeping resources in
+        memory across simulations. The function returns an appropriate application exit value. */
+    int doServe();
+
+    /** This function implements shared-setup mode for the ski files in the internal list: it
+        groups the ski files by medium setup key and performs the simulations group by group, so
+        that the simulations in a group can share the initial medium state and the spatial tree
+        grid topology. Ski files that cannot be read are reported and skipped. */
+    void doGroupedSimulations();
+
+    /** This function performs the simulations for the specified range of indices in the internal
+        list, one after the other or in parallel depending on the -s option. */
+    void doSimulations(size_t firstIndex, size_t numIndices);
+
+    /** This function returns a key identifying the configuration of the medium system in the
+        specified ski file, composed of the XML representation of the medium system, the simulation
+        mode, and (if the -k option is present) the input path, in addition to the other settings
+        that may affect the medium setup: the random number generator (including its seed), the
+        cosmology, the wavelength range or wavelengths of the primary sources, and the default
+        instrument wavelength grid. Ski files with the same key produce the same initial medium
+        state. If the simulation has no medium system, the function returns the empty string. If
+        the ski file cannot be read, the function throws a fatal error. */
+    string mediumSetupKey(string skipath);
+
     /** This function exports a smile schema. This is an undocumented option. */
     int doSmileSchema();
 
@@ -128,7 +219,10 @@ private:
     string _producerInfo;
     string _hostUserInfo;
     vector<string> _skifiles;
+    vector<string> _setupKeys;  // medium setup key for each ski file, or empty if not in shared-setup or server mode
     int _parallelSims{1};
+    int _targetThreads{0};    // number of threads per process for the run time prediction, or zero if unspecified
+    int _targetProcesses{0};  // number of processes for the run time prediction, or zero if unspecified
     bool _hasError{false};
 };
 
@@ -0,0 +1,74 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "CdfSampler.hpp"
+#include "SpecialFunctions.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+void CdfSampler::initLinLin(const Array& xv, const Array& Pv)
+{
+    _logLog = false;
+    _xv = &xv;
+    _Pv = &Pv;
+    _numIntervals = xv.size() - 1;
+
+    // precompute the inverse slope of the cdf in each interval
+    _av.resize(_numIntervals);
+    _cv.resize(0);
+    for (size_t i = 0; i != _numIntervals; ++i) _av[i] = (xv[i + 1] - xv[i]) / (Pv[i + 1] - Pv[i]);
+
+    buildGuideTable();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void CdfSampler::initLogLog(const Array& xv, const Array& pv, const Array& Pv)
+{
+    _logLog = true;
+    _xv = &xv;
+    _Pv = &Pv;
+    _numIntervals = xv.size() - 1;
+
+    // precompute minus the power-law exponent and the scale factor of the cdf in each interval
+    _av.resize(_numIntervals);
+    _cv.resize(_numIntervals);
+    for (size_t i = 0; i != _numIntervals; ++i)
+    {
+        _av[i] = -log(pv[i + 1] / pv[i]) / log(xv[i + 1] / xv[i]);
+        _cv[i] = 1. / (pv[i] * xv[i]);
+    }
+
+    buildGuideTable();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void CdfSampler::buildGuideTable()
+{
+    // entry j holds the largest interval index i for which P_i <= j/(N-1), clipped to [0,N-2]
+    const Array& Pv = *_Pv;
+    _guidev.resize(_numIntervals);
+    size_t i = 0;
+    for (size_t j = 0; j != _numIntervals; ++j)
+    {
+        double P = static_cast<double>(j) / _numIntervals;
+        while (i < _numIntervals - 1 && Pv[i + 1] <= P) ++i;
+        _guidev[j] = static_cast<int>(i);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+double CdfSampler::sample(double X) const
+{
+    int i = locate(X);
+    const Array& xv = *_xv;
+    const Array& Pv = *_Pv;
+    if (_logLog) return xv[i] * SpecialFunctions::gexp(_av[i], (X - Pv[i]) * _cv[i]);
+    return xv[i] + (X - Pv[i]) * _av[i];
+}
+
+////////////////////////////////////////////////////////////////////
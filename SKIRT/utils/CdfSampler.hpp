@@ -0,0 +1,85 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef CDFSAMPLER_HPP
+#define CDFSAMPLER_HPP
+
+#include "Array.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** A CdfSampler instance allows drawing random numbers from a tabulated probability distribution
+    in constant time, independent of the number of grid points. The distribution is specified
+    through its normalized cumulative distribution function (cdf) \f$P_i\f$ sampled at a set of
+    \f$N\f$ points \f$x_i\f$, as produced by the NR::cdf() family of functions, and optionally the
+    corresponding normalized probability density function (pdf) \f$p_i\f$.
+
+    Given a uniform deviate \f${\cal{X}}\f$, the sampler must locate the interval
+    \f$[P_i,P_{i+1}[\f$ containing the deviate and then invert the cdf within that interval. Rather
+    than performing a binary search over the cdf for each draw, the sampler builds a guide table
+    (Chen and Asau 1974) when it is initialized. The guide table has \f$N-1\f$ entries; entry
+    \f$j\f$ holds the index of the interval containing the value \f$j/(N-1)\f$. For a given deviate,
+    the guide table provides the index of the interval containing the largest tabulated value not
+    exceeding the deviate, and a short sequential search (on average less than two steps) finds
+    the actual interval. The sampler also precomputes the quantities needed to invert the cdf in
+    each interval, so that no logarithms need to be evaluated for each draw.
+
+    Two interpolation schemes are supported, corresponding to the Random::cdfLinLin() and
+    Random::cdfLogLog() functions. With the lin-lin scheme, the cdf is assumed to be piece-wise
+    linear. With the log-log scheme, the pdf is assumed to be a power law between any two grid
+    points. Apart from round-off errors, the sampled values are identical to those returned by these
+    functions for the same uniform deviate. */
+class CdfSampler
+{
+public:
+    /** The default constructor creates an empty sampler, which must be initialized by calling one
+        of the initialization functions before it can be used. */
+    CdfSampler() {}
+
+    /** This function initializes the sampler for the lin-lin interpolation scheme, given the grid
+        points \f$x_i\f$ and the corresponding normalized cdf values \f$P_i\f$. The arrays must
+        have the same size, with at least two elements, and the cdf must be nondecreasing from 0
+        to 1. The sampler keeps references to the arrays \em xv and \em Pv. */
+    void initLinLin(const Array& xv, const Array& Pv);
+
+    /** This function initializes the sampler for the log-log interpolation scheme, given the grid
+        points \f$x_i\f$ and the corresponding normalized pdf values \f$p_i\f$ and cdf values
+        \f$P_i\f$. The arrays must have the same size, with at least two elements; the grid points
+        must be positive and the cdf must be nondecreasing from 0 to 1. The sampler keeps references
+        to the arrays \em xv and \em Pv. */
+    void initLogLog(const Array& xv, const Array& pv, const Array& Pv);
+
+    /** This function returns the value drawn from the distribution for the specified uniform
+        deviate \f${\cal{X}}\f$ in the interval \f$[0,1]\f$. */
+    double sample(double X) const;
+
+private:
+    /** This function builds the guide table for the cdf values stored in the sampler. */
+    void buildGuideTable();
+
+    /** This function returns the index \f$i\f$ of the interval \f$[P_i,P_{i+1}[\f$ containing
+        the specified value, clipped to the range \f$[0,N-2]\f$, i.e. the same index as would be
+        returned by NR::locateClip(). */
+    int locate(double X) const
+    {
+        size_t j = static_cast<size_t>(X * _numIntervals);
+        int i = _guidev[j < _numIntervals ? j : _numIntervals - 1];
+        while (i < static_cast<int>(_numIntervals) - 1 && (*_Pv)[i + 1] <= X) ++i;
+        return i;
+    }
+
+private:
+    bool _logLog{false};          // true for the log-log interpolation scheme, false for lin-lin
+    size_t _numIntervals{0};      // the number of intervals N-1
+    const Array* _xv{nullptr};    // the grid points, owned by the caller
+    const Array* _Pv{nullptr};    // the cdf values, owned by the caller
+    Array _av;                    // for each interval: the slope (lin-lin) or minus the power-law exponent (log-log)
+    Array _cv;                    // for each interval: the cdf scale factor (log-log only)
+    vector<int> _guidev;          // the guide table
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -18,21 +18,34 @@ namespace
 
 SpatialGridPath::SpatialGridPath(const Position& bfr, const Direction& bfk) : _bfr(bfr), _bfk(bfk)
 {
-    _segments.reserve(INITIAL_CAPACITY);
+    reserve();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 SpatialGridPath::SpatialGridPath()
 {
-    _segments.reserve(INITIAL_CAPACITY);
+    reserve();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SpatialGridPath::reserve()
+{
+    _mv.reserve(INITIAL_CAPACITY);
+    _dsv.reserve(INITIAL_CAPACITY);
+    _sv.reserve(INITIAL_CAPACITY);
+    _tauv.reserve(INITIAL_CAPACITY);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void SpatialGridPath::clear()
 {
-    _segments.clear();
+    _mv.clear();
+    _dsv.clear();
+    _sv.clear();
+    _tauv.clear();
     _s = 0.;
 }
 
@@ -43,7 +56,10 @@ void SpatialGridPath::addSegment(int m, double ds)
     if (ds > 0)
     {
         _s += ds;
-        _segments.push_back(Segment{m, ds, _s, 0.});
+        _mv.push_back(m);
+        _dsv.push_back(ds);
+        _sv.push_back(_s);
+        _tauv.push_back(0.);
     }
 }
 
@@ -156,7 +172,7 @@ Position SpatialGridPath::moveInside(const Box& box, double eps)
 
 double SpatialGridPath::totalOpticalDepth() const
 {
-    return !_segments.empty() ? _segments.back().tau : 0.;
+    return !_tauv.empty() ? _tauv.back() : 0.;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -164,37 +180,36 @@ double SpatialGridPath::totalOpticalDepth() const
 void SpatialGridPath::findInteractionPoint(double tau)
 {
     // we can't handle an empty path
-    if (_segments.empty())
+    if (_tauv.empty())
     {
         _interactionCellIndex = -1;
         _interactionDistance = 0.;
     }
     else
     {
-        // find a pointer to the first segment that has an exit optical depth larger than or equal to the given value,
-        // or a pointer beyond the list if no such element is found
-        auto seg = std::lower_bound(_segments.cbegin(), _segments.cend(), tau,
-                                    [](const Segment& seg, double t) { return seg.tau < t; });
+        // find the index of the first segment that has an exit optical depth larger than or equal to the given value,
+        // or the number of segments if no such element is found
+        size_t i = std::lower_bound(_tauv.cbegin(), _tauv.cend(), tau) - _tauv.cbegin();
 
         // if we find the first segment, interpolate with the path's entry point
-        if (seg == _segments.cbegin())
+        if (i == 0)
         {
-            _interactionCellIndex = seg->m;
-            _interactionDistance = NR::interpolateLinLin(tau, 0., seg->tau, 0., seg->s);
+            _interactionCellIndex = _mv[0];
+            _interactionDistance = NR::interpolateLinLin(tau, 0., _tauv[0], 0., _sv[0]);
         }
 
         // if we find some other segment, interpolate with the previous segment
-        else if (seg < _segments.cend())
+        else if (i < _tauv.size())
         {
-            _interactionCellIndex = seg->m;
-            _interactionDistance = NR::interpolateLinLin(tau, (seg - 1)->tau, seg->tau, (seg - 1)->s, seg->s);
+            _interactionCellIndex = _mv[i];
+            _interactionDistance = NR::interpolateLinLin(tau, _tauv[i - 1], _tauv[i], _sv[i - 1], _sv[i]);
         }
 
         // if we are beyond the last segment, just use the last segment (i.e. assume this is a numerical inaccuracy)
         else
         {
-            _interactionCellIndex = (seg - 1)->m;
-            _interactionDistance = (seg - 1)->s;
+            _interactionCellIndex = _mv[i - 1];
+            _interactionDistance = _sv[i - 1];
         }
     }
 }
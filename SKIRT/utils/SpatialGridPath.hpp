@@ -15,8 +15,8 @@ class Box;
 /** A SpatialGridPath object contains the geometric details of a path through a spatial grid. Given
     a spatial grid, i.e. some partition of space into cells, a starting position \f${\bf{r}}\f$ and
     a propagation direction \f${\bf{k}}\f$, one can calculate the path through the grid. A
-    SpatialGridPath object maintains a record for each cell crossed by the path, called a \em
-    segment. A segment stores the spatial cell index (so the cell can be identified in the grid),
+    SpatialGridPath object maintains information on each cell crossed by the path, called a \em
+    segment. A segment is described by the spatial cell index (so the cell can be identified in the grid),
     together with the physical path length \f$\Delta s\f$ covered within the cell, and the path
     length \f$s\f$ covered along the entire path up to the end of the cell.
 
@@ -82,22 +82,28 @@ public:
 
     // ------- Retrieving path segments -------
 
-    // basic data structure holding information about a given segment in the path
-    struct Segment
-    {
-        int m;       // cell index
-        double ds;   // distance within the cell
-        double s;    // cumulative distance until cell exit
-        double tau;  // cumulative optical depth at cell exit
-    };
-
-    /** This function returns (a read-only reference to) a list of the current segments in the
-        path. Each Segment object holds the following public data members: the index \em m of the
-        spatial cell being represented, the distance \f$\Delta s\f$ covered by the path inside the
-        cell, the cumulative distance \f$s\f$ covered by the path from its initial position to the
-        exit point from the cell, and the cumulative cumulative optical depth \f$\tau\f$ at the
-        exit point (or zero if this information has not been set for the path). */
-    const vector<Segment>& segments() const { return _segments; }
+    /** This function returns the number of segments in the current path. */
+    int numSegments() const { return _mv.size(); }
+
+    /** This function returns (a read-only reference to) the list of spatial cell indices \f$m\f$
+        for the segments in the current path. The segment information is stored as a separate list
+        for each property (rather than a list of records) so that clients can process the segments
+        of a path in tight loops over contiguous memory. */
+    const vector<int>& cellIndices() const { return _mv; }
+
+    /** This function returns (a read-only reference to) the list of distances \f$\Delta s\f$
+        covered by the path inside the cell for the segments in the current path. */
+    const vector<double>& segmentLengths() const { return _dsv; }
+
+    /** This function returns (a read-only reference to) the list of cumulative distances \f$s\f$
+        covered by the path from its initial position to the exit point from the cell for the
+        segments in the current path. */
+    const vector<double>& cumulativeLengths() const { return _sv; }
+
+    /** This function returns (a read-only reference to) the list of cumulative optical depths
+        \f$\tau\f$ at the exit point from the cell for the segments in the current path, or zero if
+        this information has not been set for the path. */
+    const vector<double>& opticalDepths() const { return _tauv; }
 
     // ------- Handling optical depth -------
 
@@ -108,7 +114,23 @@ public:
 
         This (non-geometric) information can be stored here as a convenience to client classes. If
         the index is out of range, undefined behavior results. */
-    void setOpticalDepth(int i, double tau) { _segments[i].tau = tau; }
+    void setOpticalDepth(int i, double tau) { _tauv[i] = tau; }
+
+    /** This function sets the cumulative optical depth for all segments in the path, given a
+        function that calculates the optical depth inside a single segment. The function is invoked
+        for each segment crossing a spatial cell (i.e. for each segment with a nonnegative cell
+        index) with the index \f$m\f$ of the cell, the distance \f$\Delta s\f$ covered inside the
+        cell, and the cumulative distance \f$s\f$ at the exit point from the cell as its
+        arguments. The calculation proceeds in two passes over the segments: the first pass stores
+        the optical depth inside each segment, and the second pass accumulates these values. As a
+        result, the calculations for the individual segments are independent of each other and can
+        be pipelined by the processor, or even vectorized by the compiler. */
+    template<class F> void setOpticalDepths(F segmentOpticalDepth)
+    {
+        int n = _mv.size();
+        for (int i = 0; i != n; ++i) _tauv[i] = _mv[i] >= 0 ? segmentOpticalDepth(_mv[i], _dsv[i], _sv[i]) : 0.;
+        for (int i = 1; i < n; ++i) _tauv[i] += _tauv[i - 1];
+    }
 
     /** This function returns the optical depth corresponding to the end of the last path segment
         in the path, or zero if the path has no segments. The function assumes that both the
@@ -147,11 +169,19 @@ public:
         there was no interaction point within the path. */
     double interactionDistance() const { return _interactionDistance; }
 
+    // ------- Private helper -------
+private:
+    /** This function reserves an initial capacity for the segment information lists. */
+    void reserve();
+
     // ------- Data members -------
 private:
     Position _bfr;
     Direction _bfk;
-    vector<Segment> _segments;
+    vector<int> _mv;       // cell index for each segment
+    vector<double> _dsv;   // distance within the cell for each segment
+    vector<double> _sv;    // cumulative distance until cell exit for each segment
+    vector<double> _tauv;  // cumulative optical depth at cell exit for each segment
     double _s{0.};
     int _interactionCellIndex{-1};
     double _interactionDistance{0.};
@@ -93,11 +93,28 @@ namespace
         HANDLE maphandle{NULL};
 #else
         int filehandle{-1};
+        time_t modified{0};  // modification time of the file when it was mapped
 #endif
     };
 
     // Dictionary keeping track of all currently acquired file memory maps: <canonical_path, map_record>
     std::unordered_map<string, MapRecord> _maps;
+
+    // Flag indicating whether memory maps are retained after their last release
+    bool _retainMaps{false};
+
+    // Actually releases the memory map described by the specified record; the caller must hold the map mutex
+    void unmap(MapRecord& record)
+    {
+#if defined(_WIN64)
+        UnmapViewOfFile(record.start);
+        CloseHandle(record.maphandle);
+        CloseHandle(record.filehandle);
+#else
+        munmap(record.start, record.length);
+        close(record.filehandle);
+#endif
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -220,7 +237,8 @@ void System::initialize(int argc, char** argv)
 
 void System::finalize()
 {
-    // Release any remaining file memory mappings
+    // Release any remaining file memory mappings, including retained ones
+    setMemoryMapRetention(false);
     while (!_maps.empty()) System::releaseMemoryMap(_maps.begin()->first);
 
     // Clear and deallocate the list of command line arguments
@@ -616,6 +634,21 @@ std::pair<void*, size_t> System::acquireMemoryMap(string path)
     //  - thread-safety of the operating system calls is not so clear
     std::unique_lock<std::mutex> lock(_mapMutex);
 
+#ifndef _WIN64
+    // if a retained map is no longer acquired and the file has changed since it was mapped, release the map
+    if (_maps.count(path) && !_maps.at(path).count)
+    {
+        MapRecord& record = _maps.at(path);
+        struct stat status;
+        if (stat(path.c_str(), &status) == -1 || status.st_mtime != record.modified
+            || static_cast<size_t>(status.st_size) != record.length)
+        {
+            unmap(record);
+            _maps.erase(path);
+        }
+    }
+#endif
+
     // make a new map only if we don't have one cached
     if (!_maps.count(path))
     {
@@ -660,7 +693,11 @@ std::pair<void*, size_t> System::acquireMemoryMap(string path)
         {
             // get the file size
             struct stat filesize;
-            if (fstat(record.filehandle, &filesize) != -1) record.length = filesize.st_size;
+            if (fstat(record.filehandle, &filesize) != -1)
+            {
+                record.length = filesize.st_size;
+                record.modified = filesize.st_mtime;
+            }
 
             if (record.length)
             {
@@ -704,18 +741,10 @@ void System::releaseMemoryMap(string path)
         MapRecord& record = _maps.at(path);
         record.count--;
 
-        // actually release the memory map only when count has reached zero
-        if (!record.count)
+        // actually release the memory map only when count has reached zero, unless maps are being retained
+        if (!record.count && !_retainMaps)
         {
-
-#if defined(_WIN64)
-            UnmapViewOfFile(record.start);
-            CloseHandle(record.maphandle);
-            CloseHandle(record.filehandle);
-#else
-            munmap(record.start, record.length);
-            close(record.filehandle);
-#endif
+            unmap(record);
 
             // remove the map entry from our dictionary
             _maps.erase(path);
@@ -725,6 +754,29 @@ void System::releaseMemoryMap(string path)
 
 ////////////////////////////////////////////////////////////////////
 
+void System::setMemoryMapRetention(bool retain)
+{
+    std::unique_lock<std::mutex> lock(_mapMutex);
+    _retainMaps = retain;
+
+    // when retention is turned off, release the maps that are no longer acquired
+    if (!retain)
+    {
+        for (auto it = _maps.begin(); it != _maps.end();)
+        {
+            if (!it->second.count)
+            {
+                unmap(it->second);
+                it = _maps.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 vector<string> System::stacktrace()
 {
     vector<string> result;
@@ -1004,3 +1056,61 @@ size_t System::currentMemoryUsage()
 }
 
 ////////////////////////////////////////////////////////////////////
+
+#if defined(__linux__)
+#    include <pthread.h>  // for binding threads to cores
+#    include <sched.h>    // for obtaining the allowed cores
+#endif
+
+bool System::pinCurrentThread(int index)
+{
+#if defined(__linux__)
+    // get the set of cores on which the calling thread is allowed to run
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed)) return false;
+    int numAllowed = CPU_COUNT(&allowed);
+    if (numAllowed < 1) return false;
+
+    // select the requested core from the allowed set and bind the thread to it
+    int target = index % numAllowed;
+    for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed) && !target--)
+        {
+            cpu_set_t selected;
+            CPU_ZERO(&selected);
+            CPU_SET(cpu, &selected);
+            return !pthread_setaffinity_np(pthread_self(), sizeof(selected), &selected);
+        }
+    }
+    return false;
+#else
+    (void)index;
+    return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t System::discardMemoryPages(void* address, size_t size)
+{
+#if defined(__linux__)
+    // determine the range of pages entirely contained in the specified memory range
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t begin = reinterpret_cast<size_t>(address);
+    size_t first = (begin + pageSize - 1) / pageSize * pageSize;
+    size_t last = (begin + size) / pageSize * pageSize;
+    if (last <= first) return 0;
+
+    // for private anonymous memory, discarded pages are replaced by zero-filled pages on first access
+    if (madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED)) return 0;
+    return last - first;
+#else
+    (void)address;
+    (void)size;
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
@@ -180,6 +180,14 @@ public:
         operations is needed to actually release the memory map. */
     static void releaseMemoryMap(string path);
 
+    /** This function enables or disables retention of memory maps. If retention is enabled, a
+        memory map is not actually released when its acquisition count drops to zero, so that a
+        subsequent acquisition of the same file returns the existing map without remapping the
+        file. This is useful for long-running processes that perform many simulations using the
+        same resource files. When retention is disabled, all retained memory maps that are no
+        longer acquired are released. Retention is disabled by default. */
+    static void setMemoryMapRetention(bool retain);
+
     // ================== Debugging ==================
 
     /** This function returns a list of lines representing a stack trace to the current execution
@@ -199,6 +207,26 @@ public:
     /** Returns the current physical memory use for the current process in bytes, or zero if the
         value cannot be determined. */
     static size_t currentMemoryUsage();
+
+    // ================== Memory placement ==================
+
+    /** This function binds the calling thread to a single logical core, selected by the specified
+        index from the cores on which the calling thread is currently allowed to run (the index is
+        taken modulo the number of allowed cores). The function returns true if successful, and
+        false if the operation failed or is not supported on the current platform (thread binding is
+        currently implemented only on Linux). Binding threads to cores is a prerequisite for
+        assigning memory pages to the NUMA node closest to the threads that use them. */
+    static bool pinCurrentThread(int index);
+
+    /** This function discards the physical memory pages entirely contained in the specified range
+        of memory, which must have been allocated on the heap and filled with zeros, and returns the
+        number of discarded bytes. The contents of the memory range remain all zeros, but the
+        physical page for each discarded virtual page is allocated only when that page is first
+        written. As a result, on a NUMA system, the page is placed on the node closest to the thread
+        writing it, so that parallel initialization of the range spreads its pages across nodes. If
+        the operation is not supported on the current platform, the function does nothing and
+        returns zero. */
+    static size_t discardMemoryPages(void* address, size_t size);
 };
 
 ////////////////////////////////////////////////////////////////////
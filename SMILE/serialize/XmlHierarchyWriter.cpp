@@ -170,3 +170,11 @@ void XmlHierarchyWriter::write(Item* item, const SchemaDef* schema, string fileP
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void XmlHierarchyWriter::writeFragment(Item* item, const SchemaDef* schema, std::ostream& out)
+{
+    XmlWriter writer(out, item->type() + " fragment");
+    writeProperties(item, schema, writer);
+}
+
+////////////////////////////////////////////////////////////////////
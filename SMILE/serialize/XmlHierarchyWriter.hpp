@@ -7,6 +7,7 @@
 #define XMLHIERARCHYWRITER_HPP
 
 #include "Basics.hpp"
+#include <iosfwd>
 class Item;
 class SchemaDef;
 
@@ -23,6 +24,14 @@ public:
         specifies a producer identification string to be included as an attribute on the root
         element. If an error occurs, this function throws a fatal error. */
     static void write(Item* item, const SchemaDef* schema, string filePath, string producer = string());
+
+    /** Writes the structure and properties of the specified item and its children, described by
+        the given schema definition, as an XML fragment to the specified output stream. In contrast
+        to the write() function, the item does not need to be the top-level item of a dataset, and
+        the output does not include a document header or a root element. The output depends only on
+        the item's properties, so that it can be used for comparing parts of different datasets. If
+        an error occurs, this function throws a fatal error. */
+    static void writeFragment(Item* item, const SchemaDef* schema, std::ostream& out);
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,301 @@
+#!/bin/bash
+# (use "chmod +rx scriptname" to make script executable)
+#
+# For use on any Unix system, including Mac OS X and Linux
+#
+# Execute this script with "git" as default directory to run the
+# macro benchmarks in "SKIRT/bench/macro" with a release build of skirt
+# for a number of thread and process counts, and to produce a scaling
+# report listing the parallel efficiency for each simulation phase and
+# the peak memory usage per process.
+#
+# Usage: ./benchmarkSKIRT.sh [options]
+#
+#   -t <list>  : comma-separated thread counts (default: 1,2,4,... up to the number of cores)
+#   -r <list>  : comma-separated process counts (default: 1); counts above 1 use mpirun
+#   -m <mode>  : "strong" to keep the number of photon packets fixed (default), or
+#                "weak" to scale the number of photon packets with the number of cores
+#   -p <factor>: multiplier for the number of photon packets in each ski file (default: 1)
+#   -f <glob>  : only run the ski files with a name matching the pattern (default: *)
+#   -n <count> : number of runs per configuration; the shortest times are reported (default: 1)
+#   -s <path>  : the skirt executable (default: ../release/SKIRT/main/skirt)
+#   -o <dir>   : the output directory (default: ../benchmarks)
+#
+# The script writes the simulation output for each configuration in a separate subdirectory,
+# the raw timings and memory figures in "timings.tsv" and "memory.tsv", and the scaling report
+# in "report.txt", all inside the output directory. Phase timings are parsed from the
+# "Finished ... in ... s." lines in the simulation log files, and memory usage from the
+# "Peak memory usage" line in the log file of each process. Efficiencies are calculated
+# relative to the configuration with the smallest number of cores (processes x threads).
+# In weak scaling mode, the setup and output phases do not scale with the number of photon
+# packets, so that their efficiency mostly reflects the overhead of adding cores.
+#
+
+# --------------------------------------------------------------------
+
+# Set the default options
+THREADS=""
+RANKS="1"
+MODE="strong"
+FACTOR="1"
+FILTER="*"
+REPEAT="1"
+SKIRT="../release/SKIRT/main/skirt"
+OUTDIR="../benchmarks"
+
+# Parse the command line options
+while getopts "t:r:m:p:f:n:s:o:" OPTION
+do
+case $OPTION in
+t) THREADS="$OPTARG" ;;
+r) RANKS="$OPTARG" ;;
+m) MODE="$OPTARG" ;;
+p) FACTOR="$OPTARG" ;;
+f) FILTER="$OPTARG" ;;
+n) REPEAT="$OPTARG" ;;
+s) SKIRT="$OPTARG" ;;
+o) OUTDIR="$OPTARG" ;;
+*) echo "Fatal error: invalid option; see the script header for usage information"; exit 1 ;;
+esac
+done
+
+# Verify the options
+if [ "$MODE" != "strong" ] && [ "$MODE" != "weak" ]
+then
+echo "Fatal error: scaling mode must be 'strong' or 'weak'"
+exit 1
+fi
+if [ ! -x "$SKIRT" ]
+then
+echo "Fatal error: there is no skirt executable at $SKIRT"
+exit 1
+fi
+if [ ! -d SKIRT/bench/macro ]
+then
+echo "Fatal error: this script must be executed with the 'git' directory as default directory"
+exit 1
+fi
+
+# Use powers of two up to the number of cores as the default thread counts
+if [ "$THREADS" == "" ]
+then
+NUMCORES=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+THREADS="1"
+T=2
+while [ $T -le $NUMCORES ]
+do
+THREADS="$THREADS,$T"
+T=$((T*2))
+done
+fi
+THREADS="${THREADS//,/ }"
+RANKS="${RANKS//,/ }"
+
+# Look for mpirun if any of the configurations use multiple processes
+MPIRUN=""
+for R in $RANKS
+do
+if [ $R -gt 1 ]
+then
+MPIRUN="$(which mpirun)"
+if [ "$MPIRUN" == "" ]
+then
+echo "Fatal error: there is no mpirun in the default path; omit process counts above 1"
+exit 1
+fi
+fi
+done
+
+# Prepare the output directory and the raw data files
+mkdir -p "$OUTDIR" || exit 1
+OUTDIR="$(cd "$OUTDIR" && pwd)"
+SKIRT="$(cd "$(dirname "$SKIRT")" && pwd)/$(basename "$SKIRT")"
+TIMINGS="$OUTDIR/timings.tsv"
+MEMORY="$OUTDIR/memory.tsv"
+printf "ski\tranks\tthreads\trun\tphase\tseconds\n" > "$TIMINGS"
+printf "ski\tranks\tthreads\trun\tprocess\tpeakMB\n" > "$MEMORY"
+
+echo
+echo "Using $SKIRT"
+echo "Running $MODE scaling benchmarks for processes [$RANKS] and threads [$THREADS]"
+echo
+
+# Run each selected ski file for each configuration
+for SKIFILE in SKIRT/bench/macro/$FILTER.ski
+do
+if [ ! -f "$SKIFILE" ]
+then
+echo "Fatal error: there are no ski files matching '$FILTER'"
+exit 1
+fi
+NAME="$(basename "$SKIFILE" .ski)"
+for R in $RANKS
+do
+for T in $THREADS
+do
+for N in $(seq 1 $REPEAT)
+do
+RUNDIR="$OUTDIR/$NAME/r${R}_t${T}_n${N}"
+rm -rf "$RUNDIR"
+mkdir -p "$RUNDIR"
+
+# Copy the ski file, adjusting the number of photon packets for the scaling mode
+if [ "$MODE" == "weak" ]
+then
+SCALE=$(awk "BEGIN { print $FACTOR * $R * $T }")
+else
+SCALE=$FACTOR
+fi
+awk -v scale=$SCALE '{
+    if (match($0, /numPackets="[^"]*"/))
+    {
+        value = substr($0, RSTART+12, RLENGTH-13)
+        $0 = substr($0, 1, RSTART-1) "numPackets=\"" sprintf("%.6g", value*scale) "\"" substr($0, RSTART+RLENGTH)
+    }
+    print
+}' "$SKIFILE" > "$RUNDIR/$NAME.ski"
+
+# Run the simulation; verbose mode causes each process to write its own log file
+echo "Running $NAME with $R process(es) x $T thread(s), run $N of $REPEAT..."
+if [ $R -gt 1 ]
+then
+"$MPIRUN" -np $R "$SKIRT" -b -v -t $T -o "$RUNDIR" "$RUNDIR/$NAME.ski" > "$RUNDIR/console.txt" 2>&1
+else
+"$SKIRT" -b -v -t $T -o "$RUNDIR" "$RUNDIR/$NAME.ski" > "$RUNDIR/console.txt" 2>&1
+fi
+LOGFILE="$RUNDIR/${NAME}_log.txt"
+if [ ! -f "$LOGFILE" ] || ! grep -q "Finished simulation" "$LOGFILE"
+then
+echo "  Simulation failed; see $RUNDIR/console.txt"
+continue
+fi
+
+# Extract the phase timings from the log file of the root process; phases that occur more than
+# once (such as the emission segments in consecutive iterations) are accumulated
+awk -v ski=$NAME -v r=$R -v t=$T -v n=$N '
+    /- Finished .* in [0-9.e+-]+ s/ {
+        line = $0
+        sub(/^.*- Finished /, "", line)
+        sec = line
+        sub(/ in [0-9.e+-]+ s.*$/, "", line)
+        sub(/^.* in /, "", sec)
+        sub(/ s.*$/, "", sec)
+        if (line ~ /^simulation /) line = "total"
+        if (!(line in sum)) order[++num] = line
+        sum[line] += sec
+    }
+    END { for (i = 1; i <= num; i++) printf "%s\t%d\t%d\t%d\t%s\t%s\n", ski, r, t, n, order[i], sum[order[i]] }
+' "$LOGFILE" >> "$TIMINGS"
+
+# Extract the peak memory usage from the log file of each process
+for PLOG in "$RUNDIR/${NAME}"_log*.txt
+do
+PROC="$(basename "$PLOG" .txt)"
+PROC="${PROC#${NAME}_log}"
+PROC="${PROC:-P000}"
+awk -v ski=$NAME -v r=$R -v t=$T -v n=$N -v p=$PROC '
+    /Peak memory usage: / {
+        line = $0
+        sub(/^.*Peak memory usage: /, "", line)
+        split(line, parts, " ")
+        mb = parts[1]
+        if (parts[2] == "KB") mb /= 1024
+        if (parts[2] == "GB") mb *= 1024
+        if (parts[2] == "TB") mb *= 1024 * 1024
+        peak = mb
+    }
+    END { if (peak != "") printf "%s\t%d\t%d\t%d\t%s\t%.1f\n", ski, r, t, n, p, peak }
+' "$PLOG" >> "$MEMORY"
+done
+done
+done
+done
+done
+
+# --------------------------------------------------------------------
+
+# Produce the scaling report from the raw data
+awk -v mode=$MODE -F '\t' '
+    # load the timings, retaining the shortest time over all runs for each configuration and phase
+    FNR == 1 { next }
+    FILENAME ~ /timings.tsv$/ {
+        ski = $1; cfg = $2 "\t" $3; phase = $5
+        if (!(ski in seenSki)) { seenSki[ski] = 1; skis[++numSkis] = ski }
+        if (!((ski, cfg) in seenCfg)) { seenCfg[ski, cfg] = 1; cfgs[ski, ++numCfgs[ski]] = cfg }
+        if (!((ski, phase) in seenPhase)) { seenPhase[ski, phase] = 1; phases[ski, ++numPhases[ski]] = phase }
+        key = ski SUBSEP cfg SUBSEP phase
+        if (!(key in time) || $6 < time[key]) time[key] = $6
+        next
+    }
+    # load the memory figures, retaining the maximum for a single process and the sum over all processes
+    FILENAME ~ /memory.tsv$/ {
+        key = $1 SUBSEP $2 "\t" $3
+        if (!(key in mem) || $6 > mem[key]) mem[key] = $6
+        if (!((key, $4) in seenRun)) { seenRun[key, $4] = 1; numRuns[key]++ }
+        total[key] += $6
+        next
+    }
+    END {
+        printf "SKIRT %s scaling report\n", mode
+        for (s = 1; s <= numSkis; s++)
+        {
+            ski = skis[s]
+            printf "\n==== %s ====\n\n", ski
+
+            # determine the baseline configuration with the smallest number of cores
+            base = ""
+            for (c = 1; c <= numCfgs[ski]; c++)
+            {
+                split(cfgs[ski, c], rt, "\t")
+                if (base == "" || rt[1] * rt[2] < baseCores) { base = cfgs[ski, c]; baseCores = rt[1] * rt[2] }
+            }
+
+            # wall-clock times and efficiencies per phase
+            printf "%-34s", "phase \\ processes x threads"
+            for (c = 1; c <= numCfgs[ski]; c++) { split(cfgs[ski, c], rt, "\t"); printf "%18s", rt[1] " x " rt[2] }
+            printf "\n"
+            for (p = 1; p <= numPhases[ski]; p++)
+            {
+                phase = phases[ski, p]
+                printf "%-34s", substr(phase, 1, 33)
+                for (c = 1; c <= numCfgs[ski]; c++)
+                {
+                    cfg = cfgs[ski, c]
+                    split(cfg, rt, "\t")
+                    cores = rt[1] * rt[2]
+                    t = time[ski, cfg, phase]
+                    t0 = time[ski, base, phase]
+                    if (t == "" || t0 == "") { printf "%18s", "-"; continue }
+                    if (t <= 0 || t0 <= 0) { printf "%18s", sprintf("%.1fs", t); continue }
+                    eff = (mode == "weak") ? t0 / t : (t0 * baseCores) / (t * cores)
+                    printf "%18s", sprintf("%.1fs %3.0f%%", t, 100 * eff)
+                }
+                printf "\n"
+            }
+
+            # peak memory per process
+            printf "%-34s", "peak memory per process (max)"
+            for (c = 1; c <= numCfgs[ski]; c++)
+            {
+                key = ski SUBSEP cfgs[ski, c]
+                printf "%18s", (key in mem) ? sprintf("%.0f MB", mem[key]) : "-"
+            }
+            printf "\n"
+            printf "%-34s", "peak memory summed over processes"
+            for (c = 1; c <= numCfgs[ski]; c++)
+            {
+                key = ski SUBSEP cfgs[ski, c]
+                printf "%18s", (key in total) ? sprintf("%.0f MB", total[key] / numRuns[key]) : "-"
+            }
+            printf "\n"
+        }
+        printf "\nTimes are the shortest wall-clock times over all runs; percentages are %s scaling efficiencies\n", mode
+        printf "relative to the configuration with the smallest number of cores.\n"
+    }
+' "$TIMINGS" "$MEMORY" > "$OUTDIR/report.txt"
+
+echo
+cat "$OUTDIR/report.txt"
+echo
+echo "Scaling report written to $OUTDIR/report.txt"
+echo